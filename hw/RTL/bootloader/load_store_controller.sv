@@ -1,8 +1,36 @@
+// UART bootloader: IMEM writes, DMEM reads/writes and core run control from the
+// host (tools/bootloader.c).
+//
+// v1 header:  {type (1 = IMEM write, 0 = DMEM read), addr[14:0], ndata[15:0]},
+//             followed by ndata words (write) or answered with ndata words (read).
+//             No acknowledgement and no integrity check.
+// v2 header:  bits [31:30] = 2'b11 (a v1 address that large is out of range anyway),
+//             [23,29:28] op (bit 23 is op[2]), [27:24] seq, then the op fields:
+//   WRITE (0): addr[22:8], ndata[7:0] (1..CHUNK_MAX), followed by ndata words
+//   BAUD  (1): bit_div[15:0], the new bit period in 1/16 clocks (>= 64)
+//   SYNC  (2): sets the expected seq to the header seq (and confirms a baud switch)
+//   HASH  (3): addr[22:8], nchunks[7:0], followed by one word with the chunk length;
+//              after the response, returns the CRC-32 of each IMEM chunk in order
+//   DWRITE (4): addr[22:8], ndata[7:0], followed by ndata words and one word with the
+//              byte strobes [3:0]; written to DMEM like WRITE is to IMEM
+//   CTRL  (5): [8] update halt, [9] update reset, [0] halt, [1] reset (hold the core
+//              in reset); with [9:8] = 0 it only reports the core state
+// Every v2 frame ends with a CRC-32 word (IEEE, over the header and payload bytes as
+// sent) and is answered with {8'hAC, 14'h0, halted, in_reset, status[3:0], next_seq[3:0]}.
+// WRITE/DWRITE are staged and only copied to memory after their CRC and seq check, so
+// the host can keep several chunks in flight and go back to next_seq on a NAK.
+// A halt takes effect at the core's next instruction fetch (core_halted); the host
+// polls CTRL until the response shows it.
+// After BAUD is acknowledged both ends switch rate; unless a SYNC arrives at the new
+// rate within BAUD_TIMEOUT clocks the controller falls back to the previous rate.
+// A line idle for 256 bit times abandons a partial word or v2 frame.
 module load_store_controller #(
     parameter CLK_FREQ = 50_000_000,
     parameter BAUD_RATE = 115200,
     parameter int ADDR_WIDTH = 10,
-    parameter int DATA_WIDTH = 32
+    parameter int DATA_WIDTH = 32,
+    parameter int CHUNK_MAX = 128,
+    parameter int BAUD_TIMEOUT = CLK_FREQ / 10
 ) (
     input  logic clk,                       // System clock
     input  logic nrst,                      // Active low reset
@@ -10,13 +38,24 @@ module load_store_controller #(
     output logic tx,                        // Transmit data line
 
     // DMEM Interface
+    output logic                     we_d,
+    output logic                     re_d,      // DATA_R reads (port B is the loader's)
+    output logic [DATA_WIDTH/8-1:0]  wstrb_d,
     output logic [ADDR_WIDTH-1:0]    addr_d,
+    output logic [DATA_WIDTH-1:0]    din_d,
     input  logic [DATA_WIDTH-1:0]    dout_d,
 
     // IMEM Interface
     output logic                     we_i,
+    output logic                     re_i,      // HASH reads (dout_i one clock later)
     output logic [ADDR_WIDTH-1:0]    addr_i,
-    output logic [DATA_WIDTH-1:0]    din_i
+    output logic [DATA_WIDTH-1:0]    din_i,
+    input  logic [DATA_WIDTH-1:0]    dout_i,
+
+    // Core run control
+    output logic                     core_halt,     // stop at the next fetch
+    output logic                     core_reset,    // hold the core in reset
+    input  logic                     core_halted
 );
 
     parameter logic WRITE   = 1;
@@ -25,8 +64,24 @@ module load_store_controller #(
     parameter int POS_ADDR  = 30;   // 30 down to 16 (15 bits total)
     parameter int POS_TYPE  = 31;
 
+    localparam logic [2:0] OP_WRITE  = 3'd0;
+    localparam logic [2:0] OP_BAUD   = 3'd1;
+    localparam logic [2:0] OP_SYNC   = 3'd2;
+    localparam logic [2:0] OP_HASH   = 3'd3;
+    localparam logic [2:0] OP_DWRITE = 3'd4;
+    localparam logic [2:0] OP_CTRL   = 3'd5;
+
+    localparam logic [3:0] ST_ACK       = 4'd0;
+    localparam logic [3:0] ST_BAD_CRC   = 4'd1;
+    localparam logic [3:0] ST_BAD_SEQ   = 4'd2;
+    localparam logic [3:0] ST_BAD_RANGE = 4'd3;
+
+    localparam logic [15:0] DEFAULT_DIV = 16'((64'(CLK_FREQ) * 16 + BAUD_RATE / 2) / BAUD_RATE);
+    localparam int STAGE_W = $clog2(CHUNK_MAX);
+
     //Auxiliary signals
     logic ena_tx_word;
+    logic ena_tx_read;
     logic tx_done_word;
     logic new_rx_word;
     logic [DATA_WIDTH-1:0] data_send_word;
@@ -39,15 +94,65 @@ module load_store_controller #(
     logic [14:0] header_addr;
     logic        header_addr_oob;
 
-    typedef enum logic [2:0] {
+    // v2 frames
+    logic [2:0]  v2_op;
+    logic [2:0]  hdr_op;
+    logic [3:0]  seq_rx;
+    logic [3:0]  seq_exp;
+    logic [31:0] crc;
+    logic        v2_range_err;
+    logic [15:0] v2_ndata;
+    logic [16:0] v2_final_addr;
+    logic [15:0] new_div;
+    logic [DATA_WIDTH-1:0] stage [CHUNK_MAX];   // WRITE/DWRITE payload until the CRC is checked
+    logic [3:0]  dw_strb;                       // DWRITE byte strobes (last payload word)
+    logic [9:0]  ctrl_req;
+    logic [7:0]  core_st;                       // response bits [15:8]
+    logic [31:0] resp_word;
+    logic        resp_pending;
+
+    // HASH
+    logic [7:0]  hash_chunks;                   // chunks still to hash
+    logic [15:0] hash_len;                      // words per chunk
+    logic [31:0] hash_end;
+    logic        hash_range_err;
+    logic [15:0] hash_cnt;                      // words folded into hash_crc
+    logic        hash_rd_q;                     // dout_i holds the word read last clock
+    logic [31:0] hash_crc;
+
+    // Baud rate
+    logic [15:0] bit_div;
+    logic [15:0] prev_div;
+    logic        baud_trial;                    // switched, waiting for SYNC
+    logic [31:0] baud_timer;
+    logic        rx_flush;
+    logic        rx_timeout;
+
+    typedef enum logic [3:0] {
         IDLE,
         HEADER,
         DATA_W,
         DATA_R,
-        DROP
+        DROP,
+        V2_DATA,
+        V2_CRC,
+        V2_COMMIT,
+        V2_BAUD,
+        V2_HASH,
+        V2_HASH_OUT
     } state_t;
     state_t state;    
 
+    // CRC-32 (IEEE 802.3, reflected) of one little-endian word
+    function automatic logic [31:0] crc32_word(input logic [31:0] crc_in, input logic [31:0] data);
+        logic [31:0] c;
+        c = crc_in;
+        for (int i = 0; i < 32; i++) begin
+            c = (c >> 1) ^ ((c[0] ^ data[i]) ? 32'hEDB88320 : 32'h0);
+        end
+        return c;
+    endfunction
+
     // Instantiate UART word adapter
     uart_word_adapter #(
         .CLK_FREQ(CLK_FREQ),
@@ -57,6 +162,9 @@ module load_store_controller #(
         .nrst(nrst),
         .rx(rx),
         .tx(tx),
+        .bit_div(bit_div),
+        .rx_flush(rx_flush),
+        .rx_timeout(rx_timeout),
         .data_send_word(data_send_word),
         .data_recv_word(data_recv_word),
         .ena_tx_word(ena_tx_word),
@@ -66,9 +174,25 @@ module load_store_controller #(
 
     assign header_num_data = data_recv_word[POS_NDATA : 0];
     assign header_addr = data_recv_word[POS_ADDR : POS_NDATA+1];
-    assign final_addr = header_addr + header_num_data - 1;
+    assign final_addr = 17'(header_addr) + 17'(header_num_data) - 17'd1;
     assign header_addr_oob = final_addr[16:ADDR_WIDTH] != '0;
 
+    assign hdr_op = {data_recv_word[23], data_recv_word[29:28]};
+    assign v2_ndata = {8'b0, data_recv_word[7:0]};
+    assign v2_final_addr = 17'(data_recv_word[22:8]) + 17'(v2_ndata) - 17'd1;
+    assign ena_tx_word = ena_tx_read || resp_pending;
+    assign core_st = {6'b0, core_halted, core_reset};
+
+    assign hash_end = 32'(addr_pos) + 32'(hash_chunks) * 32'(hash_len);
+    assign hash_range_err = (v2_op == OP_HASH) &&
+                            (hash_chunks == 0 || hash_len == 0 || hash_end > (32'd1 << ADDR_WIDTH));
+
+    always_ff @(posedge clk) begin
+        if (state == V2_DATA && new_rx_word && cnt_data < 16'(CHUNK_MAX)) begin
+            stage[cnt_data[STAGE_W-1:0]] <= data_recv_word;
+        end
+    end
+
     // State machine for load/store operations
     always_ff @(posedge clk or negedge nrst) begin
         if (!nrst) begin
@@ -76,14 +200,41 @@ module load_store_controller #(
             cnt_data <= 0;
             addr_pos <= 0;
             num_data <= 0;
-            ena_tx_word <= 0;
+            ena_tx_read <= 0;
+            v2_op <= OP_WRITE;
+            dw_strb <= 0;
+            ctrl_req <= 0;
+            core_halt <= 0;
+            core_reset <= 0;
+            seq_rx <= 0;
+            seq_exp <= 0;
+            crc <= 0;
+            v2_range_err <= 0;
+            new_div <= DEFAULT_DIV;
+            resp_word <= 0;
+            resp_pending <= 0;
+            bit_div <= DEFAULT_DIV;
+            prev_div <= DEFAULT_DIV;
+            baud_trial <= 0;
+            baud_timer <= 0;
+            rx_flush <= 0;
+            hash_chunks <= 0;
+            hash_len <= 0;
+            hash_cnt <= 0;
+            hash_rd_q <= 0;
+            hash_crc <= 0;
         end else begin
+            rx_flush <= 0;
+            if (resp_pending && tx_done_word) begin
+                resp_pending <= 0;
+            end
+
             case (state)
                 IDLE: begin
                     cnt_data <= 0;
                     addr_pos <= 0;
                     num_data <= 0;
-                    ena_tx_word <= 0;
+                    ena_tx_read <= 0;
                     if (new_rx_word) begin
                         state <= HEADER;
                     end
@@ -92,8 +243,38 @@ module load_store_controller #(
                     addr_pos <= header_addr;
                     num_data <= header_num_data;
                     cnt_data <= 0;
+                    // v2 frame: header goes into the CRC, payload (if any) into the stage
+                    if (data_recv_word[31:30] == 2'b11) begin
+                        v2_op <= hdr_op;
+                        seq_rx <= data_recv_word[27:24];
+                        crc <= crc32_word(32'hFFFFFFFF, data_recv_word);
+                        new_div <= data_recv_word[15:0];
+                        ctrl_req <= data_recv_word[9:0];
+                        state <= V2_CRC;
+                        case (hdr_op)
+                            OP_WRITE, OP_DWRITE: begin
+                                addr_pos <= data_recv_word[22:8];
+                                // DWRITE: the strobe word follows the data
+                                num_data <= v2_ndata + 16'(hdr_op == OP_DWRITE);
+                                v2_range_err <= (v2_ndata == 0) || (v2_ndata > 16'(CHUNK_MAX)) ||
+                                                (v2_final_addr[16:ADDR_WIDTH] != '0);
+                                if (v2_ndata != 0) begin
+                                    state <= V2_DATA;
+                                end
+                            end
+                            OP_BAUD: v2_range_err <= data_recv_word[15:0] < 16'd64;
+                            OP_HASH: begin      // chunk length word follows
+                                addr_pos <= data_recv_word[22:8];
+                                num_data <= 1;
+                                hash_chunks <= data_recv_word[7:0];
+                                v2_range_err <= 0;
+                                state <= V2_DATA;
+                            end
+                            OP_SYNC, OP_CTRL: v2_range_err <= 0;
+                            default: v2_range_err <= 1;
+                        endcase
                     // Not valid header, go to IDLE
-                    if (header_num_data == 0) begin
+                    end else if (header_num_data == 0) begin
                         state <= IDLE;
                     // Out of bounds address
                     end else if (header_addr_oob) begin
@@ -107,11 +288,11 @@ module load_store_controller #(
 
                 // Read data from DMEM and send via UART
                 DATA_R: begin
-                    ena_tx_word <= 1;
+                    ena_tx_read <= 1;
                     if (tx_done_word) begin
-                        cnt_data <= cnt_data + 1;
-                        if (cnt_data == num_data - 1) begin
-                            ena_tx_word <= 0;
+                        cnt_data <= cnt_data + 16'd1;
+                        if (cnt_data == num_data - 16'd1) begin
+                            ena_tx_read <= 0;
                             state <= IDLE;
                         end
                     end
@@ -120,8 +301,8 @@ module load_store_controller #(
                 // Write data to IMEM received via UART (program core)
                 DATA_W: begin
                     if (new_rx_word) begin
-                        cnt_data <= cnt_data + 1;
-                        if (cnt_data == num_data - 1) begin
+                        cnt_data <= cnt_data + 16'd1;
+                        if (cnt_data == num_data - 16'd1) begin
                             state <= IDLE;
                         end
                     end
@@ -129,24 +310,147 @@ module load_store_controller #(
                 // Drop incoming data when out of bounds
                 DROP: begin
                     if (new_rx_word) begin
-                        cnt_data <= cnt_data + 1;
-                        if (cnt_data == num_data - 1) begin
+                        cnt_data <= cnt_data + 16'd1;
+                        if (cnt_data == num_data - 16'd1) begin
                             state <= IDLE;
                         end
                     end
                 end
 
+                // v2 WRITE/DWRITE payload into the stage buffer
+                V2_DATA: begin
+                    if (new_rx_word) begin
+                        crc <= crc32_word(crc, data_recv_word);
+                        hash_len <= data_recv_word[15:0];
+                        dw_strb <= data_recv_word[3:0];
+                        cnt_data <= cnt_data + 16'd1;
+                        if (cnt_data == num_data - 16'd1) begin
+                            state <= V2_CRC;
+                        end
+                    end else if (rx_timeout) begin
+                        state <= IDLE;
+                    end
+                end
+
+                // Check the frame and answer; only a good WRITE/DWRITE reaches memory
+                V2_CRC: begin
+                    cnt_data <= 0;
+                    if (new_rx_word) begin
+                        resp_pending <= 1;
+                        resp_word <= {8'hAC, 8'h0, core_st, ST_ACK, seq_exp};
+                        state <= IDLE;
+                        if (~crc != data_recv_word) begin
+                            resp_word <= {8'hAC, 8'h0, core_st, ST_BAD_CRC, seq_exp};
+                        end else if (v2_op == OP_SYNC) begin
+                            seq_exp <= seq_rx;
+                            baud_trial <= 0;
+                            resp_word <= {8'hAC, 8'h0, core_st, ST_ACK, seq_rx};
+                        end else if ((v2_op == OP_WRITE || v2_op == OP_DWRITE) && seq_rx != seq_exp) begin
+                            resp_word <= {8'hAC, 8'h0, core_st, ST_BAD_SEQ, seq_exp};
+                        end else if (v2_range_err || hash_range_err) begin
+                            resp_word <= {8'hAC, 8'h0, core_st, ST_BAD_RANGE, seq_exp};
+                        end else if (v2_op == OP_WRITE || v2_op == OP_DWRITE) begin
+                            seq_exp <= seq_exp + 4'd1;
+                            resp_word <= {8'hAC, 8'h0, core_st, ST_ACK, seq_exp + 4'd1};
+                            num_data <= num_data - 16'(v2_op == OP_DWRITE);
+                            state <= V2_COMMIT;
+                        end else if (v2_op == OP_CTRL) begin
+                            // Reported state is the one before this request; a halt
+                            // shows up in the next response once the core has stopped.
+                            if (ctrl_req[8]) core_halt <= ctrl_req[0];
+                            if (ctrl_req[9]) core_reset <= ctrl_req[1];
+                        end else if (v2_op == OP_HASH) begin
+                            hash_cnt <= 0;
+                            hash_rd_q <= 0;
+                            hash_crc <= 32'hFFFFFFFF;
+                            state <= V2_HASH;
+                        end else begin
+                            state <= V2_BAUD;
+                        end
+                    end else if (rx_timeout) begin
+                        state <= IDLE;
+                    end
+                end
+
+                // Stage -> IMEM/DMEM, one word per clock (shorter than one UART word)
+                V2_COMMIT: begin
+                    cnt_data <= cnt_data + 16'd1;
+                    if (cnt_data == num_data - 16'd1) begin
+                        state <= IDLE;
+                    end
+                end
+
+                // Read one chunk through the IMEM port (one word per clock)
+                V2_HASH: begin
+                    hash_rd_q <= (cnt_data < hash_len);
+                    if (cnt_data < hash_len) begin
+                        cnt_data <= cnt_data + 16'd1;
+                    end
+                    if (hash_rd_q) begin
+                        hash_crc <= crc32_word(hash_crc, dout_i);
+                        hash_cnt <= hash_cnt + 16'd1;
+                        if (hash_cnt == hash_len - 16'd1) begin
+                            state <= V2_HASH_OUT;
+                        end
+                    end
+                end
+
+                // Queue the chunk CRC behind the previous response, then the next chunk
+                V2_HASH_OUT: begin
+                    if (!resp_pending) begin
+                        resp_word <= ~hash_crc;
+                        resp_pending <= 1;
+                        addr_pos <= addr_pos + hash_len[14:0];
+                        hash_chunks <= hash_chunks - 8'd1;
+                        cnt_data <= 0;
+                        hash_cnt <= 0;
+                        hash_rd_q <= 0;
+                        hash_crc <= 32'hFFFFFFFF;
+                        state <= (hash_chunks == 1) ? IDLE : V2_HASH;
+                    end
+                end
+
+                // Switch once the ACK has left at the old rate
+                V2_BAUD: begin
+                    if (!resp_pending) begin
+                        prev_div <= bit_div;
+                        bit_div <= new_div;
+                        baud_trial <= 1;
+                        baud_timer <= BAUD_TIMEOUT;
+                        rx_flush <= 1;
+                        state <= IDLE;
+                    end
+                end
+
+                default: state <= IDLE;
             endcase
+
+            // No SYNC at the new rate: fall back to the previous one
+            if (baud_trial && state != V2_BAUD) begin
+                if (baud_timer == 0) begin
+                    bit_div <= prev_div;
+                    baud_trial <= 0;
+                    rx_flush <= 1;
+                    state <= IDLE;
+                end else begin
+                    baud_timer <= baud_timer - 1;
+                end
+            end
         end
     end
 
     // Address calculation
     always_comb begin
-        we_i = state == DATA_W ? new_rx_word : 1'b0; // Write enable for IMEM
-        din_i = data_recv_word; // Data to write to IMEM
-        data_send_word = dout_d; // Read data from DMEM
-        addr_d = addr_pos + cnt_data;
-        addr_i = addr_pos + cnt_data;
+        we_i = state == DATA_W ? new_rx_word : (state == V2_COMMIT && v2_op == OP_WRITE); // Write enable for IMEM
+        re_i = state == V2_HASH; // Read enable for IMEM (HASH)
+        din_i = state == V2_COMMIT ? stage[cnt_data[STAGE_W-1:0]] : data_recv_word; // Data to write to IMEM
+        we_d = state == V2_COMMIT && v2_op == OP_DWRITE; // Write enable for DMEM (DWRITE)
+        re_d = state == DATA_R; // Read enable for DMEM (READ)
+        wstrb_d = dw_strb;
+        din_d = stage[cnt_data[STAGE_W-1:0]];
+        data_send_word = state == DATA_R ? dout_d : resp_word; // DMEM data or v2 response
+        addr_d = ADDR_WIDTH'(16'(addr_pos) + cnt_data);
+        addr_i = ADDR_WIDTH'(16'(addr_pos) + cnt_data);
     end
 
     
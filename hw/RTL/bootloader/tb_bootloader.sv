@@ -6,6 +6,7 @@ module tb_bootloader;
     parameter int CLK_FREQ = 50_000_000;
     parameter int NANOS_PER_SEC = 1_000_000_000;
     parameter int BAUD_RATE = 115200;
+    parameter int BAUD_TIMEOUT = 50_000;    // clocks before a baud switch falls back
 
     // Signals
     logic clk;
@@ -13,12 +14,22 @@ module tb_bootloader;
     logic tx;
     logic rx;
     // DMEM bus signals
+    logic                   dmem_b_we;
+    logic                   dmem_b_re;
+    logic [3:0]             dmem_b_wstrb;
     logic [9:0]             dmem_b_addr;
+    logic [31:0]            dmem_b_wdata;
     logic [31:0]            dmem_rdata;
+    // Core run control (core_model below)
+    logic                   core_halt;
+    logic                   core_reset;
+    logic                   core_halted;
     // IMEM bus signals
     logic                   imem_b_we;
+    logic                   imem_b_re;
     logic [9:0]             imem_b_addr;
     logic [31:0]            imem_b_wdata;
+    logic [31:0]            imem_b_rdata;
 
     // IMEM buffer
     logic [31:0] imem_buffer[$];
@@ -27,26 +38,56 @@ module tb_bootloader;
     localparam time BIT_TIME = NANOS_PER_SEC / BAUD_RATE;
     localparam int  DMEM_DEPTH = 1024;
 
+    // Current line rate of the TB side (follows v2 baud switches)
+    realtime bit_time = BIT_TIME;
+
     // Instantiate bootloader DUT
     load_store_controller #(
         .CLK_FREQ(CLK_FREQ),
         .BAUD_RATE(BAUD_RATE),
         .ADDR_WIDTH(10),
-        .DATA_WIDTH(32)
+        .DATA_WIDTH(32),
+        .BAUD_TIMEOUT(BAUD_TIMEOUT)
     ) dut (
         .clk(clk),
         .nrst(nrst),
         .tx(tx),
         .rx(rx),
         // DMEM Interface
+        .we_d(dmem_b_we),
+        .re_d(dmem_b_re),
+        .wstrb_d(dmem_b_wstrb),
         .addr_d(dmem_b_addr),
+        .din_d(dmem_b_wdata),
         .dout_d(dmem_rdata),
         // IMEM Interface
         .we_i(imem_b_we),
+        .re_i(imem_b_re),
         .addr_i(imem_b_addr),
-        .din_i(imem_b_wdata)
+        .din_i(imem_b_wdata),
+        .dout_i(imem_b_rdata),
+        // Core run control
+        .core_halt(core_halt),
+        .core_reset(core_reset),
+        .core_halted(core_halted)
     );
 
+    // Core stand-in: reaches its next fetch some clocks after a halt request
+    int core_busy;
+    always_ff @(posedge clk or negedge nrst) begin
+        if (!nrst) begin
+            core_halted <= 0;
+            core_busy <= 0;
+        end else if (!core_halt) begin
+            core_halted <= 0;
+            core_busy <= 40;
+        end else if (core_busy != 0) begin
+            core_busy <= core_busy - 1;
+        end else begin
+            core_halted <= 1;
+        end
+    end
+
     // Instantiate DMEM model
     mem #(
         .ADDR_WIDTH(10),
@@ -54,10 +95,10 @@ module tb_bootloader;
     ) dmem_inst (
         .clk(clk),
         .en_a(1),           // Always enabled
-        .we_a(0),           // Unused
-        .wstrb_a(0),        // Unused
+        .we_a(dmem_b_we),
+        .wstrb_a(dmem_b_wstrb),
         .addr_a(dmem_b_addr),
-        .din_a(0),          // Unused
+        .din_a(dmem_b_wdata),
         .dout_a(dmem_rdata)
     );
 
@@ -72,23 +113,23 @@ module tb_bootloader;
         .wstrb_a(4'b1111),
         .addr_a(imem_b_addr),
         .din_a(imem_b_wdata),
-        .dout_a()    // Unused
+        .dout_a(imem_b_rdata)
     );
 
     // UART Send byte task
     task automatic uart_send_byte(input logic [7:0] data);
         @(posedge clk);
         rx = 0; // Start bit
-        #(NANOS_PER_SEC / BAUD_RATE); // Wait for 1 bit duration at 115200 baud
+        #(bit_time); // Wait for 1 bit duration
 
         // Send data bits (LSB first)
         for (int i = 0; i < 8; i++) begin
             rx = data[i];
-            #(NANOS_PER_SEC / BAUD_RATE); // Wait for 1 bit duration
+            #(bit_time); // Wait for 1 bit duration
         end
 
         rx = 1; // Stop bit
-        #(NANOS_PER_SEC / BAUD_RATE); // Wait for stop bit duration
+        #(bit_time); // Wait for stop bit duration
     endtask
 
     // UART write word32
@@ -143,7 +184,7 @@ module tb_bootloader;
             if (($time - start_time) > timeout) begin
                 $fatal(1, "Timeout waiting for %0d DMEM words, got %0d", count, dmem_buffer.size());
             end
-            #BIT_TIME;
+            #(bit_time);
         end
     endtask
 
@@ -174,6 +215,216 @@ module tb_bootloader;
         end
     endtask
 
+    // ---- Protocol v2 ----
+
+    function automatic logic [31:0] crc32_word(input logic [31:0] crc_in, input logic [31:0] data);
+        logic [31:0] c = crc_in;
+        for (int i = 0; i < 32; i++) begin
+            c = (c >> 1) ^ ((c[0] ^ data[i]) ? 32'hEDB88320 : 32'h0);
+        end
+        return c;
+    endfunction
+
+    // Send one v2 frame: header, payload, CRC (optionally corrupted)
+    task automatic v2_send(input logic [2:0] op, input logic [3:0] seq, input logic [22:0] fields,
+                           input logic [31:0] payload[$], input bit bad_crc = 0);
+        logic [31:0] header = {2'b11, op[1:0], seq, op[2], fields};
+        logic [31:0] crc = crc32_word(32'hFFFFFFFF, header);
+        uart_write_word32(header);
+        foreach (payload[i]) begin
+            crc = crc32_word(crc, payload[i]);
+            uart_write_word32(payload[i]);
+        end
+        uart_write_word32(bad_crc ? ~crc ^ 32'h1 : ~crc);
+    endtask
+
+    task automatic v2_write(input logic [3:0] seq, input logic [14:0] addr,
+                            input logic [31:0] payload[$], input bit bad_crc = 0);
+        v2_send(3'd0, seq, {addr, 8'(payload.size())}, payload, bad_crc);
+    endtask
+
+    task automatic v2_dwrite(input logic [3:0] seq, input logic [14:0] addr, input logic [3:0] strb,
+                             input logic [31:0] payload[$], input bit bad_crc = 0);
+        v2_send(3'd4, seq, {addr, 8'(payload.size())}, {payload, {28'b0, strb}}, bad_crc);
+    endtask
+
+    // Response check; bits [9:8] (core halted/in reset) only when core_st is given
+    task automatic v2_expect(input logic [3:0] status, input logic [3:0] next_seq,
+                             input int core_st = -1);
+        logic [31:0] got;
+        logic [31:0] mask = (core_st < 0) ? 32'hFFFF_FCFF : 32'hFFFF_FFFF;
+        wait_dmem_words(1, bit_time * 2000);
+        got = dmem_buffer.pop_front();
+        if ((got & mask) !== ({8'hAC, 14'h0, 2'(core_st), status, next_seq} & mask)) begin
+            $error("v2 response: expected status %0d seq %0d, got %08h", status, next_seq, got);
+        end
+    endtask
+
+    task automatic dmem_expect(input logic [14:0] addr, input logic [31:0] data[$]);
+        foreach (data[i]) begin
+            if (dmem_inst.mem[addr + i] !== data[i]) begin
+                $error("DMEM at %0h: expected %0h, got %0h", addr + i, data[i], dmem_inst.mem[addr + i]);
+            end
+        end
+    endtask
+
+    task automatic imem_expect(input logic [14:0] addr, input logic [31:0] data[$]);
+        foreach (data[i]) begin
+            if (imem_inst.mem[addr + i] !== data[i]) begin
+                $error("IMEM at %0h: expected %0h, got %0h", addr + i, data[i], imem_inst.mem[addr + i]);
+            end
+        end
+    endtask
+
+    function automatic void make_chunk(output logic [31:0] data[$], input int n, input logic [31:0] tag);
+        data = {};
+        for (int i = 0; i < n; i++) begin
+            data.push_back(tag + i);
+        end
+    endfunction
+
+    // HASH: one CRC-32 per chunk of chunk_len words, checked against the given data
+    task automatic v2_hash_expect(input logic [14:0] addr, input int nchunks, input int chunk_len,
+                                  input logic [31:0] data[$], input logic [3:0] next_seq);
+        logic [31:0] crc;
+        logic [31:0] got;
+        v2_send(3'd3, 0, {addr, 8'(nchunks)}, {32'(chunk_len)});
+        v2_expect(0, next_seq);
+        for (int k = 0; k < nchunks; k++) begin
+            crc = 32'hFFFFFFFF;
+            for (int i = 0; i < chunk_len; i++) begin
+                crc = crc32_word(crc, data[k * chunk_len + i]);
+            end
+            wait_dmem_words(1, bit_time * 2000);
+            got = dmem_buffer.pop_front();
+            if (got !== ~crc) begin
+                $error("HASH chunk %0d at %0h: expected %08h, got %08h", k, addr, ~crc, got);
+            end
+        end
+    endtask
+
+    int v2_seq;     // expected seq on the controller side, for BAUD responses
+
+    function automatic realtime div_bit_time(input logic [15:0] div);
+        return real'(div) / 16.0 * (real'(NANOS_PER_SEC) / CLK_FREQ) * 1ns;
+    endfunction
+
+    // Switch both ends to bit_div/16 clocks per bit
+    task automatic v2_baud(input logic [15:0] div);
+        v2_send(3'd1, 0, {7'b0, div}, {});
+        v2_expect(0, 4'(v2_seq));
+        #(bit_time * 2);    // the controller switches after its stop bit
+        bit_time = div_bit_time(div);
+    endtask
+
+    task automatic v2_tests();
+        logic [31:0] a[$], b[$], c[$], before[$];
+
+        // SYNC sets the expected sequence number
+        v2_seq = 0;
+        v2_send(3'd2, 0, 23'b0, {});
+        v2_expect(0, 0);
+
+        // One good chunk is written and acknowledged
+        make_chunk(a, 8, 32'hA000_0000);
+        v2_write(0, 40, a);
+        v2_expect(0, 1);
+        imem_expect(40, a);
+
+        // A corrupted chunk is NAKed and leaves IMEM alone; the retry is accepted
+        make_chunk(b, 16, 32'hB000_0000);
+        for (int i = 0; i < 16; i++) before.push_back(imem_inst.mem[100 + i]);
+        v2_write(1, 100, b, 1);
+        v2_expect(1, 1);
+        imem_expect(100, before);
+        v2_write(1, 100, b);
+        v2_expect(0, 2);
+        imem_expect(100, b);
+
+        // Window of three chunks, the middle one corrupted: the one after it is
+        // rejected by seq, then both are resent (go-back-N)
+        make_chunk(a, 4, 32'hC000_0000);
+        make_chunk(b, 4, 32'hC100_0000);
+        make_chunk(c, 4, 32'hC200_0000);
+        v2_write(2, 200, a);
+        v2_write(3, 204, b, 1);
+        v2_write(4, 208, {32'hDEAD_0000, 32'hDEAD_0001, 32'hDEAD_0002, 32'hDEAD_0003});
+        v2_expect(0, 3);
+        v2_expect(1, 3);
+        v2_expect(2, 3);
+        if (imem_inst.mem[208] === 32'hDEAD_0000) begin
+            $error("v2 chunk rejected by seq reached IMEM");
+        end
+        v2_write(3, 204, b);
+        v2_write(4, 208, c);
+        v2_expect(0, 4);
+        v2_expect(0, 5);
+        imem_expect(200, a);
+        imem_expect(204, b);
+        imem_expect(208, c);
+
+        // Out of range chunk
+        v2_write(5, DMEM_DEPTH - 2, c);
+        v2_expect(3, 5);
+        v2_seq = 5;
+
+        // HASH per chunk and over the whole range; out of range is rejected
+        v2_hash_expect(200, 3, 4, {a, b, c}, 5);
+        v2_hash_expect(200, 1, 12, {a, b, c}, 5);
+        v2_send(3'd3, 0, {15'(DMEM_DEPTH - 4), 8'd2}, {32'd4});
+        v2_expect(3, 5);
+
+        // DWRITE: full words, then byte strobes merge into them; a bad CRC writes nothing
+        make_chunk(a, 4, 32'hE000_0000);
+        v2_dwrite(5, 30, 4'b1111, a);
+        v2_expect(0, 6);
+        dmem_expect(30, a);
+        v2_dwrite(6, 31, 4'b0101, {32'h1122_3344, 32'h5566_7788});
+        v2_expect(0, 7);
+        dmem_expect(30, {32'hE000_0000, 32'hE022_0044, 32'hE066_0088, 32'hE000_0003});
+        v2_dwrite(7, 30, 4'b1111, {32'h0}, 1);
+        v2_expect(1, 7);
+        dmem_expect(30, {32'hE000_0000});
+        v2_dwrite(7, DMEM_DEPTH - 1, 4'b1111, {32'h0, 32'h0});
+        v2_expect(3, 7);
+        uart_read_dmem_verify(30, 4);
+
+        // CTRL: halt (acknowledged at once, reported once the core stopped), reset, run
+        v2_send(3'd5, 0, 23'h101, {});
+        v2_expect(0, 7, 0);
+        while (!core_halted) #(bit_time);
+        v2_send(3'd5, 0, 23'h0, {});
+        v2_expect(0, 7, 2'b10);
+        v2_send(3'd5, 0, 23'h202, {});
+        v2_expect(0, 7, 2'b10);
+        if (!core_reset || !core_halt) $error("CTRL reset: core_reset %0b core_halt %0b", core_reset, core_halt);
+        v2_send(3'd5, 0, 23'h300, {});
+        v2_expect(0, 7, 2'b11);
+        if (core_reset || core_halt) $error("CTRL run: core_reset %0b core_halt %0b", core_reset, core_halt);
+        v2_send(3'd5, 0, 23'h0, {});
+        v2_expect(0, 7, 0);
+        v2_seq = 7;
+
+        // 3 Mbaud (fractional divider), then a chunk and a v1 read at that rate
+        v2_baud(16'((CLK_FREQ * 64'd16 + 1_500_000) / 3_000_000));
+        v2_send(3'd2, 5, 23'b0, {});
+        v2_expect(0, 5);
+        make_chunk(a, 64, 32'hD000_0000);
+        v2_write(5, 300, a);
+        v2_expect(0, 6);
+        imem_expect(300, a);
+        uart_read_dmem_verify(10, 8);
+
+        // No SYNC after a switch: the controller falls back to the previous rate
+        v2_seq = 6;
+        v2_baud(16'd128);
+        bit_time = div_bit_time(16'((CLK_FREQ * 64'd16 + 1_500_000) / 3_000_000));
+        #(BAUD_TIMEOUT * (real'(NANOS_PER_SEC) / CLK_FREQ) * 1ns + 1us);
+        v2_send(3'd2, 6, 23'b0, {});
+        v2_expect(0, 6);
+        uart_read_dmem_verify(20, 4);
+    endtask
+
     // Monitor tx output
     initial begin
         integer i, j;
@@ -186,12 +437,12 @@ module tb_bootloader;
             for (j = 0; j < 4; j++) begin
                 
                 @(negedge tx); // start bit
-                #(NANOS_PER_SEC / (2 * BAUD_RATE)); // half bit
+                #(bit_time / 2); // half bit
                 for (i = 0; i < 8; i++) begin
-                    #(NANOS_PER_SEC / BAUD_RATE); // 1 bit
+                    #(bit_time); // 1 bit
                     rx_byte[i] = tx;
                 end
-                #(NANOS_PER_SEC / (BAUD_RATE)); // stop bit
+                #(bit_time); // stop bit
 
                 rx_word = {rx_byte, rx_word[31:8]};
             end
@@ -276,6 +527,8 @@ module tb_bootloader;
             end
         end
 
+        v2_tests();
+
         $finish;
     end
 
@@ -6,6 +6,7 @@ module uart #(
     input  logic nrst,              // Active low reset
     input  logic rx,                // Receive data line
     output logic tx,                // Transmit data line
+    input  logic [15:0] bit_div,    // Bit period in 1/16 clock cycles (>= 64)
 
     input  logic [7:0] data_send,   // Data to be transmitted
     output logic [7:0] data_recv,   // Data received
@@ -16,10 +17,9 @@ module uart #(
 
 );
 
-    // Calculate the number of clock cycles per bit
-    localparam integer CYCLES_PER_BIT = CLK_FREQ / BAUD_RATE;
-    localparam integer SAMPLE_TIME = CYCLES_PER_BIT / 2;
-
+    // Fractional divider: the phase accumulators advance by 16 every clock and
+    // wrap at bit_div, so a bit lasts bit_div/16 clocks on average
+    // (CLK_FREQ*16/BAUD_RATE gives BAUD_RATE; the parameters are kept for reference).
     logic sample_rx;
 
     // Transmitter state machine
@@ -35,21 +35,21 @@ module uart #(
     logic [1:0] rx_ff; // For synchronizing rx input
     logic [7:0] data_send_reg;
 
-    logic [$clog2(CYCLES_PER_BIT):0] clk_div1;
-    logic [$clog2(CYCLES_PER_BIT):0] clk_div2;
+    logic [16:0] acc_tx;
+    logic [16:0] acc_rx;
     logic tick_tx;
 
     // Transmitter logic
     always_ff @(posedge clk or negedge nrst) begin
         if (!nrst) begin
-            clk_div1 <= 0;
+            acc_tx <= 0;
             tick_tx <= 0;
         end else begin
-            if (clk_div1 == CYCLES_PER_BIT - 1) begin
-                clk_div1 <= 0;
+            if (acc_tx + 17'd16 >= {1'b0, bit_div}) begin
+                acc_tx <= acc_tx + 17'd16 - {1'b0, bit_div};
                 tick_tx <= 1;
             end else begin
-                clk_div1 <= clk_div1 + 1;
+                acc_tx <= acc_tx + 17'd16;
                 tick_tx <= 0;
             end
         end
@@ -78,7 +78,7 @@ module uart #(
                         if (tx_bit_cnt == 7) begin
                             tx_state <= STOP_BIT;
                         end else begin
-                            tx_bit_cnt <= tx_bit_cnt + 1;
+                            tx_bit_cnt <= tx_bit_cnt + 4'd1;
                         end
                     end
                 end
@@ -96,7 +96,7 @@ module uart #(
     always_comb begin
         // tx handling
         if (tx_state == DATA_BITS)
-            tx = data_send_reg[tx_bit_cnt]; // Data bits
+            tx = data_send_reg[tx_bit_cnt[2:0]]; // Data bits
         else if (tx_state == STOP_BIT)
             tx = 1'b1; // Stop bit
         else if (tx_state == START_BIT)
@@ -104,8 +104,9 @@ module uart #(
         else
             tx = 1'b1; // Idle state
 
-        // tx_done handling
-        tx_done = (tx_state == STOP_BIT) && (clk_div1 == CYCLES_PER_BIT - 2);
+        // tx_done handling: two clocks before the stop bit ends
+        tx_done = (tx_state == STOP_BIT) && (acc_tx + 17'd16 < {1'b0, bit_div})
+                                         && (acc_tx + 17'd32 >= {1'b0, bit_div});
     end
 
     // Receiver logic
@@ -117,14 +118,17 @@ module uart #(
         end
     end
 
+    // Starts half a bit ahead so that samples land mid-bit.
     always_ff @(posedge clk or negedge nrst) begin
         if (!nrst) begin
-            clk_div2 <= 0;
+            acc_rx <= 0;
         end else begin
-            if (clk_div2 == CYCLES_PER_BIT - 1 || rx_state == IDLE) begin
-                clk_div2 <= 0;
+            if (rx_state == IDLE) begin
+                acc_rx <= {2'b0, bit_div[15:1]};
+            end else if (sample_rx) begin
+                acc_rx <= acc_rx + 17'd16 - {1'b0, bit_div};
             end else begin
-                clk_div2 <= clk_div2 + 1;
+                acc_rx <= acc_rx + 17'd16;
             end
         end
     end
@@ -152,11 +156,11 @@ module uart #(
                 end
                 DATA_BITS: begin
                     if (sample_rx) begin
-                        data_recv[rx_bit_cnt] <= rx_ff[1];
+                        data_recv[rx_bit_cnt[2:0]] <= rx_ff[1];
                         if (rx_bit_cnt == 7) begin
                             rx_state <= STOP_BIT;
                         end else begin
-                            rx_bit_cnt <= rx_bit_cnt + 1;
+                            rx_bit_cnt <= rx_bit_cnt + 4'd1;
                         end
                     end
                 end
@@ -172,6 +176,6 @@ module uart #(
     end
 
     always_comb
-        sample_rx = (clk_div2 == SAMPLE_TIME);
+        sample_rx = (rx_state != IDLE) && (acc_rx + 17'd16 >= {1'b0, bit_div});
 
 endmodule
\ No newline at end of file
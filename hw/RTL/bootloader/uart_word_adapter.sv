@@ -6,6 +6,9 @@ module uart_word_adapter #(
     input  logic nrst,                      // Active low reset
     input  logic rx,                        // Receive data line
     output logic tx,                        // Transmit data line
+    input  logic [15:0] bit_div,            // Bit period in 1/16 clock cycles (see uart.sv)
+    input  logic rx_flush,                  // Drop a partially received word
+    output logic rx_timeout,                // Line idle for 256 bit times (1 clk pulse)
 
     input  logic [31:0] data_send_word,     // 32-bit Data to be transmitted
     output logic [31:0] data_recv_word,     // 32-bit Data received
@@ -29,6 +32,7 @@ module uart_word_adapter #(
     logic [31:0] word_data_tx;
 
     logic [1:0] cnt_ram;
+    logic [19:0] rx_idle_cnt;
 
     typedef enum logic [1:0] {
         IDLE,
@@ -46,6 +50,7 @@ module uart_word_adapter #(
         .nrst(nrst),
         .rx(rx),
         .tx(tx),
+        .bit_div(bit_div),
         .data_send(data_send_byte),
         .data_recv(data_recv_byte),
         .ena_tx(ena_tx_byte),
@@ -61,8 +66,12 @@ module uart_word_adapter #(
             word_data_rx <= 0;
             new_rx_word <= 0;
         end else begin
-            if (new_rx_byte) begin
-                byte_count_rx <= byte_count_rx + 1;
+            if (rx_flush || rx_timeout) begin
+                // Resynchronize on word boundaries after a lost byte
+                byte_count_rx <= 0;
+                new_rx_word <= 0;
+            end else if (new_rx_byte) begin
+                byte_count_rx <= byte_count_rx + 2'd1;
                 word_data_rx <= {data_recv_byte, word_data_rx[31:8]};
                 if (byte_count_rx == 3 ) begin
                     new_rx_word <= 1;
@@ -73,6 +82,18 @@ module uart_word_adapter #(
         end
     end
     always_comb data_recv_word = word_data_rx;
+
+    // Idle line detection: 256 bit times = 16 * bit_div clocks
+    always_ff @(posedge clk or negedge nrst) begin
+        if (!nrst) begin
+            rx_idle_cnt <= 0;
+        end else if (new_rx_byte) begin
+            rx_idle_cnt <= 0;
+        end else if (rx_idle_cnt < {bit_div, 4'b0}) begin
+            rx_idle_cnt <= rx_idle_cnt + 20'd1;
+        end
+    end
+    assign rx_timeout = (rx_idle_cnt == {bit_div, 4'b0} - 20'd1);
     
     
     // Transmit logic: Convert 32-bit word to 4 bytes
@@ -81,7 +102,7 @@ module uart_word_adapter #(
             cnt_ram <= 0;
         end else begin
             if (ena_tx_word && state == IDLE) begin
-                cnt_ram <= cnt_ram + 1;
+                cnt_ram <= cnt_ram + 2'd1;
             end else begin
                 cnt_ram <= 0;
             end
@@ -110,7 +131,7 @@ module uart_word_adapter #(
                     ena_tx_byte <= 1;
                     data_send_byte <= word_data_tx[7:0];
                     if (tx_done_byte) begin
-                        byte_count_tx <= byte_count_tx + 1;
+                        byte_count_tx <= byte_count_tx + 2'd1;
                         word_data_tx <= {8'b0, word_data_tx[31:8]};
                         if (byte_count_tx == 3) begin
                             state <= DONE;
@@ -122,6 +143,7 @@ module uart_word_adapter #(
                     tx_done_word <= 1;
                     state <= IDLE;
                 end
+                default: state <= IDLE;
             endcase
         end
     end
@@ -7,13 +7,31 @@ module ROC_RV32 #(
     parameter int ADDR_WIDTH_D = 10,
     parameter int DATA_WIDTH_D = 32,
     parameter int N_EXT_IRQ = 8,
-    parameter logic [31:0] RESET_MTVEC = 32'h0000_1000
+    parameter logic [31:0] RESET_MTVEC = 32'h0000_1000,
+    // 0: multi-cycle FSM (control_unit), 1: five-stage pipeline (rv32_pipeline)
+    parameter bit PIPELINE = 1'b0,
+    // 1: RV32M multiply/divide (rv32_muldiv), 0: those encodings execute as ADD
+    parameter bit RV32M = 1'b0,
+    // 1: interrupts are also taken between instructions when nothing is in flight
+    // (multi-cycle: every FETCH; pipeline: empty EX/MEM/WB, e.g. asleep in WFI),
+    // not only when an instruction commits
+    parameter bit EARLY_IRQ = 1'b0,
+    // 1: RV32C compressed instructions (rv32c_expand), PC aligned to 2 bytes
+    parameter bit RV32C = 1'b0,
+    // mhartid (soc N_HARTS: 0 and 1)
+    parameter logic [31:0] HART_ID = 32'd0
 ) (
     input  logic                               clk,
     input  logic                               rst_n,
     // instruction memory
     input  logic [DATA_WIDTH_I-1:0]            data_imem,
     output logic [ADDR_WIDTH_I-1:0]            imem_addr,
+    // Byte fetch address for cached code (soc XMEM). data_imem holds the word for
+    // the previous cycle's address once imem_valid is high; ifetch_req marks the
+    // cycles where the core consumes it. TCM fetch keeps imem_valid tied high.
+    output logic [31:0]                        ifetch_addr,
+    output logic                               ifetch_req,
+    input  logic                               imem_valid,
 
     // LSU
     output  logic                    rready_cpu,
@@ -24,11 +42,25 @@ module ROC_RV32 #(
     output  logic [31:0]             addr_cpu,
     output  logic [31:0]             data_cpu_o,
     input   logic [31:0]             data_cpu_i,
+    // LSU write buffer: drained (FENCE) and late write error report
+    input   logic                    lsu_idle,
+    input   logic                    bus_err,
+    input   logic [31:0]             bus_err_addr,
+    // AMO in the memory stage: keep the other bus masters off the interconnect
+    output  logic                    amo_lock,
+    input   logic                    irq_software,
     input   logic                    timer_irq,
-    input   logic [N_EXT_IRQ-1:0]    external_irq
+    input   logic [N_EXT_IRQ-1:0]    external_irq,
+    // CLINT mtime, read through the time/timeh CSRs
+    input   logic [63:0]             mtime,
+    // Debug halt (bootloader): stop before the next instruction; halted once nothing
+    // is in flight
+    input   logic                    halt_req,
+    output  logic                    halted
 );
 
     localparam logic [31:0] INSN_MRET = 32'h3020_0073;
+    localparam logic [31:0] INSN_WFI  = 32'h1050_0073;
 
     logic [31:0] ir;
     
@@ -52,7 +84,17 @@ module ROC_RV32 #(
 
     logic [31:0] pc_output;
     logic [31:0] pc_ir;
-    logic [31:0] pc_ir_plus4;
+    logic [31:0] pc_ir_next;
+
+    // RV32C fetch (multi-cycle)
+    logic [31:0] fetch_pc;
+    logic [15:0] fetch_half;
+    logic [31:0] fetch_exp;
+    logic        fetch_c;
+    logic        ifetch_split;
+    logic        ifetch_hold;
+    logic        ir_c;
+    logic [15:0] ir_lo;
 
     logic        wena_reg;
     logic        csr_wena;
@@ -84,9 +126,112 @@ module ROC_RV32 #(
 
     logic irq;
 
+    // One instruction retires this cycle (for CPI measurements).
+    logic instr_retire;
+
+    // Performance counter events (rv32_mtrap_csr mhpmcounter3..7)
+    logic ev_load;
+    logic ev_store;
+    logic ev_branch_taken;
+    logic ev_lsu_stall;
+    logic ev_wfi;
+
+    // Retirement trace (an RVFI subset), one record per instr_retire cycle. Nothing
+    // in the SoC reads it; the testbenches write it out with +TRACE=<file>.
+    logic        rvfi_valid;
+    logic [31:0] rvfi_pc;
+    logic [31:0] rvfi_insn;         // RV32C: the expanded instruction
+    logic        rvfi_c;            // 16-bit instruction
+    logic        rvfi_intr;         // first instruction retired after a trap was taken
+    logic [4:0]  rvfi_rd_addr;      // 0: no register write
+    logic [31:0] rvfi_rd_wdata;
+    logic        rvfi_mem_load;
+    logic        rvfi_mem_store;
+    logic [31:0] rvfi_mem_addr;
+    logic [31:0] rvfi_mem_data;     // load: value written to rd, store: the LSU word
+
+    logic        muldiv_start;
+    logic        muldiv_done;
+    logic [31:0] muldiv_result;
+
+
+    generate if (PIPELINE) begin : g_pipeline
+
+        rv32_pipeline #(
+            .ADDR_WIDTH_I(ADDR_WIDTH_I),
+            .N_EXT_IRQ(N_EXT_IRQ),
+            .RESET_MTVEC(RESET_MTVEC),
+            .RV32M(RV32M),
+            .EARLY_IRQ(EARLY_IRQ),
+            .RV32C(RV32C),
+            .HART_ID(HART_ID)
+        ) pipeline_ins (
+            .clk(clk),
+            .rst_n(rst_n),
+            .data_imem(data_imem),
+            .imem_addr(imem_addr),
+            .ifetch_addr(ifetch_addr),
+            .ifetch_req(ifetch_req),
+            .imem_valid(imem_valid),
+            .rready_cpu(rready_cpu),
+            .rvalid_cpu(rvalid_cpu),
+            .wready_cpu(wready_cpu),
+            .wvalid_cpu(wvalid_cpu),
+            .strb_cpu(strb_cpu),
+            .addr_cpu(addr_cpu),
+            .data_cpu_o(data_cpu_o),
+            .data_cpu_i(data_cpu_i),
+            .lsu_idle(lsu_idle),
+            .bus_err(bus_err),
+            .bus_err_addr(bus_err_addr),
+            .amo_lock(amo_lock),
+            .irq_software(irq_software),
+            .timer_irq(timer_irq),
+            .external_irq(external_irq),
+            .mtime(mtime),
+            .halt_req(halt_req),
+            .halted(halted),
+            .pc_output(pc_output),
+            .ir(ir),
+            .instr_retire(instr_retire),
+            .rvfi_pc(rvfi_pc),
+            .rvfi_c(rvfi_c),
+            .rvfi_intr(rvfi_intr),
+            .rvfi_rd_addr(rvfi_rd_addr),
+            .rvfi_rd_wdata(rvfi_rd_wdata),
+            .rvfi_mem_load(rvfi_mem_load),
+            .rvfi_mem_store(rvfi_mem_store),
+            .rvfi_mem_addr(rvfi_mem_addr),
+            .rvfi_mem_data(rvfi_mem_data)
+        );
+
+        // No FSM here: report S_WB on retiring cycles so cpu_state == 4 still marks a commit.
+        assign cpu_state = instr_retire ? 3'd4 : 3'd0;
+
+    end else begin : g_multicycle
 
     // Word-addressed memories (PC/result are byte addresses)
-    assign imem_addr = pc_output[ADDR_WIDTH_I+1:2];
+    // RV32C: a 32-bit instruction at pc[1] = 1 takes its high half from the next
+    // word, presented from the DECODE cycle that finds it until S_DECODE_HI has it.
+    assign fetch_pc = (RV32C && ((cpu_state == 3'd1 && imem_valid && ifetch_split) || cpu_state == 3'd6))
+                    ? (pc_output + 32'd4) : pc_output;
+    assign imem_addr = fetch_pc[ADDR_WIDTH_I+1:2];
+    assign ifetch_addr = fetch_pc;
+    // IR is latched in DECODE (cpu_state 1) and S_DECODE_HI (6), which wait for imem_valid.
+    assign ifetch_req = (cpu_state == 3'd1) || (cpu_state == 3'd6);
+
+    // RV32C: the half-word at the PC is a 16-bit instruction unless its low bits are 11.
+    assign fetch_half   = pc_output[1] ? data_imem[31:16] : data_imem[15:0];
+    assign fetch_c      = RV32C && (fetch_half[1:0] != 2'b11);
+    assign ifetch_split = RV32C && pc_output[1] && !fetch_c;
+    // WB -> DECODE when the next instruction is in the word still on imem (the
+    // second half of a word after a compressed one), unless the PC is redirected.
+    assign ifetch_hold  = (pc_output[31:2] == pc_ir[31:2]) && !take_trap && !take_return && !halt_req;
+
+    rv32c_expand expand_ins (
+        .instr_c(fetch_half),
+        .instr(fetch_exp)
+    );
     assign addr_cpu = alu_out;
 
     //////////////// ALU ////////////////
@@ -94,8 +239,6 @@ module ROC_RV32 #(
     assign op2 = alu_src2 ? imm_ext : do2;
     // MUX for ALU operand 1 PC (for AUIPC) or register
     assign op1 = alu_src1 ? pc_ir : do1;
-    // IRQ
-    assign irq = |{timer_irq, external_irq};
     alu alu_ins(
         .op1(op1),
         .op2(op2),
@@ -104,7 +247,10 @@ module ROC_RV32 #(
     );
 
     // control unit
-    control_unit control_unit_ins(
+    control_unit #(
+        .RV32M(RV32M),
+        .RV32C(RV32C)
+    ) control_unit_ins(
         .clk(clk),
         .rst_n(rst_n),
         // From decoder
@@ -135,6 +281,10 @@ module ROC_RV32 #(
         .rvalid_cpu(rvalid_cpu),        // Read valid from LSU
         .wready_cpu(wready_cpu),        // Write ready from LSU
         .wvalid_cpu(wvalid_cpu),        // Write enable for LSU
+        .lsu_idle(lsu_idle),            // LSU write buffer drained (FENCE)
+        .imem_valid(imem_valid),        // Instruction word valid (I-cache hit)
+        .ifetch_split(ifetch_split),    // RV32C: instruction continues in the next word
+        .ifetch_hold(ifetch_hold),      // RV32C: next instruction already on imem
         .data_2_reg(data_2_reg),        // Data to register from ALU 00 Memory 01 PC 10 IMM 11 
         .branch_invert(branch_invert),  // Branch taken signal MUX control
 
@@ -142,10 +292,38 @@ module ROC_RV32 #(
         .data_cpu_i(data_cpu_i),        // Data to store after formatting
         .strb_cpu(strb_cpu),            // Byte write strobe for store
 
+        // RV32M unit
+        .muldiv_start(muldiv_start),
+        .muldiv_done(muldiv_done),
+
+        // AMO bus lock
+        .amo_lock(amo_lock),
+
         // Interrupt
-        .irq(irq)
+        .irq(irq),
+        .take_trap(take_trap),
+        .wfi_sleep(ev_wfi),
+        .halt_req(halt_req)
     );
 
+    assign halted = halt_req && (cpu_state == 3'd0); // held in S_FETCH
+
+    if (RV32M) begin : g_muldiv
+        rv32_muldiv muldiv_ins (
+            .clk(clk),
+            .rst_n(rst_n),
+            .start(muldiv_start),
+            .funct3(funct3),
+            .op1(do1),
+            .op2(do2),
+            .valid(muldiv_done),
+            .result(muldiv_result)
+        );
+    end else begin : g_no_muldiv
+        assign muldiv_done = 1'b0;
+        assign muldiv_result = 32'b0;
+    end
+
     // Decode minimal SYSTEM support needed by the machine-trap CSR block.
     // SYSTEM instructions are retired in WB in this core.
     always_comb begin
@@ -201,13 +379,14 @@ module ROC_RV32 #(
     // mtrap and CSR unit
     rv32_mtrap_csr #(
         .N_EXT_IRQ(N_EXT_IRQ),
-        .RESET_MTVEC(RESET_MTVEC)
+        .RESET_MTVEC(RESET_MTVEC),
+        .HART_ID(HART_ID)
     ) mtrap_csr_ins (
         .clk(clk),
         .rst_n(rst_n),
 
         // Interrupt lines from peripherals
-        .irq_software(1'b0),
+        .irq_software(irq_software),
         .irq_timer(timer_irq),
         .irq_external(external_irq),
 
@@ -218,15 +397,31 @@ module ROC_RV32 #(
         .csr_wdata(csr_wdata),
         .csr_rdata(csr_rdata),
 
-        // Trap decision point (commit point)
+        // Trap decision points: WB, and with EARLY_IRQ every FETCH (the PC is
+        // already the next instruction's in both; an mret resumes at its target)
         .instr_commit(cpu_state == 3'd4),
-        .actual_pc(pc_output),
+        .irq_point(cpu_state == 3'd4 || (EARLY_IRQ && cpu_state == 3'd0 && !halt_req)),
+        .actual_pc(mret_commit ? return_pc : pc_output),
+
+        // Counters
+        .mtime(mtime),
+        .instr_retire(instr_retire),
+        .ev_load(ev_load),
+        .ev_store(ev_store),
+        .ev_branch_taken(ev_branch_taken),
+        .ev_lsu_stall(ev_lsu_stall),
+        .ev_wfi(ev_wfi),
+
+        // Late write errors
+        .bus_err(bus_err),
+        .bus_err_addr(bus_err_addr),
 
         // Trap control outputs to CPU
         .take_trap(take_trap),
         .trap_pc(trap_pc),
         .take_return(take_return),
-        .return_pc(return_pc)
+        .return_pc(return_pc),
+        .irq_wake(irq)
     );
 
     // decoder
@@ -246,7 +441,7 @@ module ROC_RV32 #(
     );
 
     // program counter
-    assign pc_ir_plus4 = pc_ir + 32'd4;
+    assign pc_ir_next = pc_ir + (ir_c ? 32'd2 : 32'd4);
     pc program_counter (
         .clk(clk),
         .rst_n(rst_n),
@@ -259,6 +454,7 @@ module ROC_RV32 #(
         .take_return(take_return),
         .return_pc(return_pc),
         .pc_ir(pc_ir),
+        .pc_ir_next(pc_ir_next),
         .imm_ext(imm_ext),
         .do1(do1),
         .pc_output(pc_output)
@@ -268,19 +464,34 @@ module ROC_RV32 #(
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             ir     <= 32'b0;
+            ir_c   <= 1'b0;
+            ir_lo  <= 16'b0;
             pc_ir  <= 32'b0;
             alu_out <= 32'b0;
         end else begin
-            // Latch instruction/PC during DECODE (imem dout is stable during FETCH)
+            // Latch instruction/PC during DECODE (imem dout is stable during FETCH);
+            // DECODE repeats until imem_valid, the last latch is the valid word.
             if (cpu_state == 3'd1) begin // S_DECODE
-                ir    <= data_imem;
+                ir    <= fetch_c ? fetch_exp : data_imem;
+                ir_c  <= fetch_c;
+                ir_lo <= fetch_half;
                 pc_ir <= pc_output;
             end
 
+            // RV32C split instruction: high half from the next word
+            if (RV32C && cpu_state == 3'd6) begin // S_DECODE_HI
+                ir <= {data_imem[15:0], ir_lo};
+            end
+
             // Latch ALU result during EXEC
             if (cpu_state == 3'd2) begin // S_EXEC
                 alu_out <= result;
             end
+
+            // Latch the multiply/divide result in S_MULDIV
+            if (cpu_state == 3'd5 && muldiv_done) begin
+                alu_out <= muldiv_result;
+            end
         end
     end
 
@@ -292,7 +503,7 @@ module ROC_RV32 #(
             case (data_2_reg)
                 2'b00: reg_di = alu_out;      // From ALUOut
                 2'b01: reg_di = load_ext;     // From Memory (extended)
-                2'b10: reg_di = pc_ir_plus4;  // From instr PC + 4
+                2'b10: reg_di = pc_ir_next;   // From instr PC + 4 (+ 2 if compressed)
                 2'b11: reg_di = imm_ext;      // From IMM
                 default: reg_di = 32'b0;
             endcase
@@ -310,4 +521,45 @@ module ROC_RV32 #(
         .do2(do2)
     );
 
+    // Branches, stores and WFI finish without a WB state.
+    assign instr_retire = (cpu_state == 3'd4)
+                        | (cpu_state == 3'd2 && (opcode == OPC_BRANCH || ir == INSN_WFI))
+                        | (cpu_state == 3'd3 && opcode == OPC_STORE && wvalid_cpu && wready_cpu);
+
+    assign ev_load         = (cpu_state == 3'd4) && opcode == OPC_LOAD;
+    assign ev_store        = (cpu_state == 3'd3) && opcode == OPC_STORE && wvalid_cpu && wready_cpu;
+    assign ev_branch_taken = (cpu_state == 3'd2) && opcode == OPC_BRANCH && (result[0] ^ branch_invert);
+
+    // Retirement trace: loads retire in WB, stores in S_MEM (alu_out is the address).
+    logic intr_pend;
+
+    assign rvfi_pc        = pc_ir;
+    assign rvfi_c         = ir_c;
+    assign rvfi_intr      = intr_pend;
+    assign rvfi_rd_addr   = wena_reg ? rd : 5'd0;
+    assign rvfi_rd_wdata  = reg_di;
+    assign rvfi_mem_load  = (opcode == OPC_LOAD);
+    assign rvfi_mem_store = (opcode == OPC_STORE);
+    assign rvfi_mem_addr  = (rvfi_mem_load || rvfi_mem_store) ? alu_out : 32'b0;
+    assign rvfi_mem_data  = rvfi_mem_store ? data_cpu_o : rvfi_mem_load ? load_ext : 32'b0;
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            intr_pend <= 1'b0;
+        end else if (take_trap) begin
+            intr_pend <= 1'b1;
+        end else if (instr_retire) begin
+            intr_pend <= 1'b0;
+        end
+    end
+
+    end endgenerate
+
+    // Same condition as the pipeline's mhpmcounter6 event. DMEM answers in the cycle
+    // the request is raised; only AXI slaves stall.
+    assign ev_lsu_stall = (rready_cpu && !rvalid_cpu) || (wvalid_cpu && !wready_cpu);
+
+    assign rvfi_valid = instr_retire;
+    assign rvfi_insn  = ir;
+
 endmodule
@@ -1,7 +1,12 @@
 import alu_ops_pkg::*;
 import rv32_opcodes_pkg::*;
 
-module control_unit(
+module control_unit #(
+    // 1: decode RV32M (funct7 == 0000001) and run it on the muldiv unit
+    parameter bit RV32M = 1'b0,
+    // 1: RV32C, 32-bit instructions may straddle two IMEM words (S_DECODE_HI)
+    parameter bit RV32C = 1'b0
+) (
     input logic        clk,
     input logic        rst_n,
     // From decoder
@@ -34,6 +39,12 @@ module control_unit(
     input   logic       rvalid_cpu,   // Read valid from lsu
     input   logic       wready_cpu,   // Write ready from lsu
     output logic        wvalid_cpu,   // Write enable for lsu
+    input   logic       lsu_idle,     // No posted MMIO write pending (FENCE)
+    input   logic       imem_valid,   // Instruction word valid (held low on an I-cache miss)
+    // RV32C: the instruction being decoded continues in the next word
+    input   logic       ifetch_split,
+    // RV32C: the next instruction is in the word already on imem (WB skips FETCH)
+    input   logic       ifetch_hold,
     // Data to register from ALU 00 Memory 01 PC 10 IMM 11 
     output logic [1:0]  data_2_reg,
     // select if branch is taken or not since we only have in ALU
@@ -45,18 +56,59 @@ module control_unit(
     output logic [31:0] data_cpu_o,
     output logic [3:0]  strb_cpu,
 
+    // RV32M unit handshake
+    output logic        muldiv_start,
+    input  logic        muldiv_done,
+
+    // AMO in S_MEM: the other bus masters are held off from its read to the
+    // write's BRESP (axi_lite_arbiter m*_lock)
+    output logic        amo_lock,
+
     // Interrupt
-    input logic        irq
+    input logic        irq,
+    // Interrupt taken in FETCH (EARLY_IRQ): the PC moves to the trap vector
+    input logic        take_trap,
+    // Sleeping in FETCH after WFI (performance counter event)
+    output logic       wfi_sleep,
+    // Debug halt: hold in FETCH (between instructions) while set
+    input logic        halt_req
 );
 
     localparam logic [2:0]
-        S_FETCH  = 3'd0,
-        S_DECODE = 3'd1,
-        S_EXEC   = 3'd2,
-        S_MEM    = 3'd3,
-        S_WB     = 3'd4;
+        S_FETCH     = 3'd0,
+        S_DECODE    = 3'd1,
+        S_EXEC      = 3'd2,
+        S_MEM       = 3'd3,
+        S_WB        = 3'd4,
+        S_MULDIV    = 3'd5,
+        S_DECODE_HI = 3'd6;
 
     logic wfi;
+    logic is_muldiv;
+    logic is_amo;
+
+    // AMO in S_MEM: read, write back, then wait for the write to leave the LSU
+    localparam logic [1:0]
+        AMO_READ  = 2'd0,
+        AMO_WRITE = 2'd1,
+        AMO_DRAIN = 2'd2;
+
+    logic [1:0]  amo_phase;
+    logic [31:0] amo_old;       // word read, written to rd in WB
+    logic [31:0] amo_result;
+
+    assign is_muldiv    = RV32M && opcode == OPC_OP && funct7 == 7'b0000001;
+    assign muldiv_start = (cpu_state == S_EXEC) && is_muldiv;
+    assign is_amo       = opcode == OPC_AMO && amo_supported(funct3, funct7[6:2]);
+    assign amo_lock     = (cpu_state == S_MEM) && is_amo;
+
+    rv32_amo_alu amo_alu_ins (
+        .funct5(funct7[6:2]),
+        .old(amo_old),
+        .rs2(rs2_data),
+        .result(amo_result)
+    );
+    assign wfi_sleep    = (cpu_state == S_FETCH) && wfi;
 
     // Fully sequential FSM (multi-cycle, no pipeline)
     // Note: opcode/funct* are stable because the top-level latches IR.
@@ -66,6 +118,8 @@ module control_unit(
             rready_cpu <= 0;
             wvalid_cpu <= 0;
             wfi <= 0;
+            amo_phase <= AMO_READ;
+            amo_old <= 32'b0;
         end else begin
             // Default deassertions each cycle; asserted only in S_MEM.
             rready_cpu <= 1'b0;
@@ -82,10 +136,23 @@ module control_unit(
                     if (!wfi) begin
                         cpu_state <= S_DECODE;
                     end
+
+                    if (halt_req) begin
+                        cpu_state <= S_FETCH;
+                    end
+
+                    // The word on imem is for the old PC: fetch again at the vector.
+                    if (take_trap) begin
+                        wfi <= 0;
+                        cpu_state <= S_FETCH;
+                    end
                 end
 
-                // In DECODE, the top-level latches IR <= imem_dout.
-                S_DECODE: cpu_state <= S_EXEC;
+                // In DECODE, the top-level latches IR <= imem_dout (stays here on an I-cache miss).
+                S_DECODE: if (imem_valid) cpu_state <= (RV32C && ifetch_split) ? S_DECODE_HI : S_EXEC;
+
+                // RV32C: the top-level latches the high half of IR from the next word.
+                S_DECODE_HI: if (imem_valid) cpu_state <= S_EXEC;
 
                 // Execute: compute ALU/compare and decide if memory/WB is needed.
                 S_EXEC: begin
@@ -93,10 +160,14 @@ module control_unit(
                        && rs1 == 5'b00000 && rd == 5'b00000) begin
                         wfi <= 1'b1; // WFI instruction: enter WFI state until next interrupt
                         cpu_state <= S_FETCH;
+                    end else if (is_muldiv) begin
+                        cpu_state <= S_MULDIV; // operands go to the muldiv unit this cycle
                     end else begin
                         unique case (opcode)
                             OPC_LOAD:   cpu_state <= S_MEM;   // LOAD
                             OPC_STORE:  cpu_state <= S_MEM;   // STORE
+                            OPC_MISC_MEM: cpu_state <= S_MEM; // FENCE (drain posted writes)
+                            OPC_AMO:    cpu_state <= is_amo ? S_MEM : S_WB;
                             OPC_BRANCH: cpu_state <= S_FETCH; // BRANCH (no WB)
                             default:    cpu_state <= S_WB;    // ALU/JAL/JALR/LUI/AUIPC
                         endcase
@@ -104,8 +175,35 @@ module control_unit(
                 end
 
                 // Memory access: for LOAD we need a WB cycle; for STORE we're done.
+                // FENCE waits here until the LSU write buffer is empty.
+                // AMO: a load, a store of amo_result to the same word, then the FENCE
+                // wait, so the write has reached the slave before amo_lock drops.
                 S_MEM: begin
-                    if (opcode == OPC_LOAD) begin
+                    if (is_amo) begin
+                        unique case (amo_phase)
+                            AMO_READ: begin
+                                rready_cpu <= 1'b1;
+                                if (rvalid_cpu & rready_cpu) begin
+                                    rready_cpu <= 1'b0;
+                                    amo_old <= data_cpu_i;
+                                    amo_phase <= AMO_WRITE;
+                                end
+                            end
+                            AMO_WRITE: begin
+                                wvalid_cpu <= 1'b1;
+                                if (wready_cpu & wvalid_cpu) begin
+                                    wvalid_cpu <= 1'b0;
+                                    amo_phase <= AMO_DRAIN;
+                                end
+                            end
+                            default: begin
+                                if (lsu_idle) begin
+                                    amo_phase <= AMO_READ;
+                                    cpu_state <= S_WB;
+                                end
+                            end
+                        endcase
+                    end else if (opcode == OPC_LOAD) begin
                         rready_cpu <= 1'b1;
                         if (rvalid_cpu & rready_cpu) begin
                             rready_cpu <= 1'b0;
@@ -117,13 +215,24 @@ module control_unit(
                             wvalid_cpu <= 1'b0;
                             cpu_state <= S_FETCH;
                         end
+                    end else if (opcode == OPC_MISC_MEM) begin
+                        if (lsu_idle) begin
+                            cpu_state <= S_WB;
+                        end
                     end else begin
                         cpu_state <= S_FETCH;
                     end
                 end
 
-                // Writeback then fetch next.
-                S_WB:    cpu_state <= S_FETCH;
+                // Wait for the multiply/divide result (top-level latches it into ALUOut).
+                S_MULDIV: begin
+                    if (muldiv_done) begin
+                        cpu_state <= S_WB;
+                    end
+                end
+
+                // Writeback then fetch next, unless the next instruction is already on imem.
+                S_WB:    cpu_state <= (RV32C && ifetch_hold) ? S_DECODE : S_FETCH;
 
                 default: cpu_state <= S_FETCH;
             endcase
@@ -181,9 +290,10 @@ module control_unit(
                 endcase
             end
 
-            // Address/rs1+imm math
+            // Address/rs1+imm math (AMO: imm_ext is 0)
             OPC_LOAD,
             OPC_STORE,
+            OPC_AMO,
             OPC_JALR: begin
                 alu_src1 = 1'b0;
                 alu_src2 = 1'b1;
@@ -227,7 +337,8 @@ module control_unit(
 
         if (cpu_state == S_WB) begin
             unique case (opcode)
-                OPC_LOAD: data_2_reg = 2'b01; // LOAD -> Memory
+                OPC_LOAD,
+                OPC_AMO:  data_2_reg = 2'b01; // LOAD/AMO -> Memory
                 OPC_JAL,
                 OPC_JALR: data_2_reg = 2'b10; // JAL/JALR -> PC+4
                 OPC_LUI:  data_2_reg = 2'b11; // LUI -> IMM
@@ -253,6 +364,7 @@ module control_unit(
                 OPC_JALR:   wena_reg = 1'b1; // JALR
                 OPC_LUI:    wena_reg = 1'b1; // LUI
                 OPC_AUIPC:  wena_reg = 1'b1; // AUIPC
+                OPC_AMO:    wena_reg = is_amo; // AMO writes the old word to rd
                 OPC_SYSTEM: wena_reg = (funct3 != 3'b000); // CSR* writes old CSR to rd
                 default:    wena_reg = 1'b0;
             endcase
@@ -306,7 +418,9 @@ module control_unit(
     // Load sign/zero extension based on funct3 and byte offset (alu_out is byte address)
     always_comb begin
         load_ext = data_cpu_i;
-        if (opcode == OPC_LOAD) begin
+        if (is_amo) begin
+            load_ext = amo_old;
+        end else if (opcode == OPC_LOAD) begin
             unique case (funct3)
                 3'b000: begin // LB
                     unique case (alu_out[1:0])
@@ -350,7 +464,10 @@ module control_unit(
         data_cpu_o = rs2_data;
         strb_cpu  = 4'b0000;
 
-        if (opcode == OPC_STORE) begin
+        if (is_amo) begin
+            data_cpu_o = amo_result;
+            strb_cpu  = 4'b1111;
+        end else if (opcode == OPC_STORE) begin
             unique case (funct3)
                 3'b010: begin // SW
                     data_cpu_o = rs2_data;
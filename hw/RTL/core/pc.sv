@@ -12,6 +12,7 @@ module pc(
     input  logic        take_return,
     input  logic [31:0] return_pc,
     input  logic [31:0] pc_ir,
+    input  logic [31:0] pc_ir_next,     // pc_ir + instruction length (4, or 2 for RV32C)
     input  logic [31:0] imm_ext,
     input  logic [31:0] do1,
     output logic [31:0] pc_output
@@ -30,19 +31,19 @@ module pc(
         end else if (take_return) begin
             pc_next = return_pc;
         end else begin
-            pc_next = pc_ir + 32'd4;
+            pc_next = pc_ir_next;
             unique case (opcode)
-                // if branch taken, pc_next = pc_ir + imm_ext else pc_ir + 4
+                // if branch taken, pc_next = pc_ir + imm_ext else the next instruction
                 // if(condition) pc = target else pc = pc + 4
                 OPC_BRANCH: begin
                     branch_taken = (result[0] ^ branch_invert);
                     pc_next = branch_taken ? (pc_ir + imm_ext)
-                                           : (pc_ir + 32'd4);
+                                           : pc_ir_next;
                 end
                 // Jump and link
                 OPC_JAL:  pc_next = pc_ir + imm_ext;
                 OPC_JALR: pc_next = (do1 + imm_ext) & 32'hFFFF_FFFE;
-                default:  pc_next = pc_ir + 32'd4;
+                default:  pc_next = pc_ir_next;
             endcase
         end
     end
@@ -0,0 +1,31 @@
+import rv32_opcodes_pkg::*;
+
+// A extension AMO*.W: the word written back for funct5 from the word read
+// (old, which goes to rd) and rs2. Combinational; both cores hold old and rs2
+// in registers across the read and write phases of S_MEM.
+// rv32_opcodes_pkg::amo_supported() is the decode check: funct3 010 and one of
+// the nine AMOs. LR.W/SC.W and the other funct5 values are not implemented and
+// run as a no-op like any other unknown encoding in this core.
+module rv32_amo_alu (
+    input  logic [4:0]  funct5,
+    input  logic [31:0] old,
+    input  logic [31:0] rs2,
+    output logic [31:0] result
+);
+
+    always_comb begin
+        unique case (funct5)
+            AMO_SWAP: result = rs2;
+            AMO_ADD:  result = old + rs2;
+            AMO_XOR:  result = old ^ rs2;
+            AMO_AND:  result = old & rs2;
+            AMO_OR:   result = old | rs2;
+            AMO_MIN:  result = ($signed(old) < $signed(rs2)) ? old : rs2;
+            AMO_MAX:  result = ($signed(old) < $signed(rs2)) ? rs2 : old;
+            AMO_MINU: result = (old < rs2) ? old : rs2;
+            AMO_MAXU: result = (old < rs2) ? rs2 : old;
+            default:  result = old;
+        endcase
+    end
+
+endmodule
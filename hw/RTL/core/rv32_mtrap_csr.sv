@@ -1,6 +1,9 @@
 module rv32_mtrap_csr #(
+    // At most 8: the vectored causes 24..31 are the last ones below 32
     parameter int N_EXT_IRQ = 8,
-    parameter logic [31:0] RESET_MTVEC = 32'h0000_1000
+    parameter logic [31:0] RESET_MTVEC = 32'h0000_1000,
+    // Read-only mhartid
+    parameter logic [31:0] HART_ID = 32'd0
 ) (
     input  logic                    clk,
     input  logic                    rst_n,
@@ -19,34 +22,81 @@ module rv32_mtrap_csr #(
     input  logic [31:0]             csr_wdata,
     output logic [31:0]             csr_rdata,
 
-    // Trap decision point (commit point)
+    // mret decision point (commit point)
     input  logic                    instr_commit,
+    // Interrupt decision point: every commit, plus (EARLY_IRQ cores) boundaries with
+    // nothing in flight. actual_pc is the PC to resume at (mepc).
+    input  logic                    irq_point,
     input  logic [31:0]             actual_pc,
 
+    // Counter inputs: CLINT mtime (for time/timeh), retire and per-cycle events
+    input  logic [63:0]             mtime,
+    input  logic                    instr_retire,
+    input  logic                    ev_load,            // load retired
+    input  logic                    ev_store,           // store retired
+    input  logic                    ev_branch_taken,    // conditional branch taken
+    input  logic                    ev_lsu_stall,       // LSU request waiting for the handshake
+    input  logic                    ev_wfi,             // cycle spent sleeping in WFI
+
+    // Late write error from the LSU (posted MMIO store got SLVERR/DECERR)
+    input  logic                    bus_err,
+    input  logic [31:0]             bus_err_addr,
+
     // Trap control outputs to CPU
     output logic                    take_trap,
     output logic [31:0]             trap_pc,
     output logic                    take_return,
-    output logic [31:0]             return_pc
+    output logic [31:0]             return_pc,
+
+    // WFI wake-up: any pending interrupt enabled in mie (regardless of mstatus.MIE)
+    output logic                    irq_wake
 );
 
     localparam logic [11:0] CSR_MSTATUS = 12'h300;
     localparam logic [11:0] CSR_MIE     = 12'h304;
+    // MODE (bit 0): 0 direct, 1 vectored; bit 1 reads as 0
     localparam logic [11:0] CSR_MTVEC   = 12'h305;
     localparam logic [11:0] CSR_MEPC    = 12'h341;
     localparam logic [11:0] CSR_MCAUSE  = 12'h342;
     localparam logic [11:0] CSR_MIP     = 12'h344;
     localparam logic [11:0] CSR_EXT_INT = 12'hF00;
+    // Bus error: bit 0 pending (write 0 to clear), address of the first failed write
+    localparam logic [11:0] CSR_MBUSERR      = 12'hF01;
+    localparam logic [11:0] CSR_MBUSERR_ADDR = 12'hF02;
+    // Per-source enable of irq_external into MEIP (bit n gates line n). Only line 0 is
+    // enabled at reset, so software that just sets MIE.MEIE sees the old behaviour.
+    localparam logic [11:0] CSR_EXT_INT_EN   = 12'hF03;
+    // Per-source priority, 2 bits per line (line n at [2n+1:2n]); among the enabled
+    // pending lines the highest value wins, ties go to the lower line. Reset: all 0.
+    localparam logic [11:0] CSR_EXT_INT_PRIO = 12'hF04;
+    // Read-only claim: bit 31 set when an enabled line is pending, [4:0] the line the
+    // priority picks (the one a vectored trap would enter for).
+    localparam logic [11:0] CSR_EXT_INT_CLAIM = 12'hF05;
+    localparam logic [11:0] CSR_MCOUNTINHIBIT = 12'h320;
+    localparam logic [11:0] CSR_MHARTID = 12'hF14;
+
+    // Counters: mcycle (0), minstret (2) and mhpmcounter3..8 at 0xB00 + n
+    // (high halves at 0xB80 + n); read-only cycle/time/instret/hpmcounter
+    // shadows at 0xC00 + n / 0xC80 + n. Event of each mhpmcounter:
+    //   3 loads, 4 stores, 5 taken branches, 6 LSU stall cycles, 7 WFI cycles, 8 traps
+    localparam int N_HPM = 6;
+    localparam int HPM_IDX_W = $clog2(N_HPM);
+    localparam logic [31:0] MCOUNTINHIBIT_MASK = 32'h0000_01FD;
 
     localparam int MSTATUS_MIE_BIT = 3;
     localparam int MSTATUS_MPIE_BIT = 7;
     localparam int MIE_MSIE_BIT = 3;
     localparam int MIE_MTIE_BIT = 7;
     localparam int MIE_MEIE_BIT = 11;
+    localparam int MIE_BUSERR_BIT = 16;     // first platform-defined interrupt
 
     localparam logic [31:0] MCAUSE_MSI = 32'h8000_0003;
     localparam logic [31:0] MCAUSE_MTI = 32'h8000_0007;
     localparam logic [31:0] MCAUSE_MEI = 32'h8000_000B;
+    localparam logic [31:0] MCAUSE_BUSERR = 32'h8000_0010;
+    // Vectored mtvec (MODE = 1): external line n is reported as cause 24 + n and enters
+    // at its own vector; direct mode keeps MCAUSE_MEI for all lines.
+    localparam int MCAUSE_EXT_BASE = 24;
 
     logic [31:0] mstatus;
     logic [31:0] mie;
@@ -55,11 +105,40 @@ module rv32_mtrap_csr #(
     logic [31:0] mcause;
     logic [31:0] mip;
     logic [31:0] ext_int;
+    logic [N_EXT_IRQ-1:0] ext_int_en;
+    logic [2*N_EXT_IRQ-1:0] ext_int_prio;
+    logic [N_EXT_IRQ-1:0] ext_act;
+    logic        ext_sel_valid;
+    logic [4:0]  ext_sel;
+    logic        buserr_pend;
+    logic [31:0] buserr_addr;
+    logic        buserr_clr;
+
+    // Post-write view: the CSR values with the committing instruction's write applied
+    logic [31:0] mstatus_w;
+    logic [31:0] mie_w;
+    logic [31:0] mtvec_w;
+    logic [31:0] mip_w;
+    logic [N_EXT_IRQ-1:0] ext_int_en_w;
+    logic [2*N_EXT_IRQ-1:0] ext_int_prio_w;
+    logic [5:0]  ext_trap_sel;  // {valid, line} picked from the post-write enables/priorities
+
+    logic [63:0] mcycle;
+    logic [63:0] minstret;
+    logic [63:0] mhpmcounter [N_HPM];
+    logic [31:0] mcountinhibit;
+    logic [N_HPM-1:0] hpm_inc;
+
+    logic        cnt_space;     // csr_addr is a counter CSR (0xB00/0xB80/0xC00/0xC80 + 0..31)
+    logic        cnt_wena;
+    logic [4:0]  cnt_idx;
+    logic [63:0] cnt_rdata;
 
     logic global_ie;
     logic pend_swi;
     logic pend_tim;
     logic pend_ext;
+    logic pend_buserr;
     logic irq_take;
     logic [31:0] irq_mcause;
 
@@ -67,28 +146,95 @@ module rv32_mtrap_csr #(
         mip = 32'b0;
         mip[MIE_MSIE_BIT] = irq_software;
         mip[MIE_MTIE_BIT] = irq_timer;
-        mip[MIE_MEIE_BIT] = |irq_external;
+        mip[MIE_MEIE_BIT] = |(irq_external & ext_int_en);
+        mip[MIE_BUSERR_BIT] = buserr_pend;
     end
 
-    assign trap_pc = mtvec;
+    assign irq_wake = |(mip & mie);
     assign return_pc = mepc;
 
+    // The CSR write of the committing instruction always lands, and an interrupt taken
+    // at the same commit is decided on (and saves MPIE from) the written values, as if
+    // it came one cycle later. A `csrrci mstatus, 8` that commits with a pending
+    // interrupt therefore closes the critical section instead of being lost.
+    always_comb begin
+        mstatus_w = mstatus;
+        mie_w = mie;
+        mtvec_w = mtvec;
+        ext_int_en_w = ext_int_en;
+        ext_int_prio_w = ext_int_prio;
+
+        if (csr_wena) begin
+            unique case (csr_addr)
+                CSR_MSTATUS: begin
+                    mstatus_w[MSTATUS_MIE_BIT] = csr_wdata[MSTATUS_MIE_BIT];
+                    mstatus_w[MSTATUS_MPIE_BIT] = csr_wdata[MSTATUS_MPIE_BIT];
+                end
+                CSR_MIE: begin
+                    mie_w[MIE_MSIE_BIT] = csr_wdata[MIE_MSIE_BIT];
+                    mie_w[MIE_MTIE_BIT] = csr_wdata[MIE_MTIE_BIT];
+                    mie_w[MIE_MEIE_BIT] = csr_wdata[MIE_MEIE_BIT];
+                    mie_w[MIE_BUSERR_BIT] = csr_wdata[MIE_BUSERR_BIT];
+                end
+                CSR_MTVEC: mtvec_w = {csr_wdata[31:2], 1'b0, csr_wdata[0]};
+                CSR_EXT_INT_EN: ext_int_en_w = csr_wdata[N_EXT_IRQ-1:0];
+                CSR_EXT_INT_PRIO: ext_int_prio_w = csr_wdata[2*N_EXT_IRQ-1:0];
+                default: ;
+            endcase
+        end
+    end
+
+    always_comb begin
+        mip_w = mip;
+        mip_w[MIE_MEIE_BIT] = |(irq_external & ext_int_en_w);
+        mip_w[MIE_BUSERR_BIT] = buserr_pend && !buserr_clr;
+    end
+
+    // Vectored mode: BASE + 4 * cause, with BASE 128-byte aligned so the cause just
+    // fills bits [6:2] (no adder between the priority logic and the PC).
+    assign trap_pc = mtvec_w[0] ? {mtvec_w[31:7], irq_mcause[4:0], 2'b00} : {mtvec_w[31:2], 2'b00};
+
+    assign ext_act = irq_external & ext_int_en;
+
+    // {valid, line}: the active line with the highest priority, the lower line on a tie.
+    function automatic logic [5:0] ext_pick(input logic [N_EXT_IRQ-1:0] act,
+                                            input logic [2*N_EXT_IRQ-1:0] prio);
+        logic [1:0] best;
+        ext_pick = 6'd0;
+        best = 2'd0;
+        for (int i = 0; i < N_EXT_IRQ; i++) begin
+            if (act[i] && (!ext_pick[5] || prio[2*i +: 2] > best)) begin
+                ext_pick = {1'b1, 5'(i)};
+                best = prio[2*i +: 2];
+            end
+        end
+    endfunction
+
+    // The claim CSR reads the registered state (its read feeds csr_wdata); the trap
+    // cause comes from the post-write enables and priorities.
+    assign {ext_sel_valid, ext_sel} = ext_pick(ext_act, ext_int_prio);
+    assign ext_trap_sel = ext_pick(irq_external & ext_int_en_w, ext_int_prio_w);
+
     always_comb begin
-        global_ie = mstatus[MSTATUS_MIE_BIT];
+        global_ie = mstatus_w[MSTATUS_MIE_BIT];
 
-        pend_swi = global_ie & mie[MIE_MSIE_BIT] & mip[MIE_MSIE_BIT];
-        pend_tim = global_ie & mie[MIE_MTIE_BIT] & mip[MIE_MTIE_BIT];
-        pend_ext = global_ie & mie[MIE_MEIE_BIT] & mip[MIE_MEIE_BIT];
+        pend_swi = global_ie & mie_w[MIE_MSIE_BIT] & mip_w[MIE_MSIE_BIT];
+        pend_tim = global_ie & mie_w[MIE_MTIE_BIT] & mip_w[MIE_MTIE_BIT];
+        pend_ext = global_ie & mie_w[MIE_MEIE_BIT] & mip_w[MIE_MEIE_BIT];
+        pend_buserr = global_ie & mie_w[MIE_BUSERR_BIT] & mip_w[MIE_BUSERR_BIT];
     end
 
-    // Interrupt priority: external > timer > software.
+    // Interrupt priority: bus error > external > timer > software.
     always_comb begin
         irq_take = 1'b0;
         irq_mcause = 32'b0;
 
-        if (pend_ext) begin
+        if (pend_buserr) begin
+            irq_take = 1'b1;
+            irq_mcause = MCAUSE_BUSERR;
+        end else if (pend_ext) begin
             irq_take = 1'b1;
-            irq_mcause = MCAUSE_MEI;
+            irq_mcause = mtvec_w[0] ? 32'h8000_0000 | 32'(MCAUSE_EXT_BASE + ext_trap_sel[4:0]) : MCAUSE_MEI;
         end else if (pend_tim) begin
             irq_take = 1'b1;
             irq_mcause = MCAUSE_MTI;
@@ -98,10 +244,24 @@ module rv32_mtrap_csr #(
         end
     end
 
-    // Traps are accepted only at instruction commit boundaries.
-    assign take_trap = instr_commit & irq_take;
+    // Interrupts are accepted only at instruction boundaries (irq_point).
+    assign take_trap = irq_point & irq_take;
     assign take_return = instr_commit & mret_commit;
 
+    always_comb begin
+        cnt_rdata = 64'b0;
+        if (cnt_idx == 5'd0) begin
+            cnt_rdata = mcycle;
+        end else if (cnt_idx == 5'd1) begin
+            // time exists only as the user shadow
+            cnt_rdata = (csr_addr[11:8] == 4'hC) ? mtime : 64'b0;
+        end else if (cnt_idx == 5'd2) begin
+            cnt_rdata = minstret;
+        end else if (cnt_idx >= 5'd3 && cnt_idx < 5'(3 + N_HPM)) begin
+            cnt_rdata = mhpmcounter[HPM_IDX_W'(cnt_idx - 5'd3)];
+        end
+    end
+
     always_comb begin
         csr_rdata = 32'b0;
         unique case (csr_addr)
@@ -112,48 +272,134 @@ module rv32_mtrap_csr #(
             CSR_MCAUSE:  csr_rdata = mcause;
             CSR_MIP:     csr_rdata = mip;
             CSR_EXT_INT: csr_rdata = ext_int;
-            default:     csr_rdata = 32'b0;
+            CSR_EXT_INT_EN: csr_rdata = {{32-N_EXT_IRQ{1'b0}}, ext_int_en};
+            CSR_EXT_INT_PRIO: csr_rdata = 32'(ext_int_prio);
+            CSR_EXT_INT_CLAIM: csr_rdata = {ext_sel_valid, 26'b0, ext_sel};
+            CSR_MBUSERR: csr_rdata = {31'b0, buserr_pend};
+            CSR_MBUSERR_ADDR: csr_rdata = buserr_addr;
+            CSR_MCOUNTINHIBIT: csr_rdata = mcountinhibit;
+            CSR_MHARTID: csr_rdata = HART_ID;
+            default: begin
+                if (cnt_space)
+                    csr_rdata = csr_addr[7] ? cnt_rdata[63:32] : cnt_rdata[31:0];
+                else
+                    csr_rdata = 32'b0;
+            end
         endcase
     end
 
-    // Priority: trap > mret > software CSR write.
+    // The write lands first; a trap or mret at the same commit updates on top of it
+    // (mret never writes a CSR itself).
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             mstatus <= 32'b0;
             mie <= 32'b0;
-            mtvec <= {RESET_MTVEC[31:2], 2'b00};
+            mtvec <= {RESET_MTVEC[31:2], 1'b0, RESET_MTVEC[0]};
             mepc <= 32'b0;
             mcause <= 32'b0;
         end else begin
+            mstatus <= mstatus_w;
+            mie <= mie_w;
+            mtvec <= mtvec_w;
+            if (csr_wena && csr_addr == CSR_MEPC)
+                mepc <= {csr_wdata[31:1], 1'b0};
+            if (csr_wena && csr_addr == CSR_MCAUSE)
+                mcause <= csr_wdata;
+
             if (take_trap) begin
                 mepc <= {actual_pc[31:1], 1'b0};
                 mcause <= irq_mcause;
 
-                mstatus[MSTATUS_MPIE_BIT] <= mstatus[MSTATUS_MIE_BIT];
+                mstatus[MSTATUS_MPIE_BIT] <= mstatus_w[MSTATUS_MIE_BIT];
                 mstatus[MSTATUS_MIE_BIT] <= 1'b0;
             end else if (take_return) begin
                 mstatus[MSTATUS_MIE_BIT] <= mstatus[MSTATUS_MPIE_BIT];
                 mstatus[MSTATUS_MPIE_BIT] <= 1'b1;
-            end else if (csr_wena) begin
-                unique case (csr_addr)
-                    CSR_MSTATUS: begin
-                        mstatus[MSTATUS_MIE_BIT] <= csr_wdata[MSTATUS_MIE_BIT];
-                        mstatus[MSTATUS_MPIE_BIT] <= csr_wdata[MSTATUS_MPIE_BIT];
-                    end
-                    CSR_MIE: begin
-                        mie[MIE_MSIE_BIT] <= csr_wdata[MIE_MSIE_BIT];
-                        mie[MIE_MTIE_BIT] <= csr_wdata[MIE_MTIE_BIT];
-                        mie[MIE_MEIE_BIT] <= csr_wdata[MIE_MEIE_BIT];
-                    end
-                    CSR_MTVEC: mtvec <= {csr_wdata[31:2], 2'b00};
-                    CSR_MEPC: mepc <= {csr_wdata[31:1], 1'b0};
-                    CSR_MCAUSE: mcause <= csr_wdata;
-                    default: ;
-                endcase
             end
         end
     end
 
+    // Performance counters. A CSR write to a counter half wins over its increment.
+    assign cnt_space = (csr_addr[11:8] == 4'hB || csr_addr[11:8] == 4'hC) && csr_addr[6:5] == 2'b00;
+    assign cnt_idx   = csr_addr[4:0];
+    // The write lands like any other CSR write; mhpmcounter8 does not count a trap
+    // taken at the commit that writes it, and the trap counts under the old mcountinhibit.
+    assign cnt_wena  = csr_wena && csr_addr[11:8] == 4'hB && csr_addr[6:5] == 2'b00;
+
+    assign hpm_inc = {take_trap, ev_wfi, ev_lsu_stall, ev_branch_taken, ev_store, ev_load};
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            mcountinhibit <= 32'b0;
+        end else if (csr_wena && csr_addr == CSR_MCOUNTINHIBIT) begin
+            mcountinhibit <= csr_wdata & MCOUNTINHIBIT_MASK;
+        end
+    end
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            mcycle <= 64'b0;
+            minstret <= 64'b0;
+        end else begin
+            if (cnt_wena && cnt_idx == 5'd0)
+                mcycle <= csr_addr[7] ? {csr_wdata, mcycle[31:0]} : {mcycle[63:32], csr_wdata};
+            else if (!mcountinhibit[0])
+                mcycle <= mcycle + 64'd1;
+
+            if (cnt_wena && cnt_idx == 5'd2)
+                minstret <= csr_addr[7] ? {csr_wdata, minstret[31:0]} : {minstret[63:32], csr_wdata};
+            else if (!mcountinhibit[2] && instr_retire)
+                minstret <= minstret + 64'd1;
+        end
+    end
+
+    for (genvar i = 0; i < N_HPM; i++) begin : g_hpm
+        always_ff @(posedge clk or negedge rst_n) begin
+            if (!rst_n) begin
+                mhpmcounter[i] <= 64'b0;
+            end else if (cnt_wena && cnt_idx == 5'(i + 3)) begin
+                mhpmcounter[i] <= csr_addr[7] ? {csr_wdata, mhpmcounter[i][31:0]}
+                                              : {mhpmcounter[i][63:32], csr_wdata};
+            end else if (!mcountinhibit[i + 3] && hpm_inc[i]) begin
+                mhpmcounter[i] <= mhpmcounter[i] + 64'd1;
+            end
+        end
+    end
+
+    // Bus error: sticky until software writes 0; keeps the first failing address.
+    // A new error in the clearing cycle wins.
+    assign buserr_clr = csr_wena && csr_addr == CSR_MBUSERR && !csr_wdata[0];
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            buserr_pend <= 1'b0;
+            buserr_addr <= 32'b0;
+        end else if (bus_err) begin
+            if (!buserr_pend || buserr_clr) buserr_addr <= bus_err_addr;
+            buserr_pend <= 1'b1;
+        end else if (buserr_clr) begin
+            buserr_pend <= 1'b0;
+        end
+    end
+
+    // A driver masks its own line (e.g. a TX-room interrupt with nothing left to send)
+    // without touching MIE.MEIE, which the other sources share.
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            ext_int_en <= N_EXT_IRQ'(1);
+        end else begin
+            ext_int_en <= ext_int_en_w;
+        end
+    end
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            ext_int_prio <= '0;
+        end else begin
+            ext_int_prio <= ext_int_prio_w;
+        end
+    end
+
     // Set external interrupt source 
 
     always_ff @(posedge clk or negedge rst_n) begin
@@ -0,0 +1,124 @@
+// RV32M multiply/divide unit.
+//
+// - start: one-cycle request; operands and funct3 are sampled on that edge.
+// - valid: result is ready; stays high (with result) until the next start.
+//
+// MUL/MULH/MULHSU/MULHU: operands registered on start, 33x33 signed product
+// registered on the next edge (valid 2 cycles after start, maps onto DSP48s).
+// DIV/DIVU/REM/REMU: restoring divider on magnitudes, one quotient bit per
+// cycle, plus a sign-fix cycle (valid 34 cycles after start). Division by zero
+// returns all ones / the dividend one cycle after start; the signed overflow
+// case (-2^31 / -1) falls out of the magnitude algorithm as -2^31 / 0.
+module rv32_muldiv (
+    input  logic        clk,
+    input  logic        rst_n,
+
+    input  logic        start,
+    input  logic [2:0]  funct3,
+    input  logic [31:0] op1,
+    input  logic [31:0] op2,
+
+    output logic        valid,
+    output logic [31:0] result
+);
+
+    typedef enum logic [1:0] {MD_IDLE, MD_MUL, MD_DIV, MD_FIX} md_state_t;
+    md_state_t state;
+
+    logic [2:0]  f3;
+    logic [32:0] mul_a;
+    logic [32:0] mul_b;
+    logic [65:0] product;
+
+    logic [31:0] quo;       // dividend magnitude shifting out, quotient shifting in
+    logic [32:0] rem;
+    logic [31:0] div;       // divisor magnitude
+    logic [5:0]  count;
+    logic        neg_quo;
+    logic        neg_rem;
+
+    logic        is_signed_div;
+    logic        op1_neg;
+    logic        op2_neg;
+    logic [32:0] rem_shift;
+    logic [32:0] rem_sub;
+
+    // MULH/MULHSU sign-extend op1, MULH sign-extends op2. Both are widened to
+    // the 66-bit product before the multiply.
+    assign product = 66'($signed(mul_a)) * 66'($signed(mul_b));
+
+    assign is_signed_div = (funct3 == 3'b100) || (funct3 == 3'b110); // DIV/REM
+    assign op1_neg = is_signed_div && op1[31];
+    assign op2_neg = is_signed_div && op2[31];
+
+    assign rem_shift = {rem[31:0], quo[31]};
+    assign rem_sub   = rem_shift - {1'b0, div};
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            state   <= MD_IDLE;
+            valid   <= 1'b0;
+            result  <= 32'b0;
+            f3      <= 3'b0;
+            mul_a   <= 33'b0;
+            mul_b   <= 33'b0;
+            quo     <= 32'b0;
+            rem     <= 33'b0;
+            div     <= 32'b0;
+            count   <= 6'd0;
+            neg_quo <= 1'b0;
+            neg_rem <= 1'b0;
+        end else if (start) begin
+            f3    <= funct3;
+            valid <= 1'b0;
+            if (!funct3[2]) begin
+                mul_a <= {(funct3 == 3'b001 || funct3 == 3'b010) & op1[31], op1};
+                mul_b <= {(funct3 == 3'b001) & op2[31], op2};
+                state <= MD_MUL;
+            end else if (op2 == 32'b0) begin
+                result <= funct3[1] ? op1 : 32'hFFFF_FFFF;
+                valid  <= 1'b1;
+                state  <= MD_IDLE;
+            end else begin
+                quo     <= op1_neg ? -op1 : op1;
+                div     <= op2_neg ? -op2 : op2;
+                rem     <= 33'b0;
+                count   <= 6'd32;
+                neg_quo <= op1_neg ^ op2_neg;
+                neg_rem <= op1_neg;
+                state   <= MD_DIV;
+            end
+        end else begin
+            unique case (state)
+                MD_MUL: begin
+                    result <= (f3 == 3'b000) ? product[31:0] : product[63:32];
+                    valid  <= 1'b1;
+                    state  <= MD_IDLE;
+                end
+                MD_DIV: begin
+                    if (!rem_sub[32]) begin
+                        rem <= rem_sub;
+                        quo <= {quo[30:0], 1'b1};
+                    end else begin
+                        rem <= rem_shift;
+                        quo <= {quo[30:0], 1'b0};
+                    end
+                    count <= count - 6'd1;
+                    if (count == 6'd1) begin
+                        state <= MD_FIX;
+                    end
+                end
+                MD_FIX: begin
+                    if (f3[1])
+                        result <= neg_rem ? -rem[31:0] : rem[31:0];
+                    else
+                        result <= neg_quo ? -quo : quo;
+                    valid <= 1'b1;
+                    state <= MD_IDLE;
+                end
+                default: ;
+            endcase
+        end
+    end
+
+endmodule
@@ -11,5 +11,25 @@ package rv32_opcodes_pkg;
     localparam logic [6:0] OPC_AUIPC  = 7'b0010111;
     localparam logic [6:0] OPC_LUI    = 7'b0110111;
     localparam logic [6:0] OPC_SYSTEM = 7'b1110011;
+    localparam logic [6:0] OPC_MISC_MEM = 7'b0001111;   // FENCE
+    localparam logic [6:0] OPC_AMO    = 7'b0101111;     // A extension (AMO*.W)
+
+    // AMO funct5 (funct7[6:2]); aq/rl (funct7[1:0]) are ignored, every AMO is
+    // ordered after the hart's earlier stores and completes before the next instruction.
+    localparam logic [4:0] AMO_ADD  = 5'b00000;
+    localparam logic [4:0] AMO_SWAP = 5'b00001;
+    localparam logic [4:0] AMO_XOR  = 5'b00100;
+    localparam logic [4:0] AMO_OR   = 5'b01000;
+    localparam logic [4:0] AMO_AND  = 5'b01100;
+    localparam logic [4:0] AMO_MIN  = 5'b10000;
+    localparam logic [4:0] AMO_MAX  = 5'b10100;
+    localparam logic [4:0] AMO_MINU = 5'b11000;
+    localparam logic [4:0] AMO_MAXU = 5'b11100;
+
+    // The AMOs this core implements (rv32_amo_alu): word size, no LR/SC.
+    function automatic logic amo_supported(input logic [2:0] funct3, input logic [4:0] funct5);
+        return funct3 == 3'b010 && funct5 inside {AMO_ADD, AMO_SWAP, AMO_XOR, AMO_OR, AMO_AND,
+                                                  AMO_MIN, AMO_MAX, AMO_MINU, AMO_MAXU};
+    endfunction
 
 endpackage
@@ -0,0 +1,970 @@
+import alu_ops_pkg::*;
+import rv32_opcodes_pkg::*;
+
+// Five-stage IF/ID/EX/MEM/WB implementation of the ROC_RV32 core.
+// Selected with ROC_RV32 #(.PIPELINE(1)); same IMEM, LSU and interrupt interface
+// as the multi-cycle core (control_unit.sv).
+//
+// - IF:  the synchronous IMEM is addressed with the next PC, so the instruction for
+//        id_pc is on data_imem while it sits in ID (a stall re-reads the same word).
+//        Behind the XMEM I-cache, ID also waits for imem_valid (miss refill).
+//        With RV32C, ID takes the half-word at id_pc and expands it (rv32c_expand);
+//        a 32-bit instruction at id_pc[1] = 1 keeps its low half in id_lo and
+//        waits in ID one more cycle while IF presents the next word.
+// - ID:  decode and register read with WB bypass. JAL redirects fetch from here.
+// - EX:  ALU with MEM/WB forwarding. Branches (predicted not taken) and JALR
+//        resolve here and squash the instruction in ID. With RV32M, MUL*/DIV*/REM*
+//        start rv32_muldiv on their forwarded operands and hold EX until it is done.
+// - MEM: same rready/wvalid sequence as control_unit S_MEM (deasserted in the first
+//        MEM cycle, held until the LSU handshake). Load data is only forwarded from
+//        WB, so a dependent instruction waits in EX (load-use interlock).
+//        FENCE holds MEM until the LSU has no posted MMIO write left (lsu_idle).
+//        An AMO runs a load, a store of the rv32_amo_alu result and the FENCE wait
+//        in MEM (amo_lock high throughout); its rd value is forwarded like a load's.
+// - WB:  register write, CSR access, mret and interrupt entry through
+//        rv32_mtrap_csr. SYSTEM instructions are serialized: they enter an empty
+//        pipeline and nothing younger issues until they retire.
+//
+// halt_req stops issue from ID; halted is raised once EX/MEM/WB have drained.
+//
+// Whenever WB holds an instruction, MEM is empty or in its first cycle (no LSU
+// request issued yet), so a trap at WB can flush MEM/EX/ID safely.
+// With EARLY_IRQ an interrupt is also taken while EX/MEM/WB are empty (asleep in
+// WFI, an I-cache miss, a SYSTEM drain): it squashes the instruction in ID, which
+// becomes mepc, instead of waiting for it to reach WB.
+module rv32_pipeline #(
+    parameter int ADDR_WIDTH_I = 10,
+    parameter int N_EXT_IRQ = 8,
+    parameter logic [31:0] RESET_MTVEC = 32'h0000_1000,
+    parameter bit RV32M = 1'b0,
+    parameter bit EARLY_IRQ = 1'b0,
+    parameter bit RV32C = 1'b0,
+    parameter logic [31:0] HART_ID = 32'd0
+) (
+    input  logic                    clk,
+    input  logic                    rst_n,
+    // instruction memory
+    input  logic [31:0]             data_imem,
+    output logic [ADDR_WIDTH_I-1:0] imem_addr,
+    output logic [31:0]             ifetch_addr,
+    output logic                    ifetch_req,
+    input  logic                    imem_valid,
+
+    // LSU
+    output logic                    rready_cpu,
+    input  logic                    rvalid_cpu,
+    input  logic                    wready_cpu,
+    output logic                    wvalid_cpu,
+    output logic [3:0]              strb_cpu,
+    output logic [31:0]             addr_cpu,
+    output logic [31:0]             data_cpu_o,
+    input  logic [31:0]             data_cpu_i,
+    input  logic                    lsu_idle,
+    input  logic                    bus_err,
+    input  logic [31:0]             bus_err_addr,
+    output logic                    amo_lock,
+    input  logic                    irq_software,
+    input  logic                    timer_irq,
+    input  logic [N_EXT_IRQ-1:0]    external_irq,
+    input  logic [63:0]             mtime,
+
+    // Debug halt
+    input  logic                    halt_req,
+    output logic                    halted,
+
+    // Observation
+    output logic [31:0]             pc_output,      // PC of the instruction in ID
+    output logic [31:0]             ir,             // instruction in WB
+    output logic                    instr_retire,   // WB retires an instruction this cycle
+
+    // Retirement trace of the instruction in WB (ROC_RV32 rvfi_*)
+    output logic [31:0]             rvfi_pc,
+    output logic                    rvfi_c,
+    output logic                    rvfi_intr,
+    output logic [4:0]              rvfi_rd_addr,
+    output logic [31:0]             rvfi_rd_wdata,
+    output logic                    rvfi_mem_load,
+    output logic                    rvfi_mem_store,
+    output logic [31:0]             rvfi_mem_addr,
+    output logic [31:0]             rvfi_mem_data
+);
+
+    localparam logic [31:0] INSN_MRET = 32'h3020_0073;
+    localparam logic [31:0] INSN_WFI  = 32'h1050_0073;
+
+    localparam logic [1:0]
+        AMO_READ  = 2'd0,
+        AMO_WRITE = 2'd1,
+        AMO_DRAIN = 2'd2;
+
+    logic irq;
+    logic wfi_sleep;
+
+    // Trap/CSR unit
+    logic        csr_wena;
+    logic [11:0] csr_addr;
+    logic [31:0] csr_wdata;
+    logic [31:0] csr_rdata;
+    logic        mret_commit;
+    logic        take_trap;
+    logic [31:0] trap_pc;
+    logic        take_return;
+    logic [31:0] return_pc;
+    logic        trap_flush;
+    logic        irq_early;     // EARLY_IRQ trap point: nothing older than ID in flight
+
+    // IF/ID
+    logic        id_valid;
+    logic [31:0] id_pc;
+    logic [31:0] pc_sel;
+    logic [31:0] fetch_pc;
+    logic        hi_fetch;      // RV32C: ID needs the word after id_pc next cycle
+    logic        id_hi_pend;    // RV32C: data_imem holds the high half of a split instruction
+    logic [15:0] id_lo;         // RV32C: its low half (upper half of the word at id_pc)
+
+    // ID
+    logic [15:0] id_half;
+    logic [31:0] id_exp;
+    logic        id_c;          // compressed: 2 bytes long
+    logic        id_split;      // 32-bit instruction that continues in the next word
+    logic [31:0] id_instr;      // expanded / reassembled instruction
+    logic [4:0]  id_rs1;
+    logic [4:0]  id_rs2;
+    logic [4:0]  id_rd;
+    logic [6:0]  id_opcode;
+    logic [2:0]  id_funct3;
+    logic [6:0]  id_funct7;
+    logic [11:0] id_imm_i;
+    logic [11:0] id_imm_s;
+    logic [12:0] id_imm_b;
+    logic [19:0] id_imm_u;
+    logic [20:0] id_imm_j;
+    logic [31:0] id_imm;
+    alu_ops_pkg::alu_op_t id_op;
+    logic        id_alu_src1;
+    logic        id_alu_src2;
+    logic        id_branch_invert;
+    logic        id_we;
+    logic [1:0]  id_wb_sel;
+    logic        id_uses_rs1;
+    logic        id_uses_rs2;
+    logic        id_is_load;
+    logic        id_is_store;
+    logic        id_is_branch;
+    logic        id_is_jal;
+    logic        id_is_jalr;
+    logic        id_is_system;
+    logic        id_is_muldiv;
+    logic        id_is_fence;
+    logic        id_is_amo;
+    logic [31:0] rf_do1;
+    logic [31:0] rf_do2;
+    logic [31:0] id_rs1_val;
+    logic [31:0] id_rs2_val;
+    logic        id_issue;
+    logic        sys_hazard;
+
+    // ID/EX
+    logic        ex_valid;
+    logic [31:0] ex_pc;
+    logic [31:0] ex_ir;
+    logic        ex_c;
+    logic [4:0]  ex_rs1;
+    logic [4:0]  ex_rs2;
+    logic [4:0]  ex_rd;
+    logic [31:0] ex_rs1_val;
+    logic [31:0] ex_rs2_val;
+    logic [31:0] ex_imm;
+    alu_ops_pkg::alu_op_t ex_op;
+    logic        ex_alu_src1;
+    logic        ex_alu_src2;
+    logic        ex_branch_invert;
+    logic        ex_we;
+    logic [1:0]  ex_wb_sel;
+    logic        ex_uses_rs1;
+    logic        ex_uses_rs2;
+    logic        ex_is_load;
+    logic        ex_is_store;
+    logic        ex_is_branch;
+    logic        ex_is_jal;
+    logic        ex_is_jalr;
+    logic        ex_is_system;
+    logic        ex_is_muldiv;
+    logic        ex_is_fence;
+    logic        ex_is_amo;
+
+    // EX
+    logic [31:0] ex_fwd1;
+    logic [31:0] ex_fwd2;
+    logic [31:0] ex_op1;
+    logic [31:0] ex_op2;
+    logic [31:0] ex_alu_result;
+    logic [31:0] ex_result;
+    logic [31:0] ex_target;
+    logic [31:0] ex_npc;
+    logic        ex_taken;
+    logic        ex_redirect;
+    logic        ex_stall;
+    logic        ex_to_mem;
+    logic        load_use;
+    logic        md_start;
+    logic        md_valid;
+    logic [31:0] md_result;
+    logic        md_wait;
+    logic        ex_md_started;
+
+    // EX/MEM
+    logic        mem_valid;
+    logic [31:0] mem_ir;
+    logic [4:0]  mem_rd;
+    logic [31:0] mem_result;    // ALU/link/LUI value, or the byte address for loads/stores
+    logic [31:0] mem_rs2_val;
+    logic [31:0] mem_npc;
+    logic [2:0]  mem_funct3;
+    logic        mem_we;
+    logic        mem_is_load;
+    logic        mem_is_store;
+    logic        mem_is_system;
+    logic        mem_is_fence;
+    logic        mem_is_amo;
+    logic [1:0]  mem_amo_phase; // AMO_READ, AMO_WRITE, AMO_DRAIN
+    logic [31:0] mem_amo_old;   // word read, written to rd
+    logic [31:0] mem_amo_result;
+    logic        mem_done;
+    logic        mem_stall;
+    logic [31:0] load_ext;
+    logic [31:0] mem_pc;        // trace only
+    logic        mem_c;
+
+    // MEM/WB
+    logic        wb_valid;
+    logic [31:0] wb_ir;
+    logic [4:0]  wb_rd;
+    logic [31:0] wb_result;     // rs1 value for SYSTEM (CSR write operand)
+    logic [31:0] wb_npc;
+    logic        wb_we;
+    logic        wb_is_system;
+    logic        wb_rf_we;
+    logic [31:0] wb_data;
+    // trace only
+    logic [31:0] wb_pc;
+    logic        wb_c;
+    logic        wb_is_load;
+    logic        wb_is_store;
+    logic [31:0] wb_addr;
+    logic [31:0] wb_sdata;
+    logic        intr_pend;
+
+    assign pc_output    = id_pc;
+    assign ir           = wb_ir;
+    assign instr_retire = wb_valid;
+
+    //////////////// IF ////////////////
+    // Priority: trap (WB, or ID with EARLY_IRQ)/mret at WB > branch/JALR at EX > JAL at ID > sequential.
+    // A stalled ID re-presents its own PC so data_imem keeps the same word, or the
+    // next one while a split RV32C instruction waits for its high half.
+    always_comb begin
+        hi_fetch = 1'b0;
+        if (take_trap) begin
+            pc_sel = trap_pc;
+        end else if (take_return) begin
+            pc_sel = return_pc;
+        end else if (ex_redirect) begin
+            pc_sel = ex_target;
+        end else if (id_issue) begin
+            pc_sel = id_is_jal ? (id_pc + id_imm) : (id_pc + (id_c ? 32'd2 : 32'd4));
+        end else begin
+            pc_sel = id_pc;
+            hi_fetch = RV32C && id_valid && (id_split || id_hi_pend);
+        end
+    end
+
+    assign fetch_pc    = hi_fetch ? (id_pc + 32'd4) : pc_sel;
+    assign imem_addr   = fetch_pc[ADDR_WIDTH_I+1:2];
+    assign ifetch_addr = fetch_pc;
+    // ID needs its word unless it is being squashed (no refill for a dead fetch).
+    assign ifetch_req  = id_valid && !ex_redirect && !trap_flush;
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            id_valid   <= 1'b0;
+            id_pc      <= 32'b0;
+            id_hi_pend <= 1'b0;
+            id_lo      <= 16'b0;
+        end else begin
+            id_valid   <= 1'b1;
+            id_pc      <= pc_sel;
+            id_hi_pend <= hi_fetch;
+            if (id_split)
+                id_lo <= data_imem[31:16];
+        end
+    end
+
+    //////////////// ID ////////////////
+    // RV32C: the half-word at id_pc selects a 16-bit or a 32-bit instruction.
+    if (RV32C) begin : g_rv32c
+        assign id_half  = id_pc[1] ? data_imem[31:16] : data_imem[15:0];
+        assign id_c     = !id_hi_pend && (id_half[1:0] != 2'b11);
+        assign id_split = id_valid && imem_valid && !id_hi_pend && id_pc[1] && !id_c;
+        assign id_instr = id_hi_pend ? {data_imem[15:0], id_lo} : (id_c ? id_exp : data_imem);
+
+        rv32c_expand expand_ins (
+            .instr_c(id_half),
+            .instr(id_exp)
+        );
+    end else begin : g_no_rv32c
+        assign id_half  = 16'b0;
+        assign id_exp   = 32'b0;
+        assign id_c     = 1'b0;
+        assign id_split = 1'b0;
+        assign id_instr = data_imem;
+    end
+
+    decoder decoder_ins(
+        .instruction(id_instr),
+        .rs1(id_rs1),
+        .rs2(id_rs2),
+        .rd(id_rd),
+        .opcode(id_opcode),
+        .funct3(id_funct3),
+        .funct7(id_funct7),
+        .imm_i(id_imm_i),
+        .imm_s(id_imm_s),
+        .imm_b(id_imm_b),
+        .imm_u(id_imm_u),
+        .imm_j(id_imm_j)
+    );
+
+    // ALU control + operand mux selects (same encoding as control_unit).
+    // SYSTEM computes rs1 + 0 so the CSR write operand travels down as the result.
+    always_comb begin
+        id_op = ADD;
+        id_alu_src1 = 1'b0; // 0: A=rs1, 1: A=pc
+        id_alu_src2 = 1'b0; // 0: B=rs2, 1: B=imm
+
+        unique case (id_opcode)
+            OPC_OP: begin
+                unique case ({id_funct7, id_funct3})
+                    10'b0000000_000: id_op = ADD;
+                    10'b0100000_000: id_op = SUB;
+                    10'b0000000_111: id_op = AND;
+                    10'b0000000_110: id_op = OR;
+                    10'b0000000_100: id_op = XOR;
+                    10'b0000000_001: id_op = SLL;
+                    10'b0000000_101: id_op = SRL;
+                    10'b0100000_101: id_op = SRA;
+                    10'b0000000_010: id_op = SLT;
+                    10'b0000000_011: id_op = SLTU;
+                    default:         id_op = ADD;
+                endcase
+            end
+
+            OPC_OP_IMM: begin
+                id_alu_src2 = 1'b1;
+                unique case (id_funct3)
+                    3'b000: id_op = ADD;   // ADDI
+                    3'b111: id_op = AND;   // ANDI
+                    3'b110: id_op = OR;    // ORI
+                    3'b100: id_op = XOR;   // XORI
+                    3'b010: id_op = SLT;   // SLTI
+                    3'b011: id_op = SLTU;  // SLTIU
+                    3'b001: id_op = SLL;   // SLLI
+                    3'b101: id_op = (id_funct7 == 7'b0100000) ? SRA : SRL; // SRAI/SRLI
+                    default: id_op = ADD;
+                endcase
+            end
+
+            OPC_LOAD,
+            OPC_STORE,
+            OPC_AMO,
+            OPC_JALR,
+            OPC_SYSTEM: begin
+                id_alu_src2 = 1'b1;
+                id_op = ADD;
+            end
+
+            OPC_AUIPC: begin
+                id_alu_src1 = 1'b1;
+                id_alu_src2 = 1'b1;
+                id_op = ADD;
+            end
+
+            OPC_BRANCH: begin
+                unique case (id_funct3)
+                    3'b000: id_op = SEQ;   // BEQ
+                    3'b001: id_op = SEQ;   // BNE (inverted)
+                    3'b100: id_op = SLT;   // BLT
+                    3'b101: id_op = SLT;   // BGE (inverted)
+                    3'b110: id_op = SLTU;  // BLTU
+                    3'b111: id_op = SLTU;  // BGEU (inverted)
+                    default: id_op = SEQ;
+                endcase
+            end
+
+            default: id_op = ADD;
+        endcase
+    end
+
+    // Immediate, writeback source and register write enable.
+    always_comb begin
+        unique case (id_opcode)
+            OPC_OP_IMM,
+            OPC_LOAD,
+            OPC_JALR:   id_imm = {{20{id_imm_i[11]}}, id_imm_i};
+            OPC_STORE:  id_imm = {{20{id_imm_s[11]}}, id_imm_s};
+            OPC_BRANCH: id_imm = {{19{id_imm_b[12]}}, id_imm_b};
+            OPC_LUI,
+            OPC_AUIPC:  id_imm = {id_imm_u, 12'b0};
+            OPC_JAL:    id_imm = {{11{id_imm_j[20]}}, id_imm_j};
+            default:    id_imm = 32'b0;
+        endcase
+
+        // Data to register from ALU 00 Memory 01 PC+4 10 IMM 11
+        unique case (id_opcode)
+            OPC_LOAD,
+            OPC_AMO:  id_wb_sel = 2'b01;
+            OPC_JAL,
+            OPC_JALR: id_wb_sel = 2'b10;
+            OPC_LUI:  id_wb_sel = 2'b11;
+            default:  id_wb_sel = 2'b00;
+        endcase
+
+        unique case (id_opcode)
+            OPC_OP,
+            OPC_OP_IMM,
+            OPC_LOAD,
+            OPC_JAL,
+            OPC_JALR,
+            OPC_LUI,
+            OPC_AUIPC:  id_we = 1'b1;
+            OPC_SYSTEM: id_we = (id_funct3 != 3'b000); // CSR* writes old CSR to rd
+            OPC_AMO:    id_we = id_is_amo;
+            default:    id_we = 1'b0;
+        endcase
+
+        // BNE/BGE/BGEU take the branch on a false compare.
+        id_branch_invert = (id_opcode == OPC_BRANCH) && id_funct3[0];
+    end
+
+    assign id_is_load   = (id_opcode == OPC_LOAD);
+    assign id_is_store  = (id_opcode == OPC_STORE);
+    assign id_is_branch = (id_opcode == OPC_BRANCH);
+    assign id_is_jal    = (id_opcode == OPC_JAL);
+    assign id_is_jalr   = (id_opcode == OPC_JALR);
+    assign id_is_system = (id_opcode == OPC_SYSTEM);
+    assign id_is_muldiv = RV32M && (id_opcode == OPC_OP) && (id_funct7 == 7'b0000001);
+    assign id_is_fence  = (id_opcode == OPC_MISC_MEM);
+    assign id_is_amo    = (id_opcode == OPC_AMO) && amo_supported(id_funct3, id_funct7[6:2]);
+    assign id_uses_rs1  = !(id_opcode inside {OPC_LUI, OPC_AUIPC, OPC_JAL});
+    assign id_uses_rs2  = (id_opcode inside {OPC_OP, OPC_STORE, OPC_BRANCH, OPC_AMO});
+
+    register_bank register_bank_ins(
+        .clk(clk),
+        .rst_n(rst_n),
+        .rs1(id_rs1),
+        .rs2(id_rs2),
+        .rd(wb_rd),
+        .di(wb_data),
+        .we(wb_rf_we),
+        .do1(rf_do1),
+        .do2(rf_do2)
+    );
+
+    // WB -> ID bypass (the register bank is written at the end of the WB cycle).
+    assign id_rs1_val = (wb_rf_we && wb_rd != 5'd0 && wb_rd == id_rs1) ? wb_data : rf_do1;
+    assign id_rs2_val = (wb_rf_we && wb_rd != 5'd0 && wb_rd == id_rs2) ? wb_data : rf_do2;
+
+    // SYSTEM instructions wait for an empty pipeline and block younger ones until they retire.
+    assign sys_hazard = (id_is_system && (ex_valid || mem_valid || wb_valid))
+                      || (ex_valid && ex_is_system)
+                      || (mem_valid && mem_is_system)
+                      || (wb_valid && wb_is_system);
+
+    assign id_issue = id_valid && imem_valid && !id_split && !ex_stall && !sys_hazard && !wfi_sleep && !halt_req;
+    assign halted   = halt_req && !ex_valid && !mem_valid && !wb_valid;
+
+    //////////////// EX ////////////////
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            ex_valid         <= 1'b0;
+            ex_pc            <= 32'b0;
+            ex_ir            <= 32'b0;
+            ex_c             <= 1'b0;
+            ex_rs1           <= 5'b0;
+            ex_rs2           <= 5'b0;
+            ex_rd            <= 5'b0;
+            ex_rs1_val       <= 32'b0;
+            ex_rs2_val       <= 32'b0;
+            ex_imm           <= 32'b0;
+            ex_op            <= ADD;
+            ex_alu_src1      <= 1'b0;
+            ex_alu_src2      <= 1'b0;
+            ex_branch_invert <= 1'b0;
+            ex_we            <= 1'b0;
+            ex_wb_sel        <= 2'b00;
+            ex_uses_rs1      <= 1'b0;
+            ex_uses_rs2      <= 1'b0;
+            ex_is_load       <= 1'b0;
+            ex_is_store      <= 1'b0;
+            ex_is_branch     <= 1'b0;
+            ex_is_jal        <= 1'b0;
+            ex_is_jalr       <= 1'b0;
+            ex_is_system     <= 1'b0;
+            ex_is_muldiv     <= 1'b0;
+            ex_is_fence      <= 1'b0;
+            ex_is_amo        <= 1'b0;
+        end else if (trap_flush || ex_redirect) begin
+            ex_valid <= 1'b0;
+        end else if (ex_stall) begin
+            // Keep the operands current while waiting (older results retire meanwhile).
+            ex_rs1_val <= ex_fwd1;
+            ex_rs2_val <= ex_fwd2;
+        end else begin
+            ex_valid <= id_issue;
+            if (id_issue) begin
+                ex_pc            <= id_pc;
+                ex_ir            <= id_instr;
+                ex_c             <= id_c;
+                ex_rs1           <= id_rs1;
+                ex_rs2           <= id_rs2;
+                ex_rd            <= id_rd;
+                ex_rs1_val       <= id_rs1_val;
+                ex_rs2_val       <= id_rs2_val;
+                ex_imm           <= id_imm;
+                ex_op            <= id_op;
+                ex_alu_src1      <= id_alu_src1;
+                ex_alu_src2      <= id_alu_src2;
+                ex_branch_invert <= id_branch_invert;
+                ex_we            <= id_we;
+                ex_wb_sel        <= id_wb_sel;
+                ex_uses_rs1      <= id_uses_rs1;
+                ex_uses_rs2      <= id_uses_rs2;
+                ex_is_load       <= id_is_load;
+                ex_is_store      <= id_is_store;
+                ex_is_branch     <= id_is_branch;
+                ex_is_jal        <= id_is_jal;
+                ex_is_jalr       <= id_is_jalr;
+                ex_is_system     <= id_is_system;
+                ex_is_muldiv     <= id_is_muldiv;
+                ex_is_fence      <= id_is_fence;
+                ex_is_amo        <= id_is_amo;
+            end
+        end
+    end
+
+    // Forwarding: MEM (non-load, non-AMO) has priority over WB, then the ID/EX copy.
+    always_comb begin
+        ex_fwd1 = ex_rs1_val;
+        if (mem_valid && mem_we && !mem_is_load && !mem_is_amo && mem_rd != 5'd0 && mem_rd == ex_rs1)
+            ex_fwd1 = mem_result;
+        else if (wb_rf_we && wb_rd != 5'd0 && wb_rd == ex_rs1)
+            ex_fwd1 = wb_data;
+
+        ex_fwd2 = ex_rs2_val;
+        if (mem_valid && mem_we && !mem_is_load && !mem_is_amo && mem_rd != 5'd0 && mem_rd == ex_rs2)
+            ex_fwd2 = mem_result;
+        else if (wb_rf_we && wb_rd != 5'd0 && wb_rd == ex_rs2)
+            ex_fwd2 = wb_data;
+    end
+
+    assign ex_op1 = ex_alu_src1 ? ex_pc : ex_fwd1;
+    assign ex_op2 = ex_alu_src2 ? ex_imm : ex_fwd2;
+
+    alu alu_ins(
+        .op1(ex_op1),
+        .op2(ex_op2),
+        .op_type(ex_op),
+        .result(ex_alu_result)
+    );
+
+    // RV32M: started once per EX occupancy, after any load-use wait so the
+    // forwarded operands are final. EX holds until the unit reports valid.
+    if (RV32M) begin : g_muldiv
+        rv32_muldiv muldiv_ins (
+            .clk(clk),
+            .rst_n(rst_n),
+            .start(md_start),
+            .funct3(ex_ir[14:12]),
+            .op1(ex_fwd1),
+            .op2(ex_fwd2),
+            .valid(md_valid),
+            .result(md_result)
+        );
+    end else begin : g_no_muldiv
+        assign md_valid = 1'b0;
+        assign md_result = 32'b0;
+    end
+
+    assign md_start = ex_valid && ex_is_muldiv && !ex_md_started && !load_use && !trap_flush;
+    assign md_wait  = ex_is_muldiv && !(ex_md_started && md_valid);
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n)
+            ex_md_started <= 1'b0;
+        else if (trap_flush || !ex_stall)
+            ex_md_started <= 1'b0;
+        else if (md_start)
+            ex_md_started <= 1'b1;
+    end
+
+    always_comb begin
+        unique case (ex_wb_sel)
+            2'b10:   ex_result = ex_pc + (ex_c ? 32'd2 : 32'd4);  // JAL/JALR link
+            2'b11:   ex_result = ex_imm;         // LUI
+            default: ex_result = ex_is_muldiv ? md_result : ex_alu_result; // ALU, AUIPC, load/store address
+        endcase
+    end
+
+    assign ex_taken  = ex_is_branch && (ex_alu_result[0] ^ ex_branch_invert);
+    assign ex_target = ex_is_jalr ? {ex_alu_result[31:1], 1'b0} : (ex_pc + ex_imm);
+    assign ex_npc    = (ex_taken || ex_is_jal || ex_is_jalr) ? ex_target : (ex_pc + (ex_c ? 32'd2 : 32'd4));
+
+    // Load-use interlock: the loaded value is forwarded from WB only.
+    assign load_use = mem_valid && (mem_is_load || mem_is_amo) && mem_rd != 5'd0
+                    && ((ex_uses_rs1 && mem_rd == ex_rs1) || (ex_uses_rs2 && mem_rd == ex_rs2));
+
+    assign ex_stall    = ex_valid && (mem_stall || load_use || md_wait);
+    assign ex_to_mem   = ex_valid && !ex_stall;
+    assign ex_redirect = ex_to_mem && (ex_taken || ex_is_jalr);
+
+    //////////////// MEM ////////////////
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            mem_valid     <= 1'b0;
+            mem_ir        <= 32'b0;
+            mem_rd        <= 5'b0;
+            mem_result    <= 32'b0;
+            mem_rs2_val   <= 32'b0;
+            mem_npc       <= 32'b0;
+            mem_funct3    <= 3'b0;
+            mem_we        <= 1'b0;
+            mem_is_load   <= 1'b0;
+            mem_is_store  <= 1'b0;
+            mem_is_system <= 1'b0;
+            mem_is_fence  <= 1'b0;
+            mem_is_amo    <= 1'b0;
+            mem_pc        <= 32'b0;
+            mem_c         <= 1'b0;
+        end else if (trap_flush) begin
+            mem_valid <= 1'b0;
+        end else if (!mem_stall) begin
+            mem_valid <= ex_to_mem;
+            if (ex_to_mem) begin
+                mem_ir        <= ex_ir;
+                mem_rd        <= ex_rd;
+                mem_result    <= ex_result;
+                mem_rs2_val   <= ex_fwd2;
+                mem_npc       <= ex_npc;
+                mem_funct3    <= ex_ir[14:12];
+                mem_we        <= ex_we;
+                mem_is_load   <= ex_is_load;
+                mem_is_store  <= ex_is_store;
+                mem_is_system <= ex_is_system;
+                mem_is_fence  <= ex_is_fence;
+                mem_is_amo    <= ex_is_amo;
+                mem_pc        <= ex_pc;
+                mem_c         <= ex_c;
+            end
+        end
+    end
+
+    // LSU handshake, as in control_unit S_MEM: request registered after the first
+    // MEM cycle and dropped on the handshake (lsu_interconnect relies on the gap).
+    // An AMO steps through the same read, write and drain phases as control_unit.
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            rready_cpu    <= 1'b0;
+            wvalid_cpu    <= 1'b0;
+            mem_amo_phase <= AMO_READ;
+            mem_amo_old   <= 32'b0;
+        end else begin
+            rready_cpu <= 1'b0;
+            wvalid_cpu <= 1'b0;
+            if (mem_valid && !trap_flush) begin
+                if (mem_is_load && !(rvalid_cpu && rready_cpu))
+                    rready_cpu <= 1'b1;
+                if (mem_is_store && !(wready_cpu && wvalid_cpu))
+                    wvalid_cpu <= 1'b1;
+                if (mem_is_amo) begin
+                    unique case (mem_amo_phase)
+                        AMO_READ: begin
+                            if (rvalid_cpu && rready_cpu) begin
+                                mem_amo_old   <= data_cpu_i;
+                                mem_amo_phase <= AMO_WRITE;
+                            end else begin
+                                rready_cpu <= 1'b1;
+                            end
+                        end
+                        AMO_WRITE: begin
+                            if (wready_cpu && wvalid_cpu)
+                                mem_amo_phase <= AMO_DRAIN;
+                            else
+                                wvalid_cpu <= 1'b1;
+                        end
+                        default: begin
+                            if (lsu_idle)
+                                mem_amo_phase <= AMO_READ;
+                        end
+                    endcase
+                end
+            end
+        end
+    end
+
+    assign mem_done = !mem_valid
+                    || (mem_is_load  ? (rready_cpu && rvalid_cpu) :
+                        mem_is_store ? (wvalid_cpu && wready_cpu) :
+                        mem_is_amo   ? (mem_amo_phase == AMO_DRAIN && lsu_idle) :
+                        mem_is_fence ? lsu_idle : 1'b1);
+    assign mem_stall = !mem_done;
+    assign amo_lock  = mem_valid && mem_is_amo;
+
+    rv32_amo_alu amo_alu_ins (
+        .funct5(mem_ir[31:27]),
+        .old(mem_amo_old),
+        .rs2(mem_rs2_val),
+        .result(mem_amo_result)
+    );
+
+    assign addr_cpu = mem_result;
+
+    // Load sign/zero extension based on funct3 and byte offset
+    always_comb begin
+        load_ext = data_cpu_i;
+        unique case (mem_funct3)
+            3'b000: begin // LB
+                unique case (mem_result[1:0])
+                    2'b00: load_ext = {{24{data_cpu_i[7]}},  data_cpu_i[7:0]};
+                    2'b01: load_ext = {{24{data_cpu_i[15]}}, data_cpu_i[15:8]};
+                    2'b10: load_ext = {{24{data_cpu_i[23]}}, data_cpu_i[23:16]};
+                    2'b11: load_ext = {{24{data_cpu_i[31]}}, data_cpu_i[31:24]};
+                    default: load_ext = 32'b0;
+                endcase
+            end
+            3'b001: begin // LH
+                if (mem_result[1] == 1'b0)
+                    load_ext = {{16{data_cpu_i[15]}}, data_cpu_i[15:0]};
+                else
+                    load_ext = {{16{data_cpu_i[31]}}, data_cpu_i[31:16]};
+            end
+            3'b010: load_ext = data_cpu_i; // LW
+            3'b100: begin // LBU
+                unique case (mem_result[1:0])
+                    2'b00: load_ext = {24'b0, data_cpu_i[7:0]};
+                    2'b01: load_ext = {24'b0, data_cpu_i[15:8]};
+                    2'b10: load_ext = {24'b0, data_cpu_i[23:16]};
+                    2'b11: load_ext = {24'b0, data_cpu_i[31:24]};
+                    default: load_ext = 32'b0;
+                endcase
+            end
+            3'b101: begin // LHU
+                if (mem_result[1] == 1'b0)
+                    load_ext = {16'b0, data_cpu_i[15:0]};
+                else
+                    load_ext = {16'b0, data_cpu_i[31:16]};
+            end
+            default: load_ext = data_cpu_i;
+        endcase
+    end
+
+    // Store data + byte strobes (SW/SB/SH)
+    always_comb begin
+        data_cpu_o = mem_rs2_val;
+        strb_cpu   = 4'b0000;
+
+        if (mem_is_amo) begin
+            data_cpu_o = mem_amo_result;
+            strb_cpu   = 4'b1111;
+        end else if (mem_is_store) begin
+            unique case (mem_funct3)
+                3'b010: begin // SW
+                    data_cpu_o = mem_rs2_val;
+                    strb_cpu   = 4'b1111;
+                end
+                3'b000: begin // SB
+                    data_cpu_o = {4{mem_rs2_val[7:0]}} << (mem_result[1:0] * 8);
+                    strb_cpu   = 4'b0001 << mem_result[1:0];
+                end
+                3'b001: begin // SH
+                    data_cpu_o = {16'b0, mem_rs2_val[15:0]} << (mem_result[1] * 16);
+                    strb_cpu   = (mem_result[1] == 1'b0) ? 4'b0011 : 4'b1100;
+                end
+                default: begin
+                    data_cpu_o = mem_rs2_val;
+                    strb_cpu   = 4'b0000;
+                end
+            endcase
+        end
+    end
+
+    //////////////// WB ////////////////
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            wb_valid     <= 1'b0;
+            wb_ir        <= 32'b0;
+            wb_rd        <= 5'b0;
+            wb_result    <= 32'b0;
+            wb_npc       <= 32'b0;
+            wb_we        <= 1'b0;
+            wb_is_system <= 1'b0;
+            wb_pc        <= 32'b0;
+            wb_c         <= 1'b0;
+            wb_is_load   <= 1'b0;
+            wb_is_store  <= 1'b0;
+            wb_addr      <= 32'b0;
+            wb_sdata     <= 32'b0;
+        end else begin
+            wb_valid <= mem_valid && mem_done && !trap_flush;
+            if (mem_valid && mem_done) begin
+                wb_ir        <= mem_ir;
+                wb_rd        <= mem_rd;
+                wb_result    <= mem_is_amo ? mem_amo_old : mem_is_load ? load_ext : mem_result;
+                wb_npc       <= mem_npc;
+                wb_we        <= mem_we;
+                wb_is_system <= mem_is_system;
+                wb_pc        <= mem_pc;
+                wb_c         <= mem_c;
+                wb_is_load   <= mem_is_load;
+                wb_is_store  <= mem_is_store;
+                wb_addr      <= mem_result;
+                wb_sdata     <= data_cpu_o;
+            end
+        end
+    end
+
+    assign wb_rf_we = wb_valid && wb_we;
+    assign wb_data  = (wb_is_system && wb_ir[14:12] != 3'b000) ? csr_rdata : wb_result;
+
+    // Retirement trace. A load reports the value it wrote to rd, a store the word
+    // it put on the LSU. rvfi_intr marks the first instruction to retire after a
+    // trap was taken (the handler's first instruction).
+    assign rvfi_pc        = wb_pc;
+    assign rvfi_c         = wb_c;
+    assign rvfi_intr      = intr_pend;
+    assign rvfi_rd_addr   = wb_rf_we ? wb_rd : 5'd0;
+    assign rvfi_rd_wdata  = wb_data;
+    assign rvfi_mem_load  = wb_is_load;
+    assign rvfi_mem_store = wb_is_store;
+    assign rvfi_mem_addr  = (wb_is_load || wb_is_store) ? wb_addr : 32'b0;
+    assign rvfi_mem_data  = wb_is_store ? wb_sdata : wb_is_load ? wb_result : 32'b0;
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            intr_pend <= 1'b0;
+        end else if (take_trap) begin
+            intr_pend <= 1'b1;
+        end else if (wb_valid) begin
+            intr_pend <= 1'b0;
+        end
+    end
+
+    // CSR access and mret at WB (same decode as the multi-cycle core).
+    always_comb begin
+        csr_wena = 1'b0;
+        csr_addr = wb_ir[31:20];
+        csr_wdata = 32'b0;
+        mret_commit = 1'b0;
+
+        if (wb_valid && wb_is_system) begin
+            unique case (wb_ir[14:12])
+                3'b001: begin // CSRRW
+                    csr_wena = 1'b1;
+                    csr_wdata = wb_result;
+                end
+                3'b010: begin // CSRRS
+                    if (wb_ir[19:15] != 5'b0) begin
+                        csr_wena = 1'b1;
+                        csr_wdata = csr_rdata | wb_result;
+                    end
+                end
+                3'b011: begin // CSRRC
+                    if (wb_ir[19:15] != 5'b0) begin
+                        csr_wena = 1'b1;
+                        csr_wdata = csr_rdata & ~wb_result;
+                    end
+                end
+                3'b101: begin // CSRRWI
+                    csr_wena = 1'b1;
+                    csr_wdata = {27'b0, wb_ir[19:15]};
+                end
+                3'b110: begin // CSRRSI
+                    if (wb_ir[19:15] != 5'b0) begin
+                        csr_wena = 1'b1;
+                        csr_wdata = csr_rdata | {27'b0, wb_ir[19:15]};
+                    end
+                end
+                3'b111: begin // CSRRCI
+                    if (wb_ir[19:15] != 5'b0) begin
+                        csr_wena = 1'b1;
+                        csr_wdata = csr_rdata & ~{27'b0, wb_ir[19:15]};
+                    end
+                end
+                3'b000: begin
+                    if (wb_ir == INSN_MRET) begin
+                        mret_commit = 1'b1;
+                    end
+                end
+                default: ;
+            endcase
+        end
+    end
+
+    rv32_mtrap_csr #(
+        .N_EXT_IRQ(N_EXT_IRQ),
+        .RESET_MTVEC(RESET_MTVEC),
+        .HART_ID(HART_ID)
+    ) mtrap_csr_ins (
+        .clk(clk),
+        .rst_n(rst_n),
+
+        .irq_software(irq_software),
+        .irq_timer(timer_irq),
+        .irq_external(external_irq),
+
+        .mret_commit(mret_commit),
+
+        .csr_wena(csr_wena),
+        .csr_addr(csr_addr),
+        .csr_wdata(csr_wdata),
+        .csr_rdata(csr_rdata),
+
+        // Every retiring instruction is a commit point; mepc is the next PC in program order.
+        .instr_commit(wb_valid),
+        .irq_point(wb_valid || irq_early),
+        .actual_pc(wb_valid ? (mret_commit ? return_pc : wb_npc) : id_pc),
+
+        // Loads/stores count when they leave MEM, taken branches when they leave EX.
+        .mtime(mtime),
+        .instr_retire(wb_valid),
+        .ev_load(mem_valid && mem_is_load && mem_done && !trap_flush),
+        .ev_store(mem_valid && mem_is_store && mem_done && !trap_flush),
+        .ev_branch_taken(ex_to_mem && ex_taken && !trap_flush),
+        .ev_lsu_stall((rready_cpu && !rvalid_cpu) || (wvalid_cpu && !wready_cpu)),
+        .ev_wfi(wfi_sleep),
+
+        .bus_err(bus_err),
+        .bus_err_addr(bus_err_addr),
+
+        .take_trap(take_trap),
+        .trap_pc(trap_pc),
+        .take_return(take_return),
+        .return_pc(return_pc),
+        .irq_wake(irq)
+    );
+
+    assign trap_flush = take_trap | take_return;
+    assign irq_early  = EARLY_IRQ && id_valid && !ex_valid && !mem_valid && !wb_valid && !halt_req;
+
+    // WFI: hold issue after it retires until an interrupt line is raised
+    // (taken at the next commit if enabled), like the FETCH wait in control_unit.
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            wfi_sleep <= 1'b0;
+        end else if (irq || take_trap) begin
+            wfi_sleep <= 1'b0;
+        end else if (wb_valid && wb_ir == INSN_WFI) begin
+            wfi_sleep <= 1'b1;
+        end
+    end
+
+endmodule
@@ -0,0 +1,137 @@
+import rv32_opcodes_pkg::*;
+
+// RV32C: expands one 16-bit instruction (instr_c[1:0] != 2'b11) into the 32-bit
+// instruction it stands for, so the decoder and control only see RV32I.
+// Reserved encodings, the RV64/F/D ones and 16'h0000 expand to 32'h0, which
+// runs as a no-op like any other unknown opcode in this core.
+module rv32c_expand(
+    input  logic [15:0] instr_c,
+    output logic [31:0] instr
+);
+
+    logic [2:0]  funct3;
+    logic [4:0]  rd;            // rd/rs1, full register number (CI/CR)
+    logic [4:0]  rs2;           // full register number (CR/CSS)
+    logic [4:0]  rdp;           // rd'/rs2' (bits 4:2) -> x8..x15
+    logic [4:0]  rs1p;          // rs1'/rd' (bits 9:7) -> x8..x15
+
+    logic [11:0] imm_ci;        // c.addi/c.li/c.andi: sext(imm[5:0])
+    logic [11:0] imm_addi4spn;  // zero-extended, scaled by 4
+    logic [11:0] imm_lw;        // c.lw/c.sw: zero-extended, scaled by 4
+    logic [11:0] imm_lwsp;
+    logic [11:0] imm_swsp;
+    logic [11:0] imm_addi16sp;  // sext, scaled by 16
+    logic [19:0] imm_lui;       // sext(nzimm[17:12])
+    logic [20:0] imm_j;         // c.j/c.jal offset, sign-extended to the J-type width
+    logic [12:0] imm_b;         // c.beqz/c.bnez offset, sign-extended to the B-type width
+
+    assign funct3 = instr_c[15:13];
+    assign rd     = instr_c[11:7];
+    assign rs2    = instr_c[6:2];
+    assign rdp    = {2'b01, instr_c[4:2]};
+    assign rs1p   = {2'b01, instr_c[9:7]};
+
+    assign imm_ci       = {{7{instr_c[12]}}, instr_c[6:2]};
+    assign imm_addi4spn = {2'b0, instr_c[10:7], instr_c[12:11], instr_c[5], instr_c[6], 2'b0};
+    assign imm_lw       = {5'b0, instr_c[5], instr_c[12:10], instr_c[6], 2'b0};
+    assign imm_lwsp     = {4'b0, instr_c[3:2], instr_c[12], instr_c[6:4], 2'b0};
+    assign imm_swsp     = {4'b0, instr_c[8:7], instr_c[12:9], 2'b0};
+    assign imm_addi16sp = {{3{instr_c[12]}}, instr_c[4:3], instr_c[5], instr_c[2], instr_c[6], 4'b0};
+    assign imm_lui      = {{15{instr_c[12]}}, instr_c[6:2]};
+    assign imm_j        = {{10{instr_c[12]}}, instr_c[8], instr_c[10:9], instr_c[6], instr_c[7],
+                           instr_c[2], instr_c[11], instr_c[5:3], 1'b0};
+    assign imm_b        = {{5{instr_c[12]}}, instr_c[6:5], instr_c[2], instr_c[11:10],
+                           instr_c[4:3], 1'b0};
+
+    always_comb begin
+        instr = 32'h0;
+
+        unique case (instr_c[1:0])
+            // Quadrant 0: stack-pointer based ADDI, LW/SW on x8..x15
+            2'b00: begin
+                unique case (funct3)
+                    3'b000: if (imm_addi4spn != 12'b0)   // C.ADDI4SPN
+                                instr = {imm_addi4spn, 5'd2, 3'b000, rdp, OPC_OP_IMM};
+                    3'b010: instr = {imm_lw, rs1p, 3'b010, rdp, OPC_LOAD};              // C.LW
+                    3'b110: instr = {imm_lw[11:5], rdp, rs1p, 3'b010, imm_lw[4:0], OPC_STORE}; // C.SW
+                    default: ;
+                endcase
+            end
+
+            // Quadrant 1: immediates, jumps, branches, x8..x15 arithmetic
+            2'b01: begin
+                unique case (funct3)
+                    3'b000: instr = {imm_ci, rd, 3'b000, rd, OPC_OP_IMM};      // C.ADDI / C.NOP
+                    3'b001: instr = {imm_j[20], imm_j[10:1], imm_j[11], imm_j[19:12],
+                                     5'd1, OPC_JAL};                            // C.JAL
+                    3'b010: instr = {imm_ci, 5'd0, 3'b000, rd, OPC_OP_IMM};    // C.LI
+                    3'b011: begin
+                        if (rd == 5'd2) begin                                    // C.ADDI16SP
+                            if (imm_addi16sp != 12'b0)
+                                instr = {imm_addi16sp, 5'd2, 3'b000, 5'd2, OPC_OP_IMM};
+                        end else if (imm_lui != 20'b0) begin                     // C.LUI
+                            instr = {imm_lui, rd, OPC_LUI};
+                        end
+                    end
+                    3'b100: begin
+                        unique case (instr_c[11:10])
+                            2'b00: if (!instr_c[12])                             // C.SRLI
+                                       instr = {7'b0000000, instr_c[6:2], rs1p, 3'b101, rs1p, OPC_OP_IMM};
+                            2'b01: if (!instr_c[12])                             // C.SRAI
+                                       instr = {7'b0100000, instr_c[6:2], rs1p, 3'b101, rs1p, OPC_OP_IMM};
+                            2'b10: instr = {imm_ci, rs1p, 3'b111, rs1p, OPC_OP_IMM}; // C.ANDI
+                            2'b11: if (!instr_c[12]) begin
+                                unique case (instr_c[6:5])
+                                    2'b00: instr = {7'b0100000, rdp, rs1p, 3'b000, rs1p, OPC_OP}; // C.SUB
+                                    2'b01: instr = {7'b0000000, rdp, rs1p, 3'b100, rs1p, OPC_OP}; // C.XOR
+                                    2'b10: instr = {7'b0000000, rdp, rs1p, 3'b110, rs1p, OPC_OP}; // C.OR
+                                    2'b11: instr = {7'b0000000, rdp, rs1p, 3'b111, rs1p, OPC_OP}; // C.AND
+                                endcase
+                            end
+                        endcase
+                    end
+                    3'b101: instr = {imm_j[20], imm_j[10:1], imm_j[11], imm_j[19:12],
+                                     5'd0, OPC_JAL};                            // C.J
+                    3'b110: instr = {imm_b[12], imm_b[10:5], 5'd0, rs1p, 3'b000,
+                                     imm_b[4:1], imm_b[11], OPC_BRANCH};        // C.BEQZ
+                    3'b111: instr = {imm_b[12], imm_b[10:5], 5'd0, rs1p, 3'b001,
+                                     imm_b[4:1], imm_b[11], OPC_BRANCH};        // C.BNEZ
+                endcase
+            end
+
+            // Quadrant 2: SLLI, stack-pointer loads/stores, register moves and jumps
+            2'b10: begin
+                unique case (funct3)
+                    3'b000: if (!instr_c[12])                                    // C.SLLI
+                                instr = {7'b0000000, instr_c[6:2], rd, 3'b001, rd, OPC_OP_IMM};
+                    3'b010: if (rd != 5'd0)                                      // C.LWSP
+                                instr = {imm_lwsp, 5'd2, 3'b010, rd, OPC_LOAD};
+                    3'b100: begin
+                        if (!instr_c[12]) begin
+                            if (rs2 == 5'd0) begin
+                                if (rd != 5'd0)                                  // C.JR
+                                    instr = {12'b0, rd, 3'b000, 5'd0, OPC_JALR};
+                            end else begin                                       // C.MV
+                                instr = {7'b0000000, rs2, 5'd0, 3'b000, rd, OPC_OP};
+                            end
+                        end else begin
+                            if (rs2 == 5'd0) begin
+                                if (rd == 5'd0)                                  // C.EBREAK
+                                    instr = 32'h0010_0073;
+                                else                                             // C.JALR
+                                    instr = {12'b0, rd, 3'b000, 5'd1, OPC_JALR};
+                            end else begin                                       // C.ADD
+                                instr = {7'b0000000, rs2, rd, 3'b000, rd, OPC_OP};
+                            end
+                        end
+                    end
+                    3'b110: instr = {imm_swsp[11:5], rs2, 5'd2, 3'b010, imm_swsp[4:0], OPC_STORE}; // C.SWSP
+                    default: ;
+                endcase
+            end
+
+            default: ;  // 2'b11: not a compressed instruction
+        endcase
+    end
+
+endmodule
@@ -0,0 +1,136 @@
+// Two AXI4 masters (D-cache, I-cache) onto one AXI4 memory port.
+//
+// Reads: one burst at a time; the D side wins when both request. The grant is
+// taken on the AR handshake and released on the last R beat.
+// Writes: only the D-cache writes (write-through), so AW/W/B pass straight through.
+module axi4_mem_arbiter (
+    input  logic        clk,
+    input  logic        rst_n,
+
+    // Master 0: D-cache (read + write)
+    input  logic [31:0] d_araddr,
+    input  logic [7:0]  d_arlen,
+    input  logic [2:0]  d_arsize,
+    input  logic [1:0]  d_arburst,
+    input  logic        d_arvalid,
+    output logic        d_arready,
+    output logic [31:0] d_rdata,
+    output logic [1:0]  d_rresp,
+    output logic        d_rlast,
+    output logic        d_rvalid,
+    input  logic        d_rready,
+
+    input  logic [31:0] d_awaddr,
+    input  logic [7:0]  d_awlen,
+    input  logic [2:0]  d_awsize,
+    input  logic [1:0]  d_awburst,
+    input  logic        d_awvalid,
+    output logic        d_awready,
+    input  logic [31:0] d_wdata,
+    input  logic [3:0]  d_wstrb,
+    input  logic        d_wlast,
+    input  logic        d_wvalid,
+    output logic        d_wready,
+    output logic [1:0]  d_bresp,
+    output logic        d_bvalid,
+    input  logic        d_bready,
+
+    // Master 1: I-cache (read only)
+    input  logic [31:0] i_araddr,
+    input  logic [7:0]  i_arlen,
+    input  logic [2:0]  i_arsize,
+    input  logic [1:0]  i_arburst,
+    input  logic        i_arvalid,
+    output logic        i_arready,
+    output logic [31:0] i_rdata,
+    output logic [1:0]  i_rresp,
+    output logic        i_rlast,
+    output logic        i_rvalid,
+    input  logic        i_rready,
+
+    // AXI4 slave (memory)
+    output logic [31:0] araddr,
+    output logic [7:0]  arlen,
+    output logic [2:0]  arsize,
+    output logic [1:0]  arburst,
+    output logic        arvalid,
+    input  logic        arready,
+    input  logic [31:0] rdata,
+    input  logic [1:0]  rresp,
+    input  logic        rlast,
+    input  logic        rvalid,
+    output logic        rready,
+
+    output logic [31:0] awaddr,
+    output logic [7:0]  awlen,
+    output logic [2:0]  awsize,
+    output logic [1:0]  awburst,
+    output logic        awvalid,
+    input  logic        awready,
+    output logic [31:0] wdata,
+    output logic [3:0]  wstrb,
+    output logic        wlast,
+    output logic        wvalid,
+    input  logic        wready,
+    input  logic [1:0]  bresp,
+    input  logic        bvalid,
+    output logic        bready
+);
+
+    logic rd_busy;      // a burst is in flight
+    logic rd_owner;     // 0: D-cache, 1: I-cache
+    logic ar_sel;       // master presented on AR while idle
+
+    assign ar_sel = !d_arvalid && i_arvalid;
+
+    // AR: only while no burst is in flight
+    assign araddr  = ar_sel ? i_araddr  : d_araddr;
+    assign arlen   = ar_sel ? i_arlen   : d_arlen;
+    assign arsize  = ar_sel ? i_arsize  : d_arsize;
+    assign arburst = ar_sel ? i_arburst : d_arburst;
+    assign arvalid = !rd_busy && (d_arvalid || i_arvalid);
+    assign d_arready = !rd_busy && !ar_sel && arready;
+    assign i_arready = !rd_busy &&  ar_sel && arready;
+
+    // R: to the owner of the burst
+    assign d_rdata  = rdata;
+    assign d_rresp  = rresp;
+    assign d_rlast  = rlast;
+    assign d_rvalid = rd_busy && !rd_owner && rvalid;
+    assign i_rdata  = rdata;
+    assign i_rresp  = rresp;
+    assign i_rlast  = rlast;
+    assign i_rvalid = rd_busy &&  rd_owner && rvalid;
+    assign rready   = rd_busy && (rd_owner ? i_rready : d_rready);
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            rd_busy  <= 1'b0;
+            rd_owner <= 1'b0;
+        end else if (!rd_busy) begin
+            if (arvalid && arready) begin
+                rd_busy  <= 1'b1;
+                rd_owner <= ar_sel;
+            end
+        end else if (rvalid && rready && rlast) begin
+            rd_busy <= 1'b0;
+        end
+    end
+
+    // AW/W/B: D-cache only
+    assign awaddr    = d_awaddr;
+    assign awlen     = d_awlen;
+    assign awsize    = d_awsize;
+    assign awburst   = d_awburst;
+    assign awvalid   = d_awvalid;
+    assign d_awready = awready;
+    assign wdata     = d_wdata;
+    assign wstrb     = d_wstrb;
+    assign wlast     = d_wlast;
+    assign wvalid    = d_wvalid;
+    assign d_wready  = wready;
+    assign d_bresp   = bresp;
+    assign d_bvalid  = bvalid;
+    assign bready    = d_bready;
+
+endmodule
@@ -0,0 +1,169 @@
+// AXI4 memory model behind the XMEM caches (soc.sv): a word array with
+// configurable access latency, standing in for DDR/SRAM in simulation and
+// built as block RAM on the FPGA.
+//
+// - INCR bursts of 32-bit beats; one read and one write transaction at a time.
+// - READ_LATENCY:  idle cycles between the AR handshake and the first R beat
+//   (then one beat per cycle).
+// - WRITE_LATENCY: idle cycles between the last W beat and BVALID.
+// - Addresses wrap at 2**ADDR_WIDTH words.
+// - Contents: INIT_FILE ($readmemh, also honored by synthesis), then in
+//   simulation +XMEM=<file> overrides it.
+module axi4_sram #(
+    parameter int ADDR_WIDTH = 16,
+    parameter int READ_LATENCY = 8,
+    parameter int WRITE_LATENCY = 4,
+    parameter string INIT_FILE = ""
+) (
+    input  logic        clk,
+    input  logic        rst_n,
+
+    input  logic [31:0] araddr,
+    input  logic [7:0]  arlen,
+    input  logic [2:0]  arsize,
+    input  logic [1:0]  arburst,
+    input  logic        arvalid,
+    output logic        arready,
+    output logic [31:0] rdata,
+    output logic [1:0]  rresp,
+    output logic        rlast,
+    output logic        rvalid,
+    input  logic        rready,
+
+    input  logic [31:0] awaddr,
+    input  logic [7:0]  awlen,
+    input  logic [2:0]  awsize,
+    input  logic [1:0]  awburst,
+    input  logic        awvalid,
+    output logic        awready,
+    input  logic [31:0] wdata,
+    input  logic [3:0]  wstrb,
+    input  logic        wlast,
+    input  logic        wvalid,
+    output logic        wready,
+    output logic [1:0]  bresp,
+    output logic        bvalid,
+    input  logic        bready
+);
+
+    localparam int LAT_W = 8;
+
+    (* ram_style="block" *) logic [31:0] mem [0:(1<<ADDR_WIDTH)-1];
+
+    initial begin
+        if (INIT_FILE != "") $readmemh(INIT_FILE, mem);
+    end
+
+    // synthesis translate_off
+    initial begin
+        string xmem_path;
+        if ($value$plusargs("XMEM=%s", xmem_path)) begin
+            $display("[XMEM] Loading from: %s", xmem_path);
+            $readmemh(xmem_path, mem);
+        end
+    end
+    // synthesis translate_on
+
+    typedef enum logic [1:0] {R_IDLE, R_WAIT, R_DATA} rd_state_t;
+    typedef enum logic [1:0] {W_IDLE, W_DATA, W_WAIT, W_RESP} wr_state_t;
+    rd_state_t st_r;
+    wr_state_t st_w;
+
+    logic [ADDR_WIDTH-1:0] raddr, waddr;
+    logic [7:0]            rlen;
+    logic [LAT_W-1:0]      rcnt, wcnt;
+    logic                  rd_next;     // current beat accepted, fetch the next word
+
+    // READ: the word for the next beat is read while the current one is held.
+    assign rd_next = (st_r == R_DATA) && rready;
+
+    always_ff @(posedge clk) begin
+        if (st_r == R_WAIT || rd_next)
+            rdata <= mem[rd_next ? raddr + 1'b1 : raddr];
+    end
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            st_r  <= R_IDLE;
+            raddr <= '0;
+            rlen  <= '0;
+            rcnt  <= '0;
+        end else begin
+            case (st_r)
+            R_IDLE: begin
+                if (arvalid) begin
+                    raddr <= araddr[ADDR_WIDTH+1:2];
+                    rlen  <= arlen;
+                    rcnt  <= LAT_W'(READ_LATENCY);
+                    st_r  <= R_WAIT;
+                end
+            end
+            R_WAIT: begin
+                if (rcnt == '0) st_r <= R_DATA;
+                else            rcnt <= rcnt - 1'b1;
+            end
+            R_DATA: begin
+                if (rready) begin
+                    raddr <= raddr + 1'b1;
+                    rlen  <= rlen - 1'b1;
+                    if (rlen == '0) st_r <= R_IDLE;
+                end
+            end
+            default: st_r <= R_IDLE;
+            endcase
+        end
+    end
+
+    assign arready = (st_r == R_IDLE);
+    assign rvalid  = (st_r == R_DATA);
+    assign rlast   = (rlen == '0);
+    assign rresp   = 2'b00;
+
+    // WRITE
+    always_ff @(posedge clk) begin
+        if (st_w == W_DATA && wvalid) begin
+            for (int i = 0; i < 4; i++)
+                if (wstrb[i]) mem[waddr][8*i +: 8] <= wdata[8*i +: 8];
+        end
+    end
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            st_w  <= W_IDLE;
+            waddr <= '0;
+            wcnt  <= '0;
+        end else begin
+            case (st_w)
+            W_IDLE: begin
+                if (awvalid) begin
+                    waddr <= awaddr[ADDR_WIDTH+1:2];
+                    st_w  <= W_DATA;
+                end
+            end
+            W_DATA: begin
+                if (wvalid) begin
+                    waddr <= waddr + 1'b1;
+                    if (wlast) begin
+                        wcnt <= LAT_W'(WRITE_LATENCY);
+                        st_w <= W_WAIT;
+                    end
+                end
+            end
+            W_WAIT: begin
+                if (wcnt == '0) st_w <= W_RESP;
+                else            wcnt <= wcnt - 1'b1;
+            end
+            W_RESP: begin
+                if (bready) st_w <= W_IDLE;
+            end
+            default: st_w <= W_IDLE;
+            endcase
+        end
+    end
+
+    assign awready = (st_w == W_IDLE);
+    assign wready  = (st_w == W_DATA);
+    assign bvalid  = (st_w == W_RESP);
+    assign bresp   = 2'b00;
+
+endmodule
@@ -0,0 +1,279 @@
+// Blocking L1 cache between the core and an AXI4 memory port (XMEM in soc.sv).
+// One module serves as I-cache (wr_req tied low) and D-cache.
+//
+// - WAYS 1 (direct-mapped) or 2 (LRU per set); SETS lines of LINE_WORDS words.
+// - Same timing as the BRAMs: `addr` is looked up every cycle and hit/rd_data
+//   refer to the address presented in the previous cycle.
+// - rd_req asks for that data. On a miss the whole line is refilled with one
+//   INCR burst (no critical-word forwarding) and the lookup is retried, so the
+//   requester must keep presenting the same address.
+// - Writes are write-through, no write-allocate: wr_req (for the previous
+//   cycle's address, held until wr_ready) updates the line on a hit and always
+//   goes out as a single-beat write; wr_ready is raised once BRESP is back.
+module l1_cache #(
+    parameter int WAYS = 1,
+    parameter int SETS = 64,
+    parameter int LINE_WORDS = 8
+) (
+    input  logic        clk,
+    input  logic        rst_n,
+
+    // CPU side
+    input  logic [31:0] addr,
+    input  logic        rd_req,
+    output logic        rd_valid,
+    output logic [31:0] rd_data,
+    input  logic        wr_req,
+    input  logic [3:0]  wr_strb,
+    input  logic [31:0] wr_data,
+    output logic        wr_ready,
+
+    // AXI4 master
+    output logic [31:0] araddr,
+    output logic [7:0]  arlen,
+    output logic [2:0]  arsize,
+    output logic [1:0]  arburst,
+    output logic        arvalid,
+    input  logic        arready,
+
+    input  logic [31:0] rdata,
+    input  logic [1:0]  rresp,
+    input  logic        rlast,
+    input  logic        rvalid,
+    output logic        rready,
+
+    output logic [31:0] awaddr,
+    output logic [7:0]  awlen,
+    output logic [2:0]  awsize,
+    output logic [1:0]  awburst,
+    output logic        awvalid,
+    input  logic        awready,
+
+    output logic [31:0] wdata,
+    output logic [3:0]  wstrb,
+    output logic        wlast,
+    output logic        wvalid,
+    input  logic        wready,
+
+    input  logic [1:0]  bresp,
+    input  logic        bvalid,
+    output logic        bready,
+
+    // Lookups that hit / line refills (read by the testbench)
+    output logic [31:0] stat_hits,
+    output logic [31:0] stat_misses
+);
+
+    localparam int OFFS_W  = $clog2(LINE_WORDS);
+    localparam int SET_W   = $clog2(SETS);
+    localparam int IDX_W   = SET_W + OFFS_W;
+    localparam int TAG_LSB = IDX_W + 2;
+    localparam int TAG_W   = 32 - TAG_LSB;
+    localparam int WAY_W   = (WAYS > 1) ? $clog2(WAYS) : 1;
+
+    typedef enum logic [2:0] {C_IDLE, C_AR, C_FILL, C_SEND, C_WAIT_B, C_ACK} cache_state_t;
+    cache_state_t state;
+
+    // Tags and valid bits live in registers; data in one BRAM per way
+    // (port A: lookup, port B: refill beats and write hits).
+    logic [TAG_W-1:0] tag_ram   [WAYS][SETS];
+    logic [SETS-1:0]  valid_ram [WAYS];
+    logic [SETS-1:0]  lru;                  // way to replace next (WAYS == 2)
+    logic [31:0]      way_dout  [WAYS];
+
+    // Lookup of the previous cycle's address
+    logic [31:0]      addr_q;
+    logic             look_ok;              // arrays were idle for that lookup
+    logic [SET_W-1:0] set_q;
+    logic [TAG_W-1:0] tag_q;
+    logic [WAYS-1:0]  way_hit;
+    logic             hit;
+    logic [WAY_W-1:0] hit_way;
+
+    // Refill / write-through state
+    logic [31:0]       line_addr;
+    logic [WAY_W-1:0]  victim;
+    logic [OFFS_W-1:0] beat;
+    logic              aw_done, w_done;
+    logic              refilled;            // next hit is the retried lookup of a miss
+    logic [31:0]       wt_addr;
+    logic [31:0]       wt_data;
+    logic [3:0]        wt_strb;
+
+    // BRAM port B
+    logic              we_b;
+    logic [WAY_W-1:0]  way_b;
+    logic [IDX_W-1:0]  addr_b;
+    logic [31:0]       din_b;
+    logic [3:0]        strb_b;
+
+    assign set_q = addr_q[TAG_LSB-1:OFFS_W+2];
+    assign tag_q = addr_q[31:TAG_LSB];
+
+    always_comb begin
+        hit_way = '0;
+        for (int w = 0; w < WAYS; w++) begin
+            way_hit[w] = valid_ram[w][set_q] && (tag_ram[w][set_q] == tag_q);
+            if (way_hit[w]) hit_way = WAY_W'(w);
+        end
+    end
+
+    assign hit      = look_ok && (|way_hit);
+    assign rd_valid = rd_req && hit;
+    assign rd_data  = way_dout[hit_way];
+    assign wr_ready = (state == C_ACK);
+
+    // Port B: refill beats, or the byte lanes of a write hit
+    always_comb begin
+        if (state == C_FILL) begin
+            we_b   = rvalid;
+            way_b  = victim;
+            addr_b = {line_addr[TAG_LSB-1:OFFS_W+2], beat};
+            din_b  = rdata;
+            strb_b = 4'b1111;
+        end else begin
+            we_b   = (state == C_IDLE) && look_ok && wr_req && hit;
+            way_b  = hit_way;
+            addr_b = addr_q[TAG_LSB-1:2];
+            din_b  = wr_data;
+            strb_b = wr_strb;
+        end
+    end
+
+    generate
+        for (genvar w = 0; w < WAYS; w++) begin : g_way
+            bram #(
+                .ADDR_WIDTH(IDX_W),
+                .DATA_WIDTH(32)
+            ) data_ram (
+                .clk(clk),
+                .en_a(1'b1),
+                .we_a(1'b0),
+                .wstrb_a(4'b0000),
+                .addr_a(addr[TAG_LSB-1:2]),
+                .din_a(32'b0),
+                .dout_a(way_dout[w]),
+                .en_b(1'b1),
+                .we_b(we_b && way_b == WAY_W'(w)),
+                .wstrb_b(strb_b),
+                .addr_b(addr_b),
+                .din_b(din_b),
+                .dout_b()
+            );
+        end
+    endgenerate
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            state       <= C_IDLE;
+            addr_q      <= '0;
+            look_ok     <= 1'b0;
+            for (int w = 0; w < WAYS; w++) valid_ram[w] <= '0;
+            lru         <= '0;
+            line_addr   <= '0;
+            victim      <= '0;
+            beat        <= '0;
+            aw_done     <= 1'b0;
+            w_done      <= 1'b0;
+            refilled    <= 1'b0;
+            wt_addr     <= '0;
+            wt_data     <= '0;
+            wt_strb     <= '0;
+            stat_hits   <= '0;
+            stat_misses <= '0;
+        end else begin
+            addr_q  <= addr;
+            look_ok <= (state == C_IDLE);
+
+            case (state)
+            C_IDLE: begin
+                if (look_ok && wr_req) begin
+                    // Write-through; the BRAM lanes are updated through port B this cycle.
+                    wt_addr <= addr_q;
+                    wt_data <= wr_data;
+                    wt_strb <= wr_strb;
+                    aw_done <= 1'b0;
+                    w_done  <= 1'b0;
+                    look_ok <= 1'b0;
+                    state   <= C_SEND;
+                end else if (look_ok && rd_req) begin
+                    if (hit) begin
+                        if (!refilled) stat_hits <= stat_hits + 1;
+                        refilled <= 1'b0;
+                        if (WAYS > 1) lru[set_q] <= ~hit_way[0];
+                    end else begin
+                        stat_misses <= stat_misses + 1;
+                        line_addr   <= {addr_q[31:OFFS_W+2], {(OFFS_W+2){1'b0}}};
+                        // Invalid way first, else the LRU one.
+                        if (WAYS == 1 || !valid_ram[0][set_q])
+                            victim <= '0;
+                        else if (!valid_ram[WAYS-1][set_q])
+                            victim <= WAY_W'(WAYS - 1);
+                        else
+                            victim <= WAY_W'(lru[set_q]);
+                        look_ok <= 1'b0;
+                        state   <= C_AR;
+                    end
+                end
+            end
+
+            C_AR: begin
+                beat <= '0;
+                if (arready) state <= C_FILL;
+            end
+
+            C_FILL: begin
+                if (rvalid) begin
+                    beat <= beat + 1'b1;
+                    if (rlast) begin
+                        // An error response still fills the line (XMEM does not
+                        // return one); a retry loop would only hang the core.
+                        tag_ram[victim][line_addr[TAG_LSB-1:OFFS_W+2]]   <= line_addr[31:TAG_LSB];
+                        valid_ram[victim][line_addr[TAG_LSB-1:OFFS_W+2]] <= 1'b1;
+                        if (WAYS > 1) lru[line_addr[TAG_LSB-1:OFFS_W+2]] <= ~victim[0];
+                        refilled <= 1'b1;
+                        state <= C_IDLE;
+                    end
+                end
+            end
+
+            C_SEND: begin
+                if (awvalid && awready) aw_done <= 1'b1;
+                if (wvalid  && wready)  w_done  <= 1'b1;
+                if ((aw_done || awready) && (w_done || wready)) state <= C_WAIT_B;
+            end
+
+            C_WAIT_B: begin
+                if (bvalid) state <= C_ACK;
+            end
+
+            C_ACK: begin
+                if (wr_req) state <= C_IDLE;
+            end
+
+            default: state <= C_IDLE;
+            endcase
+        end
+    end
+
+    // AXI4: line refill (INCR burst of 32-bit beats)
+    assign araddr  = line_addr;
+    assign arlen   = 8'(LINE_WORDS - 1);
+    assign arsize  = 3'b010;
+    assign arburst = 2'b01;
+    assign arvalid = (state == C_AR);
+    assign rready  = (state == C_FILL);
+
+    // AXI4: write-through (single beat)
+    assign awaddr  = wt_addr;
+    assign awlen   = 8'd0;
+    assign awsize  = 3'b010;
+    assign awburst = 2'b01;
+    assign awvalid = (state == C_SEND) && !aw_done;
+    assign wdata   = wt_data;
+    assign wstrb   = wt_strb;
+    assign wlast   = 1'b1;
+    assign wvalid  = (state == C_SEND) && !w_done;
+    assign bready  = (state == C_WAIT_B);
+
+endmodule
@@ -0,0 +1,438 @@
+// Descriptor-driven DMA between AXI4-Lite peripheral registers and DMEM.
+//
+// Software builds a chain of descriptors in DMEM, writes the address of the first
+// one to DESC and sets CTRL.START. A descriptor moves COUNT elements between one
+// peripheral register (a FIFO port: SPI WRITE/READ, UART TX, ...) and consecutive
+// DMEM addresses:
+//   +0x0  PERIPH   peripheral register address (through the master port)
+//   +0x4  MEM      DMEM byte address
+//   +0x8  CTRL     [15:0]  COUNT      elements (0: only the wait, if enabled)
+//                  [16]    TO_MEM     1: PERIPH -> DMEM, 0: DMEM -> PERIPH
+//                  [17]    WORD       32-bit elements (MEM word aligned), else data[7:0]
+//                  [18]    WAIT_EACH  wait before every element, not only the first
+//                  [19]    WAIT_EN    poll the slave's status register (offset 0 of
+//                                     the PERIPH 4 KB slot) ...
+//                  [20]    WAIT_VAL   ... while bit WAIT_BIT reads WAIT_VAL
+//                  [28:24] WAIT_BIT
+//   +0xC  NEXT     next descriptor (0: end of chain)
+//
+// Registers (AXI4-Lite slave, whole-word writes):
+//   0x00 CTRL    [0] START (W, ignored while busy)  [1] IRQ_EN  [2] ABORT (W)
+//   0x04 STATUS  [0] BUSY  [1] DONE (W1C)  [2] ERR (W1C)
+//   0x08 DESC    first descriptor of the next START
+//   0x0C CUR     descriptor being run (R)
+//   0x10 COUNT   elements moved since START (R)
+// irq = IRQ_EN && (DONE || ERR). ERR stops the chain: a descriptor or MEM address
+// outside DMEM, or a SLVERR/DECERR response. ABORT ends it at the next element
+// boundary with DONE.
+//
+// DMEM is reached through its port B. The bootloader has priority on that port
+// (dmem_gnt low): the access is held until granted.
+module axi_dma #(
+    parameter int unsigned ADDR_WIDTH = 11,                 // DMEM words = 2**ADDR_WIDTH
+    parameter logic [31:0] DMEM_BASE = 32'h1000_0000,
+    parameter logic [31:0] DMEM_LENGTH = (32'h1 << (ADDR_WIDTH + 2))
+) (
+    input  logic                     clk,
+    input  logic                     nrst,
+
+    // AXI4-Lite SLAVE (registers)
+    input  logic [31:0]              awaddr,
+    input  logic [2:0]               awprot,
+    input  logic                     awvalid,
+    output logic                     awready,
+
+    input  logic [31:0]              wdata,
+    input  logic [3:0]               wstrb,
+    input  logic                     wvalid,
+    output logic                     wready,
+
+    output logic [1:0]               bresp,
+    output logic                     bvalid,
+    input  logic                     bready,
+
+    input  logic [31:0]              araddr,
+    input  logic [2:0]               arprot,
+    input  logic                     arvalid,
+    output logic                     arready,
+
+    output logic [31:0]              rdata,
+    output logic [1:0]               rresp,
+    output logic                     rvalid,
+    input  logic                     rready,
+
+    // AXI4-Lite MASTER (peripheral accesses)
+    output logic [31:0]              m_awaddr,
+    output logic [2:0]               m_awprot,
+    output logic                     m_awvalid,
+    input  logic                     m_awready,
+
+    output logic [31:0]              m_wdata,
+    output logic [3:0]               m_wstrb,
+    output logic                     m_wvalid,
+    input  logic                     m_wready,
+
+    input  logic [1:0]               m_bresp,
+    input  logic                     m_bvalid,
+    output logic                     m_bready,
+
+    output logic [31:0]              m_araddr,
+    output logic [2:0]               m_arprot,
+    output logic                     m_arvalid,
+    input  logic                     m_arready,
+
+    input  logic [31:0]              m_rdata,
+    input  logic [1:0]               m_rresp,
+    input  logic                     m_rvalid,
+    output logic                     m_rready,
+
+    // DMEM port B (sync read: dout_dmem one clock after the granted address)
+    output logic                     dmem_req,
+    input  logic                     dmem_gnt,
+    output logic                     we_dmem,
+    output logic [3:0]               wstrb_dmem,
+    output logic [ADDR_WIDTH-1:0]    addr_dmem,
+    output logic [31:0]              din_dmem,
+    input  logic [31:0]              dout_dmem,
+
+    output logic                     irq
+);
+
+    localparam logic [2:0] REG_CTRL   = 3'd0;
+    localparam logic [2:0] REG_STATUS = 3'd1;
+    localparam logic [2:0] REG_DESC   = 3'd2;
+    localparam logic [2:0] REG_CUR    = 3'd3;
+    localparam logic [2:0] REG_COUNT  = 3'd4;
+
+    typedef enum logic [3:0] {
+        S_IDLE,
+        S_DESC_RD,      // descriptor word desc_idx: address to DMEM
+        S_DESC_DATA,    //   ... and its data
+        S_POLL_AR,      // status register read
+        S_POLL_R,
+        S_ELEM,         // next element (or descriptor)
+        S_MEM_RD,       // DMEM -> PERIPH: read the element
+        S_MEM_DATA,
+        S_WR,           //   ... write it to PERIPH
+        S_WR_B,
+        S_RD_AR,        // PERIPH -> DMEM: read the element
+        S_RD_R,
+        S_MEM_WR,       //   ... write it to DMEM
+        S_ADV,
+        S_NEXT
+    } state_t;
+    state_t state;
+
+    // Registers
+    logic        irq_en;
+    logic        busy, done, err;
+    logic        abort_req;
+    logic [31:0] desc_reg;
+    logic [31:0] cur_desc;
+    logic [31:0] count;
+
+    // Current descriptor
+    logic [31:0] d_periph;
+    logic [31:0] d_mem;
+    logic [31:0] d_ctrl;
+    logic [31:0] d_next;
+    logic [1:0]  desc_idx;
+    logic [15:0] elem_left;
+    logic [31:0] data_q;
+    logic        aw_done, w_done;
+
+    logic d_to_mem, d_word, d_wait_each, d_wait_en, d_wait_val;
+    logic [4:0] d_wait_bit;
+
+    assign d_to_mem    = d_ctrl[16];
+    assign d_word      = d_ctrl[17];
+    assign d_wait_each = d_ctrl[18];
+    assign d_wait_en   = d_ctrl[19];
+    assign d_wait_val  = d_ctrl[20];
+    assign d_wait_bit  = d_ctrl[28:24];
+
+    // Address checks
+    logic [31:0] desc_off, mem_off, mem_addr;
+    logic        next_ok, start_ok, mem_ok;
+
+    assign desc_off = cur_desc - DMEM_BASE;
+    assign mem_off  = d_mem - DMEM_BASE;
+    assign mem_ok   = mem_off < DMEM_LENGTH;
+    assign next_ok  = d_next[1:0] == 2'b00 && (d_next - DMEM_BASE) <= DMEM_LENGTH - 32'd16;
+    assign start_ok = desc_reg[1:0] == 2'b00 && (desc_reg - DMEM_BASE) <= DMEM_LENGTH - 32'd16;
+
+    // -------------------------------------------------------------------------
+    // AXI4-Lite slave: AW and W may arrive in either order; the write happens
+    // once both are held, then B is returned.
+    logic        aw_have, w_have;
+    logic [2:0]  aw_reg;
+    logic [31:0] w_data_q;
+    logic        reg_we;
+    logic [2:0]  reg_waddr;
+    logic [31:0] reg_wdata;
+
+    assign awready = !aw_have && !bvalid;
+    assign wready  = !w_have && !bvalid;
+    assign bresp   = 2'b00;
+
+    assign reg_waddr = aw_have ? aw_reg   : awaddr[4:2];
+    assign reg_wdata = w_have  ? w_data_q : wdata;
+    assign reg_we    = (aw_have || (awvalid && awready)) && (w_have || (wvalid && wready));
+
+    always_ff @(posedge clk or negedge nrst) begin
+        if (!nrst) begin
+            aw_have  <= 1'b0;
+            w_have   <= 1'b0;
+            aw_reg   <= '0;
+            w_data_q <= '0;
+            bvalid   <= 1'b0;
+        end else begin
+            if (reg_we) begin
+                aw_have <= 1'b0;
+                w_have  <= 1'b0;
+                bvalid  <= 1'b1;
+            end else begin
+                if (awvalid && awready) begin
+                    aw_have <= 1'b1;
+                    aw_reg  <= awaddr[4:2];
+                end
+                if (wvalid && wready) begin
+                    w_have   <= 1'b1;
+                    w_data_q <= wdata;
+                end
+            end
+            if (bvalid && bready) bvalid <= 1'b0;
+        end
+    end
+
+    assign arready = !rvalid;
+    assign rresp   = 2'b00;
+
+    always_ff @(posedge clk or negedge nrst) begin
+        if (!nrst) begin
+            rvalid <= 1'b0;
+            rdata  <= '0;
+        end else begin
+            if (arvalid && arready) begin
+                rvalid <= 1'b1;
+                case (araddr[4:2])
+                    REG_CTRL:   rdata <= {30'b0, irq_en, 1'b0};
+                    REG_STATUS: rdata <= {29'b0, err, done, busy};
+                    REG_DESC:   rdata <= desc_reg;
+                    REG_CUR:    rdata <= cur_desc;
+                    REG_COUNT:  rdata <= count;
+                    default:    rdata <= '0;
+                endcase
+            end else if (rvalid && rready) begin
+                rvalid <= 1'b0;
+            end
+        end
+    end
+
+    assign irq = irq_en && (done || err);
+
+    // -------------------------------------------------------------------------
+    // Engine
+    always_ff @(posedge clk or negedge nrst) begin
+        if (!nrst) begin
+            state     <= S_IDLE;
+            irq_en    <= 1'b0;
+            busy      <= 1'b0;
+            done      <= 1'b0;
+            err       <= 1'b0;
+            abort_req <= 1'b0;
+            desc_reg  <= '0;
+            cur_desc  <= '0;
+            count     <= '0;
+            d_periph  <= '0;
+            d_mem     <= '0;
+            d_ctrl    <= '0;
+            d_next    <= '0;
+            desc_idx  <= '0;
+            elem_left <= '0;
+            data_q    <= '0;
+            aw_done   <= 1'b0;
+            w_done    <= 1'b0;
+        end else begin
+            // Register writes
+            if (reg_we) begin
+                case (reg_waddr)
+                    REG_CTRL: begin
+                        irq_en <= reg_wdata[1];
+                        if (reg_wdata[2] && busy) abort_req <= 1'b1;
+                    end
+                    REG_STATUS: begin
+                        if (reg_wdata[1]) done <= 1'b0;
+                        if (reg_wdata[2]) err  <= 1'b0;
+                    end
+                    REG_DESC: desc_reg <= reg_wdata;
+                    default: ;
+                endcase
+            end
+
+            case (state)
+            S_IDLE: begin
+                abort_req <= 1'b0;
+                if (reg_we && reg_waddr == REG_CTRL && reg_wdata[0]) begin
+                    done     <= 1'b0;
+                    err      <= 1'b0;
+                    count    <= '0;
+                    cur_desc <= desc_reg;
+                    desc_idx <= '0;
+                    if (start_ok) begin
+                        busy  <= 1'b1;
+                        state <= S_DESC_RD;
+                    end else begin
+                        err <= 1'b1;
+                    end
+                end
+            end
+
+            S_DESC_RD: if (dmem_gnt) state <= S_DESC_DATA;
+
+            S_DESC_DATA: begin
+                case (desc_idx)
+                    2'd0: d_periph <= dout_dmem;
+                    2'd1: d_mem    <= dout_dmem;
+                    2'd2: d_ctrl   <= dout_dmem;
+                    2'd3: d_next   <= dout_dmem;
+                endcase
+                desc_idx <= desc_idx + 1'b1;
+                if (desc_idx == 2'd3) begin
+                    elem_left <= d_ctrl[15:0];
+                    state     <= d_ctrl[19] ? S_POLL_AR : S_ELEM;
+                end else begin
+                    state <= S_DESC_RD;
+                end
+            end
+
+            S_POLL_AR: if (m_arready) state <= S_POLL_R;
+
+            S_POLL_R: begin
+                if (m_rvalid) begin
+                    if (m_rresp[1]) begin
+                        err   <= 1'b1;
+                        busy  <= 1'b0;
+                        state <= S_IDLE;
+                    end else if (abort_req) begin
+                        done  <= 1'b1;
+                        busy  <= 1'b0;
+                        state <= S_IDLE;
+                    end else if (m_rdata[d_wait_bit] == d_wait_val) begin
+                        state <= S_POLL_AR;
+                    end else begin
+                        state <= S_ELEM;
+                    end
+                end
+            end
+
+            S_ELEM: begin
+                aw_done <= 1'b0;
+                w_done  <= 1'b0;
+                if (elem_left == '0) begin
+                    state <= S_NEXT;
+                end else if (abort_req) begin
+                    done  <= 1'b1;
+                    busy  <= 1'b0;
+                    state <= S_IDLE;
+                end else if (!mem_ok) begin
+                    err   <= 1'b1;
+                    busy  <= 1'b0;
+                    state <= S_IDLE;
+                end else begin
+                    state <= d_to_mem ? S_RD_AR : S_MEM_RD;
+                end
+            end
+
+            S_MEM_RD: if (dmem_gnt) state <= S_MEM_DATA;
+
+            S_MEM_DATA: begin
+                data_q <= d_word ? dout_dmem : {24'b0, dout_dmem[8*d_mem[1:0] +: 8]};
+                state  <= S_WR;
+            end
+
+            S_WR: begin
+                if (m_awvalid && m_awready) aw_done <= 1'b1;
+                if (m_wvalid  && m_wready)  w_done  <= 1'b1;
+                if ((aw_done || m_awready) && (w_done || m_wready)) state <= S_WR_B;
+            end
+
+            S_WR_B: begin
+                if (m_bvalid) begin
+                    if (m_bresp[1]) begin
+                        err   <= 1'b1;
+                        busy  <= 1'b0;
+                        state <= S_IDLE;
+                    end else begin
+                        state <= S_ADV;
+                    end
+                end
+            end
+
+            S_RD_AR: if (m_arready) state <= S_RD_R;
+
+            S_RD_R: begin
+                if (m_rvalid) begin
+                    data_q <= m_rdata;
+                    if (m_rresp[1]) begin
+                        err   <= 1'b1;
+                        busy  <= 1'b0;
+                        state <= S_IDLE;
+                    end else begin
+                        state <= S_MEM_WR;
+                    end
+                end
+            end
+
+            S_MEM_WR: if (dmem_gnt) state <= S_ADV;
+
+            S_ADV: begin
+                count     <= count + 1'b1;
+                elem_left <= elem_left - 1'b1;
+                d_mem     <= d_mem + (d_word ? 32'd4 : 32'd1);
+                state     <= (d_wait_en && d_wait_each && elem_left != 16'd1) ? S_POLL_AR : S_ELEM;
+            end
+
+            S_NEXT: begin
+                desc_idx <= '0;
+                cur_desc <= d_next;
+                if (d_next == '0 || abort_req) begin
+                    done  <= 1'b1;
+                    busy  <= 1'b0;
+                    state <= S_IDLE;
+                end else if (!next_ok) begin
+                    err   <= 1'b1;
+                    busy  <= 1'b0;
+                    state <= S_IDLE;
+                end else begin
+                    state <= S_DESC_RD;
+                end
+            end
+
+            default: state <= S_IDLE;
+            endcase
+        end
+    end
+
+    // AXI4-Lite master
+    assign m_awaddr  = d_periph;
+    assign m_awprot  = 3'b000;
+    assign m_awvalid = (state == S_WR) && !aw_done;
+    assign m_wdata   = data_q;
+    assign m_wstrb   = 4'b1111;
+    assign m_wvalid  = (state == S_WR) && !w_done;
+    assign m_bready  = (state == S_WR_B);
+    assign m_araddr  = (state == S_POLL_AR) ? {d_periph[31:12], 12'h000} : d_periph;
+    assign m_arprot  = 3'b000;
+    assign m_arvalid = (state == S_POLL_AR) || (state == S_RD_AR);
+    assign m_rready  = (state == S_POLL_R) || (state == S_RD_R);
+
+    // DMEM port B
+    assign mem_addr   = (state == S_DESC_RD) ? desc_off + {28'b0, desc_idx, 2'b00} : mem_off;
+    assign dmem_req   = (state == S_DESC_RD) || (state == S_MEM_RD) || (state == S_MEM_WR);
+    assign we_dmem    = (state == S_MEM_WR) && dmem_gnt;
+    assign wstrb_dmem = d_word ? 4'b1111 : (4'b0001 << d_mem[1:0]);
+    assign addr_dmem  = mem_addr[ADDR_WIDTH+1:2];
+    assign din_dmem   = d_word ? data_q : {4{data_q[7:0]}};
+
+endmodule
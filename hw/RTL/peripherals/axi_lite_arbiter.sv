@@ -0,0 +1,189 @@
+// Two AXI4-Lite masters (LSU, DMA; or, with soc N_HARTS = 2, the two harts' LSUs)
+// onto one master port.
+//
+// Reads and writes are arbitrated separately, one transaction per channel at a
+// time. A master is picked while the channel is idle (round-robin when both
+// request, so neither a polling loop nor a long DMA chain starves the other),
+// then holds the channel from its AR/AW request to the R/B handshake.
+//
+// Lock (AMO): while m*_lock is high the master wants both channels to itself. No
+// new grant is made until the lock is taken, which waits for the other master's
+// transactions in flight to finish (round-robin when both lock). From then on
+// only the owner is granted, until it drops m*_lock. Tie the inputs low when a
+// master never locks.
+module axi_lite_arbiter (
+    input  logic        clk,
+    input  logic        nrst,
+
+    // Master 0: LSU
+    input  logic        m0_lock,
+    input  logic [31:0] m0_awaddr,
+    input  logic [2:0]  m0_awprot,
+    input  logic        m0_awvalid,
+    output logic        m0_awready,
+    input  logic [31:0] m0_wdata,
+    input  logic [3:0]  m0_wstrb,
+    input  logic        m0_wvalid,
+    output logic        m0_wready,
+    output logic [1:0]  m0_bresp,
+    output logic        m0_bvalid,
+    input  logic        m0_bready,
+    input  logic [31:0] m0_araddr,
+    input  logic [2:0]  m0_arprot,
+    input  logic        m0_arvalid,
+    output logic        m0_arready,
+    output logic [31:0] m0_rdata,
+    output logic [1:0]  m0_rresp,
+    output logic        m0_rvalid,
+    input  logic        m0_rready,
+
+    // Master 1: DMA
+    input  logic        m1_lock,
+    input  logic [31:0] m1_awaddr,
+    input  logic [2:0]  m1_awprot,
+    input  logic        m1_awvalid,
+    output logic        m1_awready,
+    input  logic [31:0] m1_wdata,
+    input  logic [3:0]  m1_wstrb,
+    input  logic        m1_wvalid,
+    output logic        m1_wready,
+    output logic [1:0]  m1_bresp,
+    output logic        m1_bvalid,
+    input  logic        m1_bready,
+    input  logic [31:0] m1_araddr,
+    input  logic [2:0]  m1_arprot,
+    input  logic        m1_arvalid,
+    output logic        m1_arready,
+    output logic [31:0] m1_rdata,
+    output logic [1:0]  m1_rresp,
+    output logic        m1_rvalid,
+    input  logic        m1_rready,
+
+    // AXI4-Lite master (to the crossbar)
+    output logic [31:0] awaddr,
+    output logic [2:0]  awprot,
+    output logic        awvalid,
+    input  logic        awready,
+    output logic [31:0] wdata,
+    output logic [3:0]  wstrb,
+    output logic        wvalid,
+    input  logic        wready,
+    input  logic [1:0]  bresp,
+    input  logic        bvalid,
+    output logic        bready,
+    output logic [31:0] araddr,
+    output logic [2:0]  arprot,
+    output logic        arvalid,
+    input  logic        arready,
+    input  logic [31:0] rdata,
+    input  logic [1:0]  rresp,
+    input  logic        rvalid,
+    output logic        rready
+);
+
+    logic wr_busy, wr_owner, wr_last, wr_sel;   // owner/last: 0 LSU, 1 DMA
+    logic rd_busy, rd_owner, rd_last, rd_sel;
+    logic m0_wr_req, m1_wr_req;
+    logic m0_rd_req, m1_rd_req;
+    logic wr_go, rd_go;                         // channel granted or being granted
+    logic lk_busy, lk_owner, lk_last, lk_sel;
+    logic lk_take;
+    logic m0_ok, m1_ok;                         // may be granted an idle channel
+
+    // Lock: idle, the locking master (round-robin); taken, the owner.
+    assign lk_sel  = lk_busy ? lk_owner : (m1_lock && (!m0_lock || !lk_last));
+    assign lk_take = !lk_busy && (m0_lock || m1_lock)
+                   && !(wr_busy && wr_owner != lk_sel) && !(rd_busy && rd_owner != lk_sel);
+    assign m0_ok   = lk_busy ? !lk_owner : !(m0_lock || m1_lock);
+    assign m1_ok   = lk_busy ?  lk_owner : !(m0_lock || m1_lock);
+
+    // The LSU raises AW and W together; the DMA may too. Either one is a request.
+    assign m0_wr_req = (m0_awvalid || m0_wvalid) && m0_ok;
+    assign m1_wr_req = (m1_awvalid || m1_wvalid) && m1_ok;
+    assign m0_rd_req = m0_arvalid && m0_ok;
+    assign m1_rd_req = m1_arvalid && m1_ok;
+
+    // Idle: the requester (the one that did not go last when both do). Busy: the owner.
+    assign wr_sel = wr_busy ? wr_owner : (m1_wr_req && (!m0_wr_req || !wr_last));
+    assign rd_sel = rd_busy ? rd_owner : (m1_rd_req && (!m0_rd_req || !rd_last));
+    assign wr_go  = wr_busy || m0_wr_req || m1_wr_req;
+    assign rd_go  = rd_busy || m0_rd_req || m1_rd_req;
+
+    // WRITE: AW, W and B follow the selected master
+    assign awaddr  = wr_sel ? m1_awaddr  : m0_awaddr;
+    assign awprot  = wr_sel ? m1_awprot  : m0_awprot;
+    assign awvalid = wr_go && (wr_sel ? m1_awvalid : m0_awvalid);
+    assign wdata   = wr_sel ? m1_wdata   : m0_wdata;
+    assign wstrb   = wr_sel ? m1_wstrb   : m0_wstrb;
+    assign wvalid  = wr_go && (wr_sel ? m1_wvalid : m0_wvalid);
+    assign bready  = wr_busy && (wr_owner ? m1_bready : m0_bready);
+
+    assign m0_awready = wr_go && !wr_sel && awready;
+    assign m0_wready  = wr_go && !wr_sel && wready;
+    assign m1_awready = wr_go &&  wr_sel && awready;
+    assign m1_wready  = wr_go &&  wr_sel && wready;
+    assign m0_bresp   = bresp;
+    assign m1_bresp   = bresp;
+    assign m0_bvalid  = wr_busy && !wr_owner && bvalid;
+    assign m1_bvalid  = wr_busy &&  wr_owner && bvalid;
+
+    // READ: AR and R follow the selected master
+    assign araddr  = rd_sel ? m1_araddr  : m0_araddr;
+    assign arprot  = rd_sel ? m1_arprot  : m0_arprot;
+    assign arvalid = rd_go && (rd_sel ? m1_arvalid : m0_arvalid);
+    assign rready  = rd_busy && (rd_owner ? m1_rready : m0_rready);
+
+    assign m0_arready = rd_go && !rd_sel && arready;
+    assign m1_arready = rd_go &&  rd_sel && arready;
+    assign m0_rdata   = rdata;
+    assign m1_rdata   = rdata;
+    assign m0_rresp   = rresp;
+    assign m1_rresp   = rresp;
+    assign m0_rvalid  = rd_busy && !rd_owner && rvalid;
+    assign m1_rvalid  = rd_busy &&  rd_owner && rvalid;
+
+    // The grant is taken on the first request cycle (valid must then stay high
+    // until its handshake) and released on the response.
+    always_ff @(posedge clk or negedge nrst) begin
+        if (!nrst) begin
+            wr_busy  <= 1'b0;
+            wr_owner <= 1'b0;
+            wr_last  <= 1'b0;
+            rd_busy  <= 1'b0;
+            rd_owner <= 1'b0;
+            rd_last  <= 1'b0;
+            lk_busy  <= 1'b0;
+            lk_owner <= 1'b0;
+            lk_last  <= 1'b0;
+        end else begin
+            if (!wr_busy) begin
+                if (m0_wr_req || m1_wr_req) begin
+                    wr_busy  <= 1'b1;
+                    wr_owner <= wr_sel;
+                    wr_last  <= wr_sel;
+                end
+            end else if (bvalid && bready) begin
+                wr_busy <= 1'b0;
+            end
+
+            if (!rd_busy) begin
+                if (m0_rd_req || m1_rd_req) begin
+                    rd_busy  <= 1'b1;
+                    rd_owner <= rd_sel;
+                    rd_last  <= rd_sel;
+                end
+            end else if (rvalid && rready) begin
+                rd_busy <= 1'b0;
+            end
+
+            if (lk_take) begin
+                lk_busy  <= 1'b1;
+                lk_owner <= lk_sel;
+                lk_last  <= lk_sel;
+            end else if (lk_busy && !(lk_owner ? m1_lock : m0_lock)) begin
+                lk_busy <= 1'b0;
+            end
+        end
+    end
+
+endmodule
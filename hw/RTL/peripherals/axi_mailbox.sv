@@ -0,0 +1,157 @@
+// Inter-hart mailbox (soc N_HARTS): software interrupt bits and a shared RAM on
+// the AXI4-Lite crossbar, reached by every hart's LSU (and the DMA).
+//
+//   0x000 + 4h  MSIP[h]  [0] machine software interrupt pending of hart h (R/W)
+//   0x800       RAM      RAM_WORDS words, byte strobes (the harts' DMEMs are private)
+//
+// msip[h] drives hart h's irq_software (mip.MSIP, mcause 0x80000003): a hart rings
+// another one by writing 1 to its MSIP word, the handler clears it by writing 0.
+// The RAM is where harts share data; AMO*.W on it are atomic, the axi_lite_arbiters
+// in front of the crossbar hold the other masters off for the whole AMO.
+// Other offsets read as 0 and ignore writes.
+module axi_mailbox #(
+    parameter int unsigned N_HARTS = 2,                     // MSIP words (at most 8)
+    parameter int unsigned RAM_WORDS = 512                  // at most 512 (0x800..0xFFF)
+) (
+    input  logic                     clk,
+    input  logic                     nrst,
+
+    // AXI4-Lite SLAVE
+    input  logic [31:0]              awaddr,
+    input  logic [2:0]               awprot,
+    input  logic                     awvalid,
+    output logic                     awready,
+
+    input  logic [31:0]              wdata,
+    input  logic [3:0]               wstrb,
+    input  logic                     wvalid,
+    output logic                     wready,
+
+    output logic [1:0]               bresp,
+    output logic                     bvalid,
+    input  logic                     bready,
+
+    input  logic [31:0]              araddr,
+    input  logic [2:0]               arprot,
+    input  logic                     arvalid,
+    output logic                     arready,
+
+    output logic [31:0]              rdata,
+    output logic [1:0]               rresp,
+    output logic                     rvalid,
+    input  logic                     rready,
+
+    output logic [N_HARTS-1:0]       msip
+);
+
+    localparam int unsigned RAM_AW = $clog2(RAM_WORDS);
+
+    logic [31:0] ram [RAM_WORDS];
+    logic [31:0] ram_q;
+    logic [31:0] reg_q;
+    logic        rd_ram;
+    logic        ram_w_hit;
+    logic        ram_r_hit;
+
+    // -------------------------------------------------------------------------
+    // AXI4-Lite slave: AW and W may arrive in either order; the write happens
+    // once both are held, then B is returned (same scheme as axi_dma).
+    logic        aw_have, w_have;
+    logic [11:0] aw_off;
+    logic [31:0] w_data_q;
+    logic [3:0]  w_strb_q;
+    logic        reg_we;
+    logic [11:0] reg_waddr;
+    logic [31:0] reg_wdata;
+    logic [3:0]  reg_wstrb;
+
+    assign awready = !aw_have && !bvalid;
+    assign wready  = !w_have && !bvalid;
+    assign bresp   = 2'b00;
+
+    assign reg_waddr = aw_have ? aw_off   : awaddr[11:0];
+    assign reg_wdata = w_have  ? w_data_q : wdata;
+    assign reg_wstrb = w_have  ? w_strb_q : wstrb;
+    assign reg_we    = (aw_have || (awvalid && awready)) && (w_have || (wvalid && wready));
+
+    always_ff @(posedge clk or negedge nrst) begin
+        if (!nrst) begin
+            aw_have  <= 1'b0;
+            w_have   <= 1'b0;
+            aw_off   <= '0;
+            w_data_q <= '0;
+            w_strb_q <= '0;
+            bvalid   <= 1'b0;
+            msip     <= '0;
+        end else begin
+            if (reg_we) begin
+                aw_have <= 1'b0;
+                w_have  <= 1'b0;
+                bvalid  <= 1'b1;
+                for (int h = 0; h < N_HARTS; h++) begin
+                    if (reg_waddr[11:2] == 10'(h) && reg_wstrb[0])
+                        msip[h] <= reg_wdata[0];
+                end
+            end else begin
+                if (awvalid && awready) begin
+                    aw_have <= 1'b1;
+                    aw_off  <= awaddr[11:0];
+                end
+                if (wvalid && wready) begin
+                    w_have   <= 1'b1;
+                    w_data_q <= wdata;
+                    w_strb_q <= wstrb;
+                end
+            end
+            if (bvalid && bready) bvalid <= 1'b0;
+        end
+    end
+
+    // A full-size RAM fills 0x800..0xFFF; a smaller one leaves the top unmapped
+    // (and a full one would make the bound check a constant compare).
+    generate if (RAM_WORDS == 512) begin : g_ram_full
+        assign ram_w_hit = reg_waddr[11];
+        assign ram_r_hit = araddr[11];
+    end else begin : g_ram_part
+        assign ram_w_hit = reg_waddr[11] && reg_waddr[10:2] < 9'(RAM_WORDS);
+        assign ram_r_hit = araddr[11] && araddr[10:2] < 9'(RAM_WORDS);
+    end endgenerate
+
+    // Shared RAM: byte-enable write and registered read, no reset (block RAM).
+    always_ff @(posedge clk) begin
+        if (reg_we && ram_w_hit) begin
+            for (int b = 0; b < 4; b++) begin
+                if (reg_wstrb[b])
+                    ram[reg_waddr[RAM_AW+1:2]][8*b +: 8] <= reg_wdata[8*b +: 8];
+            end
+        end
+        if (arvalid && arready) begin
+            ram_q <= ram[araddr[RAM_AW+1:2]];
+        end
+    end
+
+    assign arready = !rvalid;
+    assign rresp   = 2'b00;
+    assign rdata   = rd_ram ? ram_q : reg_q;
+
+    always_ff @(posedge clk or negedge nrst) begin
+        if (!nrst) begin
+            rvalid <= 1'b0;
+            rd_ram <= 1'b0;
+            reg_q  <= '0;
+        end else begin
+            if (arvalid && arready) begin
+                rvalid <= 1'b1;
+                rd_ram <= ram_r_hit;
+                reg_q  <= '0;
+                for (int h = 0; h < N_HARTS; h++) begin
+                    if (araddr[11:2] == 10'(h))
+                        reg_q <= {31'b0, msip[h]};
+                end
+            end else if (rvalid && rready) begin
+                rvalid <= 1'b0;
+            end
+        end
+    end
+
+endmodule
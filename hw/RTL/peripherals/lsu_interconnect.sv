@@ -16,7 +16,17 @@ module lsu_interconnect #(
     // IMEM length in bytes (assume same depth as DMEM unless overridden).
     parameter logic [31:0] IMEM_LENGTH = (32'h1 << (ADDR_DMEM_WIDTH + 2)),
     parameter addr_region_t DMEM_MAP = '{base: DMEM_BASE, length: DMEM_LENGTH},
-    parameter addr_region_t MMIO_MAP = '{base: 0, length: 32'h1000_0000}
+    parameter addr_region_t MMIO_MAP = '{base: 0, length: 32'h1000_0000},
+
+    // Posted MMIO writes: a store is accepted into a WBUF_DEPTH-entry buffer and the
+    // core moves on; the buffer drains in order to AXI. 0 = store waits for BRESP.
+    parameter int unsigned WBUF_DEPTH = 4,
+    // Crossbar slave granularity: loads wait for buffered writes to the same slave.
+    parameter int unsigned SLAVE_LSB = 12,
+
+    // Cached external memory (D-cache port); XMEM_LENGTH = 0 leaves it unmapped.
+    parameter logic [31:0] XMEM_BASE = 32'h8000_0000,
+    parameter logic [31:0] XMEM_LENGTH = 32'h0
 ) (
 
     input  logic                     clk,
@@ -33,6 +43,16 @@ module lsu_interconnect #(
     output logic [ADDR_DMEM_WIDTH-1:0]  addr_imem,
     input  logic [31:0]                 dout_imem,
 
+    // XMEM INTERFACE (l1_cache CPU side: lookup one cycle ahead of rd/wr)
+    output logic                        xmem_rd,
+    output logic                        xmem_wr,
+    output logic [31:0]                 xmem_addr,
+    output logic [3:0]                  xmem_wstrb,
+    output logic [31:0]                 xmem_wdata,
+    input  logic [31:0]                 xmem_rdata,
+    input  logic                        xmem_rvalid,
+    input  logic                        xmem_wready,
+
     // AXI4-Lite MASTER INTERFACE
     output logic [31:0]              awaddr,
     output logic [2:0]               awprot,
@@ -66,7 +86,12 @@ module lsu_interconnect #(
     input  logic [3:0]              strb_lsu,
     input  logic [31:0]             addr_lsu,
     input  logic [31:0]             data_lsu_i,
-    output logic [31:0]             data_lsu_o
+    output logic [31:0]             data_lsu_o,
+
+    // Posted-write status
+    output logic                    wbuf_empty,     // no MMIO write buffered or in flight (FENCE)
+    output logic                    wr_err,         // pulse: a write got SLVERR/DECERR
+    output logic [31:0]             wr_err_addr     // its address (valid with wr_err)
 );
 
     logic [31:0] lsu_byte_addr;
@@ -75,10 +100,24 @@ module lsu_interconnect #(
     state_t st_w, st_r;
 
     // WRITE CHANNEL SIGNALS
-    logic [31:0] lat_waddr, lat_wdata;
-    logic [3:0]  lat_wstrb;
     logic aw_done, w_done;
 
+    // POSTED-WRITE BUFFER (ring; an entry is freed when its BRESP arrives)
+    localparam int unsigned WBUF_SLOTS = (WBUF_DEPTH == 0) ? 1 : WBUF_DEPTH;
+    localparam int unsigned WBUF_PTR_W = (WBUF_SLOTS > 1) ? $clog2(WBUF_SLOTS) : 1;
+
+    logic [31:0] wbuf_addr [WBUF_SLOTS];
+    logic [31:0] wbuf_data [WBUF_SLOTS];
+    logic [3:0]  wbuf_strb [WBUF_SLOTS];
+    logic [WBUF_SLOTS-1:0] wbuf_valid;
+    logic [WBUF_PTR_W-1:0] wbuf_wr_ptr, wbuf_rd_ptr;
+    logic wbuf_push, wbuf_pop, wbuf_full;
+    logic rd_hazard;
+
+    // Non-posted mode (WBUF_DEPTH == 0): the store waits for its own BRESP.
+    typedef enum logic [1:0] {NP_IDLE, NP_WAIT, NP_DONE} np_state_t;
+    np_state_t st_np;
+
     // READ CHANNEL SIGNALS
     logic [31:0] lat_raddr, lat_rdata;
     logic ar_done, r_done;
@@ -89,11 +128,25 @@ module lsu_interconnect #(
 
     logic dmem_range, mmio_range;
     logic imem_range;
+    logic xmem_range;
     logic [31:0] imem_byte_addr;
 
     assign dmem_range = (addr_lsu >= DMEM_MAP.base) && (addr_lsu < (DMEM_MAP.base + DMEM_MAP.length));
     assign imem_range = (addr_lsu >= IMEM_BASE) && (addr_lsu < (IMEM_BASE + IMEM_LENGTH));
+    // The MMIO window starts at address 0, so its lower bound is always met; the
+    // compare is kept so the decode follows axi_map_pkg if the map moves.
+    /* verilator lint_off UNSIGNED */
     assign mmio_range = (addr_lsu >= MMIO_MAP.base) && (addr_lsu < (MMIO_MAP.base + MMIO_MAP.length));
+    /* verilator lint_on UNSIGNED */
+    assign xmem_range = (XMEM_LENGTH != 0) && (addr_lsu >= XMEM_BASE) && (addr_lsu < (XMEM_BASE + XMEM_LENGTH));
+
+    // The core keeps addr_lsu stable through S_MEM and raises rready/wvalid from
+    // its second cycle, so the cache has already looked the address up.
+    assign xmem_rd    = rready_lsu && xmem_range;
+    assign xmem_wr    = wvalid_lsu && xmem_range;
+    assign xmem_addr  = addr_lsu;
+    assign xmem_wstrb = strb_lsu;
+    assign xmem_wdata = data_lsu_i;
 
     always_comb begin
         lsu_byte_addr = addr_lsu - DMEM_BASE;
@@ -131,6 +184,16 @@ module lsu_interconnect #(
             data_lsu_o   = lat_rdata;
             rvalid_lsu   = rvalid_axi;
             wready_lsu   = wready_axi;
+        // ADDR IN XMEM RANGE (D-CACHE)
+        end else if (xmem_range) begin
+            we_dmem      = 0;
+            wstrb_dmem   = 0;
+            addr_dmem    = 0;
+            din_dmem     = 0;
+            addr_imem    = '0;
+            data_lsu_o   = xmem_rdata;
+            rvalid_lsu   = xmem_rvalid;
+            wready_lsu   = xmem_wready;
         // ADDR OUT OF RANGE
         end else begin
             // DISCONNECT DMEM INTERFACE
@@ -145,29 +208,94 @@ module lsu_interconnect #(
         end
     end
 
-    // AXI WRITE FSM
+    // WRITE BUFFER
+    assign wbuf_full  = wbuf_valid[wbuf_wr_ptr];
+    assign wbuf_empty = !(|wbuf_valid);
+
+    generate if (WBUF_DEPTH == 0) begin : g_wr_nonposted
+        assign wbuf_push = wvalid_lsu && mmio_range && (st_np == NP_IDLE);
+
+        always_ff @(posedge clk or negedge nrst) begin
+            if (!nrst) begin
+                st_np      <= NP_IDLE;
+                wready_axi <= 0;
+            end else begin
+                case (st_np)
+                NP_IDLE: if (wbuf_push) st_np <= NP_WAIT;
+                NP_WAIT: begin
+                    if (wbuf_pop) begin
+                        st_np      <= NP_DONE;
+                        wready_axi <= 1;
+                    end
+                end
+                NP_DONE: begin
+                    if (wready_lsu && wvalid_lsu) begin
+                        st_np      <= NP_IDLE;
+                        wready_axi <= 0;
+                    end
+                end
+                default: st_np <= NP_IDLE;
+                endcase
+            end
+        end
+    end else begin : g_wr_posted
+        // Accept as soon as there is room; the store retires like a DMEM store.
+        assign wbuf_push  = wvalid_lsu && mmio_range && !wbuf_full;
+        assign wready_axi = !wbuf_full;
+        assign st_np      = NP_IDLE;
+    end endgenerate
+
     always_ff @(posedge clk or negedge nrst) begin
         if (!nrst) begin
-            st_w     <= IDLE;
-            aw_done <= 0;
-            w_done  <= 0;
-            wready_axi <= 0;
-            lat_waddr <= 0;
-            lat_wdata <= 0;
-            lat_wstrb <= 0;
+            wbuf_valid  <= '0;
+            wbuf_wr_ptr <= '0;
+            wbuf_rd_ptr <= '0;
         end else begin
+            if (wbuf_push) begin
+                wbuf_addr[wbuf_wr_ptr] <= addr_lsu;
+                wbuf_data[wbuf_wr_ptr] <= data_lsu_i;
+                wbuf_strb[wbuf_wr_ptr] <= strb_lsu;
+                wbuf_wr_ptr <= (wbuf_wr_ptr == WBUF_PTR_W'(WBUF_SLOTS - 1)) ? '0 : wbuf_wr_ptr + 1'b1;
+            end
+            if (wbuf_pop) begin
+                wbuf_rd_ptr <= (wbuf_rd_ptr == WBUF_PTR_W'(WBUF_SLOTS - 1)) ? '0 : wbuf_rd_ptr + 1'b1;
+            end
+            // Push and pop never hit the same slot (a full buffer does not push).
+            for (int i = 0; i < WBUF_SLOTS; i++) begin
+                if (wbuf_push && wbuf_wr_ptr == WBUF_PTR_W'(i)) wbuf_valid[i] <= 1'b1;
+                if (wbuf_pop  && wbuf_rd_ptr == WBUF_PTR_W'(i)) wbuf_valid[i] <= 1'b0;
+            end
+        end
+    end
+
+    // Loads wait while a write to the same slave is buffered or in flight.
+    always_comb begin
+        rd_hazard = 1'b0;
+        for (int i = 0; i < WBUF_SLOTS; i++) begin
+            if (wbuf_valid[i] && wbuf_addr[i][31:SLAVE_LSB] == addr_lsu[31:SLAVE_LSB])
+                rd_hazard = 1'b1;
+        end
+    end
+
+    // AXI WRITE FSM: drains the buffer head, one transaction at a time.
+    always_ff @(posedge clk or negedge nrst) begin
+        if (!nrst) begin
+            st_w        <= IDLE;
+            aw_done     <= 0;
+            w_done      <= 0;
+            wr_err      <= 0;
+            wr_err_addr <= 0;
+        end else begin
+            wr_err <= 0;
+
             case (st_w)
 
             IDLE: begin
                 aw_done <= 0;
                 w_done  <= 0;
-                wready_axi <= 0;
 
-                if (wvalid_lsu & mmio_range) begin
-                    lat_waddr  <= addr_lsu;
-                    lat_wdata <= data_lsu_i;
-                    lat_wstrb <= strb_lsu;
-                    st_w        <= SEND;
+                if (wbuf_valid[wbuf_rd_ptr]) begin
+                    st_w <= SEND;
                 end
             end
 
@@ -182,27 +310,29 @@ module lsu_interconnect #(
 
             WAIT_B: begin
                 if (bvalid && bready) begin
-                    st_w <= WAIT_END;
-                    wready_axi <= 1;
-                end
-            end
-
-            WAIT_END: begin
-                if (wready_lsu && wvalid_lsu) begin
                     st_w <= IDLE;
+                    // SLVERR/DECERR arrive after a posted store has retired: report them.
+                    if (bresp[1]) begin
+                        wr_err      <= 1;
+                        wr_err_addr <= wbuf_addr[wbuf_rd_ptr];
+                    end
                 end
             end
 
+            default: st_w <= IDLE;
+
             endcase
         end
     end
 
+    assign wbuf_pop = (st_w == WAIT_B) && bvalid && bready;
+
     // AXI: WRITE ADDRESS & WRITE DATA CHANNELS
     assign awvalid = (st_w == SEND) && !aw_done;
     assign wvalid  = (st_w == SEND) && !w_done;
-    assign awaddr  = lat_waddr;
-    assign wdata   = lat_wdata;
-    assign wstrb   = lat_wstrb;
+    assign awaddr  = wbuf_addr[wbuf_rd_ptr];
+    assign wdata   = wbuf_data[wbuf_rd_ptr];
+    assign wstrb   = wbuf_strb[wbuf_rd_ptr];
     assign bready  = (st_w == WAIT_B);
 
 
@@ -222,7 +352,7 @@ module lsu_interconnect #(
                 r_done  <= 0;
                 rvalid_axi <= 0;
 
-                if (rready_lsu & mmio_range) begin
+                if (rready_lsu & mmio_range & !rd_hazard) begin
                     lat_raddr  <= addr_lsu;
                     st_r        <= SEND;
                 end
@@ -247,6 +377,8 @@ module lsu_interconnect #(
                 end
             end
 
+            default: st_r <= IDLE;
+
             endcase
         end
     end
@@ -8,7 +8,36 @@ module soc #(
     parameter int DATA_WIDTH = 32,
     // Base address for data memory (Harvard mapping).
     // All LOAD/STORE addresses are expected to be in [DMEM_BASE, DMEM_BASE + 4*2**ADDR_WIDTH_D).
-    parameter logic [31:0] DMEM_BASE = 32'h1000_0000
+    parameter logic [31:0] DMEM_BASE = 32'h1000_0000,
+    // Core microarchitecture: 0 multi-cycle, 1 five-stage pipeline (see ROC_RV32)
+    parameter bit CPU_PIPELINE = 1'b0,
+    // RV32M multiply/divide unit in the core (build software with -march=rv32imzicsr)
+    parameter bit CPU_RV32M = 1'b0,
+    // Also take interrupts between instructions when nothing is in flight (see ROC_RV32)
+    parameter bit CPU_EARLY_IRQ = 1'b0,
+    // RV32C compressed instructions (build software with -march=rv32iczicsr)
+    parameter bit CPU_RV32C = 1'b0,
+    // Posted MMIO write buffer entries in lsu_interconnect (0: stores wait for BRESP)
+    parameter int MMIO_WBUF_DEPTH = 4,
+    // Harts: 1, or 2 (build software with the A extension, -march=rv32iazicsr). Hart 1
+    // has its own IMEM (loaded with the same image), DMEM and lsu_interconnect, and
+    // shares the crossbar through a second axi_lite_arbiter. The peripheral and timer
+    // interrupts go to hart 0; both take software interrupts from axi_mailbox.
+    parameter int N_HARTS = 1,
+    // External memory (XMEM) at XMEM_BASE behind an I-cache and a D-cache on an
+    // AXI4 memory port (axi4_sram here). IMEM/DMEM stay as tightly coupled memory.
+    parameter bit XMEM_EN = 1'b0,
+    parameter logic [31:0] XMEM_BASE = 32'h8000_0000,
+    // 16 -> 2^16 words = 256KB
+    parameter int XMEM_ADDR_WIDTH = 16,
+    parameter int XMEM_READ_LATENCY = 8,
+    parameter int XMEM_WRITE_LATENCY = 4,
+    parameter string XMEM_INIT_FILE = "",
+    // Cache geometry: 1 (direct-mapped) or 2 ways, CACHE_SETS lines of CACHE_LINE_WORDS
+    parameter int ICACHE_WAYS = 1,
+    parameter int DCACHE_WAYS = 1,
+    parameter int CACHE_SETS = 64,
+    parameter int CACHE_LINE_WORDS = 8
 ) (
     input  logic                               clk,
     input  logic                               rst,
@@ -36,14 +65,48 @@ module soc #(
 );
 
     logic rst_n;
+    logic core_rst_n;
 
     assign rst_n = ~rst;
 
+    // Bootloader run control: the core can be held in reset or halted between
+    // instructions while the host loads or pokes memory. Only the core is reset;
+    // the interconnect finishes any posted MMIO write on its own.
+    logic core_halt;
+    logic core_reset;
+    logic core_halted;              // every hart
+    logic core0_halted;
+
+    assign core_rst_n = rst_n & ~core_reset;
+
     // IRQ
     logic                             timer_irq;
     logic [N_EXT_IRQ-1:0]             external_irq;
     logic                             gpio_irq;
 
+    // Copy of the CLINT mtime for the core time/timeh CSRs
+    logic [63:0]                      mtime_shadow;
+
+    // Software interrupts (axi_mailbox MSIP words), one per hart
+    logic [N_HARTS-1:0]               msip;
+
+    // AMO bus locks (axi_lite_arbiter m*_lock): hart 0, and any hart
+    logic                             amo_lock;
+    logic                             cpu_lock;
+
+    // UART TX FIFO level estimate and its "room" interrupt (external_irq[1])
+    localparam int UART_TX_DEPTH     = 16;
+    localparam int UART_TX_LOW_WATER = UART_TX_DEPTH / 2;
+    localparam int UART_BYTE_CYCLES  = (CLK_FREQ / BAUD_RATE + 1) * 10;
+    localparam int UART_TX_LEVEL_W   = $clog2(UART_TX_DEPTH) + 1;
+    localparam int UART_TX_TIMER_W   = $clog2(UART_BYTE_CYCLES);
+    logic [UART_TX_LEVEL_W-1:0]               uart_tx_level;
+    logic [UART_TX_TIMER_W-1:0]               uart_tx_timer;
+    logic                                     uart_aw_tx;
+    logic                                     uart_tx_push;
+    logic                                     uart_tx_pop;
+    logic                                     uart_tx_irq;
+
     // instruction memory
     logic [DATA_WIDTH-1:0]            data_imem_o;
     logic [DATA_WIDTH-1:0]            data_imem_i;
@@ -51,10 +114,16 @@ module soc #(
     logic [ADDR_WIDTH-1:0]            imem_addr_boot;
     logic [ADDR_WIDTH-1:0]            imem_addr_lsu;
     logic [DATA_WIDTH-1:0]            data_imem_lsu;
+    logic [DATA_WIDTH-1:0]            imem_hash_word;
     logic [ADDR_WIDTH-1:0]            imem_addr_b;
     logic [DATA_WIDTH-1:0]            imem_din_b;
     logic                             imem_we_b;
     logic                             we_i;
+    logic                             re_i;
+    logic [DATA_WIDTH-1:0]            data_imem_cpu;
+    logic [31:0]                      ifetch_addr;
+    logic                             ifetch_req;
+    logic                             imem_valid;
 
     // data memory
     logic                              wena_mem_d;
@@ -64,6 +133,24 @@ module soc #(
     logic [DATA_WIDTH-1:0]             data_dmem_o;
     logic [ADDR_WIDTH-1:0]             dmem_addr_boot;
     logic [DATA_WIDTH-1:0]             data_dmem_boot_o;
+    logic                              dmem_we_boot;
+    logic                              dmem_re_boot;
+    logic [(DATA_WIDTH/8)-1:0]         dmem_wstrb_boot;
+    logic [DATA_WIDTH-1:0]             dmem_din_boot;
+    logic [ADDR_WIDTH-1:0]             dmem_addr_b;
+    logic                              dmem_we_b;
+    logic [(DATA_WIDTH/8)-1:0]         dmem_wstrb_b;
+    logic [DATA_WIDTH-1:0]             dmem_din_b;
+    logic [DATA_WIDTH-1:0]             dmem_dout_b;
+
+    // DMA engine: DMEM port B when the bootloader is not using it
+    logic                              dma_dmem_req;
+    logic                              dma_dmem_gnt;
+    logic                              dma_dmem_we;
+    logic [(DATA_WIDTH/8)-1:0]         dma_dmem_wstrb;
+    logic [ADDR_WIDTH-1:0]             dma_dmem_addr;
+    logic [DATA_WIDTH-1:0]             dma_dmem_din;
+    logic                              dma_irq;
 
     // LSU interconnect signals
     logic                    rready_lsu;
@@ -74,8 +161,22 @@ module soc #(
     logic [31:0]             addr_lsu;
     logic [31:0]             data_lsu_i;
     logic [31:0]             data_lsu_o;
-
-    // AXI4-Lite MASTER INTERFACE signals
+    logic                    lsu_wbuf_empty;
+    logic                    lsu_wr_err;
+    logic [31:0]             lsu_wr_err_addr;
+
+    // LSU -> D-cache (XMEM)
+    localparam logic [31:0] XMEM_LENGTH = XMEM_EN ? (32'h1 << (XMEM_ADDR_WIDTH + 2)) : 32'h0;
+    logic                    xmem_rd;
+    logic                    xmem_wr;
+    logic [31:0]             xmem_addr;
+    logic [3:0]              xmem_wstrb;
+    logic [31:0]             xmem_wdata;
+    logic [31:0]             xmem_rdata;
+    logic                    xmem_rvalid;
+    logic                    xmem_wready;
+
+    // AXI4-Lite MASTER INTERFACE signals (LSU)
     logic [31:0]              awaddr;
     logic [2:0]               awprot;
     logic                     awvalid;
@@ -96,8 +197,71 @@ module soc #(
     logic                     rvalid;
     logic                     rready;
 
+    // Harts' master port: hart 0's LSU, or both LSUs through g_hart1.hart_arb
+    logic [31:0]              cpu_awaddr;
+    logic [2:0]               cpu_awprot;
+    logic                     cpu_awvalid;
+    logic                     cpu_awready;
+    logic [31:0]              cpu_wdata;
+    logic [3:0]               cpu_wstrb;
+    logic                     cpu_wvalid;
+    logic                     cpu_wready;
+    logic [1:0]               cpu_bresp;
+    logic                     cpu_bvalid;
+    logic                     cpu_bready;
+    logic [31:0]              cpu_araddr;
+    logic [2:0]               cpu_arprot;
+    logic                     cpu_arvalid;
+    logic                     cpu_arready;
+    logic [31:0]              cpu_rdata;
+    logic [1:0]               cpu_rresp;
+    logic                     cpu_rvalid;
+    logic                     cpu_rready;
+
+    // AXI4-Lite DMA master
+    logic [31:0]              dma_awaddr;
+    logic [2:0]               dma_awprot;
+    logic                     dma_awvalid;
+    logic                     dma_awready;
+    logic [31:0]              dma_wdata;
+    logic [3:0]               dma_wstrb;
+    logic                     dma_wvalid;
+    logic                     dma_wready;
+    logic [1:0]               dma_bresp;
+    logic                     dma_bvalid;
+    logic                     dma_bready;
+    logic [31:0]              dma_araddr;
+    logic [2:0]               dma_arprot;
+    logic                     dma_arvalid;
+    logic                     dma_arready;
+    logic [31:0]              dma_rdata;
+    logic [1:0]               dma_rresp;
+    logic                     dma_rvalid;
+    logic                     dma_rready;
+
+    // Crossbar master port (harts and DMA through axi_lite_arbiter)
+    logic [31:0]              xbar_awaddr;
+    logic [2:0]               xbar_awprot;
+    logic                     xbar_awvalid;
+    logic                     xbar_awready;
+    logic [31:0]              xbar_wdata;
+    logic [3:0]               xbar_wstrb;
+    logic                     xbar_wvalid;
+    logic                     xbar_wready;
+    logic [1:0]               xbar_bresp;
+    logic                     xbar_bvalid;
+    logic                     xbar_bready;
+    logic [31:0]              xbar_araddr;
+    logic [2:0]               xbar_arprot;
+    logic                     xbar_arvalid;
+    logic                     xbar_arready;
+    logic [31:0]              xbar_rdata;
+    logic [1:0]               xbar_rresp;
+    logic                     xbar_rvalid;
+    logic                     xbar_rready;
+
     localparam int AXI_ADDR_WIDTH = 32;
-    localparam int AXI_NUM_SLAVES = 5;
+    localparam int AXI_NUM_SLAVES = 7;
     localparam logic [AXI_ADDR_WIDTH-1:0] GPIO_BASE  = 32'h0000_0000;
     localparam logic [AXI_ADDR_WIDTH-1:0] GPIO_MASK  = 32'h0000_0FFF;
     localparam logic [AXI_ADDR_WIDTH-1:0] REG_BASE   = 32'h0000_1000;
@@ -108,6 +272,10 @@ module soc #(
     localparam logic [AXI_ADDR_WIDTH-1:0] CLINT_MASK = 32'h0000_0FFF;
     localparam logic [AXI_ADDR_WIDTH-1:0] SPI_BASE   = 32'h0000_4000;
     localparam logic [AXI_ADDR_WIDTH-1:0] SPI_MASK   = 32'h0000_0FFF;
+    localparam logic [AXI_ADDR_WIDTH-1:0] DMA_BASE   = 32'h0000_5000;
+    localparam logic [AXI_ADDR_WIDTH-1:0] DMA_MASK   = 32'h0000_0FFF;
+    localparam logic [AXI_ADDR_WIDTH-1:0] MAILBOX_BASE = 32'h0000_6000;
+    localparam logic [AXI_ADDR_WIDTH-1:0] MAILBOX_MASK = 32'h0000_0FFF;
 
     // AXI4-Lite SLAVE INTERFACE arrays (crossbar -> peripherals)
     logic [AXI_ADDR_WIDTH-1:0] awaddr_s [AXI_NUM_SLAVES-1:0];
@@ -134,6 +302,8 @@ module soc #(
     always_comb begin
         external_irq = '0;
         external_irq[0] = gpio_irq;
+        external_irq[1] = uart_tx_irq;
+        external_irq[2] = dma_irq;
     end
 
     // Core CPU
@@ -142,13 +312,21 @@ module soc #(
         .DATA_WIDTH_I(DATA_WIDTH),
         .ADDR_WIDTH_D(ADDR_WIDTH),
         .DATA_WIDTH_D(DATA_WIDTH),
-        .N_EXT_IRQ(N_EXT_IRQ)
+        .N_EXT_IRQ(N_EXT_IRQ),
+        .PIPELINE(CPU_PIPELINE),
+        .RV32M(CPU_RV32M),
+        .EARLY_IRQ(CPU_EARLY_IRQ),
+        .RV32C(CPU_RV32C),
+        .HART_ID(32'd0)
     ) cpu_core (
         .clk(clk),
-        .rst_n(rst_n),
+        .rst_n(core_rst_n),
         // instruction memory
-        .data_imem(data_imem_o),
+        .data_imem(data_imem_cpu),
         .imem_addr(imem_addr_cpu),
+        .ifetch_addr(ifetch_addr),
+        .ifetch_req(ifetch_req),
+        .imem_valid(imem_valid),
         // lsu
         .rready_cpu(rready_lsu),
         .rvalid_cpu(rvalid_lsu),
@@ -158,16 +336,68 @@ module soc #(
         .addr_cpu(addr_lsu),
         .data_cpu_o(data_lsu_i),
         .data_cpu_i(data_lsu_o),
+        .lsu_idle(lsu_wbuf_empty),
+        .bus_err(lsu_wr_err),
+        .bus_err_addr(lsu_wr_err_addr),
+        .amo_lock(amo_lock),
         // Interrupts
+        .irq_software(msip[0]),
         .timer_irq(timer_irq),
-        .external_irq(external_irq)
+        .external_irq(external_irq),
+        .mtime(mtime_shadow),
+        // Bootloader run control
+        .halt_req(core_halt),
+        .halted(core0_halted)
     );
 
+    // axi_clint does not export mtime. Its mtime counts one per clk from the same
+    // reset and is not writable over AXI, so this counter tracks it exactly and
+    // `rdtime` costs one CSR read instead of three AXI round-trips.
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n)
+            mtime_shadow <= 64'b0;
+        else
+            mtime_shadow <= mtime_shadow + 64'd1;
+    end
+
+    // top_uart has no interrupt output, so the TX level is tracked here the same way:
+    // +1 per accepted write to the TX register (offset 4), -1 per byte time while
+    // non-empty. The byte time is rounded up, so the estimate is never below the real
+    // level and software still checks the full flag before each write.
+    assign uart_tx_push = bvalid_s[2] && bready_s[2] && uart_aw_tx && bresp_s[2] == 2'b00
+                        && uart_tx_level != UART_TX_LEVEL_W'(UART_TX_DEPTH);
+    assign uart_tx_pop  = uart_tx_level != '0 && uart_tx_timer == UART_TX_TIMER_W'(UART_BYTE_CYCLES - 1);
+    assign uart_tx_irq  = uart_tx_level <= UART_TX_LEVEL_W'(UART_TX_LOW_WATER);
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            uart_aw_tx <= 1'b0;
+            uart_tx_level <= '0;
+            uart_tx_timer <= '0;
+        end else begin
+            if (awvalid_s[2] && awready_s[2])
+                uart_aw_tx <= awaddr_s[2][11:0] == 12'h004;
+
+            if (uart_tx_level == '0 || uart_tx_pop)
+                uart_tx_timer <= '0;
+            else
+                uart_tx_timer <= uart_tx_timer + 1'b1;
+
+            if (uart_tx_push && !uart_tx_pop)
+                uart_tx_level <= uart_tx_level + 1'b1;
+            else if (uart_tx_pop && !uart_tx_push)
+                uart_tx_level <= uart_tx_level - 1'b1;
+        end
+    end
+
     // LSU Interconnect
     lsu_interconnect #(
         .ADDR_DMEM_WIDTH(ADDR_WIDTH),
         .DMEM_BASE(DMEM_BASE),
-        .IMEM_BASE(32'h2000_0000)
+        .IMEM_BASE(32'h2000_0000),
+        .WBUF_DEPTH(MMIO_WBUF_DEPTH),
+        .XMEM_BASE(XMEM_BASE),
+        .XMEM_LENGTH(XMEM_LENGTH)
     ) lsu_ic (
         .clk(clk),
         .nrst(rst_n),
@@ -183,6 +413,16 @@ module soc #(
         .addr_imem(imem_addr_lsu),
         .dout_imem(data_imem_lsu),
 
+        // XMEM INTERFACE (D-cache)
+        .xmem_rd(xmem_rd),
+        .xmem_wr(xmem_wr),
+        .xmem_addr(xmem_addr),
+        .xmem_wstrb(xmem_wstrb),
+        .xmem_wdata(xmem_wdata),
+        .xmem_rdata(xmem_rdata),
+        .xmem_rvalid(xmem_rvalid),
+        .xmem_wready(xmem_wready),
+
         // AXI4-Lite MASTER INTERFACE
         .awaddr(awaddr),
         .awprot(awprot),
@@ -216,10 +456,86 @@ module soc #(
         .strb_lsu(strb_lsu),
         .addr_lsu(addr_lsu),
         .data_lsu_i(data_lsu_i),
-        .data_lsu_o(data_lsu_o)
+        .data_lsu_o(data_lsu_o),
+
+        // Posted-write status
+        .wbuf_empty(lsu_wbuf_empty),
+        .wr_err(lsu_wr_err),
+        .wr_err_addr(lsu_wr_err_addr)
     );
 
-    // AXI4-Lite crossbar (master from LSU -> MMIO slaves)
+    // Harts and DMA share the crossbar master port. An AMO also keeps the DMA out.
+    axi_lite_arbiter axi_arb (
+        .clk(clk),
+        .nrst(rst_n),
+
+        // Master 0: harts
+        .m0_lock(cpu_lock),
+        .m0_awaddr(cpu_awaddr),
+        .m0_awprot(cpu_awprot),
+        .m0_awvalid(cpu_awvalid),
+        .m0_awready(cpu_awready),
+        .m0_wdata(cpu_wdata),
+        .m0_wstrb(cpu_wstrb),
+        .m0_wvalid(cpu_wvalid),
+        .m0_wready(cpu_wready),
+        .m0_bresp(cpu_bresp),
+        .m0_bvalid(cpu_bvalid),
+        .m0_bready(cpu_bready),
+        .m0_araddr(cpu_araddr),
+        .m0_arprot(cpu_arprot),
+        .m0_arvalid(cpu_arvalid),
+        .m0_arready(cpu_arready),
+        .m0_rdata(cpu_rdata),
+        .m0_rresp(cpu_rresp),
+        .m0_rvalid(cpu_rvalid),
+        .m0_rready(cpu_rready),
+
+        // Master 1: DMA
+        .m1_lock(1'b0),
+        .m1_awaddr(dma_awaddr),
+        .m1_awprot(dma_awprot),
+        .m1_awvalid(dma_awvalid),
+        .m1_awready(dma_awready),
+        .m1_wdata(dma_wdata),
+        .m1_wstrb(dma_wstrb),
+        .m1_wvalid(dma_wvalid),
+        .m1_wready(dma_wready),
+        .m1_bresp(dma_bresp),
+        .m1_bvalid(dma_bvalid),
+        .m1_bready(dma_bready),
+        .m1_araddr(dma_araddr),
+        .m1_arprot(dma_arprot),
+        .m1_arvalid(dma_arvalid),
+        .m1_arready(dma_arready),
+        .m1_rdata(dma_rdata),
+        .m1_rresp(dma_rresp),
+        .m1_rvalid(dma_rvalid),
+        .m1_rready(dma_rready),
+
+        // To the crossbar
+        .awaddr(xbar_awaddr),
+        .awprot(xbar_awprot),
+        .awvalid(xbar_awvalid),
+        .awready(xbar_awready),
+        .wdata(xbar_wdata),
+        .wstrb(xbar_wstrb),
+        .wvalid(xbar_wvalid),
+        .wready(xbar_wready),
+        .bresp(xbar_bresp),
+        .bvalid(xbar_bvalid),
+        .bready(xbar_bready),
+        .araddr(xbar_araddr),
+        .arprot(xbar_arprot),
+        .arvalid(xbar_arvalid),
+        .arready(xbar_arready),
+        .rdata(xbar_rdata),
+        .rresp(xbar_rresp),
+        .rvalid(xbar_rvalid),
+        .rready(xbar_rready)
+    );
+
+    // AXI4-Lite crossbar (harts/DMA master -> MMIO slaves)
     axi_lite_crossbar #(
         .ADDR_WIDTH(AXI_ADDR_WIDTH),
         .DATA_WIDTH(DATA_WIDTH),
@@ -229,36 +545,38 @@ module soc #(
             '{base: REG_BASE,   mask: REG_MASK},
             '{base: UART_BASE,  mask: UART_MASK},
             '{base: CLINT_BASE, mask: CLINT_MASK},
-            '{base: SPI_BASE,   mask: SPI_MASK}
+            '{base: SPI_BASE,   mask: SPI_MASK},
+            '{base: DMA_BASE,   mask: DMA_MASK},
+            '{base: MAILBOX_BASE, mask: MAILBOX_MASK}
         })
     ) axi_xbar (
         .clk(clk),
         .nrst(rst_n),
 
         // Master Interface
-        .awaddr_m(awaddr),
-        .awprot_m(awprot),
-        .awvalid_m(awvalid),
-        .awready_m(awready),
-
-        .wdata_m(wdata),
-        .wstrb_m(wstrb),
-        .wvalid_m(wvalid),
-        .wready_m(wready),
-
-        .bresp_m(bresp),
-        .bvalid_m(bvalid),
-        .bready_m(bready),
-
-        .araddr_m(araddr),
-        .arprot_m(arprot),
-        .arvalid_m(arvalid),
-        .arready_m(arready),
-
-        .rdata_m(rdata),
-        .rresp_m(rresp),
-        .rvalid_m(rvalid),
-        .rready_m(rready),
+        .awaddr_m(xbar_awaddr),
+        .awprot_m(xbar_awprot),
+        .awvalid_m(xbar_awvalid),
+        .awready_m(xbar_awready),
+
+        .wdata_m(xbar_wdata),
+        .wstrb_m(xbar_wstrb),
+        .wvalid_m(xbar_wvalid),
+        .wready_m(xbar_wready),
+
+        .bresp_m(xbar_bresp),
+        .bvalid_m(xbar_bvalid),
+        .bready_m(xbar_bready),
+
+        .araddr_m(xbar_araddr),
+        .arprot_m(xbar_arprot),
+        .arvalid_m(xbar_arvalid),
+        .arready_m(xbar_arready),
+
+        .rdata_m(xbar_rdata),
+        .rresp_m(xbar_rresp),
+        .rvalid_m(xbar_rvalid),
+        .rready_m(xbar_rready),
 
         // Slave Interfaces
         .awaddr_s(awaddr_s),
@@ -487,8 +805,677 @@ module soc #(
 
     );
 
+    // AXI4-Lite DMA engine (peripheral FIFO <-> DMEM, descriptors in DMEM)
+    axi_dma #(
+        .ADDR_WIDTH(ADDR_WIDTH),
+        .DMEM_BASE(DMEM_BASE)
+    ) dma_i (
+        .clk(clk),
+        .nrst(rst_n),
+
+        // AXI4-Lite SLAVE (crossbar slave 5)
+        .awaddr(awaddr_s[5]),
+        .awprot(awprot_s[5]),
+        .awvalid(awvalid_s[5]),
+        .awready(awready_s[5]),
+
+        .wdata(wdata_s[5]),
+        .wstrb(wstrb_s[5]),
+        .wvalid(wvalid_s[5]),
+        .wready(wready_s[5]),
+
+        .bresp(bresp_s[5]),
+        .bvalid(bvalid_s[5]),
+        .bready(bready_s[5]),
+
+        .araddr(araddr_s[5]),
+        .arprot(arprot_s[5]),
+        .arvalid(arvalid_s[5]),
+        .arready(arready_s[5]),
+
+        .rdata(rdata_s[5]),
+        .rresp(rresp_s[5]),
+        .rvalid(rvalid_s[5]),
+        .rready(rready_s[5]),
+
+        // AXI4-Lite MASTER (arbiter master 1)
+        .m_awaddr(dma_awaddr),
+        .m_awprot(dma_awprot),
+        .m_awvalid(dma_awvalid),
+        .m_awready(dma_awready),
+
+        .m_wdata(dma_wdata),
+        .m_wstrb(dma_wstrb),
+        .m_wvalid(dma_wvalid),
+        .m_wready(dma_wready),
+
+        .m_bresp(dma_bresp),
+        .m_bvalid(dma_bvalid),
+        .m_bready(dma_bready),
+
+        .m_araddr(dma_araddr),
+        .m_arprot(dma_arprot),
+        .m_arvalid(dma_arvalid),
+        .m_arready(dma_arready),
+
+        .m_rdata(dma_rdata),
+        .m_rresp(dma_rresp),
+        .m_rvalid(dma_rvalid),
+        .m_rready(dma_rready),
+
+        // DMEM port B
+        .dmem_req(dma_dmem_req),
+        .dmem_gnt(dma_dmem_gnt),
+        .we_dmem(dma_dmem_we),
+        .wstrb_dmem(dma_dmem_wstrb),
+        .addr_dmem(dma_dmem_addr),
+        .din_dmem(dma_dmem_din),
+        .dout_dmem(dmem_dout_b),
+
+        .irq(dma_irq)
+    );
+
+    // Inter-hart mailbox: MSIP words and the shared RAM
+    axi_mailbox #(
+        .N_HARTS(N_HARTS)
+    ) mailbox_i (
+        .clk(clk),
+        .nrst(rst_n),
+
+        // AXI4-Lite SLAVE (crossbar slave 6)
+        .awaddr(awaddr_s[6]),
+        .awprot(awprot_s[6]),
+        .awvalid(awvalid_s[6]),
+        .awready(awready_s[6]),
+
+        .wdata(wdata_s[6]),
+        .wstrb(wstrb_s[6]),
+        .wvalid(wvalid_s[6]),
+        .wready(wready_s[6]),
+
+        .bresp(bresp_s[6]),
+        .bvalid(bvalid_s[6]),
+        .bready(bready_s[6]),
+
+        .araddr(araddr_s[6]),
+        .arprot(arprot_s[6]),
+        .arvalid(arvalid_s[6]),
+        .arready(arready_s[6]),
+
+        .rdata(rdata_s[6]),
+        .rresp(rresp_s[6]),
+        .rvalid(rvalid_s[6]),
+        .rready(rready_s[6]),
+
+        .msip(msip)
+    );
+
+    // External memory: I-cache + D-cache -> axi4_mem_arbiter -> AXI4 memory.
+    // The AXI4 port between the arbiter and axi4_sram is where a DDR controller goes.
+    generate if (XMEM_EN) begin : g_xmem
+
+        // Fetch from XMEM when the previous cycle's address was in it (the word
+        // on data_imem belongs to that address, as with the IMEM BRAM).
+        logic        ifetch_xmem;
+        logic        ifetch_xmem_q;
+        logic        icache_valid;
+        logic [31:0] icache_data;
+
+        // AXI4 channels: cache masters (ic_/dc_) and the memory port (m_)
+        logic [31:0] ic_araddr, dc_araddr, m_araddr;
+        logic [7:0]  ic_arlen, dc_arlen, m_arlen;
+        logic [2:0]  ic_arsize, dc_arsize, m_arsize;
+        logic [1:0]  ic_arburst, dc_arburst, m_arburst;
+        logic        ic_arvalid, dc_arvalid, m_arvalid;
+        logic        ic_arready, dc_arready, m_arready;
+        logic [31:0] ic_rdata, dc_rdata, m_rdata;
+        logic [1:0]  ic_rresp, dc_rresp, m_rresp;
+        logic        ic_rlast, dc_rlast, m_rlast;
+        logic        ic_rvalid, dc_rvalid, m_rvalid;
+        logic        ic_rready, dc_rready, m_rready;
+        logic [31:0] dc_awaddr, m_awaddr;
+        logic [7:0]  dc_awlen, m_awlen;
+        logic [2:0]  dc_awsize, m_awsize;
+        logic [1:0]  dc_awburst, m_awburst;
+        logic        dc_awvalid, m_awvalid;
+        logic        dc_awready, m_awready;
+        logic [31:0] dc_wdata, m_wdata;
+        logic [3:0]  dc_wstrb, m_wstrb;
+        logic        dc_wlast, m_wlast;
+        logic        dc_wvalid, m_wvalid;
+        logic        dc_wready, m_wready;
+        logic [1:0]  dc_bresp, m_bresp;
+        logic        dc_bvalid, m_bvalid;
+        logic        dc_bready, m_bready;
+
+        // Hit/refill counters (printed by tb_ROC_RV32_program)
+        logic [31:0] icache_hits, icache_misses;
+        logic [31:0] dcache_hits, dcache_misses;
+
+        assign ifetch_xmem = (ifetch_addr >= XMEM_BASE) && (ifetch_addr < (XMEM_BASE + XMEM_LENGTH));
+
+        always_ff @(posedge clk or negedge rst_n) begin
+            if (!rst_n) ifetch_xmem_q <= 1'b0;
+            else        ifetch_xmem_q <= ifetch_xmem;
+        end
+
+        assign data_imem_cpu = ifetch_xmem_q ? icache_data : data_imem_o;
+        assign imem_valid    = !ifetch_xmem_q || icache_valid;
+
+        l1_cache #(
+            .WAYS(ICACHE_WAYS),
+            .SETS(CACHE_SETS),
+            .LINE_WORDS(CACHE_LINE_WORDS)
+        ) icache (
+            .clk(clk),
+            .rst_n(rst_n),
+            .addr(ifetch_addr),
+            .rd_req(ifetch_req && ifetch_xmem_q),
+            .rd_valid(icache_valid),
+            .rd_data(icache_data),
+            .wr_req(1'b0),
+            .wr_strb(4'b0000),
+            .wr_data(32'b0),
+            .wr_ready(),
+            .araddr(ic_araddr),
+            .arlen(ic_arlen),
+            .arsize(ic_arsize),
+            .arburst(ic_arburst),
+            .arvalid(ic_arvalid),
+            .arready(ic_arready),
+            .rdata(ic_rdata),
+            .rresp(ic_rresp),
+            .rlast(ic_rlast),
+            .rvalid(ic_rvalid),
+            .rready(ic_rready),
+            .awaddr(),
+            .awlen(),
+            .awsize(),
+            .awburst(),
+            .awvalid(),
+            .awready(1'b0),
+            .wdata(),
+            .wstrb(),
+            .wlast(),
+            .wvalid(),
+            .wready(1'b0),
+            .bresp(2'b00),
+            .bvalid(1'b0),
+            .bready(),
+            .stat_hits(icache_hits),
+            .stat_misses(icache_misses)
+        );
+
+        l1_cache #(
+            .WAYS(DCACHE_WAYS),
+            .SETS(CACHE_SETS),
+            .LINE_WORDS(CACHE_LINE_WORDS)
+        ) dcache (
+            .clk(clk),
+            .rst_n(rst_n),
+            .addr(xmem_addr),
+            .rd_req(xmem_rd),
+            .rd_valid(xmem_rvalid),
+            .rd_data(xmem_rdata),
+            .wr_req(xmem_wr),
+            .wr_strb(xmem_wstrb),
+            .wr_data(xmem_wdata),
+            .wr_ready(xmem_wready),
+            .araddr(dc_araddr),
+            .arlen(dc_arlen),
+            .arsize(dc_arsize),
+            .arburst(dc_arburst),
+            .arvalid(dc_arvalid),
+            .arready(dc_arready),
+            .rdata(dc_rdata),
+            .rresp(dc_rresp),
+            .rlast(dc_rlast),
+            .rvalid(dc_rvalid),
+            .rready(dc_rready),
+            .awaddr(dc_awaddr),
+            .awlen(dc_awlen),
+            .awsize(dc_awsize),
+            .awburst(dc_awburst),
+            .awvalid(dc_awvalid),
+            .awready(dc_awready),
+            .wdata(dc_wdata),
+            .wstrb(dc_wstrb),
+            .wlast(dc_wlast),
+            .wvalid(dc_wvalid),
+            .wready(dc_wready),
+            .bresp(dc_bresp),
+            .bvalid(dc_bvalid),
+            .bready(dc_bready),
+            .stat_hits(dcache_hits),
+            .stat_misses(dcache_misses)
+        );
+
+        axi4_mem_arbiter xmem_arb (
+            .clk(clk),
+            .rst_n(rst_n),
+
+            .d_araddr(dc_araddr),
+            .d_arlen(dc_arlen),
+            .d_arsize(dc_arsize),
+            .d_arburst(dc_arburst),
+            .d_arvalid(dc_arvalid),
+            .d_arready(dc_arready),
+            .d_rdata(dc_rdata),
+            .d_rresp(dc_rresp),
+            .d_rlast(dc_rlast),
+            .d_rvalid(dc_rvalid),
+            .d_rready(dc_rready),
+            .d_awaddr(dc_awaddr),
+            .d_awlen(dc_awlen),
+            .d_awsize(dc_awsize),
+            .d_awburst(dc_awburst),
+            .d_awvalid(dc_awvalid),
+            .d_awready(dc_awready),
+            .d_wdata(dc_wdata),
+            .d_wstrb(dc_wstrb),
+            .d_wlast(dc_wlast),
+            .d_wvalid(dc_wvalid),
+            .d_wready(dc_wready),
+            .d_bresp(dc_bresp),
+            .d_bvalid(dc_bvalid),
+            .d_bready(dc_bready),
+
+            .i_araddr(ic_araddr),
+            .i_arlen(ic_arlen),
+            .i_arsize(ic_arsize),
+            .i_arburst(ic_arburst),
+            .i_arvalid(ic_arvalid),
+            .i_arready(ic_arready),
+            .i_rdata(ic_rdata),
+            .i_rresp(ic_rresp),
+            .i_rlast(ic_rlast),
+            .i_rvalid(ic_rvalid),
+            .i_rready(ic_rready),
+
+            .araddr(m_araddr),
+            .arlen(m_arlen),
+            .arsize(m_arsize),
+            .arburst(m_arburst),
+            .arvalid(m_arvalid),
+            .arready(m_arready),
+            .rdata(m_rdata),
+            .rresp(m_rresp),
+            .rlast(m_rlast),
+            .rvalid(m_rvalid),
+            .rready(m_rready),
+            .awaddr(m_awaddr),
+            .awlen(m_awlen),
+            .awsize(m_awsize),
+            .awburst(m_awburst),
+            .awvalid(m_awvalid),
+            .awready(m_awready),
+            .wdata(m_wdata),
+            .wstrb(m_wstrb),
+            .wlast(m_wlast),
+            .wvalid(m_wvalid),
+            .wready(m_wready),
+            .bresp(m_bresp),
+            .bvalid(m_bvalid),
+            .bready(m_bready)
+        );
+
+        axi4_sram #(
+            .ADDR_WIDTH(XMEM_ADDR_WIDTH),
+            .READ_LATENCY(XMEM_READ_LATENCY),
+            .WRITE_LATENCY(XMEM_WRITE_LATENCY),
+            .INIT_FILE(XMEM_INIT_FILE)
+        ) xmem (
+            .clk(clk),
+            .rst_n(rst_n),
+            .araddr(m_araddr),
+            .arlen(m_arlen),
+            .arsize(m_arsize),
+            .arburst(m_arburst),
+            .arvalid(m_arvalid),
+            .arready(m_arready),
+            .rdata(m_rdata),
+            .rresp(m_rresp),
+            .rlast(m_rlast),
+            .rvalid(m_rvalid),
+            .rready(m_rready),
+            .awaddr(m_awaddr),
+            .awlen(m_awlen),
+            .awsize(m_awsize),
+            .awburst(m_awburst),
+            .awvalid(m_awvalid),
+            .awready(m_awready),
+            .wdata(m_wdata),
+            .wstrb(m_wstrb),
+            .wlast(m_wlast),
+            .wvalid(m_wvalid),
+            .wready(m_wready),
+            .bresp(m_bresp),
+            .bvalid(m_bvalid),
+            .bready(m_bready)
+        );
+
+    end else begin : g_no_xmem
+        assign data_imem_cpu = data_imem_o;
+        assign imem_valid    = 1'b1;
+        assign xmem_rdata    = 32'b0;
+        assign xmem_rvalid   = 1'b0;
+        assign xmem_wready   = 1'b0;
+    end endgenerate
+
+    // Second hart: its own IMEM, DMEM and LSU, sharing the crossbar with hart 0
+    // through hart_arb. The bootloader's IMEM writes go to both IMEMs, so both
+    // harts run the same image (software branches on mhartid), and HASH reads
+    // both (imem_hash_word); DMEM loads, dumps and the DMA only reach hart 0's
+    // DMEM. Hart 1 has no XMEM port, no CLINT timer and no peripheral
+    // interrupts: hart 0 hands it work through the mailbox.
+    generate if (N_HARTS > 1) begin : g_hart1
+
+        logic [DATA_WIDTH-1:0]     data_imem1;
+        logic [ADDR_WIDTH-1:0]     imem_addr1;
+        logic [ADDR_WIDTH-1:0]     imem_addr_lsu1;
+        logic [DATA_WIDTH-1:0]     data_imem_lsu1;
+
+        logic                      wena_mem_d1;
+        logic [(DATA_WIDTH/8)-1:0] store_strb1;
+        logic [ADDR_WIDTH-1:0]     dmem_addr1;
+        logic [DATA_WIDTH-1:0]     store_wdata1;
+        logic [DATA_WIDTH-1:0]     data_dmem1;
+
+        logic                      rready_lsu1;
+        logic                      rvalid_lsu1;
+        logic                      wready_lsu1;
+        logic                      wvalid_lsu1;
+        logic [3:0]                strb_lsu1;
+        logic [31:0]               addr_lsu1;
+        logic [31:0]               data_lsu1_i;
+        logic [31:0]               data_lsu1_o;
+        logic                      lsu1_wbuf_empty;
+        logic                      lsu1_wr_err;
+        logic [31:0]               lsu1_wr_err_addr;
+        logic                      amo_lock1;
+        logic                      halted1;
+
+        // AXI4-Lite master (hart 1 LSU)
+        logic [31:0]               h1_awaddr;
+        logic [2:0]                h1_awprot;
+        logic                      h1_awvalid;
+        logic                      h1_awready;
+        logic [31:0]               h1_wdata;
+        logic [3:0]                h1_wstrb;
+        logic                      h1_wvalid;
+        logic                      h1_wready;
+        logic [1:0]                h1_bresp;
+        logic                      h1_bvalid;
+        logic                      h1_bready;
+        logic [31:0]               h1_araddr;
+        logic [2:0]                h1_arprot;
+        logic                      h1_arvalid;
+        logic                      h1_arready;
+        logic [31:0]               h1_rdata;
+        logic [1:0]                h1_rresp;
+        logic                      h1_rvalid;
+        logic                      h1_rready;
+
+        ROC_RV32 #(
+            .ADDR_WIDTH_I(ADDR_WIDTH),
+            .DATA_WIDTH_I(DATA_WIDTH),
+            .ADDR_WIDTH_D(ADDR_WIDTH),
+            .DATA_WIDTH_D(DATA_WIDTH),
+            .N_EXT_IRQ(N_EXT_IRQ),
+            .PIPELINE(CPU_PIPELINE),
+            .RV32M(CPU_RV32M),
+            .EARLY_IRQ(CPU_EARLY_IRQ),
+            .RV32C(CPU_RV32C),
+            .HART_ID(32'd1)
+        ) cpu_core1 (
+            .clk(clk),
+            .rst_n(core_rst_n),
+            // instruction memory (IMEM only)
+            .data_imem(data_imem1),
+            .imem_addr(imem_addr1),
+            .ifetch_addr(),
+            .ifetch_req(),
+            .imem_valid(1'b1),
+            // lsu
+            .rready_cpu(rready_lsu1),
+            .rvalid_cpu(rvalid_lsu1),
+            .wready_cpu(wready_lsu1),
+            .wvalid_cpu(wvalid_lsu1),
+            .strb_cpu(strb_lsu1),
+            .addr_cpu(addr_lsu1),
+            .data_cpu_o(data_lsu1_i),
+            .data_cpu_i(data_lsu1_o),
+            .lsu_idle(lsu1_wbuf_empty),
+            .bus_err(lsu1_wr_err),
+            .bus_err_addr(lsu1_wr_err_addr),
+            .amo_lock(amo_lock1),
+            // Interrupts
+            .irq_software(msip[1]),
+            .timer_irq(1'b0),
+            .external_irq('0),
+            .mtime(mtime_shadow),
+            // Bootloader run control
+            .halt_req(core_halt),
+            .halted(halted1)
+        );
+
+        lsu_interconnect #(
+            .ADDR_DMEM_WIDTH(ADDR_WIDTH),
+            .DMEM_BASE(DMEM_BASE),
+            .IMEM_BASE(32'h2000_0000),
+            .WBUF_DEPTH(MMIO_WBUF_DEPTH)
+        ) lsu_ic1 (
+            .clk(clk),
+            .nrst(rst_n),
+
+            .we_dmem(wena_mem_d1),
+            .wstrb_dmem(store_strb1),
+            .addr_dmem(dmem_addr1),
+            .din_dmem(store_wdata1),
+            .dout_dmem(data_dmem1),
+
+            .addr_imem(imem_addr_lsu1),
+            .dout_imem(data_imem_lsu1),
+
+            .xmem_rd(),
+            .xmem_wr(),
+            .xmem_addr(),
+            .xmem_wstrb(),
+            .xmem_wdata(),
+            .xmem_rdata(32'b0),
+            .xmem_rvalid(1'b0),
+            .xmem_wready(1'b0),
+
+            .awaddr(h1_awaddr),
+            .awprot(h1_awprot),
+            .awvalid(h1_awvalid),
+            .awready(h1_awready),
+
+            .wdata(h1_wdata),
+            .wstrb(h1_wstrb),
+            .wvalid(h1_wvalid),
+            .wready(h1_wready),
+
+            .bresp(h1_bresp),
+            .bvalid(h1_bvalid),
+            .bready(h1_bready),
+
+            .araddr(h1_araddr),
+            .arprot(h1_arprot),
+            .arvalid(h1_arvalid),
+            .arready(h1_arready),
+
+            .rdata(h1_rdata),
+            .rresp(h1_rresp),
+            .rvalid(h1_rvalid),
+            .rready(h1_rready),
+
+            .rready_lsu(rready_lsu1),
+            .rvalid_lsu(rvalid_lsu1),
+            .wready_lsu(wready_lsu1),
+            .wvalid_lsu(wvalid_lsu1),
+            .strb_lsu(strb_lsu1),
+            .addr_lsu(addr_lsu1),
+            .data_lsu_i(data_lsu1_i),
+            .data_lsu_o(data_lsu1_o),
+
+            .wbuf_empty(lsu1_wbuf_empty),
+            .wr_err(lsu1_wr_err),
+            .wr_err_addr(lsu1_wr_err_addr)
+        );
+
+        // Port B: the bootloader while it writes or hashes IMEM, otherwise hart 1's
+        // IMEM data window
+        imem #(
+            .ADDR_WIDTH(ADDR_WIDTH),
+            .DATA_WIDTH(DATA_WIDTH)
+        ) instruction_memory1 (
+            .clk(clk),
+
+            .en_a(1),
+            .we_a(0),
+            .addr_a(imem_addr1),
+            .din_a(32'b0),
+            .dout_a(data_imem1),
+
+            .en_b(1),
+            .we_b(imem_we_b),
+            .wstrb_b(imem_we_b ? 4'b1111 : 4'b0000),
+            .addr_b((imem_we_b || re_i) ? imem_addr_boot : imem_addr_lsu1),
+            .din_b(imem_din_b),
+            .dout_b(data_imem_lsu1)
+        );
+
+        dmem #(
+            .ADDR_WIDTH(ADDR_WIDTH),
+            .DATA_WIDTH(DATA_WIDTH)
+        ) data_memory1 (
+            .clk(clk),
+
+            .en_a(1),
+            .we_a(wena_mem_d1),
+            .wstrb_a(store_strb1),
+            .addr_a(dmem_addr1),
+            .din_a(store_wdata1),
+            .dout_a(data_dmem1),
+
+            .en_b(0),
+            .we_b(0),
+            .wstrb_b(4'b0000),
+            .addr_b('0),
+            .din_b(32'b0),
+            .dout_b()
+        );
+
+        // The two LSUs onto the harts' master port, with the AMO lock
+        axi_lite_arbiter hart_arb (
+            .clk(clk),
+            .nrst(rst_n),
+
+            // Master 0: hart 0 LSU
+            .m0_lock(amo_lock),
+            .m0_awaddr(awaddr),
+            .m0_awprot(awprot),
+            .m0_awvalid(awvalid),
+            .m0_awready(awready),
+            .m0_wdata(wdata),
+            .m0_wstrb(wstrb),
+            .m0_wvalid(wvalid),
+            .m0_wready(wready),
+            .m0_bresp(bresp),
+            .m0_bvalid(bvalid),
+            .m0_bready(bready),
+            .m0_araddr(araddr),
+            .m0_arprot(arprot),
+            .m0_arvalid(arvalid),
+            .m0_arready(arready),
+            .m0_rdata(rdata),
+            .m0_rresp(rresp),
+            .m0_rvalid(rvalid),
+            .m0_rready(rready),
+
+            // Master 1: hart 1 LSU
+            .m1_lock(amo_lock1),
+            .m1_awaddr(h1_awaddr),
+            .m1_awprot(h1_awprot),
+            .m1_awvalid(h1_awvalid),
+            .m1_awready(h1_awready),
+            .m1_wdata(h1_wdata),
+            .m1_wstrb(h1_wstrb),
+            .m1_wvalid(h1_wvalid),
+            .m1_wready(h1_wready),
+            .m1_bresp(h1_bresp),
+            .m1_bvalid(h1_bvalid),
+            .m1_bready(h1_bready),
+            .m1_araddr(h1_araddr),
+            .m1_arprot(h1_arprot),
+            .m1_arvalid(h1_arvalid),
+            .m1_arready(h1_arready),
+            .m1_rdata(h1_rdata),
+            .m1_rresp(h1_rresp),
+            .m1_rvalid(h1_rvalid),
+            .m1_rready(h1_rready),
+
+            // To axi_arb master 0
+            .awaddr(cpu_awaddr),
+            .awprot(cpu_awprot),
+            .awvalid(cpu_awvalid),
+            .awready(cpu_awready),
+            .wdata(cpu_wdata),
+            .wstrb(cpu_wstrb),
+            .wvalid(cpu_wvalid),
+            .wready(cpu_wready),
+            .bresp(cpu_bresp),
+            .bvalid(cpu_bvalid),
+            .bready(cpu_bready),
+            .araddr(cpu_araddr),
+            .arprot(cpu_arprot),
+            .arvalid(cpu_arvalid),
+            .arready(cpu_arready),
+            .rdata(cpu_rdata),
+            .rresp(cpu_rresp),
+            .rvalid(cpu_rvalid),
+            .rready(cpu_rready)
+        );
+
+        assign cpu_lock    = amo_lock || amo_lock1;
+        assign core_halted = core0_halted && halted1;
+
+        // HASH covers both IMEMs: a word that differs between them is hashed
+        // inverted, so the chunk CRC only matches when both hold the image.
+        assign imem_hash_word = (data_imem_lsu1 == data_imem_lsu) ? data_imem_lsu : ~data_imem_lsu;
+
+    end else begin : g_one_hart
+
+        assign cpu_awaddr  = awaddr;
+        assign cpu_awprot  = awprot;
+        assign cpu_awvalid = awvalid;
+        assign awready     = cpu_awready;
+        assign cpu_wdata   = wdata;
+        assign cpu_wstrb   = wstrb;
+        assign cpu_wvalid  = wvalid;
+        assign wready      = cpu_wready;
+        assign bresp       = cpu_bresp;
+        assign bvalid      = cpu_bvalid;
+        assign cpu_bready  = bready;
+        assign cpu_araddr  = araddr;
+        assign cpu_arprot  = arprot;
+        assign cpu_arvalid = arvalid;
+        assign arready     = cpu_arready;
+        assign rdata       = cpu_rdata;
+        assign rresp       = cpu_rresp;
+        assign rvalid      = cpu_rvalid;
+        assign cpu_rready  = rready;
+
+        assign cpu_lock       = amo_lock;
+        assign core_halted    = core0_halted;
+        assign imem_hash_word = data_imem_lsu;
+
+    end endgenerate
+
     // Instruction Memory (sync read)
-    assign imem_addr_b = (imem_we_b) ? imem_addr_boot : imem_addr_lsu;
+    // The bootloader owns port B while it writes or hashes IMEM.
+    assign imem_addr_b = (imem_we_b || re_i) ? imem_addr_boot : imem_addr_lsu;
     assign imem_din_b  = data_imem_i;
     assign imem_we_b   = we_i;
 
@@ -515,6 +1502,14 @@ module soc #(
     );
 
     // Data Memory
+    // Port B: the bootloader while it reads or writes DMEM, otherwise the DMA.
+    assign dma_dmem_gnt = !(dmem_we_boot || dmem_re_boot);
+    assign dmem_we_b    = dma_dmem_gnt ? dma_dmem_we    : dmem_we_boot;
+    assign dmem_wstrb_b = dma_dmem_gnt ? dma_dmem_wstrb : dmem_wstrb_boot;
+    assign dmem_addr_b  = dma_dmem_gnt ? dma_dmem_addr  : dmem_addr_boot;
+    assign dmem_din_b   = dma_dmem_gnt ? dma_dmem_din   : dmem_din_boot;
+    assign data_dmem_boot_o = dmem_dout_b;
+
     dmem #(
         .ADDR_WIDTH(ADDR_WIDTH),
         .DATA_WIDTH(DATA_WIDTH)
@@ -531,11 +1526,11 @@ module soc #(
 
         // Port B DEBUG/DMA
         .en_b(1),
-        .we_b(0),
-        .wstrb_b('0),
-        .addr_b(dmem_addr_boot),
-        .din_b(),         // Not used
-        .dout_b(data_dmem_boot_o)
+        .we_b(dmem_we_b),
+        .wstrb_b(dmem_wstrb_b),
+        .addr_b(dmem_addr_b),
+        .din_b(dmem_din_b),
+        .dout_b(dmem_dout_b)
     );
 
     // Bootloader Load/Store Controller
@@ -552,13 +1547,24 @@ module soc #(
         .tx(tx),
 
         // DMEM Interface
+        .we_d(dmem_we_boot),
+        .re_d(dmem_re_boot),
+        .wstrb_d(dmem_wstrb_boot),
         .addr_d(dmem_addr_boot),
+        .din_d(dmem_din_boot),
         .dout_d(data_dmem_boot_o),
 
         // IMEM Interface
         .we_i(we_i),
+        .re_i(re_i),
         .addr_i(imem_addr_boot),
-        .din_i(data_imem_i)
+        .din_i(data_imem_i),
+        .dout_i(imem_hash_word),
+
+        // Core run control
+        .core_halt(core_halt),
+        .core_reset(core_reset),
+        .core_halted(core_halted)
     );
 
     assign led_status = ~rst_n;
@@ -25,14 +25,49 @@ module tb_ROC_RV32_program;
 	parameter int ADDR_WIDTH = 11;
 	parameter int DATA_WIDTH = 32;
 	parameter int NANOS_PER_SEC = 1_000_000_000;
+	// Select the pipelined core with -gCPU_PIPELINE=1 (make ... CPU_PIPELINE=1).
+	parameter bit CPU_PIPELINE = 1'b0;
+	// RV32M unit with -gCPU_RV32M=1 (make ... CPU_RV32M=1 also builds with -march=rv32imzicsr).
+	parameter bit CPU_RV32M = 1'b0;
+	// Interrupts between instructions as well as at commit with -gCPU_EARLY_IRQ=1.
+	parameter bit CPU_EARLY_IRQ = 1'b0;
+	// RV32C with -gCPU_RV32C=1 (make ... CPU_RV32C=1 also builds with the C extension).
+	parameter bit CPU_RV32C = 1'b0;
+	// Posted MMIO write buffer depth (-gMMIO_WBUF_DEPTH=0: stores wait for BRESP).
+	parameter int MMIO_WBUF_DEPTH = 4;
+	// Cached external memory at 0x8000_0000 (-gXMEM_EN=1); the image for it comes
+	// from +XMEM=<file> (make ... XMEM=1). Cache/memory knobs as in soc.sv.
+	parameter bit XMEM_EN = 1'b0;
+	parameter int XMEM_READ_LATENCY = 8;
+	parameter int XMEM_WRITE_LATENCY = 4;
+	parameter int ICACHE_WAYS = 1;
+	parameter int DCACHE_WAYS = 1;
+	parameter int CACHE_SETS = 64;
+	parameter int CACHE_LINE_WORDS = 8;
+	// Second hart with -gN_HARTS=2 (make ... N_HARTS=2 also builds with the A extension).
+	// Both harts run the image; the stop protocol watches hart 0's DMEM.
+	parameter int N_HARTS = 1;
 	localparam time BIT_TIME = NANOS_PER_SEC / BAUD_RATE;
+	localparam time CLK_PERIOD = 20;
 
 	soc #(
 		.CLK_FREQ(CLK_FREQ),
 		.BAUD_RATE(BAUD_RATE),
 		.ADDR_WIDTH(ADDR_WIDTH),
 		.DATA_WIDTH(DATA_WIDTH),
-		.N_EXT_IRQ(1)
+		.CPU_PIPELINE(CPU_PIPELINE),
+		.CPU_RV32M(CPU_RV32M),
+		.CPU_EARLY_IRQ(CPU_EARLY_IRQ),
+		.CPU_RV32C(CPU_RV32C),
+		.MMIO_WBUF_DEPTH(MMIO_WBUF_DEPTH),
+		.XMEM_EN(XMEM_EN),
+		.XMEM_READ_LATENCY(XMEM_READ_LATENCY),
+		.XMEM_WRITE_LATENCY(XMEM_WRITE_LATENCY),
+		.ICACHE_WAYS(ICACHE_WAYS),
+		.DCACHE_WAYS(DCACHE_WAYS),
+		.CACHE_SETS(CACHE_SETS),
+		.CACHE_LINE_WORDS(CACHE_LINE_WORDS),
+		.N_HARTS(N_HARTS)
 	) dut (
 		.clk(clk),
 		.rst(~rst_n),
@@ -51,8 +86,21 @@ module tb_ROC_RV32_program;
 		.spi_cs_n(spi_cs_n)
 	);
 
+	// Cache statistics at the final snapshot (the g_xmem scope only exists with XMEM_EN).
+	event final_snapshot;
+
+	generate if (XMEM_EN) begin : g_cache_stats
+		always @(final_snapshot) begin
+			$display("icache: hits=%0d misses=%0d  dcache: hits=%0d misses=%0d  (ways %0d/%0d, %0d sets x %0d words, xmem lat r%0d/w%0d)",
+				dut.g_xmem.icache_hits, dut.g_xmem.icache_misses,
+				dut.g_xmem.dcache_hits, dut.g_xmem.dcache_misses,
+				ICACHE_WAYS, DCACHE_WAYS, CACHE_SETS, CACHE_LINE_WORDS,
+				XMEM_READ_LATENCY, XMEM_WRITE_LATENCY);
+		end
+	end endgenerate
+
 	initial clk = 1'b0;
-	always #10 clk = ~clk;
+	always #(CLK_PERIOD / 2) clk = ~clk;
 
 	task automatic reset_dut();
 		rst_n = 1'b0;
@@ -62,6 +110,7 @@ module tb_ROC_RV32_program;
 	endtask
 
 	int unsigned cycles;
+	int unsigned instret;
 	int unsigned store_count;
 	logic        saw_store_to_word0;
 	logic        saw_fail_signature;
@@ -75,6 +124,21 @@ module tb_ROC_RV32_program;
 	logic [31:0] imem_image[$];
 	string line;
 	logic [31:0] dmem_buffer[$];
+	// Retirement trace (+TRACE=<file>), format in tools/roc_trace.h
+	string       trace_path;
+	integer      trace_fd;
+	int unsigned trace_wait;
+	// +FAST_LOAD / +FAST_DUMP: IMEM and DMEM BRAM accessed directly, in zero simulated
+	// time, instead of through the bootloader UART. +CHECK_DUMP compares a UART dump
+	// with the BRAM contents (the bootloader test). Cycles spent on, or saved from,
+	// the bootloader UART are reported in the "[TB] boot:" line.
+	bit          fast_load;
+	bit          fast_dump;
+	bit          check_dump;
+	int unsigned dump_words;
+	int unsigned dump_errors;
+	longint unsigned uart_cycles;
+	longint unsigned skipped_cycles;
 
 	task automatic uart_send_byte(input logic [7:0] data);
 		@(posedge clk);
@@ -131,13 +195,19 @@ module tb_ROC_RV32_program;
 		end
 	endtask
 
-	task automatic load_imem_via_uart();
+	// Bootloader UART cycles for `bytes` bytes (start, 8 data and stop bits each).
+	function automatic longint unsigned uart_cycles_for(input longint unsigned bytes);
+		return bytes * 10 * BIT_TIME / CLK_PERIOD;
+	endfunction
+
+	// An IMEM load: a header per 128-word chunk, the words, then the settle time.
+	function automatic longint unsigned uart_load_cycles(input int words);
+		return uart_cycles_for(4 * (words + (words + 127) / 128)) + 200 * BIT_TIME / CLK_PERIOD;
+	endfunction
+
+	task automatic read_imem_image();
 		int r;
 		logic [31:0] word;
-		int idx;
-		int chunk_len;
-		int remaining;
-		logic [31:0] chunk[$];
 
 		imem_image.delete();
 		fd = $fopen(imem_path, "r");
@@ -160,7 +230,17 @@ module tb_ROC_RV32_program;
 		if (imem_image.size() > (1<<ADDR_WIDTH)) begin
 			$fatal(1, "IMEM image too large: %0d words", imem_image.size());
 		end
+	endtask
+
+	task automatic load_imem_via_uart();
+		int idx;
+		int chunk_len;
+		int remaining;
+		logic [31:0] chunk[$];
+		time t0;
 
+		t0 = $time;
+		read_imem_image();
 		idx = 0;
 		remaining = imem_image.size();
 		while (remaining > 0) begin
@@ -173,14 +253,84 @@ module tb_ROC_RV32_program;
 			idx += chunk_len;
 			remaining -= chunk_len;
 		end
+		#(BIT_TIME * 200);
+		uart_cycles += ($time - t0) / CLK_PERIOD;
+		$display("[TB] IMEM: %0d words over the bootloader UART in %0d cycles", imem_image.size(), ($time - t0) / CLK_PERIOD);
+	endtask
+
+	// Hart 1's IMEM gets the same image (the g_hart1 scope only exists with N_HARTS > 1).
+	event imem_backdoor;
+	logic run_window = 1'b0;
+
+	generate if (N_HARTS > 1) begin : g_hart1_tb
+		int unsigned instret1 = 0;
+
+		always @(imem_backdoor) begin
+			for (int i = 0; i < imem_image.size(); i++) begin
+				dut.g_hart1.instruction_memory1.data_memory.mem[i] = imem_image[i];
+			end
+		end
+
+		always @(posedge clk) begin
+			if (run_window && rst_n && dut.g_hart1.cpu_core1.instr_retire) begin
+				instret1 <= instret1 + 1;
+			end
+		end
+
+		always @(final_snapshot) begin
+			$display("hart1: instret=%0d pc_output=0x%08x halted=%0d",
+				instret1, dut.g_hart1.cpu_core1.pc_output, dut.g_hart1.halted1);
+		end
+	end endgenerate
+
+	task automatic load_imem_backdoor();
+		read_imem_image();
+		for (int i = 0; i < imem_image.size(); i++) begin
+			dut.instruction_memory.data_memory.mem[i] = imem_image[i];
+		end
+		-> imem_backdoor;
+		skipped_cycles += uart_load_cycles(imem_image.size());
+		$display("[TB] IMEM: %0d words written directly (+FAST_LOAD), %0d UART cycles skipped",
+			imem_image.size(), uart_load_cycles(imem_image.size()));
+	endtask
+
+	task automatic load_imem();
+		if (fast_load) begin
+			load_imem_backdoor();
+		end else begin
+			load_imem_via_uart();
+		end
+	endtask
+
+	// One record per retired instruction: seven little-endian words (%u).
+	task automatic trace_record();
+		$fwrite(trace_fd, "%u%u%u%u%u%u%u", cycles,
+			dut.cpu_core.rvfi_pc, dut.cpu_core.rvfi_insn, dut.cpu_core.rvfi_rd_wdata,
+			dut.cpu_core.rvfi_mem_addr, dut.cpu_core.rvfi_mem_data,
+			{trace_wait[15:0], 4'b0, dut.cpu_core.rvfi_intr, dut.cpu_core.rvfi_mem_store,
+			 dut.cpu_core.rvfi_mem_load, dut.cpu_core.rvfi_c, 3'b0, dut.cpu_core.rvfi_rd_addr});
 	endtask
 
 	task automatic dump_dmem(input int count);
 		logic [31:0] words[$];
+		time t0;
 		$display("---- DMEM DUMP (word-addressed) ----");
-		bootloader_read_dmem(0, count, words);
+		if (fast_dump) begin
+			for (int i = 0; i < count; i++) begin
+				words.push_back(dut.data_memory.data_memory.mem[i]);
+			end
+			skipped_cycles += uart_cycles_for(4 + 4 * count);
+		end else begin
+			t0 = $time;
+			bootloader_read_dmem(0, count, words);
+			uart_cycles += ($time - t0) / CLK_PERIOD;
+		end
 		for (int i = 0; i < words.size(); i++) begin
 			$display("dmem[%0d]=0x%08x", i, words[i]);
+			if (check_dump && !fast_dump && words[i] !== dut.data_memory.data_memory.mem[i]) begin
+				$error("DMEM dump mismatch at dmem[%0d]: UART 0x%08x, BRAM 0x%08x", i, words[i], dut.data_memory.data_memory.mem[i]);
+				dump_errors++;
+			end
 		end
 		$display("----------------------------------");
 	endtask
@@ -260,6 +410,14 @@ module tb_ROC_RV32_program;
 		use_stop_wdata = 1'b1;
 		void'($value$plusargs("STOP_ADDR=%d", stop_addr_word));
 		void'($value$plusargs("MAX_CYCLES=%d", max_cycles));
+		fast_load = $test$plusargs("FAST_LOAD");
+		fast_dump = $test$plusargs("FAST_DUMP");
+		check_dump = $test$plusargs("CHECK_DUMP");
+		dump_words = 10;
+		void'($value$plusargs("DUMP_WORDS=%d", dump_words));
+		dump_errors = 0;
+		uart_cycles = 0;
+		skipped_cycles = 0;
 		if ($value$plusargs("STOP_WDATA=%h", stop_wdata)) begin
 			use_stop_wdata = 1'b1;
 		end
@@ -270,26 +428,46 @@ module tb_ROC_RV32_program;
 		end
 
 		// Load program into IMEM through bootloader UART.
+		// +IMEM=<path> selects the image (used by tools/regress.py to give each test its own).
 		// Note: Questa runs from ./questasim (see run_sim.tcl), so we try paths relative to that.
-		imem_path = "sw/imem.dat";
-		fd = $fopen(imem_path, "r");
-		if (fd == 0) begin
-			imem_path = "../sw/imem.dat";
+		if ($value$plusargs("IMEM=%s", imem_path)) begin
+			fd = $fopen(imem_path, "r");
+			if (fd == 0) begin
+				$fatal(1, "Failed to open %s", imem_path);
+			end
+		end else begin
+			imem_path = "sw/imem.dat";
 			fd = $fopen(imem_path, "r");
+			if (fd == 0) begin
+				imem_path = "../sw/imem.dat";
+				fd = $fopen(imem_path, "r");
+			end
 		end
 		if (fd == 0) begin
 			$fatal(1, "Failed to open sw/imem.dat (tried sw/imem.dat and ../sw/imem.dat)");
 		end
 		$fclose(fd);
-		$display("[TB] Loading IMEM via bootloader from: %s", imem_path);
+		$display("[TB] Loading IMEM %s from: %s", fast_load ? "directly" : "via bootloader", imem_path);
 
-		load_imem_via_uart();
-		#(BIT_TIME * 200);
+		load_imem();
 
 		reset_dut();
 
 
+		trace_fd = 0;
+		trace_wait = 0;
+		if ($value$plusargs("TRACE=%s", trace_path)) begin
+			trace_fd = $fopen(trace_path, "wb");
+			if (trace_fd == 0) begin
+				$fatal(1, "Failed to open %s", trace_path);
+			end
+			$fwrite(trace_fd, "%u%u%u%u", 32'h5254_5652, 32'd1, 32'd7, 32'd0);
+			$display("[TB] Writing retirement trace to: %s", trace_path);
+		end
+
 		cycles = 0;
+		instret = 0;
+		run_window = 1'b1;
 		store_count = 0;
 		saw_store_to_word0 = 1'b0;
 		saw_fail_signature = 1'b0;
@@ -300,6 +478,20 @@ module tb_ROC_RV32_program;
 		while (!saw_store_to_word0 && cycles < max_cycles) begin
 			@(posedge clk);
 			cycles++;
+			if (rst_n && dut.cpu_core.instr_retire) begin
+				instret++;
+			end
+
+			// LSU wait cycles are charged to the next instruction to retire.
+			if (rst_n && trace_fd != 0) begin
+				if (dut.cpu_core.ev_lsu_stall && trace_wait != 32'hFFFF) begin
+					trace_wait++;
+				end
+				if (dut.cpu_core.rvfi_valid) begin
+					trace_record();
+					trace_wait = 0;
+				end
+			end
 
 			if (rst_n && dut.cpu_core.cpu_state == 3'd4) begin
 				// $display("[WB] pc=0x%08x ir=0x%08x opcode=0x%02x rd=%0d rs1=%0d rs2=%0d", dut.cpu_core.pc_ir, dut.cpu_core.ir, dut.cpu_core.opcode, dut.cpu_core.rd, dut.cpu_core.rs1, dut.cpu_core.rs2);
@@ -327,6 +519,8 @@ module tb_ROC_RV32_program;
 			end
 		end
 
+		run_window = 1'b0;
+
 		if (!saw_store_to_word0) begin
 			$fatal(1, "Timeout: no stop store observed within %0d cycles. Default is store 0x%08x to dmem[word %0d]. Optional: +STOP_WDATA=<hex>, +STOP_ADDR=<word>, +MAX_CYCLES=<n>.", max_cycles, stop_wdata, stop_addr_word);
 		end
@@ -336,22 +530,39 @@ module tb_ROC_RV32_program;
 			$display("PASS: SUCCESS signature observed at dmem[word %0d]: wdata=0x%08x", stop_addr_word, last_word0_wdata);
 		end
 
+		if (trace_fd != 0) begin
+			$fclose(trace_fd);
+		end
+
 		// dmem is synchronous; allow the write to commit before reading mem[]
 		@(posedge clk);
 
 		$display("---- FINAL SNAPSHOT ----");
 		$display("cycles=%0d pc_output=0x%08x cpu_state=%0d ir=0x%08x", cycles, dut.cpu_core.pc_output, dut.cpu_core.cpu_state, dut.cpu_core.ir);
+		$display("instret=%0d CPI=%0.3f pipeline=%0d rv32m=%0d wbuf=%0d", instret, (instret != 0) ? real'(cycles) / real'(instret) : 0.0, CPU_PIPELINE, CPU_RV32M, MMIO_WBUF_DEPTH);
+		-> final_snapshot;
+		#0;
 		$display("------------------------");
 
-		dump_dmem(10);
-		#(2000000);
-		dump_dmem(10);
+		dump_dmem(dump_words);
 
-		load_imem_via_uart();
-		#(BIT_TIME * 200);
+		// Bootloader path: read again while the program idles, reload the image and
+		// read once more after the reset (skipped with +FAST_DUMP).
+		if (!fast_dump) begin
+			#(2000000);
+			dump_dmem(dump_words);
 
-		reset_dut();
-		dump_dmem(10);
+			load_imem();
+
+			reset_dut();
+			dump_dmem(dump_words);
+		end
+
+		if (dump_errors != 0) begin
+			$error("DMEM dump mismatch: %0d words differ between the UART dump and the BRAM", dump_errors);
+		end
+		$display("[TB] boot: load=%s dump=%s uart_cycles=%0d skipped_cycles=%0d sim_cycles=%0d",
+			fast_load ? "direct" : "uart", fast_dump ? "direct" : "uart", uart_cycles, skipped_cycles, $time / CLK_PERIOD);
 
 		$finish;
 	end
@@ -0,0 +1,490 @@
+// Verilator harness for the soc, equivalent to tb_ROC_RV32_program.sv:
+//  - loads the program through the bootloader UART (128-word chunks), or with
+//    +FAST_LOAD writes the IMEM BRAM directly
+//  - resets the core and runs until the stop store (+STOP_ADDR/+STOP_WDATA/+MAX_CYCLES)
+//  - prints the AXI UART TX stream, drives the pin_gpio[0] interrupt stimulus
+//  - dumps DMEM through the bootloader read command, or with +FAST_DUMP reads the
+//    BRAM directly (+CHECK_DUMP: compare the UART dump with the BRAM)
+//  - writes the retirement trace with +TRACE=<file> (tools/roc_trace.h)
+// and reports simulated cycles per wall-clock second, and the UART cycles the
+// direct load/dump skipped.
+#include "Vtb_soc_verilator.h"
+#include "Vtb_soc_verilator__Dpi.h"
+#include "svdpi.h"
+#include "verilated.h"
+
+#include "../../../tools/roc_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef TB_CLK_FREQ
+#define TB_CLK_FREQ 50000000u
+#endif
+#ifndef TB_BAUD_RATE
+#define TB_BAUD_RATE 115200u
+#endif
+#ifndef TB_ADDR_WIDTH
+#define TB_ADDR_WIDTH 11
+#endif
+
+namespace {
+
+constexpr uint32_t BIT_CYCLES = TB_CLK_FREQ / TB_BAUD_RATE;
+constexpr uint32_t CHUNK_WORDS = 128;
+constexpr uint64_t GPIO_IRQ_PERIOD = 100000;
+constexpr uint64_t GPIO_IRQ_WIDTH = 10;
+
+// Bootloader UART cycles for `bytes` bytes (start, 8 data and stop bits each).
+constexpr uint64_t uart_cycles_for(uint64_t bytes) {
+    return bytes * 10 * BIT_CYCLES;
+}
+
+// An IMEM load: a header per chunk, the words, then the settle time.
+constexpr uint64_t uart_load_cycles(uint64_t words) {
+    return uart_cycles_for(4 * (words + (words + CHUNK_WORDS - 1) / CHUNK_WORDS)) + (uint64_t)BIT_CYCLES * 200;
+}
+
+// Serializer for a line into the DUT (start bit, 8 data bits LSB first, stop bit).
+struct UartDriver {
+    std::deque<uint8_t> queue;
+    uint32_t frame = 0;
+    int bit = -1;
+    uint32_t count = 0;
+    bool line = true;
+
+    bool idle() const { return bit < 0 && queue.empty(); }
+
+    void step() {
+        if (bit < 0) {
+            if (queue.empty()) {
+                line = true;
+                return;
+            }
+            frame = (1u << 9) | ((uint32_t)queue.front() << 1);
+            queue.pop_front();
+            bit = 0;
+            count = BIT_CYCLES;
+            line = false;
+            return;
+        }
+        if (--count == 0) {
+            if (++bit == 10) {
+                bit = -1;
+                line = true;
+                return;
+            }
+            line = (frame >> bit) & 1u;
+            count = BIT_CYCLES;
+        }
+    }
+};
+
+// Deserializer for a line out of the DUT, sampling each bit at its centre.
+struct UartMonitor {
+    bool prev = true;
+    int bit = -1;
+    uint32_t count = 0;
+    uint8_t byte = 0;
+
+    bool step(bool line, uint8_t &out) {
+        bool done = false;
+        if (bit < 0) {
+            if (prev && !line) {
+                bit = 0;
+                byte = 0;
+                count = BIT_CYCLES + BIT_CYCLES / 2;
+            }
+        } else if (--count == 0) {
+            if (bit < 8) {
+                byte |= (uint8_t)((line ? 1u : 0u) << bit);
+                bit++;
+                count = BIT_CYCLES;
+            } else {
+                out = byte;
+                done = true;
+                bit = -1;
+            }
+        }
+        prev = line;
+        return done;
+    }
+};
+
+struct Harness {
+    std::unique_ptr<VerilatedContext> ctx;
+    std::unique_ptr<Vtb_soc_verilator> top;
+    uint64_t ticks = 0;
+
+    UartDriver boot_tx;
+    UartMonitor boot_rx;
+    UartMonitor uart_print;
+    std::vector<uint8_t> boot_bytes;
+    std::deque<uint32_t> dmem_buffer;
+    bool gpio_stimulus = true;
+
+    explicit Harness(int argc, char **argv) : ctx(new VerilatedContext) {
+        ctx->commandArgs(argc, argv);
+        top.reset(new Vtb_soc_verilator{ctx.get()});
+        top->clk = 0;
+        top->rst = 1;
+        top->rx = 1;
+        top->uart_rx = 1;
+        top->spi_miso = 0;
+        top->gpio0_drive = 0;
+        top->eval();
+    }
+
+    void tick() {
+        boot_tx.step();
+        top->rx = boot_tx.line;
+        if (gpio_stimulus) {
+            top->gpio0_drive = (ticks % (GPIO_IRQ_PERIOD + GPIO_IRQ_WIDTH)) >= GPIO_IRQ_PERIOD;
+        }
+
+        top->clk = 0;
+        top->eval();
+        top->clk = 1;
+        top->eval();
+        ticks++;
+
+        uint8_t b;
+        if (uart_print.step(top->uart_tx, b)) {
+            std::putchar(b);
+            std::fflush(stdout);
+        }
+        if (boot_rx.step(top->tx, b)) {
+            boot_bytes.push_back(b);
+            if (boot_bytes.size() == 4) {
+                dmem_buffer.push_back((uint32_t)boot_bytes[0] | ((uint32_t)boot_bytes[1] << 8) |
+                                      ((uint32_t)boot_bytes[2] << 16) | ((uint32_t)boot_bytes[3] << 24));
+                boot_bytes.clear();
+            }
+        }
+    }
+
+    void run_cycles(uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            tick();
+        }
+    }
+
+    void reset() {
+        top->rst = 1;
+        run_cycles(5);
+        top->rst = 0;
+        run_cycles(2);
+    }
+
+    void send_word(uint32_t w) {
+        for (int i = 0; i < 4; i++) {
+            boot_tx.queue.push_back((uint8_t)(w >> (8 * i)));
+        }
+    }
+
+    void drain_tx() {
+        while (!boot_tx.idle()) {
+            tick();
+        }
+    }
+
+    void bootloader_write_imem(uint32_t addr, const uint32_t *data, uint32_t n) {
+        send_word((1u << 31) | ((addr & 0x7FFFu) << 16) | (n & 0xFFFFu));
+        for (uint32_t i = 0; i < n; i++) {
+            send_word(data[i]);
+        }
+        drain_tx();
+    }
+
+    bool bootloader_read_dmem(uint32_t addr, uint32_t n, std::vector<uint32_t> &out) {
+        const size_t prev = dmem_buffer.size();
+        send_word(((addr & 0x7FFFu) << 16) | (n & 0xFFFFu));
+        drain_tx();
+        const uint64_t timeout = (uint64_t)BIT_CYCLES * (n * 40 + 200);
+        const uint64_t start = ticks;
+        while (dmem_buffer.size() < prev + n) {
+            if (ticks - start > timeout) {
+                std::fprintf(stderr, "Timeout waiting for %u DMEM words, got %zu\n",
+                             n, dmem_buffer.size() - prev);
+                return false;
+            }
+            tick();
+        }
+        out.clear();
+        for (uint32_t i = 0; i < n; i++) {
+            out.push_back(dmem_buffer.front());
+            dmem_buffer.pop_front();
+        }
+        return true;
+    }
+};
+
+bool read_imem(const std::string &path, std::vector<uint32_t> &words) {
+    FILE *f = std::fopen(path.c_str(), "r");
+    if (!f) {
+        return false;
+    }
+    char line[256];
+    while (std::fgets(line, sizeof(line), f)) {
+        char *end = nullptr;
+        unsigned long v = std::strtoul(line, &end, 16);
+        if (end != line) {
+            words.push_back((uint32_t)v);
+        }
+    }
+    std::fclose(f);
+    return true;
+}
+
+const char *plusarg(int argc, char **argv, const char *name) {
+    const size_t n = std::strlen(name);
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '+' || std::strncmp(argv[i] + 1, name, n) != 0) {
+            continue;
+        }
+        if (argv[i][1 + n] == '=') {
+            return argv[i] + n + 2;
+        }
+        if (argv[i][1 + n] == '\0') {
+            return argv[i] + n + 1;
+        }
+    }
+    return nullptr;
+}
+
+// +TRACE: LSU wait cycles are charged to the next instruction to retire.
+struct TraceWriter {
+    FILE *f = nullptr;
+    uint32_t wait = 0;
+
+    bool open(const char *path) {
+        f = std::fopen(path, "wb");
+        if (!f) {
+            return false;
+        }
+        const roc::TraceHeader h{roc::TRACE_MAGIC, roc::TRACE_VERSION, sizeof(roc::TraceRecord) / 4, 0};
+        std::fwrite(&h, sizeof(h), 1, f);
+        return true;
+    }
+
+    void step(const Vtb_soc_verilator &t, uint64_t cycle) {
+        if (t.lsu_stall && wait < roc::TRACE_WAIT_MAX) {
+            wait++;
+        }
+        if (!t.instr_retire) {
+            return;
+        }
+        roc::TraceRecord r;
+        r.cycle = (uint32_t)cycle;
+        r.pc = t.rvfi_pc;
+        r.insn = t.rvfi_insn;
+        r.rd_wdata = t.rvfi_rd_wdata;
+        r.mem_addr = t.rvfi_mem_addr;
+        r.mem_data = t.rvfi_mem_data;
+        r.info = (uint32_t)t.rvfi_rd_addr | (t.rvfi_c ? roc::TRACE_C : 0u) |
+                 (t.rvfi_mem_load ? roc::TRACE_LOAD : 0u) | (t.rvfi_mem_store ? roc::TRACE_STORE : 0u) |
+                 (t.rvfi_intr ? roc::TRACE_INTR : 0u) | (wait << roc::TRACE_WAIT_SHIFT);
+        std::fwrite(&r, sizeof(r), 1, f);
+        wait = 0;
+    }
+
+    ~TraceWriter() {
+        if (f) {
+            std::fclose(f);
+        }
+    }
+};
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    uint32_t stop_addr_word = 0;
+    uint64_t max_cycles = 5000000;
+    uint32_t stop_wdata = 0xDEADBEEFu;
+    uint32_t dump_words = 10;
+    std::string imem_path;
+
+    if (const char *v = plusarg(argc, argv, "STOP_ADDR")) stop_addr_word = (uint32_t)std::strtoul(v, nullptr, 10);
+    if (const char *v = plusarg(argc, argv, "MAX_CYCLES")) max_cycles = std::strtoull(v, nullptr, 10);
+    if (const char *v = plusarg(argc, argv, "STOP_WDATA")) stop_wdata = (uint32_t)std::strtoul(v, nullptr, 16);
+    if (const char *v = plusarg(argc, argv, "DUMP_WORDS")) dump_words = (uint32_t)std::strtoul(v, nullptr, 10);
+    if (const char *v = plusarg(argc, argv, "IMEM")) imem_path = v;
+
+    std::vector<uint32_t> image;
+    if (!imem_path.empty()) {
+        if (!read_imem(imem_path, image)) {
+            std::fprintf(stderr, "Failed to open %s\n", imem_path.c_str());
+            return 1;
+        }
+    } else if (read_imem("sw/imem.dat", image)) {
+        imem_path = "sw/imem.dat";
+    } else if (read_imem("../sw/imem.dat", image)) {
+        imem_path = "../sw/imem.dat";
+    } else {
+        std::fprintf(stderr, "Failed to open sw/imem.dat (tried sw/imem.dat and ../sw/imem.dat)\n");
+        return 1;
+    }
+    if (image.empty()) {
+        std::fprintf(stderr, "IMEM image is empty\n");
+        return 1;
+    }
+    if (image.size() > (1u << TB_ADDR_WIDTH)) {
+        std::fprintf(stderr, "IMEM image too large: %zu words\n", image.size());
+        return 1;
+    }
+
+    const bool fast_load = plusarg(argc, argv, "FAST_LOAD") != nullptr;
+    const bool fast_dump = plusarg(argc, argv, "FAST_DUMP") != nullptr;
+    const bool check_dump = plusarg(argc, argv, "CHECK_DUMP") != nullptr;
+    uint64_t uart_cycles = 0;
+    uint64_t skipped_cycles = 0;
+
+    Harness h(argc, argv);
+    h.gpio_stimulus = plusarg(argc, argv, "NO_GPIO_IRQ") == nullptr;
+    svSetScope(svGetScopeFromName("TOP.tb_soc_verilator"));
+    const auto t_start = std::chrono::steady_clock::now();
+
+    h.reset();
+
+    std::printf("[TB] Loading IMEM %s from: %s\n", fast_load ? "directly" : "via bootloader", imem_path.c_str());
+    if (fast_load) {
+        for (uint32_t i = 0; i < image.size(); i++) {
+            tb_imem_write(i, image[i]);
+        }
+        skipped_cycles += uart_load_cycles(image.size());
+        std::printf("[TB] IMEM: %zu words written directly (+FAST_LOAD), %llu UART cycles skipped\n",
+                    image.size(), (unsigned long long)uart_load_cycles(image.size()));
+    } else {
+        const uint64_t t0 = h.ticks;
+        for (uint32_t idx = 0; idx < image.size(); idx += CHUNK_WORDS) {
+            const uint32_t n = (uint32_t)std::min<size_t>(CHUNK_WORDS, image.size() - idx);
+            h.bootloader_write_imem(idx, image.data() + idx, n);
+        }
+        h.run_cycles((uint64_t)BIT_CYCLES * 200);
+        uart_cycles += h.ticks - t0;
+    }
+    h.reset();
+
+    TraceWriter trace;
+    if (const char *v = plusarg(argc, argv, "TRACE")) {
+        if (!trace.open(v)) {
+            std::fprintf(stderr, "Failed to open %s\n", v);
+            return 1;
+        }
+        std::printf("[TB] Writing retirement trace to: %s\n", v);
+    }
+
+    const uint64_t load_ticks = h.ticks;
+    const double load_wall = seconds_since(t_start);
+    const auto t_run = std::chrono::steady_clock::now();
+
+    uint64_t cycles = 0;
+    uint64_t instret = 0;
+    uint64_t instret1 = 0;
+    bool stopped = false;
+    bool failed = false;
+    uint32_t last_wdata = 0;
+    while (!stopped && cycles < max_cycles) {
+        h.tick();
+        cycles++;
+        instret += h.top->instr_retire;
+        instret1 += h.top->instr_retire1;
+        if (trace.f) {
+            trace.step(*h.top, cycles);
+        }
+        if (h.top->dmem_we && h.top->dmem_addr == stop_addr_word) {
+            last_wdata = h.top->dmem_wdata;
+            if (h.top->dmem_strb == 0xF && h.top->dmem_wdata == stop_wdata) {
+                stopped = true;
+            } else if (h.top->dmem_strb == 0xF && (h.top->dmem_wdata & 0xFFFF0000u) == 0xBAD00000u) {
+                stopped = true;
+                failed = true;
+            }
+        }
+    }
+    const double run_wall = seconds_since(t_run);
+
+    int rc = 0;
+    if (!stopped) {
+        std::printf("Timeout: no stop store observed within %llu cycles. Default is store 0x%08x to dmem[word %u]. "
+                    "Optional: +STOP_WDATA=<hex>, +STOP_ADDR=<word>, +MAX_CYCLES=<n>.\n",
+                    (unsigned long long)max_cycles, stop_wdata, stop_addr_word);
+        rc = 1;
+    } else if (failed) {
+        std::printf("FAIL signature observed at dmem[word %u]: wdata=0x%08x (code=0x%04x)\n",
+                    stop_addr_word, last_wdata, last_wdata & 0xFFFFu);
+        rc = 1;
+    } else {
+        std::printf("PASS: SUCCESS signature observed at dmem[word %u]: wdata=0x%08x\n",
+                    stop_addr_word, last_wdata);
+    }
+
+    // dmem is synchronous; allow the write to commit before reading it back.
+    h.tick();
+
+    std::printf("---- FINAL SNAPSHOT ----\n");
+    std::printf("cycles=%llu pc_output=0x%08x cpu_state=%u ir=0x%08x\n",
+                (unsigned long long)cycles, h.top->pc_output, (unsigned)h.top->cpu_state, h.top->ir);
+    std::printf("instret=%llu CPI=%.3f\n", (unsigned long long)instret,
+                instret ? (double)cycles / (double)instret : 0.0);
+    if (instret1) {
+        std::printf("hart1: instret=%llu\n", (unsigned long long)instret1);
+    }
+    std::printf("------------------------\n");
+
+    if (rc == 0) {
+        std::vector<uint32_t> words;
+        std::printf("---- DMEM DUMP (word-addressed) ----\n");
+        if (fast_dump) {
+            for (uint32_t i = 0; i < dump_words; i++) {
+                words.push_back(tb_dmem_read(i));
+            }
+            skipped_cycles += uart_cycles_for(4 + 4 * (uint64_t)dump_words);
+        } else if (dump_words != 0) {
+            const uint64_t t0 = h.ticks;
+            if (!h.bootloader_read_dmem(0, dump_words, words)) {
+                words.clear();
+            }
+            uart_cycles += h.ticks - t0;
+        }
+        for (size_t i = 0; i < words.size(); i++) {
+            std::printf("dmem[%zu]=0x%08x\n", i, words[i]);
+            if (check_dump && !fast_dump && words[i] != tb_dmem_read((uint32_t)i)) {
+                std::printf("DMEM dump mismatch at dmem[%zu]: UART 0x%08x, BRAM 0x%08x\n",
+                            i, words[i], tb_dmem_read((uint32_t)i));
+                rc = 1;
+            }
+        }
+        std::printf("----------------------------------\n");
+    }
+
+    const double total_wall = seconds_since(t_start);
+    std::printf("[VL] threads=%u load: %llu cycles %.3fs | run: %llu cycles %.3fs %.0f cycles/s | total: %llu cycles %.3fs %.0f cycles/s\n",
+                h.ctx->threads(),
+                (unsigned long long)load_ticks, load_wall,
+                (unsigned long long)cycles, run_wall, run_wall > 0.0 ? (double)cycles / run_wall : 0.0,
+                (unsigned long long)h.ticks, total_wall, total_wall > 0.0 ? (double)h.ticks / total_wall : 0.0);
+    std::printf("[TB] boot: load=%s dump=%s uart_cycles=%llu skipped_cycles=%llu sim_cycles=%llu\n",
+                fast_load ? "direct" : "uart", fast_dump ? "direct" : "uart",
+                (unsigned long long)uart_cycles, (unsigned long long)skipped_cycles, (unsigned long long)h.ticks);
+    if (skipped_cycles != 0 && cycles != 0 && run_wall > 0.0) {
+        std::printf("[VL] direct load/dump skipped %llu UART cycles, ~%.3fs at %.0f cycles/s\n",
+                    (unsigned long long)skipped_cycles, (double)skipped_cycles * run_wall / (double)cycles,
+                    (double)cycles / run_wall);
+    }
+
+    h.top->final();
+    return rc;
+}
@@ -0,0 +1,153 @@
+// Verilator top for the soc.
+// The C++ harness (tb_soc.cpp) drives the clock, reset, both UART RX lines and the
+// pin_gpio[0] stimulus, and watches the DMEM core write port for the stop signature,
+// mirroring tb_ROC_RV32_program. tb_imem_write/tb_dmem_read give it direct access to
+// the IMEM and DMEM BRAM for +FAST_LOAD/+FAST_DUMP (with N_HARTS > 1 tb_imem_write
+// loads hart 1's IMEM as well).
+
+module tb_soc_verilator #(
+    parameter int CLK_FREQ = 50_000_000,
+    parameter int BAUD_RATE = 115200,
+    parameter int ADDR_WIDTH = 11,
+    parameter int DATA_WIDTH = 32,
+    parameter bit CPU_PIPELINE = 1'b0,
+    parameter bit CPU_RV32M = 1'b0,
+    parameter bit CPU_EARLY_IRQ = 1'b0,
+    parameter bit CPU_RV32C = 1'b0,
+    parameter int MMIO_WBUF_DEPTH = 4,
+    // XMEM image: +XMEM=<file> (read by axi4_sram)
+    parameter bit XMEM_EN = 1'b0,
+    parameter int ICACHE_WAYS = 1,
+    parameter int DCACHE_WAYS = 1,
+    parameter int N_HARTS = 1
+) (
+    input  logic                    clk,
+    input  logic                    rst,
+
+    input  logic                    rx,           // bootloader UART
+    output logic                    tx,
+    input  logic                    uart_rx,      // AXI UART
+    output logic                    uart_tx,
+
+    input  logic                    gpio0_drive,  // pin_gpio[0] interrupt stimulus
+    input  logic                    spi_miso,
+
+    // DMEM port A (core side) observation for the stop protocol
+    output logic                    dmem_we,
+    output logic [ADDR_WIDTH-1:0]   dmem_addr,
+    output logic [3:0]              dmem_strb,
+    output logic [DATA_WIDTH-1:0]   dmem_wdata,
+
+    // Final snapshot
+    output logic [31:0]             pc_output,
+    output logic [2:0]              cpu_state,
+    output logic [31:0]             ir,
+    output logic                    instr_retire,
+    output logic                    instr_retire1,  // hart 1 (0 with N_HARTS = 1)
+
+    // Retirement trace (ROC_RV32 rvfi_*) for +TRACE, and the LSU stall event
+    output logic [31:0]             rvfi_pc,
+    output logic [31:0]             rvfi_insn,
+    output logic                    rvfi_c,
+    output logic                    rvfi_intr,
+    output logic [4:0]              rvfi_rd_addr,
+    output logic [31:0]             rvfi_rd_wdata,
+    output logic                    rvfi_mem_load,
+    output logic                    rvfi_mem_store,
+    output logic [31:0]             rvfi_mem_addr,
+    output logic [31:0]             rvfi_mem_data,
+    output logic                    lsu_stall
+);
+
+    tri   [31:0] pin_gpio;
+    logic        led_status;
+    logic [7:0]  seg;
+    logic [6:0]  ABDCEFG;
+    logic        DP;
+    logic        spi_clk;
+    logic        spi_mosi;
+    logic        spi_cs_n;
+
+    assign pin_gpio[0] = gpio0_drive;
+
+    soc #(
+        .CLK_FREQ(CLK_FREQ),
+        .BAUD_RATE(BAUD_RATE),
+        .ADDR_WIDTH(ADDR_WIDTH),
+        .DATA_WIDTH(DATA_WIDTH),
+        .CPU_PIPELINE(CPU_PIPELINE),
+        .CPU_RV32M(CPU_RV32M),
+        .CPU_EARLY_IRQ(CPU_EARLY_IRQ),
+        .CPU_RV32C(CPU_RV32C),
+        .MMIO_WBUF_DEPTH(MMIO_WBUF_DEPTH),
+        .XMEM_EN(XMEM_EN),
+        .ICACHE_WAYS(ICACHE_WAYS),
+        .DCACHE_WAYS(DCACHE_WAYS),
+        .N_HARTS(N_HARTS)
+    ) dut (
+        .clk(clk),
+        .rst(rst),
+        .led_status(led_status),
+        .rx(rx),
+        .tx(tx),
+        .uart_rx(uart_rx),
+        .uart_tx(uart_tx),
+        .pin_gpio(pin_gpio),
+        .seg(seg),
+        .ABDCEFG(ABDCEFG),
+        .DP(DP),
+        .spi_clk(spi_clk),
+        .spi_mosi(spi_mosi),
+        .spi_miso(spi_miso),
+        .spi_cs_n(spi_cs_n)
+    );
+
+    assign dmem_we    = dut.wena_mem_d;
+    assign dmem_addr  = dut.dmem_addr_cpu;
+    assign dmem_strb  = dut.store_strb;
+    assign dmem_wdata = dut.store_wdata;
+
+    assign pc_output  = dut.cpu_core.pc_output;
+    assign cpu_state  = dut.cpu_core.cpu_state;
+    assign ir         = dut.cpu_core.ir;
+    assign instr_retire = dut.cpu_core.instr_retire;
+
+    assign rvfi_pc        = dut.cpu_core.rvfi_pc;
+    assign rvfi_insn      = dut.cpu_core.rvfi_insn;
+    assign rvfi_c         = dut.cpu_core.rvfi_c;
+    assign rvfi_intr      = dut.cpu_core.rvfi_intr;
+    assign rvfi_rd_addr   = dut.cpu_core.rvfi_rd_addr;
+    assign rvfi_rd_wdata  = dut.cpu_core.rvfi_rd_wdata;
+    assign rvfi_mem_load  = dut.cpu_core.rvfi_mem_load;
+    assign rvfi_mem_store = dut.cpu_core.rvfi_mem_store;
+    assign rvfi_mem_addr  = dut.cpu_core.rvfi_mem_addr;
+    assign rvfi_mem_data  = dut.cpu_core.rvfi_mem_data;
+    assign lsu_stall      = dut.cpu_core.ev_lsu_stall;
+
+    // The g_hart1 scope only exists with N_HARTS > 1.
+    generate if (N_HARTS > 1) begin : g_hart1_tb
+        assign instr_retire1 = dut.g_hart1.cpu_core1.instr_retire;
+
+        function void imem_write(input int unsigned addr, input int unsigned data);
+            dut.g_hart1.instruction_memory1.data_memory.mem[addr[ADDR_WIDTH-1:0]] = data;
+        endfunction
+    end else begin : g_hart1_tb
+        assign instr_retire1 = 1'b0;
+
+        function void imem_write(input int unsigned addr, input int unsigned data);
+        endfunction
+    end endgenerate
+
+    export "DPI-C" function tb_imem_write;
+    export "DPI-C" function tb_dmem_read;
+
+    function void tb_imem_write(input int unsigned addr, input int unsigned data);
+        dut.instruction_memory.data_memory.mem[addr[ADDR_WIDTH-1:0]] = data;
+        g_hart1_tb.imem_write(addr, data);
+    endfunction
+
+    function int unsigned tb_dmem_read(input int unsigned addr);
+        return dut.data_memory.data_memory.mem[addr[ADDR_WIDTH-1:0]];
+    endfunction
+
+endmodule
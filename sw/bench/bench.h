@@ -0,0 +1,83 @@
+#include <stdint.h>
+
+// Benchmark harness for the programs in sw/bench/ (tools/bench.py, `make bench`).
+//
+// A benchmark is a kernel `uint32_t fn(uint32_t i)` whose result depends only
+// on i. bench_run() calls it once untimed (caches with XMEM=1), then times
+// fn(0) .. fn(iters - 1) with cycle, instret and hpmcounter6 and checks the sum
+// of the results against the expected checksum, so every build and core
+// configuration is known to do the same work.
+//
+// Results block, in the result words the simulators dump (dmem[0..9]):
+//   dmem[0] = 0xDEADBEEF, or 0xBAD00001 on a checksum mismatch (written last)
+//   dmem[1] = checksum              dmem[2] = expected checksum
+//   dmem[3] = BENCH_MAGIC           dmem[4] = iterations
+//   dmem[5] = cycles                dmem[6] = instructions retired
+//   dmem[7] = CPI * 1000            dmem[8] = LSU wait cycles (hpmcounter6)
+//   dmem[9] = cycles per iteration
+//
+// With -DBENCH_HOST a kernel without MMIO builds on the host instead
+// (`cc -O2 -DBENCH_HOST sw/bench/<name>.c [sw/<library>.c]`) and prints the
+// checksum, which is how the expected values were obtained.
+
+#define BENCH_MAGIC     0x48434E42u     // "BNCH"
+#define BENCH_WORDS     10u             // dmem words to dump
+
+typedef uint32_t (*bench_fn)(uint32_t i);
+
+#ifdef BENCH_HOST
+
+#include <stdio.h>
+
+static inline int bench_run(const char *name, bench_fn fn, uint32_t iters, uint32_t expected) {
+    uint32_t sum = 0u;
+    (void)fn(0u);
+    for (uint32_t i = 0; i < iters; i++) {
+        sum += fn(i);
+    }
+    printf("%s: %u iterations, checksum 0x%08x (expected 0x%08x)%s\n", name, iters, sum, expected,
+           sum == expected ? "" : " MISMATCH");
+    return sum != expected;
+}
+
+#else
+
+#include "../perf_counters.h"
+
+#define BENCH_RESULT    ((volatile uint32_t *)0x10000000u)
+
+__attribute__((noreturn))
+static inline int bench_run(const char *name, bench_fn fn, uint32_t iters, uint32_t expected) {
+    (void)name;
+    // Through a volatile so the compiler cannot unroll or fold the timed loop.
+    volatile uint32_t n_v = iters;
+    const uint32_t n = n_v;
+    uint32_t sum = 0u;
+
+    (void)fn(0u);
+
+    const uint32_t l0 = rdhpm(6);
+    const uint32_t i0 = rdinstret();
+    const uint32_t c0 = rdcycle();
+    for (uint32_t i = 0; i < n; i++) {
+        sum += fn(i);
+    }
+    const uint32_t cycles = rdcycle() - c0;
+    const uint32_t instret = rdinstret() - i0;
+    const uint32_t lsu_wait = rdhpm(6) - l0;
+
+    BENCH_RESULT[1] = sum;
+    BENCH_RESULT[2] = expected;
+    BENCH_RESULT[3] = BENCH_MAGIC;
+    BENCH_RESULT[4] = n;
+    BENCH_RESULT[5] = cycles;
+    BENCH_RESULT[6] = instret;
+    BENCH_RESULT[7] = instret ? (uint32_t)((uint64_t)cycles * 1000u / instret) : 0u;
+    BENCH_RESULT[8] = lsu_wait;
+    BENCH_RESULT[9] = n ? cycles / n : 0u;
+    BENCH_RESULT[0] = (sum == expected) ? 0xDEADBEEFu : 0xBAD00001u;
+    while (1) {
+    }
+}
+
+#endif
@@ -0,0 +1,49 @@
+// BME280 compensation benchmark: sw/bme280.c, as sample_done() in sw/main.c
+// runs it, on a sweep of raw ADC words. Mostly 32-bit multiplies, shifts and
+// one divide per pressure value: the RV32M unit against sw/muldiv.S.
+// Calibration is the datasheet example (section 8.2 / 4.2.3).
+// See sw/bench/bench.h for the results block.
+// REGRESS_ARGS: +MAX_CYCLES=20000000
+#include <stdint.h>
+#include "bench.h"
+#include "../bme280.h"
+
+#define ITERS       8u
+#define SAMPLES     16u             // T/P/H conversions per iteration
+#define CHECKSUM    0x00D48D6Bu
+
+// Calibration registers 0x88..0xA1 and 0xE1..0xE7 as the sensor returns them:
+// T1 27504, T2 26435, T3 -1000, P1 36477, P2 -10685, P3 3024, P4 2855, P5 140,
+// P6 -7, P7 15500, P8 -14600, P9 6000, H1 75, H2 370, H3 0, H4 313, H5 50, H6 30.
+static const uint8_t calib1[BME280_CALIB1_LEN] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,
+    0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B, 0x8C, 0x00,
+    0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17,
+    0x00, 0x4B,
+};
+static const uint8_t calib2[BME280_CALIB2_LEN] = { 0x72, 0x01, 0x00, 0x13, 0x29, 0x03, 0x1E };
+
+static struct bme280_calib calib;
+
+static uint32_t bme280_iter(uint32_t i) {
+    uint32_t sum = 0u;
+    // Around the datasheet example (adc_T 519888, adc_P 415148), humidity mid-range.
+    int32_t adc_T = 519888 - 2048 + (int32_t)(i << 6);
+    int32_t adc_P = 415148 - 8192 + (int32_t)(i << 8);
+    int32_t adc_H = 27000 + (int32_t)(i << 5);
+    for (uint32_t k = 0; k < SAMPLES; k++) {
+        int32_t t_fine;
+        sum += (uint32_t)bme280_comp_T_x100(&calib, adc_T, &t_fine);
+        sum += bme280_comp_P_Pa(&calib, adc_P, t_fine);
+        sum += (bme280_comp_H_x1024(&calib, adc_H, t_fine) * 100u + 512u) >> 10;
+        adc_T += 251;
+        adc_P += 1021;
+        adc_H += 409;
+    }
+    return sum;
+}
+
+int main(void) {
+    bme280_parse_calib(&calib, calib1, calib2);
+    return bench_run("bme280", bme280_iter, ITERS, CHECKSUM);
+}
@@ -0,0 +1,116 @@
+// BME280 compensation split across two harts (soc N_HARTS=2): the work of
+// sw/bench/bme280.c, with each iteration's SAMPLES conversions halved. Hart 0
+// posts the iteration in the mailbox RAM, rings hart 1's MSIP and runs the first
+// half; hart 1 (hart1_main, called by crt0) runs the second half and leaves its
+// sum and the job number there. Built with N_HARTS=1 hart 0 runs everything, so
+// the cycles per iteration of the two builds give the speedup for the same
+// checksum:
+//   tools/bench.py --opt=-O2 --config m,m+dual bme280_dual
+// The handoff costs a few mailbox round trips per iteration (hart 0 polls DONE).
+// See sw/bench/bench.h for the results block.
+// REGRESS_ARGS: +MAX_CYCLES=20000000
+#include <stdint.h>
+#include "bench.h"
+#include "../bme280.h"
+
+#define ITERS       8u
+#define SAMPLES     16u             // T/P/H conversions per iteration
+#define CHECKSUM    0x00D48D6Bu     // as bme280.c: the same conversions
+
+#ifndef N_HARTS
+#define N_HARTS     1
+#endif
+#if N_HARTS > 1 && !defined(BENCH_HOST)
+#define DUAL        1
+#else
+#define DUAL        0
+#endif
+
+// Calibration registers 0x88..0xA1 and 0xE1..0xE7, as in bme280.c.
+static const uint8_t calib1[BME280_CALIB1_LEN] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,
+    0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B, 0x8C, 0x00,
+    0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17,
+    0x00, 0x4B,
+};
+static const uint8_t calib2[BME280_CALIB2_LEN] = { 0x72, 0x01, 0x00, 0x13, 0x29, 0x03, 0x1E };
+
+// Each hart parses its own copy (the DMEMs are private).
+static struct bme280_calib calib;
+
+// Conversions k0 .. k1 - 1 of iteration i (bme280.c runs 0 .. SAMPLES - 1).
+static uint32_t bme280_samples(uint32_t i, uint32_t k0, uint32_t k1) {
+    uint32_t sum = 0u;
+    int32_t adc_T = 519888 - 2048 + (int32_t)(i << 6) + 251 * (int32_t)k0;
+    int32_t adc_P = 415148 - 8192 + (int32_t)(i << 8) + 1021 * (int32_t)k0;
+    int32_t adc_H = 27000 + (int32_t)(i << 5) + 409 * (int32_t)k0;
+    for (uint32_t k = k0; k < k1; k++) {
+        int32_t t_fine;
+        sum += (uint32_t)bme280_comp_T_x100(&calib, adc_T, &t_fine);
+        sum += bme280_comp_P_Pa(&calib, adc_P, t_fine);
+        sum += (bme280_comp_H_x1024(&calib, adc_H, t_fine) * 100u + 512u) >> 10;
+        adc_T += 251;
+        adc_P += 1021;
+        adc_H += 409;
+    }
+    return sum;
+}
+
+#if DUAL
+
+// Mailbox (axi_mailbox): hart 1's MSIP word and the first RAM words.
+#define MBOX_MSIP1      ((volatile uint32_t *)0x00006004u)
+#define MBOX_JOB        ((volatile uint32_t *)0x00006800u)  // job number, 0 = none yet
+#define MBOX_ITER       ((volatile uint32_t *)0x00006804u)  // iteration of the job
+#define MBOX_DONE       ((volatile uint32_t *)0x00006808u)  // last job finished by hart 1
+#define MBOX_RESULT     ((volatile uint32_t *)0x0000680Cu)  // its partial sum
+
+#define MIE_MSIE        (1u << 3)
+
+static uint32_t job;
+
+// Hart 1. Interrupts stay disabled in mstatus; mie.MSIE alone lets WFI wake on
+// MSIP, and MSIP is checked before sleeping, so a ring between the check and WFI
+// is not lost.
+void hart1_main(void) {
+    __asm__ volatile ("csrs mie, %0" :: "r"(MIE_MSIE) : "memory");
+    bme280_parse_calib(&calib, calib1, calib2);
+    for (;;) {
+        while (*MBOX_MSIP1 == 0u) {
+            __asm__ volatile ("wfi");
+        }
+        *MBOX_MSIP1 = 0u;
+        const uint32_t n = *MBOX_JOB;
+        *MBOX_RESULT = bme280_samples(*MBOX_ITER, SAMPLES / 2u, SAMPLES);
+        *MBOX_DONE = n;             // after RESULT: same slave, in order
+    }
+}
+
+// Hart 0. The job number, not i, tells results apart: bench_run() calls fn(0)
+// twice (untimed, then timed).
+static uint32_t bme280_iter(uint32_t i) {
+    job++;
+    *MBOX_ITER = i;
+    *MBOX_JOB = job;
+    *MBOX_MSIP1 = 1u;
+    const uint32_t sum = bme280_samples(i, 0u, SAMPLES / 2u);
+    while (*MBOX_DONE != job) {
+    }
+    return sum + *MBOX_RESULT;
+}
+
+#else
+
+static uint32_t bme280_iter(uint32_t i) {
+    return bme280_samples(i, 0u, SAMPLES);
+}
+
+#endif
+
+int main(void) {
+    bme280_parse_calib(&calib, calib1, calib2);
+#if DUAL
+    *MBOX_DONE = 0u;
+#endif
+    return bench_run("bme280_dual", bme280_iter, ITERS, CHECKSUM);
+}
@@ -0,0 +1,332 @@
+// CoreMark-style benchmark: the four CoreMark workloads (linked-list find and
+// merge sort, 16-bit matrix multiply, a numeric-token state machine, CRC-16)
+// sized for the 8 KB DMEM. Not EEMBC CoreMark and not comparable with its
+// published scores; use it to compare builds and core configurations.
+// See sw/bench/bench.h for the results block.
+// REGRESS_ARGS: +MAX_CYCLES=20000000
+#include <stdint.h>
+#include "bench.h"
+
+#define ITERS       10u
+#define CHECKSUM    0x00055B0Bu
+
+#define LIST_N      32u
+#define MAT_N       6u
+#define STATE_TOKENS 24u
+
+// ---------------------------------------------------------------- CRC-16
+// Bitwise CRC-16/ARC (reflected 0x8005), the CoreMark crcu8 loop.
+static uint16_t crc16_u8(uint8_t data, uint16_t crc) {
+    for (uint32_t i = 0; i < 8u; i++) {
+        const uint16_t x = (uint16_t)((data ^ crc) & 1u);
+        data >>= 1;
+        crc >>= 1;
+        if (x) crc ^= 0xA001u;
+    }
+    return crc;
+}
+
+static uint16_t crc16_u16(uint16_t v, uint16_t crc) {
+    crc = crc16_u8((uint8_t)v, crc);
+    return crc16_u8((uint8_t)(v >> 8), crc);
+}
+
+static uint16_t crc16_u32(uint32_t v, uint16_t crc) {
+    crc = crc16_u16((uint16_t)v, crc);
+    return crc16_u16((uint16_t)(v >> 16), crc);
+}
+
+// Xorshift seeded from the iteration, for the inputs.
+static uint32_t rnd(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *s = x;
+    return x;
+}
+
+// ---------------------------------------------------------------- list
+struct node {
+    struct node *next;
+    int16_t data;
+    uint16_t idx;
+};
+
+static struct node nodes[LIST_N];
+
+static struct node *list_build(uint32_t *seed) {
+    struct node *head = 0;
+    for (uint32_t k = LIST_N; k-- > 0;) {
+        nodes[k].data = (int16_t)(rnd(seed) & 0x7FFFu);
+        nodes[k].idx = (uint16_t)k;
+        nodes[k].next = head;
+        head = &nodes[k];
+    }
+    return head;
+}
+
+static const struct node *list_find(const struct node *l, int16_t data) {
+    while (l && l->data != data) l = l->next;
+    return l;
+}
+
+static struct node *list_reverse(struct node *l) {
+    struct node *prev = 0;
+    while (l) {
+        struct node *next = l->next;
+        l->next = prev;
+        prev = l;
+        l = next;
+    }
+    return prev;
+}
+
+static int cmp_data(const struct node *a, const struct node *b) {
+    return a->data - b->data;
+}
+
+static int cmp_idx(const struct node *a, const struct node *b) {
+    return (int)a->idx - (int)b->idx;
+}
+
+// Bottom-up merge sort of a singly linked list (CoreMark core_list_mergesort).
+static struct node *list_sort(struct node *list, int (*cmp)(const struct node *, const struct node *)) {
+    for (uint32_t insize = 1u;; insize <<= 1) {
+        struct node *p = list, *tail = 0;
+        uint32_t merges = 0u;
+        list = 0;
+        while (p) {
+            merges++;
+            struct node *q = p;
+            uint32_t psize = 0u;
+            for (uint32_t k = 0; k < insize && q; k++) {
+                psize++;
+                q = q->next;
+            }
+            uint32_t qsize = insize;
+            while (psize > 0u || (qsize > 0u && q)) {
+                struct node *e;
+                if (psize == 0u) {
+                    e = q; q = q->next; qsize--;
+                } else if (qsize == 0u || !q || cmp(p, q) <= 0) {
+                    e = p; p = p->next; psize--;
+                } else {
+                    e = q; q = q->next; qsize--;
+                }
+                if (tail) tail->next = e; else list = e;
+                tail = e;
+            }
+            p = q;
+        }
+        tail->next = 0;
+        if (merges <= 1u) return list;
+    }
+}
+
+static uint16_t bench_list(uint32_t seed, uint16_t crc) {
+    struct node *l = list_build(&seed);
+
+    // Finds: half of them hit (values taken from the list), half miss.
+    uint32_t found = 0u, pos = 0u;
+    for (uint32_t k = 0; k < 8u; k++) {
+        const int16_t v = (k & 1u) ? (int16_t)(rnd(&seed) | 0x8000u) : nodes[(k * 5u) & (LIST_N - 1u)].data;
+        const struct node *n = list_find(l, v);
+        if (n) {
+            found++;
+            pos += n->idx;
+        }
+    }
+    crc = crc16_u16((uint16_t)found, crc);
+    crc = crc16_u16((uint16_t)pos, crc);
+
+    l = list_reverse(l);
+    l = list_sort(l, cmp_data);
+    for (const struct node *n = l; n; n = n->next) {
+        crc = crc16_u16((uint16_t)n->data, crc);
+    }
+    l = list_sort(l, cmp_idx);
+    crc = crc16_u16(l->idx, crc);
+    return crc;
+}
+
+// ---------------------------------------------------------------- matrix
+static int16_t mat_a[MAT_N][MAT_N];
+static int16_t mat_b[MAT_N][MAT_N];
+static int32_t mat_c[MAT_N][MAT_N];
+
+static void mat_mul(void) {
+    for (uint32_t i = 0; i < MAT_N; i++) {
+        for (uint32_t j = 0; j < MAT_N; j++) {
+            int32_t acc = 0;
+            for (uint32_t k = 0; k < MAT_N; k++) {
+                acc += (int32_t)mat_a[i][k] * (int32_t)mat_b[k][j];
+            }
+            mat_c[i][j] = acc;
+        }
+    }
+}
+
+// CoreMark matrix_mul_matrix_bitextract: two bit fields of each product.
+static void mat_mul_bitextract(void) {
+    for (uint32_t i = 0; i < MAT_N; i++) {
+        for (uint32_t j = 0; j < MAT_N; j++) {
+            int32_t acc = 0;
+            for (uint32_t k = 0; k < MAT_N; k++) {
+                const uint32_t t = (uint32_t)((int32_t)mat_a[i][k] * (int32_t)mat_b[k][j]);
+                acc += (int32_t)(((t >> 2) & 0xFu) * ((t >> 5) & 0x7Fu));
+            }
+            mat_c[i][j] = acc;
+        }
+    }
+}
+
+static void mat_add_const(int16_t v) {
+    for (uint32_t i = 0; i < MAT_N; i++) {
+        for (uint32_t j = 0; j < MAT_N; j++) {
+            mat_a[i][j] = (int16_t)(mat_a[i][j] + v);
+        }
+    }
+}
+
+// Sum of C, with the CoreMark threshold twist so the result depends on order.
+static int16_t mat_sum(int32_t clipval) {
+    int32_t tmp = 0, prev = 0;
+    int16_t ret = 0;
+    for (uint32_t i = 0; i < MAT_N; i++) {
+        for (uint32_t j = 0; j < MAT_N; j++) {
+            const int32_t cur = mat_c[i][j];
+            tmp += cur;
+            if (tmp > clipval) {
+                ret = (int16_t)(ret + 10);
+                tmp = 0;
+            } else {
+                ret = (int16_t)(ret + ((cur > prev) ? 1 : 0));
+            }
+            prev = cur;
+        }
+    }
+    return ret;
+}
+
+static uint16_t bench_matrix(uint32_t seed, uint16_t crc) {
+    for (uint32_t i = 0; i < MAT_N; i++) {
+        for (uint32_t j = 0; j < MAT_N; j++) {
+            const uint32_t r = rnd(&seed);
+            mat_a[i][j] = (int16_t)((int32_t)(r & 0xFFu) - 128);
+            mat_b[i][j] = (int16_t)((int32_t)((r >> 8) & 0xFFu) - 128);
+        }
+    }
+    mat_mul();
+    crc = crc16_u16((uint16_t)mat_sum(0x3FFFF), crc);
+    mat_mul_bitextract();
+    crc = crc16_u16((uint16_t)mat_sum(0xFFF), crc);
+    mat_add_const((int16_t)(seed & 0x1Fu));
+    mat_mul();
+    crc = crc16_u16((uint16_t)mat_sum(0x3FFFF), crc);
+    crc = crc16_u32((uint32_t)mat_c[MAT_N - 1u][MAT_N - 1u], crc);
+    return crc;
+}
+
+// ---------------------------------------------------------------- state machine
+enum state {
+    ST_START, ST_INVALID, ST_S1, ST_S2, ST_INT, ST_FLOAT, ST_EXPONENT, ST_SCIENTIFIC, N_STATES
+};
+
+// The CoreMark core_state input tokens.
+static const char *const tokens[16] = {
+    "5012", "1234", "-874", "+122", "35.54400", ".1234500", "-110.700", "+0.64400",
+    "5.500e+3", "-.123e-2", "-87e+832", "+0.6e-12", "T0.3e-1F", "-T.T++Tq", "1T3.4e4z", "34.0e-T^",
+};
+
+static char state_buf[STATE_TOKENS * 9u + 1u];
+
+static inline int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// One token from *p up to a ',' or the end; counts every state change.
+static enum state next_state(const char **p, uint32_t *transitions) {
+    const char *s = *p;
+    enum state st = ST_START;
+    for (; *s && st != ST_INVALID; s++) {
+        const char c = *s;
+        if (c == ',') {
+            s++;
+            break;
+        }
+        enum state next = st;
+        switch (st) {
+        case ST_START:
+            if (is_digit(c)) next = ST_INT;
+            else if (c == '+' || c == '-') next = ST_S1;
+            else if (c == '.') next = ST_FLOAT;
+            else next = ST_INVALID;
+            break;
+        case ST_S1:
+            if (is_digit(c)) next = ST_INT;
+            else if (c == '.') next = ST_FLOAT;
+            else next = ST_INVALID;
+            break;
+        case ST_INT:
+            if (c == '.') next = ST_FLOAT;
+            else if (!is_digit(c)) next = ST_INVALID;
+            break;
+        case ST_FLOAT:
+            if (c == 'E' || c == 'e') next = ST_S2;
+            else if (!is_digit(c)) next = ST_INVALID;
+            break;
+        case ST_S2:
+            if (c == '+' || c == '-') next = ST_EXPONENT;
+            else next = ST_INVALID;
+            break;
+        case ST_EXPONENT:
+            if (is_digit(c)) next = ST_SCIENTIFIC;
+            else next = ST_INVALID;
+            break;
+        case ST_SCIENTIFIC:
+            if (!is_digit(c)) next = ST_INVALID;
+            break;
+        default:
+            break;
+        }
+        if (next != st) (*transitions)++;
+        st = next;
+    }
+    // An invalid token is skipped up to its separator.
+    while (*s && s[-1] != ',') s++;
+    *p = s;
+    return st;
+}
+
+static uint16_t bench_state(uint32_t seed, uint16_t crc) {
+    char *w = state_buf;
+    for (uint32_t k = 0; k < STATE_TOKENS; k++) {
+        for (const char *t = tokens[rnd(&seed) & 15u]; *t; t++) *w++ = *t;
+        *w++ = ',';
+    }
+    *w = '\0';
+
+    uint32_t final[N_STATES] = { 0 };
+    uint32_t transitions = 0u;
+    for (const char *p = state_buf; *p;) {
+        final[next_state(&p, &transitions)]++;
+    }
+    for (uint32_t k = 0; k < N_STATES; k++) {
+        crc = crc16_u16((uint16_t)final[k], crc);
+    }
+    return crc16_u16((uint16_t)transitions, crc);
+}
+
+static uint32_t coremark_iter(uint32_t i) {
+    const uint32_t seed = 0x2545F491u ^ (i * 0x9E3779B9u);
+    uint16_t crc = 0u;
+    crc = bench_list(seed, crc);
+    crc = bench_matrix(seed + 1u, crc);
+    crc = bench_state(seed + 2u, crc);
+    return crc;
+}
+
+int main(void) {
+    return bench_run("coremark", coremark_iter, ITERS, CHECKSUM);
+}
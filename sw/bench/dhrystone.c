@@ -0,0 +1,257 @@
+// Dhrystone-style benchmark: the Dhrystone 2.1 main loop and procedures
+// (record copies and pointer chasing, string copy/compare, enum switches,
+// small integer arithmetic with one multiply and one divide per run), with
+// Arr_2_Glob cut from 50x50 to 30x10 words to fit the 8 KB DMEM and local
+// string routines (no libc). Not a valid Dhrystone result; for comparing
+// builds and core configurations (DMIPS/MHz ~ runs / cycles * 1e6 / 1757).
+// See sw/bench/bench.h for the results block.
+// REGRESS_ARGS: +MAX_CYCLES=20000000
+#include <stdint.h>
+#include "bench.h"
+
+#define ITERS       5u
+#define RUNS        100u            // Dhrystone runs per iteration
+#define CHECKSUM    0x52762956u
+
+typedef enum { Ident_1, Ident_2, Ident_3, Ident_4, Ident_5 } Enumeration;
+
+typedef int One_Thirty;
+typedef int One_Fifty;
+typedef char Capital_Letter;
+typedef int Boolean;
+typedef char Str_30[31];
+typedef int Arr_1_Dim[40];
+typedef int Arr_2_Dim[30][10];
+
+typedef struct record {
+    struct record *Ptr_Comp;
+    Enumeration Discr;
+    union {
+        struct {
+            Enumeration Enum_Comp;
+            int Int_Comp;
+            char Str_Comp[31];
+        } var_1;
+        struct {
+            Enumeration E_Comp_2;
+            char Str_2_Comp[31];
+        } var_2;
+        struct {
+            char Ch_1_Comp;
+            char Ch_2_Comp;
+        } var_3;
+    } variant;
+} Rec_Type, *Rec_Pointer;
+
+static Rec_Type rec_glob, rec_next;
+static Rec_Pointer Ptr_Glob, Next_Ptr_Glob;
+static int Int_Glob;
+static Boolean Bool_Glob;
+static char Ch_1_Glob, Ch_2_Glob;
+static Arr_1_Dim Arr_1_Glob;
+static Arr_2_Dim Arr_2_Glob;
+
+static void Proc_6(Enumeration Enum_Val_Par, Enumeration *Enum_Ref_Par);
+static void Proc_7(One_Fifty Int_1_Par_Val, One_Fifty Int_2_Par_Val, One_Fifty *Int_Par_Ref);
+
+// Not inlined, as in Dhrystone built without a libc: the calls are part of the mix.
+__attribute__((noinline)) static void str_copy(char *d, const char *s) {
+    while ((*d++ = *s++) != '\0') {
+    }
+}
+
+__attribute__((noinline)) static int str_cmp(const char *a, const char *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return (int)(unsigned char)*a - (int)(unsigned char)*b;
+}
+
+static Enumeration Func_1(Capital_Letter Ch_1_Par_Val, Capital_Letter Ch_2_Par_Val) {
+    const Capital_Letter Ch_1_Loc = Ch_1_Par_Val;
+    const Capital_Letter Ch_2_Loc = Ch_1_Loc;
+    if (Ch_2_Loc != Ch_2_Par_Val) {
+        return Ident_1;
+    }
+    Ch_1_Glob = Ch_1_Loc;
+    return Ident_2;
+}
+
+static Boolean Func_2(const char *Str_1_Par_Ref, const char *Str_2_Par_Ref) {
+    One_Thirty Int_Loc = 2;
+    Capital_Letter Ch_Loc = 'A';
+    while (Int_Loc <= 2) {
+        if (Func_1(Str_1_Par_Ref[Int_Loc], Str_2_Par_Ref[Int_Loc + 1]) == Ident_1) {
+            Ch_Loc = 'A';
+            Int_Loc += 1;
+        }
+    }
+    if (Ch_Loc >= 'W' && Ch_Loc < 'Z') Int_Loc = 7;
+    if (Ch_Loc == 'R') return 1;
+    if (str_cmp(Str_1_Par_Ref, Str_2_Par_Ref) > 0) {
+        Int_Loc += 7;
+        Int_Glob = Int_Loc;
+        return 1;
+    }
+    return 0;
+}
+
+static Boolean Func_3(Enumeration Enum_Par_Val) {
+    return Enum_Par_Val == Ident_3;
+}
+
+static void Proc_3(Rec_Pointer *Ptr_Ref_Par) {
+    if (Ptr_Glob != 0) *Ptr_Ref_Par = Ptr_Glob->Ptr_Comp;
+    Proc_7(10, Int_Glob, &Ptr_Glob->variant.var_1.Int_Comp);
+}
+
+static void Proc_1(Rec_Pointer Ptr_Val_Par) {
+    Rec_Pointer Next_Record = Ptr_Val_Par->Ptr_Comp;
+    *Ptr_Val_Par->Ptr_Comp = *Ptr_Glob;
+    Ptr_Val_Par->variant.var_1.Int_Comp = 5;
+    Next_Record->variant.var_1.Int_Comp = Ptr_Val_Par->variant.var_1.Int_Comp;
+    Next_Record->Ptr_Comp = Ptr_Val_Par->Ptr_Comp;
+    Proc_3(&Next_Record->Ptr_Comp);
+    if (Next_Record->Discr == Ident_1) {
+        Next_Record->variant.var_1.Int_Comp = 6;
+        Proc_6(Ptr_Val_Par->variant.var_1.Enum_Comp, &Next_Record->variant.var_1.Enum_Comp);
+        Next_Record->Ptr_Comp = Ptr_Glob->Ptr_Comp;
+        Proc_7(Next_Record->variant.var_1.Int_Comp, 10, &Next_Record->variant.var_1.Int_Comp);
+    } else {
+        *Ptr_Val_Par = *Ptr_Val_Par->Ptr_Comp;
+    }
+}
+
+static void Proc_2(One_Fifty *Int_Par_Ref) {
+    One_Fifty Int_Loc = *Int_Par_Ref + 10;
+    Enumeration Enum_Loc = Ident_2;
+    do {
+        if (Ch_1_Glob == 'A') {
+            Int_Loc -= 1;
+            *Int_Par_Ref = Int_Loc - Int_Glob;
+            Enum_Loc = Ident_1;
+        }
+    } while (Enum_Loc != Ident_1);
+}
+
+static void Proc_4(void) {
+    const Boolean Bool_Loc = Ch_1_Glob == 'A';
+    Bool_Glob = Bool_Loc | Bool_Glob;
+    Ch_2_Glob = 'B';
+}
+
+static void Proc_5(void) {
+    Ch_1_Glob = 'A';
+    Bool_Glob = 0;
+}
+
+static void Proc_6(Enumeration Enum_Val_Par, Enumeration *Enum_Ref_Par) {
+    *Enum_Ref_Par = Enum_Val_Par;
+    if (!Func_3(Enum_Val_Par)) *Enum_Ref_Par = Ident_4;
+    switch (Enum_Val_Par) {
+    case Ident_1:
+        *Enum_Ref_Par = Ident_1;
+        break;
+    case Ident_2:
+        *Enum_Ref_Par = (Int_Glob > 100) ? Ident_1 : Ident_4;
+        break;
+    case Ident_3:
+        *Enum_Ref_Par = Ident_2;
+        break;
+    case Ident_4:
+        break;
+    case Ident_5:
+        *Enum_Ref_Par = Ident_3;
+        break;
+    }
+}
+
+static void Proc_7(One_Fifty Int_1_Par_Val, One_Fifty Int_2_Par_Val, One_Fifty *Int_Par_Ref) {
+    const One_Fifty Int_Loc = Int_1_Par_Val + 2;
+    *Int_Par_Ref = Int_2_Par_Val + Int_Loc;
+}
+
+static void Proc_8(Arr_1_Dim Arr_1_Par_Ref, Arr_2_Dim Arr_2_Par_Ref, int Int_1_Par_Val, int Int_2_Par_Val) {
+    const One_Fifty Int_Loc = Int_1_Par_Val + 5;
+    Arr_1_Par_Ref[Int_Loc] = Int_2_Par_Val;
+    Arr_1_Par_Ref[Int_Loc + 1] = Arr_1_Par_Ref[Int_Loc];
+    Arr_1_Par_Ref[Int_Loc + 30] = Int_Loc;
+    for (One_Fifty Int_Index = Int_Loc; Int_Index <= Int_Loc + 1; ++Int_Index) {
+        Arr_2_Par_Ref[Int_Loc][Int_Index] = Int_Loc;
+    }
+    Arr_2_Par_Ref[Int_Loc][Int_Loc - 1] += 1;
+    Arr_2_Par_Ref[Int_Loc + 20][Int_Loc] = Arr_1_Par_Ref[Int_Loc];
+    Int_Glob = 5;
+}
+
+// RUNS passes of the Dhrystone main loop from a fresh state. i only offsets
+// Run_Index; as in Dhrystone, the final values do not depend on it.
+static uint32_t dhrystone_iter(uint32_t i) {
+    One_Fifty Int_1_Loc = 0, Int_2_Loc = 0, Int_3_Loc = 0;
+    Enumeration Enum_Loc = Ident_1;
+    Str_30 Str_1_Loc, Str_2_Loc;
+
+    Next_Ptr_Glob = &rec_next;
+    Ptr_Glob = &rec_glob;
+    Ptr_Glob->Ptr_Comp = Next_Ptr_Glob;
+    Ptr_Glob->Discr = Ident_1;
+    Ptr_Glob->variant.var_1.Enum_Comp = Ident_3;
+    Ptr_Glob->variant.var_1.Int_Comp = 40;
+    str_copy(Ptr_Glob->variant.var_1.Str_Comp, "DHRYSTONE PROGRAM, SOME STRING");
+    str_copy(Str_1_Loc, "DHRYSTONE PROGRAM, 1'ST STRING");
+    Int_Glob = 0;
+    Arr_2_Glob[8][7] = 10;
+
+    const int first = 1 + (int)i;
+    for (int Run_Index = first; Run_Index < first + (int)RUNS; ++Run_Index) {
+        Proc_5();
+        Proc_4();
+        Int_1_Loc = 2;
+        Int_2_Loc = 3;
+        str_copy(Str_2_Loc, "DHRYSTONE PROGRAM, 2'ND STRING");
+        Enum_Loc = Ident_2;
+        Bool_Glob = !Func_2(Str_1_Loc, Str_2_Loc);
+        while (Int_1_Loc < Int_2_Loc) {
+            Int_3_Loc = 5 * Int_1_Loc - Int_2_Loc;
+            Proc_7(Int_1_Loc, Int_2_Loc, &Int_3_Loc);
+            Int_1_Loc += 1;
+        }
+        Proc_8(Arr_1_Glob, Arr_2_Glob, Int_1_Loc, Int_3_Loc);
+        Proc_1(Ptr_Glob);
+        for (Capital_Letter Ch_Index = 'A'; Ch_Index <= Ch_2_Glob; ++Ch_Index) {
+            if (Enum_Loc == Func_1(Ch_Index, 'C')) {
+                Proc_6(Ident_1, &Enum_Loc);
+                str_copy(Str_2_Loc, "DHRYSTONE PROGRAM, 3'RD STRING");
+                Int_2_Loc = Run_Index;
+                Int_Glob = Run_Index;
+            }
+        }
+        Int_2_Loc = Int_2_Loc * Int_1_Loc;
+        Int_1_Loc = Int_2_Loc / Int_3_Loc;
+        Int_2_Loc = 7 * (Int_2_Loc - Int_3_Loc) - Int_1_Loc;
+        Proc_2(&Int_1_Loc);
+    }
+
+    // The values Dhrystone prints at the end, folded into one word.
+    uint32_t h = (uint32_t)Int_Glob;
+    h = h * 31u + (uint32_t)Bool_Glob;
+    h = h * 31u + (uint32_t)(unsigned char)Ch_1_Glob;
+    h = h * 31u + (uint32_t)(unsigned char)Ch_2_Glob;
+    h = h * 31u + (uint32_t)Arr_1_Glob[8];
+    h = h * 31u + (uint32_t)Arr_2_Glob[8][7];
+    h = h * 31u + (uint32_t)Ptr_Glob->Discr;
+    h = h * 31u + (uint32_t)Ptr_Glob->variant.var_1.Enum_Comp;
+    h = h * 31u + (uint32_t)Ptr_Glob->variant.var_1.Int_Comp;
+    h = h * 31u + (uint32_t)Next_Ptr_Glob->variant.var_1.Int_Comp;
+    h = h * 31u + (uint32_t)Int_1_Loc;
+    h = h * 31u + (uint32_t)Int_2_Loc;
+    h = h * 31u + (uint32_t)Int_3_Loc;
+    h = h * 31u + (uint32_t)Enum_Loc;
+    h = h * 31u + (uint32_t)(unsigned char)Str_2_Loc[20];
+    return h;
+}
+
+int main(void) {
+    return bench_run("dhrystone", dhrystone_iter, ITERS, CHECKSUM);
+}
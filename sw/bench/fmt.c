@@ -0,0 +1,77 @@
+// Integer formatting benchmark: the put_uint/put_int/put_hex digit loops of
+// sw/stdio.c (udivmod10 of sw/muldiv.h, no divide instruction) writing into
+// a buffer instead of the UART, over values of every decimal width.
+// See sw/bench/bench.h for the results block.
+// REGRESS_ARGS: +MAX_CYCLES=20000000
+#include <stdint.h>
+#include "bench.h"
+#include "../muldiv.h"
+
+#define ITERS       8u
+#define VALUES      64u             // numbers formatted per iteration, decimal and hex
+#define CHECKSUM    0x1CE4758Fu
+
+static char buf[VALUES * 21u];
+
+static char *fmt_uint(char *p, uint32_t x) {
+    char tmp[10];
+    int i = 0;
+
+    do {
+        uint32_t r;
+        x = udivmod10(x, &r);
+        tmp[i++] = (char)('0' + r);
+    } while (x > 0);
+
+    while (i--) {
+        *p++ = tmp[i];
+    }
+    return p;
+}
+
+static char *fmt_int(char *p, int32_t v) {
+    if (v < 0) {
+        *p++ = '-';
+        return fmt_uint(p, -(uint32_t)v);
+    }
+    return fmt_uint(p, (uint32_t)v);
+}
+
+static char *fmt_hex(char *p, uint32_t x) {
+    int s = 28;
+
+    while (s > 0 && (x >> s) == 0) {
+        s -= 4;
+    }
+    for (; s >= 0; s -= 4) {
+        const uint32_t d = (x >> s) & 0xFu;
+        *p++ = (char)(d < 10 ? '0' + d : 'a' + d - 10);
+    }
+    return p;
+}
+
+static uint32_t fmt_iter(uint32_t i) {
+    uint32_t x = 0x9E3779B9u + i;
+    char *p = buf;
+    for (uint32_t k = 0; k < VALUES; k++) {
+        // Xorshift step, then keep 1..32 bits so every digit count shows up.
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        const uint32_t v = x >> (k & 31u);
+        p = fmt_int(p, (int32_t)v);
+        *p++ = ' ';
+        p = fmt_hex(p, v);
+        *p++ = '\n';
+    }
+
+    uint32_t h = 0u;
+    for (const char *q = buf; q < p; q++) {
+        h = (h << 5) + h + (uint8_t)*q;
+    }
+    return h + (uint32_t)(p - buf);
+}
+
+int main(void) {
+    return bench_run("fmt", fmt_iter, ITERS, CHECKSUM);
+}
@@ -0,0 +1,54 @@
+// memcpy/memset/memmove benchmark: the sw/string.S routines on 1 KiB blocks,
+// word-aligned, with the source one byte off and overlapping, plus the C byte
+// loop they replace. Bound by the LSU: dmem[8] (LSU wait) shows what the
+// memory side costs, e.g. with XMEM=1.
+// See sw/bench/bench.h for the results block.
+// REGRESS_ARGS: +MAX_CYCLES=20000000
+#include <stdint.h>
+#include "bench.h"
+#include "../string.h"
+
+#define ITERS       8u
+#define N_BYTES     1024u
+#define CHECKSUM    0x751BBB3Du
+
+// Words, so the checksum can read them as words; the copies go through bytes.
+static uint32_t words_a[(N_BYTES + 16u) / 4u];
+static uint32_t words_b[(N_BYTES + 16u) / 4u];
+#define buf_a   ((uint8_t *)words_a)
+#define buf_b   ((uint8_t *)words_b)
+
+// Plain C byte copy (-fno-tree-loop-distribute-patterns keeps it a loop).
+__attribute__((noinline)) static void copy_bytes(uint8_t *d, const uint8_t *s, uint32_t n) {
+    for (uint32_t k = 0; k < n; k++) {
+        d[k] = s[k];
+    }
+}
+
+static uint32_t sum_words(const uint32_t *w, uint32_t n) {
+    uint32_t h = 0u;
+    for (uint32_t k = 0; k < n / 4u; k++) {
+        h = (h << 1) + (h >> 31) + w[k];
+    }
+    return h;
+}
+
+static uint32_t memcpy_iter(uint32_t i) {
+    memset(buf_a, (int)(0x5Au ^ i), N_BYTES + 16u);
+    buf_a[i & 0x3FFu] = (uint8_t)i;
+    buf_a[N_BYTES - 1u - (i & 0x3FFu)] = (uint8_t)~i;
+
+    memcpy(buf_b, buf_a, N_BYTES);                  // aligned
+    uint32_t h = sum_words(words_b, N_BYTES);
+    memcpy(buf_b, buf_a + 1, N_BYTES);              // source one byte off
+    h += sum_words(words_b, N_BYTES);
+    memmove(buf_b + 4, buf_b, N_BYTES);             // overlapping, copied backwards
+    h += sum_words(words_b, N_BYTES + 4u);
+    copy_bytes(buf_b, buf_a + 3, N_BYTES);
+    h += sum_words(words_b, N_BYTES);
+    return h;
+}
+
+int main(void) {
+    return bench_run("memcpy", memcpy_iter, ITERS, CHECKSUM);
+}
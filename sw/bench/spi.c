@@ -0,0 +1,79 @@
+// SPI byte loop benchmark: the polled spi_xfer() of sw/main.c (TX FIFO loads,
+// N_BYTE start, busy polling, RX FIFO reads) on a BME280 calibration read
+// (1 command + 26 data bytes) and an 8-byte register write at clk_div 2.
+// Mostly MMIO loads and stores: the interconnect and the posted write buffer,
+// not the ALU. The TB and the ISS drive MISO low, so the data read is zero.
+// See sw/bench/bench.h for the results block.
+// REGRESS_ARGS: +MAX_CYCLES=20000000
+#include <stdint.h>
+#include "bench.h"
+
+#ifdef BENCH_HOST
+#error "spi.c drives the SPI controller: no host build (its checksum is ITERS * 325)"
+#endif
+
+#define ITERS       8u
+#define RX_LEN      26u
+#define TX_LEN      8u
+#define CHECKSUM    (ITERS * 325u)  // sum of k for k < RX_LEN, MISO low
+
+#define SPI_BASE        0x00004000u
+#define SPI_STATUS      0u
+#define SPI_WRITE       4u
+#define SPI_READ        8u
+#define SPI_N_BYTE      12u
+#define SPI_CLK_DIV     20u
+#define SPI_CFG         24u
+
+#define CLK_DIV         2u
+
+static uint8_t rx_buf[RX_LEN];
+static const uint8_t cmd_read[1] = { 0x88u };   // calib00 | read
+static const uint8_t cmd_write[TX_LEN] = { 0x72u, 0x01u, 0x74u, 0x27u, 0x75u, 0x20u, 0x72u, 0x01u };
+
+static inline void mmio_write(uint32_t addr, uint32_t data) {
+    *((volatile uint32_t *)addr) = data;
+}
+
+static inline uint32_t mmio_read(uint32_t addr) {
+    return *((volatile uint32_t *)addr);
+}
+
+static void wait_for_spi_ready(void) {
+    while (mmio_read(SPI_BASE + SPI_STATUS) & (1u << 4)) {
+    }
+}
+
+// sw/main.c spi_xfer()
+static void spi_xfer(const uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len) {
+    wait_for_spi_ready();
+    for (uint32_t i = 0; i < tx_len; i++) {
+        mmio_write(SPI_BASE + SPI_WRITE, tx[i]);
+    }
+    mmio_write(SPI_BASE + SPI_N_BYTE, (rx_len & 0xFFFFu) | ((tx_len & 0xFFFFu) << 16));
+    wait_for_spi_ready();
+    for (uint32_t i = 0; i < rx_len; i++) {
+        rx[i] = (uint8_t)(mmio_read(SPI_BASE + SPI_READ) & 0xFFu);
+    }
+}
+
+static uint32_t spi_iter(uint32_t i) {
+    (void)i;
+    for (uint32_t k = 0; k < RX_LEN; k++) {
+        rx_buf[k] = 0xEEu;
+    }
+    spi_xfer(cmd_read, 1u, rx_buf, RX_LEN);
+    spi_xfer(cmd_write, TX_LEN, 0, 0u);
+
+    uint32_t h = 0u;
+    for (uint32_t k = 0; k < RX_LEN; k++) {
+        h += rx_buf[k] + k;
+    }
+    return h;
+}
+
+int main(void) {
+    mmio_write(SPI_BASE + SPI_CFG, 1u);         // MSB first, mode 0
+    mmio_write(SPI_BASE + SPI_CLK_DIV, CLK_DIV);
+    return bench_run("spi", spi_iter, ITERS, CHECKSUM);
+}
@@ -0,0 +1,82 @@
+#include "bme280.h"
+
+void bme280_parse_calib(struct bme280_calib *c, const uint8_t *b1, const uint8_t *b2){
+    c->dig_T1 = (uint16_t)(b1[1] << 8 | b1[0]);
+    c->dig_T2 = (int16_t)(b1[3] << 8 | b1[2]);
+    c->dig_T3 = (int16_t)(b1[5] << 8 | b1[4]);
+
+    c->dig_P1 = (uint16_t)(b1[7] << 8 | b1[6]);
+    c->dig_P2 = (int16_t)(b1[9] << 8 | b1[8]);
+    c->dig_P3 = (int16_t)(b1[11] << 8 | b1[10]);
+    c->dig_P4 = (int16_t)(b1[13] << 8 | b1[12]);
+    c->dig_P5 = (int16_t)(b1[15] << 8 | b1[14]);
+    c->dig_P6 = (int16_t)(b1[17] << 8 | b1[16]);
+    c->dig_P7 = (int16_t)(b1[19] << 8 | b1[18]);
+    c->dig_P8 = (int16_t)(b1[21] << 8 | b1[20]);
+    c->dig_P9 = (int16_t)(b1[23] << 8 | b1[22]);
+
+    c->dig_H1 = b1[25];
+
+    c->dig_H2 = (int16_t)(b2[1] << 8 | b2[0]);
+    c->dig_H3 = b2[2];
+    c->dig_H4 = (int16_t)((b2[3] << 4) | (b2[4] & 0x0F));
+    c->dig_H5 = (int16_t)((b2[5] << 4) | (b2[4] >> 4));
+    c->dig_H6 = (int8_t)b2[6];
+}
+
+int32_t bme280_comp_T_x100(const struct bme280_calib *c, int32_t adc_T, int32_t *t_fine){
+    int32_t var1, var2;
+    var1 = ((((adc_T >> 3) - ((int32_t)c->dig_T1 << 1))) * ((int32_t)c->dig_T2)) >> 11;
+    var2 = (((((adc_T >> 4) - ((int32_t)c->dig_T1)) * ((adc_T >> 4) - ((int32_t)c->dig_T1))) >> 12) * ((int32_t)c->dig_T3)) >> 14;
+    *t_fine = var1 + var2;
+    return (*t_fine * 5 + 128) >> 8; // °C * 100
+}
+
+uint32_t bme280_comp_P_Pa(const struct bme280_calib *c, int32_t adc_P, int32_t t_fine){
+    int32_t var1, var2;
+    uint32_t p;
+
+    // Use Bosch's 32-bit integer path to avoid pulling in 64-bit libgcc helpers on RV32I.
+    var1 = (t_fine >> 1) - 64000;
+    var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)c->dig_P6;
+    var2 = var2 + ((var1 * (int32_t)c->dig_P5) << 1);
+    var2 = (var2 >> 2) + ((int32_t)c->dig_P4 << 16);
+
+    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * (int32_t)c->dig_P3) >> 3) +
+           (((int32_t)c->dig_P2 * var1) >> 1);
+    var1 = (var1 >> 18);
+    var1 = (((32768 + var1) * (int32_t)c->dig_P1) >> 15);
+
+    if (var1 == 0) {
+        return 0;
+    }
+
+    p = ((uint32_t)(1048576 - adc_P) - ((uint32_t)var2 >> 12)) * 3125u;
+    if (p < 0x80000000u) {
+        p = (p << 1) / (uint32_t)var1;
+    } else {
+        p = (p / (uint32_t)var1) << 1;
+    }
+
+    var1 = (((int32_t)c->dig_P9) * (int32_t)(((p >> 3) * (p >> 3)) >> 13)) >> 12;
+    var2 = (((int32_t)(p >> 2)) * (int32_t)c->dig_P8) >> 13;
+
+    p = p + (uint32_t)((var1 + var2 + (int32_t)c->dig_P7) >> 4);
+    return p; // Pa
+}
+
+uint32_t bme280_comp_H_x1024(const struct bme280_calib *c, int32_t adc_H, int32_t t_fine){
+    int32_t v_x1;
+
+    v_x1 = t_fine - 76800;
+    v_x1 = (((((adc_H << 14) - ((int32_t)c->dig_H4 << 20) - ((int32_t)c->dig_H5 * v_x1)) + 16384) >> 15) *
+            (((((((v_x1 * (int32_t)c->dig_H6) >> 10) * (((v_x1 * (int32_t)c->dig_H3) >> 11) + 32768)) >> 10) + 2097152) *
+               (int32_t)c->dig_H2 + 8192) >> 14));
+
+    v_x1 = v_x1 - (((((v_x1 >> 15) * (v_x1 >> 15)) >> 7) * (int32_t)c->dig_H1) >> 4);
+
+    if (v_x1 < 0) v_x1 = 0;
+    if (v_x1 > 419430400) v_x1 = 419430400;
+
+    return (uint32_t)(v_x1 >> 12); // %RH * 1024
+}
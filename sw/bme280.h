@@ -0,0 +1,22 @@
+#include <stdint.h>
+
+// BME280 calibration and integer compensation (Bosch datasheet, 32-bit
+// paths), shared by sw/main.c and sw/bench/bme280.c. No SPI access here: the
+// caller reads the two calibration blocks (0x88..0xA1 and 0xE1..0xE7) and the
+// raw ADC words.
+struct bme280_calib {
+    uint16_t dig_T1; int16_t dig_T2; int16_t dig_T3;
+    uint16_t dig_P1; int16_t dig_P2; int16_t dig_P3; int16_t dig_P4; int16_t dig_P5;
+    int16_t  dig_P6; int16_t dig_P7; int16_t dig_P8; int16_t dig_P9;
+    uint8_t  dig_H1; int16_t dig_H2; uint8_t dig_H3; int16_t dig_H4; int16_t dig_H5; int8_t dig_H6;
+};
+
+#define BME280_CALIB1_LEN   26u     // 0x88..0xA1
+#define BME280_CALIB2_LEN   7u      // 0xE1..0xE7
+
+void bme280_parse_calib(struct bme280_calib *c, const uint8_t *b1, const uint8_t *b2);
+
+// Temperature first: it sets *t_fine, which pressure and humidity take.
+int32_t bme280_comp_T_x100(const struct bme280_calib *c, int32_t adc_T, int32_t *t_fine);  // °C * 100
+uint32_t bme280_comp_P_Pa(const struct bme280_calib *c, int32_t adc_P, int32_t t_fine);    // Pa
+uint32_t bme280_comp_H_x1024(const struct bme280_calib *c, int32_t adc_H, int32_t t_fine); // %RH * 1024
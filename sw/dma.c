@@ -0,0 +1,107 @@
+#include "dma.h"
+
+#define DMA_REG         ((volatile uint32_t *)DMA_BASE_ADDR)
+#define REG_CTRL        0
+#define REG_STATUS      1
+#define REG_DESC        2
+#define REG_CUR         3
+#define REG_COUNT       4
+
+#define CTRL_START      (1u << 0)
+#define CTRL_ABORT      (1u << 2)
+
+#define MSTATUS_MIE     (1u << 3)
+#define MIE_MEIE        (1u << 11)
+
+// SPI registers (sw/main.c)
+#define SPI_BASE_ADDR   0x00004000u
+#define SPI_WRITE       4u
+#define SPI_READ        8u
+#define SPI_N_BYTE      12u
+#define SPI_WAIT_BUSY   DMA_WAIT_WHILE(4, 1)
+
+static uint32_t started_flags;
+
+static struct dma_desc spi_chain[3];
+static uint32_t spi_n_byte;
+
+void dma_start(const struct dma_desc *chain, uint32_t flags) {
+    started_flags = flags;
+    DMA_REG[REG_DESC] = (uint32_t)chain;
+    DMA_REG[REG_CTRL] = CTRL_START | (flags & DMA_IRQ_EN);
+}
+
+int dma_busy(void) {
+    return (DMA_REG[REG_STATUS] & DMA_STATUS_BUSY) != 0;
+}
+
+// With DMA_IRQ_EN the core sleeps until DONE/ERR raise the line. mstatus.MIE is
+// clear and the line (and mie.MEIE, which WFI needs) enabled only around the
+// loop, so a completion between the status read and WFI still wakes it and no
+// handler runs.
+int dma_wait(void) {
+    const int sleep = (started_flags & DMA_IRQ_EN) != 0;
+    uint32_t m = 0;
+    uint32_t e = 0;
+    uint32_t st;
+
+    if (sleep) {
+        __asm__ volatile ("csrrci %0, mstatus, %1" : "=r"(m) : "i"(MSTATUS_MIE) : "memory");
+        __asm__ volatile ("csrrs %0, mie, %1" : "=r"(e) : "r"(MIE_MEIE) : "memory");
+        __asm__ volatile ("csrsi 0xF03, %0" :: "i"(1u << DMA_IRQ) : "memory");
+    }
+    while ((st = DMA_REG[REG_STATUS]) & DMA_STATUS_BUSY) {
+        if (sleep) {
+            __asm__ volatile ("wfi");
+        }
+    }
+    DMA_REG[REG_STATUS] = st & (DMA_STATUS_DONE | DMA_STATUS_ERR);
+    if (sleep) {
+        __asm__ volatile ("csrci 0xF03, %0" :: "i"(1u << DMA_IRQ) : "memory");
+        __asm__ volatile ("csrc mie, %0" :: "r"(~e & MIE_MEIE) : "memory");
+        __asm__ volatile ("csrs mstatus, %0" :: "r"(m & MSTATUS_MIE) : "memory");
+    }
+    return (st & DMA_STATUS_ERR) ? -1 : 0;
+}
+
+// The chain stops at the next element boundary with DONE.
+void dma_abort(void) {
+    DMA_REG[REG_CTRL] = CTRL_ABORT | (started_flags & DMA_IRQ_EN);
+}
+
+uint32_t dma_count(void) {
+    return DMA_REG[REG_COUNT];
+}
+
+uint32_t dma_isr(void) {
+    const uint32_t st = DMA_REG[REG_STATUS];
+    DMA_REG[REG_STATUS] = st & (DMA_STATUS_DONE | DMA_STATUS_ERR);
+    return st;
+}
+
+void dma_spi_start(const uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len, uint32_t flags) {
+    spi_n_byte = ((rx_len & 0xFFFFu) << 0) | ((tx_len & 0xFFFFu) << 16);
+
+    spi_chain[0].periph = SPI_BASE_ADDR + SPI_WRITE;
+    spi_chain[0].mem    = (uint32_t)tx;
+    spi_chain[0].ctrl   = DMA_COUNT(tx_len) | SPI_WAIT_BUSY;
+    spi_chain[0].next   = &spi_chain[1];
+
+    spi_chain[1].periph = SPI_BASE_ADDR + SPI_N_BYTE;
+    spi_chain[1].mem    = (uint32_t)&spi_n_byte;
+    spi_chain[1].ctrl   = DMA_COUNT(1) | DMA_WORD;
+    spi_chain[1].next   = rx_len ? &spi_chain[2] : 0;
+
+    spi_chain[2].periph = SPI_BASE_ADDR + SPI_READ;
+    spi_chain[2].mem    = (uint32_t)rx;
+    spi_chain[2].ctrl   = DMA_COUNT(rx_len) | DMA_TO_MEM | SPI_WAIT_BUSY;
+    spi_chain[2].next   = 0;
+
+    dma_start(spi_chain, flags);
+}
+
+// Sleeps instead of polling STATUS, which would share the crossbar with the engine.
+int dma_spi_xfer(const uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len) {
+    dma_spi_start(tx, tx_len, rx, rx_len, DMA_IRQ_EN);
+    return dma_wait();
+}
@@ -0,0 +1,53 @@
+#include <stdint.h>
+
+// Driver for the axi_dma engine (soc crossbar slave at 0x5000, see
+// hw/RTL/peripherals/axi_dma.sv). A transfer is a chain of descriptors in DMEM;
+// each one moves COUNT bytes or words between one peripheral register (a FIFO
+// port) and consecutive DMEM addresses, optionally after waiting for a status
+// bit of that peripheral. Data buffers and descriptors must be in DMEM.
+//
+// dma_wait() polls STATUS, or sleeps in WFI when the chain was started with
+// DMA_IRQ_EN. An application that takes the completion interrupt itself
+// (external_irq[2], CSR 0xF03 bit 2) calls dma_isr() from its handler instead.
+
+#define DMA_BASE_ADDR   0x00005000u
+
+// Interrupt line of the DMA completion interrupt (soc external_irq).
+#define DMA_IRQ         2u
+
+// dma_start() flags (CTRL bits)
+#define DMA_IRQ_EN      (1u << 1)
+
+// STATUS bits
+#define DMA_STATUS_BUSY (1u << 0)
+#define DMA_STATUS_DONE (1u << 1)
+#define DMA_STATUS_ERR  (1u << 2)
+
+// Descriptor CTRL word
+#define DMA_COUNT(n)    ((uint32_t)(n) & 0xFFFFu)
+#define DMA_TO_MEM      (1u << 16)      // peripheral -> DMEM (else DMEM -> peripheral)
+#define DMA_WORD        (1u << 17)      // 32-bit elements (else bytes)
+#define DMA_WAIT_EACH   (1u << 18)      // wait before every element, not only the first
+// Poll the status register (offset 0 of the peripheral's 4 KB slot) while bit
+// `bit` reads `val`, e.g. DMA_WAIT_WHILE(4, 1) for SPI busy, (3, 1) for UART TX full.
+#define DMA_WAIT_WHILE(bit, val) ((1u << 19) | ((uint32_t)(val) << 20) | ((uint32_t)(bit) << 24))
+
+struct dma_desc {
+    uint32_t periph;                    // peripheral register address
+    uint32_t mem;                       // DMEM byte address
+    uint32_t ctrl;
+    const struct dma_desc *next;        // 0: end of chain
+};
+
+void dma_start(const struct dma_desc *chain, uint32_t flags);
+int dma_busy(void);
+int dma_wait(void);                     // 0 done, -1 error
+void dma_abort(void);
+uint32_t dma_count(void);               // elements moved by the last chain
+uint32_t dma_isr(void);                 // clears DONE/ERR, returns STATUS
+
+// spi_xfer() of sw/main.c as one chain: tx_len bytes out once the SPI is idle,
+// the N_BYTE trigger, then rx_len bytes in once the transaction is over. The
+// descriptors are static: one SPI chain at a time.
+void dma_spi_start(const uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len, uint32_t flags);
+int dma_spi_xfer(const uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len);
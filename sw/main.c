@@ -1,5 +1,12 @@
 #include <stdint.h>
 #include "stdio.h"
+#include "perf_counters.h"
+#include "muldiv.h"
+#include "dma.h"
+#include "sched.h"
+#include "sample_ring.h"
+#include "pcprof.h"
+#include "bme280.h"
 
 #define OK_FLAG  0xDEADBEEFu
 #define ERR_FLAG 0xBAD00000u
@@ -9,7 +16,6 @@
 
 #define MMIO_7SEG_BASE      0x00001000u
 #define MMIO_uart_BASE      0x00002000u
-#define MMIO_CLINT_BASE     0x00003000u
 #define MMIO_SPI_BASE       0x00004000u
 #define SEG_DATA_OFFSET     0x00u
 #define SEG_DP_OFFSET       0x04u
@@ -21,13 +27,27 @@
 #define ADDR_CLK_DIV        20
 #define ADDR_CFG            24
 
-#define CLINT_MTIME_L       0x00u
-#define CLINT_MTIME_H       0x04u
-#define CLINT_MTIMECMP_L    0x08u
-#define CLINT_MTIMECMP_H    0x0Cu
-
 #define CPU_FREQ_HZ         100000000u
 
+#define MIE_MEIE            (1u << 11)
+#define MSTATUS_MIE         (1u << 3)
+#define MCAUSE_MTI          0x80000007u
+
+// Sampling rate. A period must cover the 9-byte SPI read (16 * clk_div cycles
+// per byte, 144 ms at clk_div 100000); a sample still in flight at the next
+// deadline skips that one.
+#define SAMPLE_HZ           4u
+#define SAMPLE_PERIOD       (CPU_FREQ_HZ / SAMPLE_HZ)
+#define RING_ENTRIES        32u     // 8 s at 4 Hz
+#define RING_PAYLOAD        3u      // T_x100, P_Pa, H_x100
+
+// make SCHED_STATS=1: a second line per print with the idle share, the sampling
+// jitter and the lost samples (the default build leaves it out to fit in IMEM).
+
+// make PCPROF=1: mepc samples for tools/bootloader -profile. A prime number of
+// ticks (about 500 Hz), so the samples do not lock onto the task periods.
+#define PCPROF_PERIOD       199999u
+
 struct spi_cfg_t{
     int msb_first;
     int delay_byte;
@@ -56,10 +76,12 @@ static uint32_t seg7_pack_x100(uint32_t value_x100){
         value_x100 = 9999u;
     }
 
-    return (((value_x100 / 1000u) % 10u) << 12) |
-           (((value_x100 /  100u) % 10u) << 8)  |
-           (((value_x100 /   10u) % 10u) << 4)  |
-           (((value_x100 /    1u) % 10u) << 0);
+    uint32_t d0, d1, d2;
+    const uint32_t d3 = udivmod1000(value_x100, &d2);
+    d2 = udivmod100(d2, &d1);
+    d1 = udivmod10(d1, &d0);
+
+    return (d3 << 12) | (d2 << 8) | (d1 << 4) | d0;
 }
 
 static inline void wait_for_spi_ready(void){
@@ -69,45 +91,26 @@ static inline void wait_for_spi_ready(void){
     } while (status & (1u << 4)); // busy
 }
 
-static void clint_read_mtime(uint32_t *hi, uint32_t *lo){
-    uint32_t hi_1, hi_2, lo_v;
-
-    do {
-        mmio_read(MMIO_CLINT_BASE + CLINT_MTIME_H, &hi_1);
-        mmio_read(MMIO_CLINT_BASE + CLINT_MTIME_L, &lo_v);
-        mmio_read(MMIO_CLINT_BASE + CLINT_MTIME_H, &hi_2);
-    } while (hi_1 != hi_2);
-
-    *hi = hi_2;
-    *lo = lo_v;
-}
+static void sample_done(void);
 
-static void clint_write_mtimecmp(uint32_t hi, uint32_t lo){
-    // Write high first to max to avoid a transient early compare while updating low/high.
-    mmio_write(MMIO_CLINT_BASE + CLINT_MTIMECMP_H, 0xFFFFFFFFu);
-    mmio_write(MMIO_CLINT_BASE + CLINT_MTIMECMP_L, lo);
-    mmio_write(MMIO_CLINT_BASE + CLINT_MTIMECMP_H, hi);
+// Timer: the scheduler. External: the DMA sample read and the UART TX ring.
+__attribute__((interrupt("machine"), aligned(4)))
+static void trap_handler(void){
+    if (csr_read(mcause) == MCAUSE_MTI) {
+        sched_timer_isr();
+        return;
+    }
+    if (csr_read(0xF00) & (1u << DMA_IRQ)) {
+        sample_done();
+    }
+    stdio_uart_isr();
 }
 
-static void delay_1s(void){
-    uint32_t start_hi, start_lo;
-    uint32_t deadline_hi, deadline_lo;
-    uint32_t now_hi, now_lo;
-
-    clint_read_mtime(&start_hi, &start_lo);
-
-    deadline_lo = start_lo + CPU_FREQ_HZ;
-    deadline_hi = start_hi + ((deadline_lo < start_lo) ? 1u : 0u);
-
-    clint_write_mtimecmp(deadline_hi, deadline_lo);
-
-    do {
-        __asm__ volatile ("wfi");
-        clint_read_mtime(&now_hi, &now_lo);
-    } while ((now_hi < deadline_hi) ||
-             ((now_hi == deadline_hi) && (now_lo < deadline_lo)));
-
-    clint_write_mtimecmp(0xFFFFFFFFu, 0xFFFFFFFFu);
+static void irq_init(void){
+    csr_write(mtvec, (uint32_t)trap_handler);
+    csr_write(0xF03, 1u << DMA_IRQ);   // external line enables: GPIO off, DMA on, stdio sets its own
+    csr_write(mie, MIE_MEIE);
+    csr_write(mstatus, MSTATUS_MIE);
 }
 
 static void configure_spi(const struct spi_cfg_t *cfg){
@@ -200,8 +203,8 @@ static void bme280_init_basic(void){
     uint8_t ctrl_hum = 0x01;
     bme280_write(BME280_REG_CTRL_HUM, &ctrl_hum, 1);
 
-    // t_sb=1000ms (101), filter=off (000), spi3w=0
-    uint8_t config = (uint8_t)((0x05u << 5) | (0x00u << 2) | 0x00u);
+    // t_sb=62.5ms (001), filter=off (000), spi3w=0: a fresh measurement for every sample
+    uint8_t config = (uint8_t)((0x01u << 5) | (0x00u << 2) | 0x00u);
     bme280_write(BME280_REG_CONFIG, &config, 1);
 
     // osrs_t=x1, osrs_p=x1, mode=normal
@@ -209,103 +212,130 @@ static void bme280_init_basic(void){
     bme280_write(BME280_REG_CTRL_MEAS, &ctrl_meas, 1);
 }
 
-/* -------- Calibración + compensación (Bosch, entero) -------- */
-struct bme280_calib {
-    uint16_t dig_T1; int16_t dig_T2; int16_t dig_T3;
-    uint16_t dig_P1; int16_t dig_P2; int16_t dig_P3; int16_t dig_P4; int16_t dig_P5;
-    int16_t  dig_P6; int16_t dig_P7; int16_t dig_P8; int16_t dig_P9;
-    uint8_t  dig_H1; int16_t dig_H2; uint8_t dig_H3; int16_t dig_H4; int16_t dig_H5; int8_t dig_H6;
-};
-
+/* -------- Calibración (Bosch, compensación en sw/bme280.c) -------- */
 static struct bme280_calib calib;
-static int32_t t_fine;
 
 static void bme280_read_calibration(void){
-    uint8_t b1[26];
-    uint8_t b2[7];
-
-    bme280_read(0x88, b1, 26);
-
-    calib.dig_T1 = (uint16_t)(b1[1] << 8 | b1[0]);
-    calib.dig_T2 = (int16_t)(b1[3] << 8 | b1[2]);
-    calib.dig_T3 = (int16_t)(b1[5] << 8 | b1[4]);
-
-    calib.dig_P1 = (uint16_t)(b1[7] << 8 | b1[6]);
-    calib.dig_P2 = (int16_t)(b1[9] << 8 | b1[8]);
-    calib.dig_P3 = (int16_t)(b1[11] << 8 | b1[10]);
-    calib.dig_P4 = (int16_t)(b1[13] << 8 | b1[12]);
-    calib.dig_P5 = (int16_t)(b1[15] << 8 | b1[14]);
-    calib.dig_P6 = (int16_t)(b1[17] << 8 | b1[16]);
-    calib.dig_P7 = (int16_t)(b1[19] << 8 | b1[18]);
-    calib.dig_P8 = (int16_t)(b1[21] << 8 | b1[20]);
-    calib.dig_P9 = (int16_t)(b1[23] << 8 | b1[22]);
-
-    calib.dig_H1 = b1[25];
-
-    bme280_read(0xE1, b2, 7);
-
-    calib.dig_H2 = (int16_t)(b2[1] << 8 | b2[0]);
-    calib.dig_H3 = b2[2];
-    calib.dig_H4 = (int16_t)((b2[3] << 4) | (b2[4] & 0x0F));
-    calib.dig_H5 = (int16_t)((b2[5] << 4) | (b2[4] >> 4));
-    calib.dig_H6 = (int8_t)b2[6];
-}
+    uint8_t b1[BME280_CALIB1_LEN];
+    uint8_t b2[BME280_CALIB2_LEN];
 
-static int32_t bme280_comp_T_x100(int32_t adc_T){
-    int32_t var1, var2;
-    var1 = ((((adc_T >> 3) - ((int32_t)calib.dig_T1 << 1))) * ((int32_t)calib.dig_T2)) >> 11;
-    var2 = (((((adc_T >> 4) - ((int32_t)calib.dig_T1)) * ((adc_T >> 4) - ((int32_t)calib.dig_T1))) >> 12) * ((int32_t)calib.dig_T3)) >> 14;
-    t_fine = var1 + var2;
-    return (t_fine * 5 + 128) >> 8; // °C * 100
+    bme280_read(0x88, b1, BME280_CALIB1_LEN);
+    bme280_read(0xE1, b2, BME280_CALIB2_LEN);
+    bme280_parse_calib(&calib, b1, b2);
 }
 
-static uint32_t bme280_comp_P_Pa(int32_t adc_P){
-    int32_t var1, var2;
-    uint32_t p;
-
-    // Use Bosch's 32-bit integer path to avoid pulling in 64-bit libgcc helpers on RV32I.
-    var1 = (t_fine >> 1) - 64000;
-    var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)calib.dig_P6;
-    var2 = var2 + ((var1 * (int32_t)calib.dig_P5) << 1);
-    var2 = (var2 >> 2) + ((int32_t)calib.dig_P4 << 16);
-
-    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * (int32_t)calib.dig_P3) >> 3) +
-           (((int32_t)calib.dig_P2 * var1) >> 1);
-    var1 = (var1 >> 18);
-    var1 = (((32768 + var1) * (int32_t)calib.dig_P1) >> 15);
-
-    if (var1 == 0) {
-        return 0;
+/* ------------------------
+ * Sampling (timer task -> DMA read -> DMEM ring)
+ * ------------------------ */
+static uint32_t ring_mem[SAMPLE_RING_WORDS(RING_ENTRIES, RING_PAYLOAD)];
+static struct sample_ring *ring;
+
+static uint8_t data_cmd = BME280_REG_DATA | 0x80u;
+static uint8_t raw[8] __attribute__((aligned(4)));
+static uint32_t sample_time;
+static uint32_t sample_skipped;     // deadlines that found the previous read in flight
+static uint32_t sample_errors;
+
+static volatile uint32_t last[RING_PAYLOAD];
+static int sample_id;
+
+static volatile uint32_t *const addr_uart = (volatile uint32_t *)MMIO_uart_BASE;
+
+// SCHED_ISR task: the deadline only starts the read, so the timestamp is the
+// interrupt latency away from it no matter how long the transfer takes.
+static void sample_task(void){
+    if (dma_busy()) {
+        sample_skipped++;
+        return;
     }
+    sample_time = rdtime();
+    dma_spi_start(&data_cmd, 1u, raw, 8u, DMA_IRQ_EN);
+}
 
-    p = ((uint32_t)(1048576 - adc_P) - ((uint32_t)var2 >> 12)) * 3125u;
-    if (p < 0x80000000u) {
-        p = (p << 1) / (uint32_t)var1;
-    } else {
-        p = (p / (uint32_t)var1) << 1;
+static void sample_done(void){
+    if (dma_isr() & DMA_STATUS_ERR) {
+        sample_errors++;
+        return;
     }
 
-    var1 = (((int32_t)calib.dig_P9) * (int32_t)(((p >> 3) * (p >> 3)) >> 13)) >> 12;
-    var2 = (((int32_t)(p >> 2)) * (int32_t)calib.dig_P8) >> 13;
+    int32_t adc_P = (int32_t)(((uint32_t)raw[0] << 12) | ((uint32_t)raw[1] << 4) | ((uint32_t)raw[2] >> 4));
+    int32_t adc_T = (int32_t)(((uint32_t)raw[3] << 12) | ((uint32_t)raw[4] << 4) | ((uint32_t)raw[5] >> 4));
+    int32_t adc_H = (int32_t)(((uint32_t)raw[6] << 8)  | ((uint32_t)raw[7]));
+
+    // Compensar
+    uint32_t v[RING_PAYLOAD];
+    int32_t t_fine;
+    v[0] = (uint32_t)bme280_comp_T_x100(&calib, adc_T, &t_fine);    // °C * 100
+    v[1] = bme280_comp_P_Pa(&calib, adc_P, t_fine);                 // Pa
+    // Humedad: % *100 (desde %*1024)
+    // H_x100 = round(H*100) = (H_x1024*100 + 512)/1024
+    v[2] = (bme280_comp_H_x1024(&calib, adc_H, t_fine) * 100u + 512u) >> 10;
+
+    sample_ring_push(ring, sample_time, v);
+    for (uint32_t i = 0; i < RING_PAYLOAD; i++) {
+        last[i] = v[i];
+    }
 
-    p = p + (uint32_t)((var1 + var2 + (int32_t)calib.dig_P7) >> 4);
-    return p; // Pa
+    // Guardar también en RESULT por si quieres mirar DMEM
+    RESULT[2] = v[0];
+    RESULT[3] = v[1];
+    RESULT[4] = v[2];
+    RESULT[5] = ring->seq;
 }
 
-static uint32_t bme280_comp_H_x1024(int32_t adc_H){
-    int32_t v_x1;
-
-    v_x1 = t_fine - 76800;
-    v_x1 = (((((adc_H << 14) - ((int32_t)calib.dig_H4 << 20) - ((int32_t)calib.dig_H5 * v_x1)) + 16384) >> 15) *
-            (((((((v_x1 * (int32_t)calib.dig_H6) >> 10) * (((v_x1 * (int32_t)calib.dig_H3) >> 11) + 32768)) >> 10) + 2097152) *
-               (int32_t)calib.dig_H2 + 8192) >> 14));
-
-    v_x1 = v_x1 - (((((v_x1 >> 15) * (v_x1 >> 15)) >> 7) * (int32_t)calib.dig_H1) >> 4);
-
-    if (v_x1 < 0) v_x1 = 0;
-    if (v_x1 > 419430400) v_x1 = 419430400;
-
-    return (uint32_t)(v_x1 >> 12); // %RH * 1024
+// Foreground task, once a second: latest sample, display and scheduler figures.
+static void print_task(void){
+    uint32_t m;
+    __asm__ volatile ("csrrci %0, mstatus, %1" : "=r"(m) : "i"(MSTATUS_MIE) : "memory");
+    const int32_t  T_x100 = (int32_t)last[0];
+    const uint32_t P_Pa   = last[1];
+    const uint32_t H_x100 = last[2];
+#ifdef SCHED_STATS
+    const uint32_t seq    = ring->seq;
+#endif
+    __asm__ volatile ("csrs mstatus, %0" :: "r"(m & MSTATUS_MIE) : "memory");
+
+    // Formatear para imprimir solo int:
+    // Shift/add divides (muldiv.h) instead of __divsi3/__udivsi3 calls on RV32I.
+    uint32_t T_dec;
+    const uint32_t T_abs = (T_x100 < 0) ? (uint32_t)(-T_x100) : (uint32_t)T_x100;
+    const uint32_t T_mag = udivmod100(T_abs, &T_dec);
+    int32_t  T_int = (T_x100 < 0) ? -(int32_t)T_mag : (int32_t)T_mag;
+
+    uint32_t H_dec;
+    uint32_t H_int = udivmod100(H_x100, &H_dec);
+
+    // Presión: hPa con 2 decimales. 1 hPa = 100 Pa, así que Pa == hPa*100.
+    uint32_t P_dec;
+    uint32_t P_int = udivmod100(P_Pa, &P_dec);
+
+    uint32_t t0 = rdcycle();
+    printf_int(addr_uart, "T=%d.%dC H=%d.%d%% P=%d.%dhPa\n\r",
+               (int)T_int, (int)T_dec, (int)H_int, (int)H_dec, (int)P_int, (int)P_dec);
+    RESULT[6] = rdcycle() - t0;
+
+    // 8 displays: [Temp xx.xx][Hum xx.xx]
+    // DPs on digit 6 and digit 2 place the decimal point in each 4-digit group.
+    uint32_t T_disp = seg7_pack_x100(T_abs);
+    uint32_t H_disp = seg7_pack_x100(H_x100);
+    seg7_write((T_disp << 16) | H_disp, 0b110111011);
+
+#ifdef SCHED_STATS
+    // Idle share and sampling jitter over the last second. One __udivsi3 a
+    // second is cheap enough here.
+    struct sched_stats st;
+    struct sched_task_stats ts;
+    sched_get_stats(&st);
+    sched_get_task_stats(sample_id, &ts);
+    const uint32_t idle_pct = st.idle_cycles / udiv100(st.cycles);
+    const uint32_t jitter = ts.late_max - ts.late_min;
+    const uint32_t lost = ts.missed + sample_skipped + sample_errors;
+    printf_int(addr_uart, "seq=%u idle=%u%% jitter=%u lost=%u\n\r", seq, idle_pct, jitter, lost);
+
+    RESULT[7] = idle_pct;
+    RESULT[8] = jitter;         // mtime ticks (clk cycles)
+    RESULT[9] = lost;
+#endif
 }
 
 /* ------------------------
@@ -313,10 +343,12 @@ static uint32_t bme280_comp_H_x1024(int32_t adc_H){
  * ------------------------ */
 int main(void)
 {
-    volatile uint32_t *addr_uart = (volatile uint32_t *)MMIO_uart_BASE;
-
     RESULT[0] = 0u;
 
+    // Buffered UART output; a status line waits for bytes only if the ring is full.
+    stdio_init(addr_uart, STDIO_TX_BLOCK);
+    irq_init();
+
     spi_cfg.msb_first   = 1;
     spi_cfg.delay_byte  = 0;
     spi_cfg.n_delay_byte= 0;
@@ -335,6 +367,7 @@ int main(void)
     if (id != 0x60) {
         print(addr_uart, "BME280 ID mismatch\n\0");
         printf_int(addr_uart, "ID=%d (expected 96)\n", (int)id, 0, 0);
+        stdio_flush();
         RESULT[0] = ERR_FLAG;
         for (;;) { __asm__ volatile ("wfi"); }
     }
@@ -342,53 +375,19 @@ int main(void)
     bme280_init_basic();
     bme280_read_calibration();
 
+    // The host drains the ring with tools/bootloader -drain <word of ring_mem>.
+    ring = sample_ring_init(ring_mem, RING_ENTRIES, RING_PAYLOAD);
+
     RESULT[0] = OK_FLAG;
     RESULT[5] = 0u;
 
-    for (;;) {
-        // Leer raw
-        uint8_t raw[8];
-        bme280_read(BME280_REG_DATA, raw, 8);
-
-        int32_t adc_P = (int32_t)(((uint32_t)raw[0] << 12) | ((uint32_t)raw[1] << 4) | ((uint32_t)raw[2] >> 4));
-        int32_t adc_T = (int32_t)(((uint32_t)raw[3] << 12) | ((uint32_t)raw[4] << 4) | ((uint32_t)raw[5] >> 4));
-        int32_t adc_H = (int32_t)(((uint32_t)raw[6] << 8)  | ((uint32_t)raw[7]));
-
-        // Compensar
-        int32_t  T_x100   = bme280_comp_T_x100(adc_T);   // °C * 100
-        uint32_t P_Pa     = bme280_comp_P_Pa(adc_P);     // Pa
-        uint32_t H_x1024  = bme280_comp_H_x1024(adc_H);  // % * 1024
-
-        // Formatear para imprimir solo int:
-        int32_t  T_int = T_x100 / 100;
-        int32_t  T_dec = T_x100 % 100; if (T_dec < 0) T_dec = -T_dec;
-
-        // Humedad: % *100 (desde %*1024)
-        // H_x100 = round(H*100) = (H_x1024*100 + 512)/1024
-        uint32_t H_x100 = (H_x1024 * 100u + 512u) >> 10;
-        uint32_t H_int = H_x100 / 100u;
-        uint32_t H_dec = H_x100 % 100u;
-
-        // Presión: hPa con 2 decimales. 1 hPa = 100 Pa, así que Pa == hPa*100.
-        uint32_t P_hPa_x100 = P_Pa;
-        uint32_t P_int = P_hPa_x100 / 100u;
-        uint32_t P_dec = P_hPa_x100 % 100u;
-
-        printf_int(addr_uart, "T=%d.%dC H=%d.%d%% P=%d.%dhPa\n\r",
-                   (int)T_int, (int)T_dec, (int)H_int, (int)H_dec, (int)P_int, (int)P_dec);
-
-        // 8 displays: [Temp xx.xx][Hum xx.xx]
-        // DPs on digit 6 and digit 2 place the decimal point in each 4-digit group.
-        uint32_t T_disp = seg7_pack_x100((T_x100 < 0) ? (uint32_t)(-T_x100) : (uint32_t)T_x100);
-        uint32_t H_disp = seg7_pack_x100(H_x100);
-        seg7_write((T_disp << 16) | H_disp, 0b110111011);
-
-        // Guardar también en RESULT por si quieres mirar DMEM
-        RESULT[2] = (uint32_t)T_x100;
-        RESULT[3] = (uint32_t)P_Pa;
-        RESULT[4] = (uint32_t)H_x100;
-        RESULT[5] = RESULT[5] + 1u;
-
-        delay_1s();
-    }
+    // From here on the SPI belongs to the DMA chain of sample_task().
+    sched_init();
+    sample_id = sched_add(sample_task, SAMPLE_PERIOD, 0u, SCHED_ISR);
+    sched_add(print_task, CPU_FREQ_HZ, CPU_FREQ_HZ, 0u);
+#ifdef PCPROF
+    pcprof_start(PCPROF_PERIOD);
+#endif
+    sched_start();
+    sched_run();
 }
@@ -0,0 +1,51 @@
+#include <stdint.h>
+
+// Division by 10, 100 and 1000 with shifts and adds, for RV32I builds where
+// `/` and `%` call __udivsi3 (sw/muldiv.S). Exact for every uint32_t: the
+// shift sums underestimate the quotient by at most one and the remainder test
+// corrects it. With CPU_RV32M=1 plain `/` is as fast.
+
+static inline uint32_t udiv10(uint32_t n) {
+    uint32_t q = (n >> 1) + (n >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q >>= 3;
+    const uint32_t r = n - (((q << 2) + q) << 1);
+    return q + (r > 9u);
+}
+
+static inline uint32_t udiv100(uint32_t n) {
+    uint32_t q = (n >> 1) + (n >> 3) + (n >> 6) - (n >> 10) + (n >> 12) + (n >> 13) - (n >> 16);
+    q += q >> 20;
+    q >>= 6;
+    const uint32_t r = n - ((q << 6) + (q << 5) + (q << 2));
+    return q + ((r + 28u) >> 7);
+}
+
+static inline uint32_t udiv1000(uint32_t n) {
+    const uint32_t t = (n >> 7) + (n >> 8) + (n >> 12);
+    uint32_t q = (n >> 1) + t + (n >> 15) + (t >> 11) + (t >> 14);
+    q >>= 9;
+    const uint32_t r = n - ((q << 10) - (q << 4) - (q << 3));
+    return q + ((r + 24u) >> 10);
+}
+
+// Quotient, with n % d in *rem.
+static inline uint32_t udivmod10(uint32_t n, uint32_t *rem) {
+    const uint32_t q = udiv10(n);
+    *rem = n - (((q << 2) + q) << 1);
+    return q;
+}
+
+static inline uint32_t udivmod100(uint32_t n, uint32_t *rem) {
+    const uint32_t q = udiv100(n);
+    *rem = n - ((q << 6) + (q << 5) + (q << 2));
+    return q;
+}
+
+static inline uint32_t udivmod1000(uint32_t n, uint32_t *rem) {
+    const uint32_t q = udiv1000(n);
+    *rem = n - ((q << 10) - (q << 4) - (q << 3));
+    return q;
+}
@@ -0,0 +1,33 @@
+#include <stdint.h>
+
+// Statistical PC profiler for runs on the board. A SCHED_ISR task (sw/sched.h)
+// stores mepc, the instruction the timer interrupt stopped, into a sample ring
+// that `tools/bootloader -profile <main.elf>` drains while the program runs and
+// turns into a per-function / per-PC hotspot report.
+//
+// Entries are { seq, mtime, mepc } (sample_ring.h with one payload word).
+// Samples in sched_run()'s WFI are idle time. Other trap handlers run with MIE
+// clear, so a deadline that falls in one is taken after its mret and charged
+// to the code it interrupted: handler time is not seen.
+//
+// Pick a period that is not a multiple or divisor of the other task periods
+// (e.g. a prime number of ticks), or the samples keep landing on the same code.
+
+// Ring size, a power of two. At 115200 baud the host reads about 900 entries/s;
+// the ring has to hold what is sampled between two polls.
+#ifndef PCPROF_ENTRIES
+#define PCPROF_ENTRIES      128u
+#endif
+
+// The ring (SAMPLE_RING_WORDS(PCPROF_ENTRIES, 1) words); the bootloader finds
+// it by this name in the ELF.
+extern uint32_t pcprof_ring_mem[];
+
+// Between sched_init() and sched_start(): pcprof_init() and a SCHED_ISR task
+// sampling every `period` mtime ticks. Returns its task id, or -1.
+int pcprof_start(uint32_t period);
+
+// Without the scheduler: pcprof_init() once, then pcprof_sample() from the trap
+// handler on the program's own timer interrupt.
+void pcprof_init(void);
+void pcprof_sample(void);
@@ -0,0 +1,44 @@
+#include <stdint.h>
+
+// Zicntr / Zihpm counters of rv32_mtrap_csr.
+// cycle/instret/hpmcounterN are read-only shadows of mcycle/minstret/mhpmcounterN;
+// time is the CLINT mtime (one count per clk).
+
+#define CSR_MCOUNTINHIBIT   0x320
+
+// mhpmcounter index -> event
+#define HPM_LOADS           3   // loads retired
+#define HPM_STORES          4   // stores retired
+#define HPM_BRANCH_TAKEN    5   // conditional branches taken
+#define HPM_LSU_STALL       6   // cycles an LSU request waits for an AXI slave
+#define HPM_WFI             7   // cycles asleep after WFI
+#define HPM_TRAPS           8   // interrupts taken
+
+// mcountinhibit bits
+#define COUNTINHIBIT_CY     (1u << 0)
+#define COUNTINHIBIT_IR     (1u << 2)
+#define COUNTINHIBIT_HPM(n) (1u << (n))
+
+#define csr_read(csr) ({ uint32_t v_; __asm__ volatile ("csrr %0, " #csr : "=r"(v_)); v_; })
+#define csr_write(csr, val) __asm__ volatile ("csrw " #csr ", %0" :: "r"((uint32_t)(val)))
+
+// 64-bit read of a counter pair (hi, lo, hi again until hi is stable).
+#define COUNTER64(lo, hi) ({                                  \
+    uint32_t h_, l_, h2_;                                     \
+    do {                                                      \
+        h_ = csr_read(hi);                                    \
+        l_ = csr_read(lo);                                    \
+        h2_ = csr_read(hi);                                   \
+    } while (h_ != h2_);                                      \
+    ((uint64_t)h_ << 32) | l_; })
+
+static inline uint64_t rdcycle64(void)   { return COUNTER64(cycle, cycleh); }
+static inline uint64_t rdtime64(void)    { return COUNTER64(time, timeh); }
+static inline uint64_t rdinstret64(void) { return COUNTER64(instret, instreth); }
+
+static inline uint32_t rdcycle(void)   { return csr_read(cycle); }
+static inline uint32_t rdtime(void)    { return csr_read(time); }
+static inline uint32_t rdinstret(void) { return csr_read(instret); }
+
+// Low word of hpmcounterN (N is a literal 3..8).
+#define rdhpm(n) csr_read(hpmcounter##n)
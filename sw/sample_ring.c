@@ -0,0 +1,25 @@
+#include "sample_ring.h"
+
+struct sample_ring *sample_ring_init(uint32_t *mem, uint32_t entries, uint32_t payload) {
+    struct sample_ring *r = (struct sample_ring *)mem;
+    r->geometry = ((2u + payload) << 16) | entries;
+    r->seq = 0u;
+    r->reserved = 0u;
+    // Last, so a host never sees the magic on a half-set header.
+    r->magic = SAMPLE_RING_MAGIC;
+    return r;
+}
+
+uint32_t sample_ring_push(struct sample_ring *r, uint32_t time, const uint32_t *payload) {
+    const uint32_t entries = r->geometry & 0xFFFFu;
+    const uint32_t words = r->geometry >> 16;
+    const uint32_t k = r->seq;
+    uint32_t *slot = r->slots + (k & (entries - 1u)) * words;
+    slot[0] = k;
+    slot[1] = time;
+    for (uint32_t i = 0; i < words - 2u; i++) {
+        slot[2u + i] = payload[i];
+    }
+    r->seq = k + 1u;
+    return k;
+}
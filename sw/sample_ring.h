@@ -0,0 +1,36 @@
+#include <stdint.h>
+
+// Fixed-size sample ring in DMEM for a host to drain over the bootloader's
+// DMEM read port (tools/bootloader -drain <word>), with no help from the core.
+//
+// Layout, in words from the ring's address:
+//   0  SAMPLE_RING_MAGIC
+//   1  (entry words << 16) | entries, entries a power of two
+//   2  seq: entries written so far; entry k is in slot k % entries
+//   3  reserved (0)
+//   4  slots, each { k, mtime low word, payload... }
+//
+// The producer fills a slot and then publishes it by incrementing seq, and
+// overwrites the oldest entry when the host falls behind. A reader takes the
+// entries between its last seq and the current one; after the read, an entry
+// k is valid if k + entries > seq read again (its slot was not reused yet).
+
+#define SAMPLE_RING_MAGIC   0x474E4952u     // "RING"
+#define SAMPLE_RING_HDR     4u
+
+struct sample_ring {
+    uint32_t magic;
+    uint32_t geometry;
+    volatile uint32_t seq;
+    uint32_t reserved;
+    uint32_t slots[];
+};
+
+// Words of DMEM for a ring of `entries` slots of `payload` words each.
+#define SAMPLE_RING_WORDS(entries, payload) (SAMPLE_RING_HDR + (entries) * (2u + (payload)))
+
+// mem: SAMPLE_RING_WORDS(entries, payload) words, word-aligned (e.g. in .bss).
+struct sample_ring *sample_ring_init(uint32_t *mem, uint32_t entries, uint32_t payload);
+
+// Stores one entry stamped with `time`; returns its sequence number.
+uint32_t sample_ring_push(struct sample_ring *r, uint32_t time, const uint32_t *payload);
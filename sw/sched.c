@@ -0,0 +1,165 @@
+#include "sched.h"
+#include "perf_counters.h"
+
+#define CLINT_BASE_ADDR     0x00003000u
+#define CLINT_MTIMECMP_L    0x08u
+#define CLINT_MTIMECMP_H    0x0Cu
+
+#define MIE_MTIE            (1u << 7)
+#define MSTATUS_MIE         (1u << 3)
+
+struct task {
+    sched_fn fn;
+    uint64_t due;                       // next deadline
+    uint64_t released;                  // deadline of the pending run
+    uint32_t period;
+    uint32_t phase;
+    uint32_t flags;
+    volatile uint32_t pending;
+    struct sched_task_stats st;
+};
+
+static struct task tasks[SCHED_MAX_TASKS];
+static uint32_t n_tasks;
+static struct task *tasks_end = tasks;  // &tasks[n_tasks]: the scans below multiply nothing
+static uint32_t win_cycle;
+static uint32_t win_idle;
+
+static inline uint32_t irq_save(void) {
+    uint32_t m;
+    __asm__ volatile ("csrrci %0, mstatus, %1" : "=r"(m) : "i"(MSTATUS_MIE) : "memory");
+    return m;
+}
+
+static inline void irq_restore(uint32_t m) {
+    __asm__ volatile ("csrs mstatus, %0" :: "r"(m & MSTATUS_MIE) : "memory");
+}
+
+// High word to max first, so no intermediate value is earlier than both.
+static void set_mtimecmp(uint64_t t) {
+    volatile uint32_t *clint = (volatile uint32_t *)CLINT_BASE_ADDR;
+    clint[CLINT_MTIMECMP_H / 4u] = 0xFFFFFFFFu;
+    clint[CLINT_MTIMECMP_L / 4u] = (uint32_t)t;
+    clint[CLINT_MTIMECMP_H / 4u] = (uint32_t)(t >> 32);
+}
+
+static void record(struct task *t, uint64_t due) {
+    const uint32_t late = rdtime() - (uint32_t)due;
+    if (t->st.runs == 0u || late < t->st.late_min) {
+        t->st.late_min = late;
+    }
+    if (late > t->st.late_max) {
+        t->st.late_max = late;
+    }
+    t->st.runs++;
+}
+
+void sched_init(void) {
+    __asm__ volatile ("csrc mie, %0" :: "r"(MIE_MTIE) : "memory");
+    set_mtimecmp(~0ull);
+    n_tasks = 0u;
+    tasks_end = tasks;
+}
+
+int sched_add(sched_fn fn, uint32_t period, uint32_t phase, uint32_t flags) {
+    if (n_tasks == SCHED_MAX_TASKS || period == 0u) {
+        return -1;
+    }
+    struct task *t = &tasks[n_tasks];
+    t->fn = fn;
+    t->period = period;
+    t->phase = phase;
+    t->flags = flags;
+    t->pending = 0u;
+    t->st = (struct sched_task_stats){ 0u, 0u, 0u, 0u };
+    tasks_end = t + 1;
+    return (int)n_tasks++;
+}
+
+void sched_start(void) {
+    const uint64_t now = rdtime64();
+    uint64_t next = ~0ull;
+    for (uint32_t i = 0; i < n_tasks; i++) {
+        tasks[i].due = now + tasks[i].phase;
+        if (tasks[i].due < next) {
+            next = tasks[i].due;
+        }
+    }
+    win_cycle = rdcycle();
+    win_idle = rdhpm(7);
+    set_mtimecmp(next);
+    __asm__ volatile ("csrs mie, %0" :: "r"(MIE_MTIE) : "memory");
+}
+
+// Deadlines that already passed when a task is looked at are skipped and
+// counted as missed, so a long stall does not turn into a burst of runs.
+void sched_timer_isr(void) {
+    const uint64_t now = rdtime64();
+    uint64_t next = ~0ull;
+    for (struct task *t = tasks; t != tasks_end; t++) {
+        if (t->due <= now) {
+            const uint64_t due = t->due;
+            t->due += t->period;
+            while (t->due <= now) {
+                t->due += t->period;
+                t->st.missed++;
+            }
+            if (t->flags & SCHED_ISR) {
+                record(t, due);
+                t->fn();
+            } else {
+                if (t->pending) {
+                    t->st.missed++;
+                }
+                t->released = due;
+                t->pending = 1u;
+            }
+        }
+        if (t->due < next) {
+            next = t->due;
+        }
+    }
+    // Already past if the tasks above ran long: the interrupt is taken again at once.
+    set_mtimecmp(next);
+}
+
+// Released tasks run in id order. The scan and WFI happen with MIE clear, so a
+// release between them still wakes the core (WFI ignores mstatus.MIE). The csrrci
+// lands even when the timer is taken at its commit (rv32_mtrap_csr), so no release
+// slips in between the scan and the WFI.
+void sched_run(void) {
+    for (;;) {
+        struct task *t = tasks;
+        irq_save();
+        while (t != tasks_end && !t->pending) {
+            t++;
+        }
+        if (t == tasks_end) {
+            __asm__ volatile ("wfi");
+            irq_restore(MSTATUS_MIE);
+            continue;
+        }
+        t->pending = 0u;
+        record(t, t->released);
+        irq_restore(MSTATUS_MIE);
+        t->fn();
+    }
+}
+
+void sched_get_stats(struct sched_stats *st) {
+    const uint32_t m = irq_save();
+    const uint32_t c = rdcycle();
+    const uint32_t w = rdhpm(7);
+    st->cycles = c - win_cycle;
+    st->idle_cycles = w - win_idle;
+    win_cycle = c;
+    win_idle = w;
+    irq_restore(m);
+}
+
+void sched_get_task_stats(int id, struct sched_task_stats *st) {
+    const uint32_t m = irq_save();
+    *st = tasks[id].st;
+    tasks[id].st = (struct sched_task_stats){ 0u, 0u, 0u, 0u };
+    irq_restore(m);
+}
@@ -0,0 +1,44 @@
+#include <stdint.h>
+
+// Periodic tasks on the CLINT timer interrupt (mtimecmp -> mip.MTIP of
+// rv32_mtrap_csr). Periods and phases are in mtime ticks (one per clk).
+//
+// Every task has an absolute deadline that advances by its period, so the rate
+// does not drift with the time the tasks take. mtimecmp is always the earliest
+// deadline. A SCHED_ISR task runs inside sched_timer_isr(), so its start jitter
+// is the interrupt latency; the others are released there and run from
+// sched_run() in id order, which sleeps in WFI when none is pending.
+//
+// sched_start() sets mie.MTIE; the application calls sched_timer_isr() from its
+// trap handler on mcause 0x80000007.
+
+#define SCHED_MAX_TASKS     4
+
+// sched_add() flags
+#define SCHED_ISR           (1u << 0)   // run in the timer interrupt
+
+typedef void (*sched_fn)(void);
+
+// Start lateness (mtime at the call minus the deadline) since the last read.
+// jitter = late_max - late_min.
+struct sched_task_stats {
+    uint32_t runs;
+    uint32_t late_min;
+    uint32_t late_max;
+    uint32_t missed;                    // deadlines skipped: still pending or already past
+};
+
+struct sched_stats {
+    uint32_t cycles;                    // window length
+    uint32_t idle_cycles;               // asleep in WFI (mhpmcounter7)
+};
+
+void sched_init(void);
+int sched_add(sched_fn fn, uint32_t period, uint32_t phase, uint32_t flags);   // task id or -1
+void sched_start(void);                 // first deadlines: now + phase
+void sched_timer_isr(void);
+__attribute__((noreturn)) void sched_run(void);   // sets mstatus.MIE
+
+// Both start a new window. Read them at least every 2^32 cycles (42 s at 100 MHz).
+void sched_get_stats(struct sched_stats *st);
+void sched_get_task_stats(int id, struct sched_task_stats *st);
@@ -1,59 +1,194 @@
 #include "stdio.h"
+#include "muldiv.h"
 #include <stdarg.h>
 
+#define UART_TX_FULL    (1u << 3)
+#define MSTATUS_MIE     (1u << 3)
+#define TX_RING_MASK    (STDIO_TX_RING_SIZE - 1u)
+
+// TX ring for the UART given to stdio_init(). The caller advances tx_head and
+// stdio_uart_isr() advances tx_tail; both run free, so head - tail is the fill level.
+static char tx_ring[STDIO_TX_RING_SIZE];
+static volatile uint32_t tx_head;
+static volatile uint32_t tx_tail;
+static volatile uint32_t *tx_uart;
+static enum stdio_tx_policy tx_policy;
+static struct stdio_tx_stats tx_stats;
+
+// CSR 0xF03: per-line enable of the external interrupts into MEIP.
+static inline void uart_irq_enable(void) {
+    __asm__ volatile ("csrsi 0xF03, %0" :: "i"(1u << STDIO_UART_IRQ) : "memory");
+}
+
+static inline void uart_irq_disable(void) {
+    __asm__ volatile ("csrci 0xF03, %0" :: "i"(1u << STDIO_UART_IRQ) : "memory");
+}
+
+static inline uint32_t irq_save(void) {
+    uint32_t m;
+    __asm__ volatile ("csrrci %0, mstatus, %1" : "=r"(m) : "i"(MSTATUS_MIE) : "memory");
+    return m;
+}
+
+static inline void irq_restore(uint32_t m) {
+    __asm__ volatile ("csrs mstatus, %0" :: "r"(m & MSTATUS_MIE) : "memory");
+}
+
 static void putc_uart(volatile uint32_t *addr_uart, char c) {
-    while (addr_uart[0] & (1u << 3)) {
+    while (addr_uart[0] & UART_TX_FULL) {
         __asm__ volatile ("nop");
     }
     addr_uart[1] = (uint32_t)c;
 }
 
-static void put_int(volatile uint32_t *addr_uart, int v) {
-    char buf[12];
+// Ring -> UART until the TX FIFO is full or the ring is empty. Runs in the
+// interrupt handler or with interrupts masked.
+static void tx_pump(void) {
+    uint32_t t = tx_tail;
+    const uint32_t h = tx_head;
+
+    while (t != h && !(tx_uart[0] & UART_TX_FULL)) {
+        tx_uart[1] = (uint32_t)(uint8_t)tx_ring[t & TX_RING_MASK];
+        t++;
+    }
+    tx_tail = t;
+}
+
+static void tx_put(char c) {
+    const uint32_t h = tx_head;
+
+    if (h - tx_tail == STDIO_TX_RING_SIZE) {
+        if (tx_policy == STDIO_TX_DROP) {
+            tx_stats.dropped++;
+            return;
+        }
+        // Send from here: works whether or not interrupts are enabled.
+        tx_stats.blocked++;
+        do {
+            const uint32_t m = irq_save();
+            tx_pump();
+            irq_restore(m);
+        } while (h - tx_tail == STDIO_TX_RING_SIZE);
+    }
+
+    tx_ring[h & TX_RING_MASK] = c;
+    tx_head = h + 1u;
+    tx_stats.queued++;
+
+    const uint32_t used = h + 1u - tx_tail;
+    if (used > tx_stats.max_used) {
+        tx_stats.max_used = used;
+    }
+}
+
+static void out(volatile uint32_t *addr_uart, char c) {
+    if (addr_uart == tx_uart) {
+        tx_put(c);
+    } else {
+        putc_uart(addr_uart, c);
+    }
+}
+
+// Bytes are queued before the line is enabled, so the handler never sees an
+// empty ring with its enable bit set for long.
+static void out_done(volatile uint32_t *addr_uart) {
+    if (addr_uart == tx_uart) {
+        uart_irq_enable();
+    }
+}
+
+static void put_uint(volatile uint32_t *addr_uart, unsigned int x) {
+    char buf[10];
     int i = 0;
-    unsigned int x;
 
+    do {
+        uint32_t r;
+        x = udivmod10(x, &r);
+        buf[i++] = (char)('0' + r);
+    } while (x > 0);
+
+    while (i--) {
+        out(addr_uart, buf[i]);
+    }
+}
+
+static void put_int(volatile uint32_t *addr_uart, int v) {
     if (v < 0) {
-        putc_uart(addr_uart, '-');
-        x = (unsigned int)(-v);
+        out(addr_uart, '-');
+        put_uint(addr_uart, -(unsigned int)v);
     } else {
-        x = (unsigned int)v;
+        put_uint(addr_uart, (unsigned int)v);
     }
+}
+
+static void put_hex(volatile uint32_t *addr_uart, unsigned int x) {
+    int s = 28;
+
+    while (s > 0 && (x >> s) == 0) {
+        s -= 4;
+    }
+    for (; s >= 0; s -= 4) {
+        unsigned int d = (x >> s) & 0xFu;
+        out(addr_uart, (char)(d < 10 ? '0' + d : 'a' + d - 10));
+    }
+}
+
+void stdio_init(volatile uint32_t *addr_uart, enum stdio_tx_policy policy) {
+    uart_irq_disable();
+    tx_uart = addr_uart;
+    tx_policy = policy;
+    tx_head = 0;
+    tx_tail = 0;
+    tx_stats = (struct stdio_tx_stats){0};
+}
 
-    if (x == 0) {
-        putc_uart(addr_uart, '0');
+// Call from the trap handler on an external interrupt. It ignores other
+// sources (nothing to send) and masks its line once the ring is empty.
+void stdio_uart_isr(void) {
+    if (tx_uart == 0) {
         return;
     }
+    tx_pump();
+    if (tx_tail == tx_head) {
+        uart_irq_disable();
+    }
+}
 
-    while (x > 0) {
-        // Unsigned divide/mod by 10 without libgcc helpers.
-        // q = x / 10 using shift/add approximation, then fix remainder.
-        unsigned int q = (x >> 1) + (x >> 2);
-        q = q + (q >> 4);
-        q = q + (q >> 8);
-        q = q + (q >> 16);
-        q = q >> 3;
-        unsigned int r = x - (q * 10);
-        if (r >= 10) {
-            r -= 10;
-            q += 1;
+// Wait until every queued byte is in the UART FIFO. With interrupts enabled the
+// handler sends them and this sleeps; the check and WFI run with MIE clear, so
+// the wake-up cannot be lost. Otherwise the bytes are sent from here.
+void stdio_flush(void) {
+    if (tx_uart == 0) {
+        return;
+    }
+    for (;;) {
+        const uint32_t m = irq_save();
+        const int empty = (tx_tail == tx_head);
+        if (empty) {
+            uart_irq_disable();
+        } else if (m & MSTATUS_MIE) {
+            __asm__ volatile ("wfi");
+        } else {
+            tx_pump();
+        }
+        irq_restore(m);
+        if (empty) {
+            return;
         }
-        buf[i++] = (char)('0' + r);
-        x = q;
     }
+}
 
-    while (i--) {
-        putc_uart(addr_uart, buf[i]);
-    }
+void stdio_get_stats(struct stdio_tx_stats *st) {
+    *st = tx_stats;
 }
 
 void print(volatile uint32_t *addr_uart, const char *s) {
     int i=0;
     while (s[i] != '\0') {
-        // Wait if TX FIFO is full (status bit 3).
-        putc_uart(addr_uart, s[i]);
+        out(addr_uart, s[i]);
         i++;
     }
+    out_done(addr_uart);
 }
 
 void printf_int(volatile uint32_t *addr_uart, const char *fmt, ...) {
@@ -61,17 +196,41 @@ void printf_int(volatile uint32_t *addr_uart, const char *fmt, ...) {
     va_start(ap, fmt);
 
     for (int i = 0; fmt[i] != '\0'; i++) {
-        if (fmt[i] == '%' && fmt[i + 1] == 'd') {
-            int v = va_arg(ap, int);
-            put_int(addr_uart, v);
-            i++;
-        } else if (fmt[i] == '%' && fmt[i + 1] == '%') {
-            putc_uart(addr_uart, '%');
-            i++;
-        } else {
-            putc_uart(addr_uart, fmt[i]);
+        if (fmt[i] != '%' || fmt[i + 1] == '\0') {
+            out(addr_uart, fmt[i]);
+            continue;
+        }
+        i++;
+        switch (fmt[i]) {
+        case 'd':
+            put_int(addr_uart, va_arg(ap, int));
+            break;
+        case 'u':
+            put_uint(addr_uart, va_arg(ap, unsigned int));
+            break;
+        case 'x':
+            put_hex(addr_uart, va_arg(ap, unsigned int));
+            break;
+        case 's': {
+            const char *s = va_arg(ap, const char *);
+            while (*s != '\0') {
+                out(addr_uart, *s++);
+            }
+            break;
+        }
+        case 'c':
+            out(addr_uart, (char)va_arg(ap, int));
+            break;
+        case '%':
+            out(addr_uart, '%');
+            break;
+        default:
+            out(addr_uart, '%');
+            out(addr_uart, fmt[i]);
+            break;
         }
     }
 
     va_end(ap);
+    out_done(addr_uart);
 }
@@ -1,4 +1,38 @@
 #include <stdint.h>
 
+// print/printf_int write to the UART at addr_uart. printf_int understands
+// %d %u %x %s %c and %%.
+//
+// By default every byte polls the TX-full flag, so a line longer than the UART
+// FIFO costs the caller the time to send it. After stdio_init() the bytes for
+// that UART go to a DMEM ring instead and the UART TX-room interrupt
+// (external_irq[1], CSR 0xF03 bit 1) drains it: the trap handler calls
+// stdio_uart_isr() on an external interrupt. The ring is enabled with MIE.MEIE
+// and mstatus.MIE left to the application.
+
+// Ring size in bytes (power of two).
+#define STDIO_TX_RING_SIZE  256u
+
+// Interrupt line of the UART TX-room interrupt (soc external_irq).
+#define STDIO_UART_IRQ      1u
+
+// What print does when the ring is full.
+enum stdio_tx_policy {
+    STDIO_TX_BLOCK,     // send bytes from the caller until there is room
+    STDIO_TX_DROP,      // drop the byte and count it
+};
+
+struct stdio_tx_stats {
+    uint32_t queued;    // bytes accepted into the ring
+    uint32_t dropped;   // bytes lost with STDIO_TX_DROP
+    uint32_t blocked;   // bytes that found the ring full with STDIO_TX_BLOCK
+    uint32_t max_used;  // ring high-water mark
+};
+
+void stdio_init(volatile uint32_t *addr_uart, enum stdio_tx_policy policy);
+void stdio_uart_isr(void);
+void stdio_flush(void);
+void stdio_get_stats(struct stdio_tx_stats *st);
+
 void print(volatile uint32_t *addr_uart, const char *s);
 void printf_int(volatile uint32_t *addr_uart, const char *fmt, ...);
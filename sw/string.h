@@ -0,0 +1,10 @@
+#include <stddef.h>
+
+// Word-at-a-time memory and string routines (sw/string.S). GCC also calls
+// memcpy/memset on its own for struct copies and large initializers.
+
+void *memcpy(void *dst, const void *src, size_t n);
+void *memmove(void *dst, const void *src, size_t n);
+void *memset(void *dst, int c, size_t n);
+int memcmp(const void *a, const void *b, size_t n);
+size_t strlen(const char *s);
@@ -0,0 +1,128 @@
+// Multiply/divide runtime (sw/muldiv.S, sw/muldiv.h) self-checking test and micro-benchmark.
+// PASS  -> writes 0xDEADBEEF to dmem[0]
+// FAIL  -> writes 0xBAD00000 | test_id to dmem[0], actual to dmem[1], expected to dmem[2]
+//
+// Leaves the cycles per operation (64 calls, loop overhead subtracted) in the DMEM dump:
+//   dmem[4]  = 123456 * 1000          dmem[9]  = -1000000 / 7
+//   dmem[5]  = 1000 * 123456          dmem[10] = udiv10(1234567) (muldiv.h)
+//   dmem[6]  = -3 * 123456            dmem[11] = 64-bit multiply
+//   dmem[7]  = 1234567 / 10           dmem[12] = 64-bit unsigned divide
+//   dmem[8]  = 1234567 % 1000         dmem[13] = 64-bit signed divide
+// Build with SOFT_MULDIV=0 for the libgcc figures, CPU_RV32M=1 for the M unit.
+#include <stdint.h>
+#include "../muldiv.h"
+#include "../perf_counters.h"
+
+#define RESULT   ((volatile uint32_t *)0x10000000u)
+
+#define N_CALLS      64u
+#define N_CALLS_LOG2 6u
+
+// Operands and results go through volatiles so GCC keeps the helper calls
+// instead of folding or strength-reducing them.
+static volatile uint32_t u_a, u_b;
+static volatile int32_t  s_a, s_b;
+static volatile uint64_t u64_a, u64_b;
+static volatile int64_t  s64_a, s64_b;
+static volatile uint32_t sink;
+static volatile uint64_t sink64;
+
+__attribute__((noreturn)) static void fail(uint16_t code, uint32_t actual, uint32_t expected) {
+    RESULT[1] = actual;
+    RESULT[2] = expected;
+    RESULT[0] = 0xBAD00000u | (uint32_t)code;
+    while (1) {
+    }
+}
+
+// Cycles for N_CALLS evaluations of expr, stored through sink/sink64.
+#define TIME32(expr) ({                                             \
+    const uint32_t t0_ = rdcycle();                                 \
+    for (uint32_t i_ = 0; i_ < N_CALLS; i_++) sink = (expr);        \
+    rdcycle() - t0_; })
+
+#define TIME64(expr) ({                                             \
+    const uint32_t t0_ = rdcycle();                                 \
+    for (uint32_t i_ = 0; i_ < N_CALLS; i_++) sink64 = (expr);      \
+    rdcycle() - t0_; })
+
+static void check32(uint16_t code, uint32_t actual, uint32_t expected) {
+    if (actual != expected) fail(code, actual, expected);
+}
+
+static void check64(uint16_t code, uint64_t actual, uint64_t expected) {
+    check32(code, (uint32_t)actual, (uint32_t)expected);
+    check32(code | 0x100u, (uint32_t)(actual >> 32), (uint32_t)(expected >> 32));
+}
+
+int main(void) {
+    uint32_t base, base64;
+
+    // Loop with a plain load instead of the operation.
+    u_a = 1234567u;
+    base = TIME32(u_a);
+    u64_a = 0x123456789ABCDEFull;
+    base64 = TIME64(u64_a);
+
+    // --- 32-bit multiply: the loop runs over the smaller operand either way ---
+    u_a = 123456u; u_b = 1000u;
+    RESULT[4] = (TIME32(u_a * u_b) - base) >> N_CALLS_LOG2;
+    check32(0x0001, sink, 123456000u);
+
+    u_a = 1000u; u_b = 123456u;
+    RESULT[5] = (TIME32(u_a * u_b) - base) >> N_CALLS_LOG2;
+    check32(0x0002, sink, 123456000u);
+
+    s_a = -3; s_b = 123456;
+    RESULT[6] = (TIME32((uint32_t)(s_a * s_b)) - base) >> N_CALLS_LOG2;
+    check32(0x0003, sink, (uint32_t)-370368);
+
+    // --- 32-bit divide ---
+    u_a = 1234567u; u_b = 10u;
+    RESULT[7] = (TIME32(u_a / u_b) - base) >> N_CALLS_LOG2;
+    check32(0x0004, sink, 123456u);
+
+    u_b = 1000u;
+    RESULT[8] = (TIME32(u_a % u_b) - base) >> N_CALLS_LOG2;
+    check32(0x0005, sink, 567u);
+
+    s_a = -1000000; s_b = 7;
+    RESULT[9] = (TIME32((uint32_t)(s_a / s_b)) - base) >> N_CALLS_LOG2;
+    check32(0x0006, sink, (uint32_t)-142857);
+
+    RESULT[10] = (TIME32(udiv10(u_a)) - base) >> N_CALLS_LOG2;
+    check32(0x0007, sink, 123456u);
+
+    // --- 64-bit ---
+    u64_a = 0x123456789ull; u64_b = 1000003u;
+    RESULT[11] = (TIME64(u64_a * u64_b) - base64) >> N_CALLS_LOG2;
+    check64(0x0008, sink64, 0x115C7530E26ADBull);
+
+    u64_a = 0x123456789ABCDEFull;
+    RESULT[12] = (TIME64(u64_a / u64_b) - base64) >> N_CALLS_LOG2;
+    check64(0x0009, sink64, 0x1316B424BCull);
+
+    s64_a = -0x123456789ABCDEFll; s64_b = 12345;
+    RESULT[13] = (TIME64((uint64_t)(s64_a / s64_b)) - base64) >> N_CALLS_LOG2;
+    check64(0x000A, sink64, (uint64_t)-6641193132157ll);
+
+    // --- Edge cases (same results as the RV32M divider) ---
+    u_a = 77u; u_b = 0u;
+    check32(0x0010, u_a / u_b, 0xFFFFFFFFu);
+    check32(0x0011, u_a % u_b, 77u);
+    s_a = -7; s_b = 2;
+    check32(0x0012, (uint32_t)(s_a % s_b), (uint32_t)-1);
+    u_a = 0xFFFFFFFFu; u_b = 0xFFFFFFFFu;
+    check32(0x0013, u_a * u_b, 1u);
+    check32(0x0014, udiv100(u_a), 42949672u);
+    check32(0x0015, udiv1000(u_a), 4294967u);
+    u64_a = 0xFFFFFFFFFFFFFFFFull; u64_b = 0xFFFFFFFFull;
+    check64(0x0016, u64_a / u64_b, 0x100000001ull);
+    check64(0x0017, u64_a * u64_b, 0xFFFFFFFF00000001ull);
+    s64_a = -9; s64_b = 4;
+    check64(0x0018, (uint64_t)(s64_a % s64_b), (uint64_t)-1ll);
+
+    RESULT[0] = 0xDEADBEEFu;
+    while (1) {
+    }
+}
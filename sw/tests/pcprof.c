@@ -0,0 +1,156 @@
+// PC sampling profiler (sw/pcprof.c) self-checking test.
+// PASS  -> writes 0xDEADBEEF to dmem[0]
+// FAIL  -> writes 0xBAD00000 | test_id to dmem[0], actual to dmem[1], expected to dmem[2]
+//
+// The sampler runs as the only SCHED_ISR task, every PERIOD ticks (prime, so it
+// does not lock onto the loops). Two identical countdown loops run for 3:1 of
+// the time; their samples are told apart by mepc. Leaves in the DMEM dump:
+//   dmem[4] = cycles of one pcprof_sample() call
+//   dmem[5] = cycles the profiler takes per sample (trap entry, scheduler, sampler)
+//   dmem[6] = samples in spin_a                      dmem[7] = samples in spin_b
+//   dmem[8] = samples elsewhere (calls, loop control)
+#include <stdint.h>
+#include "../sched.h"
+#include "../sample_ring.h"
+#include "../pcprof.h"
+#include "../perf_counters.h"
+
+#define RESULT   ((volatile uint32_t *)0x10000000u)
+
+#define MCAUSE_MTI      0x80000007u
+
+#define PERIOD          997u
+#define SPIN            400u        // spin_b iterations per round
+#define MIN_SAMPLES     48u         // whole rounds until at least this many
+#define OVERHEAD_SPIN   4000u
+
+// Trap entry and saves (about 90 cycles on the ISS), the scheduler's 64-bit
+// deadline update and mtimecmp writes, and the sampler.
+#define MAX_SAMPLE_COST 800u
+#define MAX_ISR_LATE    300u
+
+static volatile uint32_t bad_cause;
+
+__attribute__((noreturn)) static void fail(uint16_t code, uint32_t actual, uint32_t expected) {
+    RESULT[1] = actual;
+    RESULT[2] = expected;
+    RESULT[0] = 0xBAD00000u | (uint32_t)code;
+    while (1) {
+    }
+}
+
+__attribute__((interrupt("machine"), aligned(4)))
+static void trap_handler(void) {
+    const uint32_t cause = csr_read(mcause);
+    if (cause != MCAUSE_MTI) {
+        bad_cause = cause;
+        csr_write(mie, 0u);
+        return;
+    }
+    sched_timer_isr();
+}
+
+// Two copies of the same countdown loop, n iterations each.
+__asm__(
+    "  .text\n"
+    "  .balign 4\n"
+    "spin_a:\n"
+    "  addi a0, a0, -1\n"
+    "  bnez a0, spin_a\n"
+    "  ret\n"
+    "spin_a_end:\n"
+    "  .balign 4\n"
+    "spin_b:\n"
+    "  addi a0, a0, -1\n"
+    "  bnez a0, spin_b\n"
+    "  ret\n"
+    "spin_b_end:\n");
+void spin_a(uint32_t n);
+void spin_b(uint32_t n);
+extern const char spin_a_end[];
+extern const char spin_b_end[];
+
+static inline int in(uint32_t pc, void (*lo)(uint32_t), const char *hi) {
+    return pc >= (uint32_t)lo && pc < (uint32_t)hi;
+}
+
+static const struct sample_ring *ring(void) {
+    return (const struct sample_ring *)pcprof_ring_mem;
+}
+
+int main(void) {
+    csr_write(mtvec, (uint32_t)trap_handler);
+
+    sched_init();
+    if (pcprof_start(PERIOD) != 0) fail(0x0001, 0u, 0u);
+
+    // --- T0010: ring header; one sample costs a handful of instructions ---
+    const struct sample_ring *r = ring();
+    if (r->magic != SAMPLE_RING_MAGIC) fail(0x0010, r->magic, SAMPLE_RING_MAGIC);
+    if (r->geometry != ((3u << 16) | PCPROF_ENTRIES)) fail(0x0011, r->geometry, (3u << 16) | PCPROF_ENTRIES);
+    uint32_t c0 = rdcycle();
+    pcprof_sample();
+    const uint32_t sample_cycles = rdcycle() - c0;
+    RESULT[4] = sample_cycles;
+    if (r->seq != 1u) fail(0x0012, r->seq, 1u);
+    if (r->slots[2] != csr_read(mepc)) fail(0x0013, r->slots[2], csr_read(mepc));
+
+    // --- T0020: cost per sample, from the same loop with and without it ---
+    c0 = rdcycle();
+    spin_a(OVERHEAD_SPIN);
+    const uint32_t quiet = rdcycle() - c0;
+
+    sched_start();
+    __asm__ volatile ("csrsi mstatus, 8" ::: "memory");
+    uint32_t s0 = r->seq;
+    c0 = rdcycle();
+    spin_a(OVERHEAD_SPIN);
+    const uint32_t busy = rdcycle() - c0;
+    const uint32_t n_over = r->seq - s0;
+    if (n_over == 0u) fail(0x0020, 0u, 1u);
+    const uint32_t per_sample = (busy - quiet) / n_over;
+    RESULT[5] = per_sample;
+    if (per_sample > MAX_SAMPLE_COST) fail(0x0021, per_sample, MAX_SAMPLE_COST);
+
+    // --- T0030: samples split 3:1 between the loops ---
+    // Rounds until enough samples, as a round takes 7 cycles an iteration on the
+    // multi-cycle core and 3 on the pipelined one.
+    s0 = r->seq;
+    do {
+        spin_a(3u * SPIN);
+        spin_b(SPIN);
+    } while (r->seq - s0 < MIN_SAMPLES);
+    __asm__ volatile ("csrci mstatus, 8" ::: "memory");
+    const uint32_t s1 = r->seq;
+    if (bad_cause != 0u) fail(0x0030, bad_cause, 0u);
+    if (s1 - s0 > PCPROF_ENTRIES) fail(0x0031, s1 - s0, PCPROF_ENTRIES);
+    if (s1 - s0 < MIN_SAMPLES) fail(0x0032, s1 - s0, MIN_SAMPLES);
+
+    uint32_t na = 0u, nb = 0u, other = 0u;
+    uint32_t prev_t = 0u;
+    for (uint32_t k = s0; k < s1; k++) {
+        const uint32_t *e = &r->slots[(k & (PCPROF_ENTRIES - 1u)) * 3u];
+        if (e[0] != k) fail(0x0033, e[0], k);
+        // Consecutive samples PERIOD apart, give or take the interrupt latency.
+        const uint32_t dt = e[1] - prev_t;
+        if (k > s0 && (dt < PERIOD - MAX_ISR_LATE || dt > PERIOD + MAX_ISR_LATE)) fail(0x0034, dt, PERIOD);
+        prev_t = e[1];
+        if (in(e[2], spin_a, spin_a_end)) {
+            na++;
+        } else if (in(e[2], spin_b, spin_b_end)) {
+            nb++;
+        } else {
+            other++;
+        }
+    }
+    RESULT[6] = na;
+    RESULT[7] = nb;
+    RESULT[8] = other;
+    if (nb == 0u) fail(0x0035, nb, 1u);
+    if (na < 2u * nb || na > 4u * nb) fail(0x0036, na, 3u * nb);
+    if (other * 8u > s1 - s0) fail(0x0037, other, (s1 - s0) / 8u);
+
+    RESULT[0] = 0xDEADBEEFu;
+    while (1) {
+    }
+}
@@ -0,0 +1,171 @@
+// Timer scheduler (sw/sched.c) and sample ring (sw/sample_ring.c) self-checking test.
+// PASS  -> writes 0xDEADBEEF to dmem[0]
+// FAIL  -> writes 0xBAD00000 | test_id to dmem[0], actual to dmem[1], expected to dmem[2]
+//
+// A SCHED_ISR sampler at PERIOD ticks pushes into a ring; a foreground task does
+// LOAD_CYCLES of busy work every FG_PERIOD; a third task overruns its period once,
+// early on. The foreground and idle figures are taken over the second half.
+// The other deadlines fall between sampler deadlines, so no handler run for them
+// delays a sample. Leaves in the DMEM dump:
+//   dmem[4] = sampler start lateness min (ticks)    dmem[5] = max
+//   dmem[6] = foreground task lateness max           dmem[7] = idle share in 1/1000
+//   dmem[8] = largest |timestamp - (t0 + k * PERIOD)| over the ring entries
+#include <stdint.h>
+#include "../sched.h"
+#include "../sample_ring.h"
+#include "../perf_counters.h"
+
+#define RESULT   ((volatile uint32_t *)0x10000000u)
+
+#define MCAUSE_MTI      0x80000007u
+
+#define PERIOD          4000u
+#define N_SAMPLES       48u
+#define ENTRIES         16u
+#define FG_PERIOD       12000u
+#define LOAD_CYCLES     3000u
+#define SLOW_PERIOD     20000u
+#define PHASE           2000u       // fg and slow: halfway between two samples
+
+// Trap entry, register saves and the scheduler scan, plus a foreground
+// critical section the interrupt may have to wait for. Entry and saves alone
+// are about 90 cycles on the ISS.
+#define MAX_ISR_LATE    500u
+#define MAX_FG_LATE     (MAX_ISR_LATE + 500u)
+
+static uint32_t ring_mem[SAMPLE_RING_WORDS(ENTRIES, 1u)];
+static struct sample_ring *ring;
+
+static volatile uint32_t n_samples;
+static volatile uint32_t n_fg;
+static volatile uint32_t n_slow;
+static volatile uint32_t bad_cause;
+static int sampler_id, fg_id, slow_id;
+static int mid_done;
+static struct sched_task_stats slow_st;
+
+__attribute__((noreturn)) static void fail(uint16_t code, uint32_t actual, uint32_t expected) {
+    RESULT[1] = actual;
+    RESULT[2] = expected;
+    RESULT[0] = 0xBAD00000u | (uint32_t)code;
+    while (1) {
+    }
+}
+
+__attribute__((interrupt("machine"), aligned(4)))
+static void trap_handler(void) {
+    const uint32_t cause = csr_read(mcause);
+    if (cause != MCAUSE_MTI) {
+        bad_cause = cause;
+        csr_write(mie, 0u);
+        return;
+    }
+    sched_timer_isr();
+}
+
+static void busy(uint32_t cycles) {
+    const uint32_t c = rdcycle();
+    while (rdcycle() - c < cycles) {
+    }
+}
+
+static void sampler(void) {
+    const uint32_t v = n_samples;
+    sample_ring_push(ring, rdtime(), &v);
+    n_samples = v + 1u;
+}
+
+static void slow(void) {
+    // The first run takes two periods and a bit: the release during it stays
+    // pending, the one after that is missed.
+    if (n_slow++ == 0u) {
+        busy(2u * SLOW_PERIOD + 500u);
+    }
+}
+
+static void check(void);
+
+static void fg(void) {
+    struct sched_stats st;
+    struct sched_task_stats f;
+    busy(LOAD_CYCLES);
+    n_fg = n_fg + 1u;
+    if (!mid_done && n_samples >= N_SAMPLES / 2u) {
+        // New windows, well after the overrun.
+        mid_done = 1;
+        sched_get_stats(&st);
+        sched_get_task_stats(fg_id, &f);
+        sched_get_task_stats(slow_id, &slow_st);
+        n_fg = 0u;
+    } else if (n_samples >= N_SAMPLES) {
+        check();
+    }
+}
+
+static void check(void) {
+    struct sched_stats st;
+    struct sched_task_stats s, f;
+    __asm__ volatile ("csrci mstatus, 8" ::: "memory");
+    sched_get_stats(&st);
+    sched_get_task_stats(sampler_id, &s);
+    sched_get_task_stats(fg_id, &f);
+
+    if (bad_cause != 0u) fail(0x0001, bad_cause, 0u);
+
+    // --- sampler: every deadline taken, from the interrupt ---
+    const uint32_t n = n_samples;
+    if (s.runs != n) fail(0x0010, s.runs, n);
+    if (s.missed != 0u) fail(0x0011, s.missed, 0u);
+    if (s.late_max > MAX_ISR_LATE) fail(0x0012, s.late_max, MAX_ISR_LATE);
+    RESULT[4] = s.late_min;
+    RESULT[5] = s.late_max;
+
+    // --- foreground: released every period, delayed only by the handler ---
+    if (f.runs != n_fg) fail(0x0020, f.runs, n_fg);
+    if (f.missed != 0u) fail(0x0021, f.missed, 0u);
+    if (f.late_max > MAX_FG_LATE) fail(0x0022, f.late_max, MAX_FG_LATE);
+    RESULT[6] = f.late_max;
+
+    // --- overrun: one deadline dropped, not a burst of catch-up runs ---
+    if (slow_st.missed != 1u) fail(0x0030, slow_st.missed, 1u);
+
+    // --- idle: the only work is the load and the handlers ---
+    if (st.idle_cycles == 0u || st.idle_cycles >= st.cycles) fail(0x0040, st.idle_cycles, st.cycles);
+    RESULT[7] = st.idle_cycles / (st.cycles / 1000u);
+
+    // --- ring: header, sequence numbers, timestamps on the PERIOD grid ---
+    if (ring->magic != SAMPLE_RING_MAGIC) fail(0x0050, ring->magic, SAMPLE_RING_MAGIC);
+    if (ring->geometry != ((3u << 16) | ENTRIES)) fail(0x0051, ring->geometry, (3u << 16) | ENTRIES);
+    if (ring->seq != n) fail(0x0052, ring->seq, n);
+    const uint32_t first = n - ENTRIES;
+    const uint32_t t0 = ring->slots[(first & (ENTRIES - 1u)) * 3u + 1u] - first * PERIOD;
+    uint32_t worst = 0u;
+    for (uint32_t k = first; k < n; k++) {
+        const uint32_t *e = &ring->slots[(k & (ENTRIES - 1u)) * 3u];
+        if (e[0] != k) fail(0x0053, e[0], k);
+        if (e[2] != k) fail(0x0054, e[2], k);
+        // No drift: each stamp is within the latency spread of its own grid point.
+        const uint32_t want = t0 + k * PERIOD;
+        const uint32_t d = (e[1] > want) ? e[1] - want : want - e[1];
+        if (d > worst) worst = d;
+    }
+    RESULT[8] = worst;
+    if (worst > s.late_max - s.late_min + 16u) fail(0x0055, worst, s.late_max - s.late_min + 16u);
+
+    RESULT[0] = 0xDEADBEEFu;
+    while (1) {
+    }
+}
+
+int main(void) {
+    csr_write(mtvec, (uint32_t)trap_handler);
+    ring = sample_ring_init(ring_mem, ENTRIES, 1u);
+
+    sched_init();
+    sampler_id = sched_add(sampler, PERIOD, PERIOD, SCHED_ISR);
+    fg_id = sched_add(fg, FG_PERIOD, PHASE, 0u);
+    slow_id = sched_add(slow, SLOW_PERIOD, PHASE, 0u);
+    if (sched_add(sampler, 0u, 0u, 0u) != -1) fail(0x0002, 0u, (uint32_t)-1);
+    sched_start();
+    sched_run();
+}
@@ -0,0 +1,206 @@
+// DMA engine (hw/RTL/peripherals/axi_dma.sv, sw/dma.c) self-checking test and SPI benchmark.
+// PASS  -> writes 0xDEADBEEF to dmem[0]
+// FAIL  -> writes 0xBAD00000 | test_id to dmem[0], actual to dmem[1], expected to dmem[2]
+//
+// Leaves the cost of a BME280-style calibration read (1 command byte, 26 data
+// bytes, SPI clk_div 2) in the DMEM dump:
+//   dmem[3] = dmem[5] minus the cycles asleep (mhpmcounter7): the core's share
+//   dmem[4] = cycles with the spi_xfer() loop of sw/main.c
+//   dmem[5] = cycles with dma_spi_xfer() (chain started, core asleep in WFI until DONE)
+//   dmem[6] = CPU cycles in dma_spi_start() (descriptors + START)
+//   dmem[7] = loop cycles per byte       dmem[9] = SPI shift cycles per byte
+//   dmem[8] = DMA cycles per byte
+#include <stdint.h>
+#include "../dma.h"
+#include "../perf_counters.h"
+
+#define RESULT   ((volatile uint32_t *)0x10000000u)
+#define SPI_BASE        0x00004000u
+#define CLINT_BASE      0x00003000u
+
+#define SPI_STATUS      0u
+#define SPI_WRITE       4u
+#define SPI_READ        8u
+#define SPI_N_BYTE      12u
+#define SPI_CLK_DIV     20u
+#define SPI_CFG         24u
+#define CLINT_MTIMECMP_L 0x08u
+#define CLINT_MTIMECMP_H 0x0Cu
+
+#define CLK_DIV         2u
+#define RX_LEN          26u
+#define N_BYTES         (1u + RX_LEN)
+
+#define MIE_MEIE        (1u << 11)
+#define MSTATUS_MIE     (1u << 3)
+#define MCAUSE_MEI      0x8000000Bu
+
+static uint8_t rx_buf[RX_LEN + 4] __attribute__((aligned(4)));
+static uint8_t cmd[4] __attribute__((aligned(4)));
+static uint32_t words[4];
+static char msg[] = "dma uart\n";
+static struct dma_desc chain[4];
+
+static volatile uint32_t n_traps;
+static volatile uint32_t last_status;
+static volatile uint32_t bad_cause;
+
+__attribute__((noreturn)) static void fail(uint16_t code, uint32_t actual, uint32_t expected) {
+    RESULT[1] = actual;
+    RESULT[2] = expected;
+    RESULT[0] = 0xBAD00000u | (uint32_t)code;
+    while (1) {
+    }
+}
+
+__attribute__((interrupt("machine"), aligned(4)))
+static void trap_handler(void) {
+    uint32_t cause = csr_read(mcause);
+    if (cause != MCAUSE_MEI) {
+        bad_cause = cause;
+    }
+    last_status = dma_isr();
+    n_traps = n_traps + 1u;
+}
+
+static inline void mmio_write(uint32_t addr, uint32_t data) {
+    *((volatile uint32_t *)addr) = data;
+}
+
+static inline uint32_t mmio_read(uint32_t addr) {
+    return *((volatile uint32_t *)addr);
+}
+
+static void wait_for_spi_ready(void) {
+    while (mmio_read(SPI_BASE + SPI_STATUS) & (1u << 4)) {
+    }
+}
+
+// sw/main.c spi_xfer()
+static void spi_xfer(const uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len) {
+    wait_for_spi_ready();
+    for (uint32_t i = 0; i < tx_len; i++) {
+        mmio_write(SPI_BASE + SPI_WRITE, tx[i]);
+    }
+    mmio_write(SPI_BASE + SPI_N_BYTE, (rx_len & 0xFFFFu) | ((tx_len & 0xFFFFu) << 16));
+    wait_for_spi_ready();
+    for (uint32_t i = 0; i < rx_len; i++) {
+        rx[i] = (uint8_t)(mmio_read(SPI_BASE + SPI_READ) & 0xFFu);
+    }
+}
+
+static void fill_rx(void) {
+    for (uint32_t i = 0; i < sizeof(rx_buf); i++) {
+        rx_buf[i] = 0xEEu;
+    }
+}
+
+// The TB and the ISS drive MISO low: RX_LEN zero bytes, nothing past them.
+static void check_rx(uint16_t code) {
+    for (uint32_t i = 0; i < sizeof(rx_buf); i++) {
+        const uint8_t want = (i < RX_LEN) ? 0x00u : 0xEEu;
+        if (rx_buf[i] != want) fail(code, i, want);
+    }
+}
+
+int main(void) {
+    uint32_t c, w, st;
+
+    mmio_write(SPI_BASE + SPI_CFG, 1u);         // MSB first, mode 0
+    mmio_write(SPI_BASE + SPI_CLK_DIV, CLK_DIV);
+    cmd[0] = 0x88u;                             // BME280 calib00 | read
+
+    // --- polled loop ---
+    fill_rx();
+    spi_xfer(cmd, 1u, rx_buf, RX_LEN);          // warm-up
+    fill_rx();
+    c = rdcycle();
+    spi_xfer(cmd, 1u, rx_buf, RX_LEN);
+    RESULT[4] = rdcycle() - c;
+    check_rx(0x0001);
+
+    // --- DMA chain, WFI until the completion interrupt (no handler) ---
+    wait_for_spi_ready();
+    fill_rx();
+    c = rdcycle();
+    w = rdhpm(7);
+    if (dma_spi_xfer(cmd, 1u, rx_buf, RX_LEN) != 0) fail(0x0010, dma_count(), 0u);
+    RESULT[5] = rdcycle() - c;
+    RESULT[3] = RESULT[5] - (rdhpm(7) - w);
+    check_rx(0x0011);
+    if (dma_count() != 2u + RX_LEN) fail(0x0012, dma_count(), 2u + RX_LEN);
+    st = mmio_read(DMA_BASE_ADDR + 4u);
+    if (st != 0u) fail(0x0013, st, 0u);
+    if (n_traps != 0u) fail(0x0014, n_traps, 0u);
+
+    RESULT[7] = RESULT[4] / N_BYTES;
+    RESULT[8] = RESULT[5] / N_BYTES;
+    RESULT[9] = 16u * CLK_DIV;
+    // The win is the foreground cycles: the wire time is the same either way, and
+    // on the pipelined core the wall clock of the two is within a few percent.
+    if (RESULT[3] >= RESULT[4]) fail(0x0015, RESULT[3], RESULT[4]);
+
+    // --- same chain, dma_wait() polling STATUS ---
+    fill_rx();
+    c = rdcycle();
+    dma_spi_start(cmd, 1u, rx_buf, RX_LEN, 0);
+    RESULT[6] = rdcycle() - c;
+    if (dma_wait() != 0) fail(0x0020, 0u, 0u);
+    check_rx(0x0021);
+
+    // --- words both ways: mtimecmp written and read back by a 4-descriptor chain ---
+    words[0] = 0xFFFFFFFFu;
+    words[1] = 0x12345678u;
+    words[2] = 0u;
+    words[3] = 0u;
+    chain[0] = (struct dma_desc){ CLINT_BASE + CLINT_MTIMECMP_H, (uint32_t)&words[0], DMA_COUNT(1) | DMA_WORD, &chain[1] };
+    chain[1] = (struct dma_desc){ CLINT_BASE + CLINT_MTIMECMP_L, (uint32_t)&words[1], DMA_COUNT(1) | DMA_WORD, &chain[2] };
+    chain[2] = (struct dma_desc){ CLINT_BASE + CLINT_MTIMECMP_L, (uint32_t)&words[2], DMA_COUNT(1) | DMA_WORD | DMA_TO_MEM, &chain[3] };
+    chain[3] = (struct dma_desc){ CLINT_BASE + CLINT_MTIMECMP_H, (uint32_t)&words[3], DMA_COUNT(1) | DMA_WORD | DMA_TO_MEM, 0 };
+    dma_start(chain, 0);
+    if (dma_wait() != 0) fail(0x0030, 0u, 0u);
+    if (words[2] != 0x12345678u) fail(0x0031, words[2], 0x12345678u);
+    if (words[3] != 0xFFFFFFFFu) fail(0x0032, words[3], 0xFFFFFFFFu);
+    if (mmio_read(DMA_BASE_ADDR + 12u) != 0u) fail(0x0033, mmio_read(DMA_BASE_ADDR + 12u), 0u);
+
+    // --- UART TX, waiting for room before every byte ---
+    chain[0] = (struct dma_desc){ 0x00002004u, (uint32_t)msg, DMA_COUNT(sizeof(msg) - 1u) | DMA_WAIT_EACH | DMA_WAIT_WHILE(3, 1), 0 };
+    dma_start(chain, 0);
+    if (dma_wait() != 0) fail(0x0040, 0u, 0u);
+    if (dma_count() != sizeof(msg) - 1u) fail(0x0041, dma_count(), sizeof(msg) - 1u);
+
+    // --- errors stop the chain: MEM outside DMEM, then a bad NEXT ---
+    chain[0] = (struct dma_desc){ SPI_BASE + SPI_WRITE, 0x10004000u, DMA_COUNT(1), 0 };
+    dma_start(chain, 0);
+    if (dma_wait() != -1) fail(0x0050, 0u, 0u);
+    if (dma_count() != 0u) fail(0x0051, dma_count(), 0u);
+    chain[0] = (struct dma_desc){ SPI_BASE + SPI_WRITE, (uint32_t)cmd, DMA_COUNT(0), (const struct dma_desc *)0x00000100u };
+    dma_start(chain, 0);
+    if (dma_wait() != -1) fail(0x0052, 0u, 0u);
+    st = mmio_read(DMA_BASE_ADDR + 4u);
+    if (st != 0u) fail(0x0053, st, 0u);
+
+    // --- completion interrupt taken by a handler ---
+    csr_write(mtvec, (uint32_t)trap_handler);
+    csr_write(0xF03, 1u << DMA_IRQ);
+    csr_write(mie, MIE_MEIE);
+    csr_write(mstatus, MSTATUS_MIE);
+    fill_rx();
+    wait_for_spi_ready();
+    dma_spi_start(cmd, 1u, rx_buf, RX_LEN, DMA_IRQ_EN);
+    // Check with MIE clear so the interrupt cannot land between the test and WFI.
+    for (;;) {
+        __asm__ volatile ("csrci mstatus, 8" ::: "memory");
+        if (n_traps != 0u) break;
+        __asm__ volatile ("wfi");
+        __asm__ volatile ("csrsi mstatus, 8" ::: "memory");
+    }
+    if (n_traps != 1u) fail(0x0060, n_traps, 1u);
+    if (bad_cause != 0u) fail(0x0061, bad_cause, 0u);
+    if (last_status != DMA_STATUS_DONE) fail(0x0062, last_status, DMA_STATUS_DONE);
+    check_rx(0x0063);
+
+    RESULT[0] = 0xDEADBEEFu;
+    while (1) {
+    }
+}
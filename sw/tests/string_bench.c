@@ -0,0 +1,213 @@
+// Memory/string routines (sw/string.S) and crt0 startup self-checking test and benchmark.
+// PASS  -> writes 0xDEADBEEF to dmem[0]
+// FAIL  -> writes 0xBAD00000 | test_id to dmem[0], actual to dmem[1], expected to dmem[2]
+//
+// Leaves cycle counts in the DMEM dump (bytes per cycle = 1024 / dmem[n] for n >= 5):
+//   dmem[4]  = reset to main (crt0: 192-byte .data copy, 2.4 KB .bss clear)
+//   dmem[5]  = memcpy 1 KiB, both aligned     dmem[9]  = memcmp 1 KiB, equal
+//   dmem[6]  = memcpy 1 KiB, src + 1          dmem[10] = strlen of 1023 chars
+//   dmem[7]  = memmove 1 KiB, dst = src + 4   dmem[11] = C byte loop copying 1 KiB
+//   dmem[8]  = memset 1 KiB
+#include <stdint.h>
+#include "../string.h"
+#include "../perf_counters.h"
+
+#define RESULT   ((volatile uint32_t *)0x10000000u)
+
+#define N_BENCH  1024u
+
+#define SEQ4(n)  (n), (n) + 1u, (n) + 2u, (n) + 3u
+#define SEQ16(n) SEQ4(n), SEQ4((n) + 4u), SEQ4((n) + 8u), SEQ4((n) + 12u)
+
+// .data (copied by crt0) and .bss (cleared by crt0).
+static volatile uint32_t data_words[48] = { SEQ16(0x1000u), SEQ16(0x1010u), SEQ16(0x1020u) };
+static uint8_t buf_a[N_BENCH + 64] __attribute__((aligned(4)));
+static uint8_t buf_b[N_BENCH + 64] __attribute__((aligned(4)));
+static uint8_t buf_ref[256] __attribute__((aligned(4)));
+
+__attribute__((noreturn)) static void fail(uint16_t code, uint32_t actual, uint32_t expected) {
+    RESULT[1] = actual;
+    RESULT[2] = expected;
+    RESULT[0] = 0xBAD00000u | (uint32_t)code;
+    while (1) {
+    }
+}
+
+static void fill(uint8_t *p, uint32_t n, uint32_t seed) {
+    for (uint32_t i = 0; i < n; i++) {
+        p[i] = (uint8_t)(seed + 37u * i) | 1u;
+    }
+}
+
+// Compare n bytes against the reference buffer; fails with the first differing index.
+static void check_bytes(uint16_t code, const uint8_t *p, const uint8_t *ref, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (p[i] != ref[i]) fail(code, i, ref[i]);
+    }
+}
+
+// Lengths around the 8-byte (byte loop) and 32-byte (block) thresholds.
+static const uint32_t lens[] = { 0, 1, 7, 8, 31, 33, 100 };
+#define N_LENS (sizeof(lens) / sizeof(lens[0]))
+
+static void check_memcpy(void) {
+    for (uint32_t so = 0; so < 4u; so++) {
+        for (uint32_t d = 0; d < 4u; d++) {
+            for (uint32_t k = 0; k < N_LENS; k++) {
+                const uint32_t n = lens[k];
+                fill(buf_a, 128u, n + so);
+                for (uint32_t i = 0; i < 128u; i++) {
+                    buf_b[i] = 0xEEu;
+                    buf_ref[i] = 0xEEu;
+                }
+                for (uint32_t i = 0; i < n; i++) {
+                    buf_ref[d + i] = buf_a[so + i];
+                }
+                if (memcpy(buf_b + d, buf_a + so, n) != buf_b + d) fail(0x0010, so, d);
+                check_bytes(0x0011, buf_b, buf_ref, 128u);
+            }
+        }
+    }
+}
+
+// Overlapping moves in both directions: dst = src +- delta.
+static void check_memmove(void) {
+    static const uint32_t deltas[] = { 1, 3, 4, 8, 37 };
+
+    for (uint32_t j = 0; j < sizeof(deltas) / sizeof(deltas[0]); j++) {
+        for (uint32_t k = 0; k < N_LENS; k++) {
+            const uint32_t n = lens[k];
+            uint8_t *const lo = buf_b + 2u;
+            uint8_t *const hi = lo + deltas[j];
+            const uint32_t span = n + deltas[j] + 4u;
+
+            // Backward: dst above src.
+            fill(buf_b, span, n);
+            for (uint32_t i = 0; i < span; i++) buf_ref[i] = buf_b[i];
+            for (uint32_t i = n; i-- > 0;) buf_ref[2u + deltas[j] + i] = buf_ref[2u + i];
+            if (memmove(hi, lo, n) != hi) fail(0x0020, j, n);
+            check_bytes(0x0021, buf_b, buf_ref, span);
+
+            // Forward: dst below src.
+            fill(buf_b, span, n + 1u);
+            for (uint32_t i = 0; i < span; i++) buf_ref[i] = buf_b[i];
+            for (uint32_t i = 0; i < n; i++) buf_ref[2u + i] = buf_ref[2u + deltas[j] + i];
+            if (memmove(lo, hi, n) != lo) fail(0x0022, j, n);
+            check_bytes(0x0023, buf_b, buf_ref, span);
+        }
+    }
+}
+
+static void check_memset(void) {
+    for (uint32_t d = 0; d < 4u; d++) {
+        for (uint32_t k = 0; k < N_LENS; k++) {
+            const uint32_t n = lens[k];
+            for (uint32_t i = 0; i < 128u; i++) {
+                buf_b[i] = 0xEEu;
+                buf_ref[i] = (i >= d && i < d + n) ? 0xA5u : 0xEEu;
+            }
+            // Only the low byte of c is used.
+            if (memset(buf_b + d, 0x1A5, n) != buf_b + d) fail(0x0030, d, n);
+            check_bytes(0x0031, buf_b, buf_ref, 128u);
+        }
+    }
+}
+
+static int sign(int v) {
+    return (v > 0) - (v < 0);
+}
+
+static void check_memcmp_strlen(void) {
+    for (uint32_t ao = 0; ao < 4u; ao++) {
+        for (uint32_t bo = 0; bo < 4u; bo += 3u) {
+            for (uint32_t k = 0; k < N_LENS; k++) {
+                const uint32_t n = lens[k];
+                fill(buf_a + ao, n, 5u);
+                fill(buf_b + bo, n, 5u);
+                buf_a[ao + n] = 1u;         // past the end: ignored
+                buf_b[bo + n] = 2u;
+                if (memcmp(buf_a + ao, buf_b + bo, n) != 0) fail(0x0040, ao, n);
+                if (n == 0u) continue;
+                // First difference in the last byte, then in the first (fill() bytes are odd).
+                buf_b[bo + n - 1u] = 0x00u;
+                if (sign(memcmp(buf_a + ao, buf_b + bo, n)) != 1) fail(0x0041, ao, n);
+                buf_a[ao] = 0x00u;
+                buf_b[bo] = 0xFFu;
+                if (sign(memcmp(buf_a + ao, buf_b + bo, n)) != -1) fail(0x0042, ao, n);
+            }
+        }
+        for (uint32_t k = 0; k < N_LENS; k++) {
+            const uint32_t n = lens[k];
+            fill(buf_a + ao, n + 8u, 0x80u);  // 0x01/0x80 bytes next to the terminator
+            buf_a[ao + n] = 0u;
+            if (strlen((const char *)buf_a + ao) != n) fail(0x0050, ao, n);
+        }
+    }
+}
+
+int main(void) {
+    const uint32_t boot = rdcycle();
+    uint32_t c;
+
+    RESULT[4] = boot;
+
+    // --- crt0 ---
+    for (uint32_t i = 0; i < 48u; i++) {
+        if (data_words[i] != 0x1000u + i) fail(0x0001, data_words[i], 0x1000u + i);
+    }
+    for (uint32_t i = 0; i < N_BENCH + 64u; i++) {
+        if (buf_a[i] != 0u || buf_b[i] != 0u) fail(0x0002, i, 0u);
+    }
+
+    // --- results ---
+    check_memcpy();
+    check_memmove();
+    check_memset();
+    check_memcmp_strlen();
+
+    // --- 1 KiB benchmarks ---
+    fill(buf_a, N_BENCH + 4u, 9u);
+
+    c = rdcycle();
+    memcpy(buf_b, buf_a, N_BENCH);
+    RESULT[5] = rdcycle() - c;
+
+    c = rdcycle();
+    memcpy(buf_b, buf_a + 1, N_BENCH);
+    RESULT[6] = rdcycle() - c;
+    if (buf_b[N_BENCH - 1u] != buf_a[N_BENCH]) fail(0x0060, buf_b[N_BENCH - 1u], buf_a[N_BENCH]);
+
+    c = rdcycle();
+    memmove(buf_a + 4, buf_a, N_BENCH);
+    RESULT[7] = rdcycle() - c;
+
+    c = rdcycle();
+    memset(buf_b, 0, N_BENCH);
+    RESULT[8] = rdcycle() - c;
+
+    memset(buf_a, 'x', N_BENCH);
+    memset(buf_b, 'x', N_BENCH);
+    c = rdcycle();
+    const int eq = memcmp(buf_a, buf_b, N_BENCH);
+    RESULT[9] = rdcycle() - c;
+    if (eq != 0) fail(0x0061, (uint32_t)eq, 0u);
+
+    buf_a[N_BENCH - 1u] = 0u;
+    c = rdcycle();
+    const size_t len = strlen((const char *)buf_a);
+    RESULT[10] = rdcycle() - c;
+    if (len != N_BENCH - 1u) fail(0x0062, len, N_BENCH - 1u);
+
+    c = rdcycle();
+    for (uint32_t i = 0; i < N_BENCH; i++) {
+        buf_b[i] = buf_a[i];
+    }
+    RESULT[11] = rdcycle() - c;
+
+    // Word copies should beat the byte loop several times over.
+    if (RESULT[5] * 4u > RESULT[11]) fail(0x0070, RESULT[5], RESULT[11] / 4u);
+
+    RESULT[0] = 0xDEADBEEFu;
+    while (1) {
+    }
+}
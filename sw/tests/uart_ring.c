@@ -0,0 +1,116 @@
+// Interrupt-driven UART output (sw/stdio.c ring + external_irq[1]) self-checking test.
+// PASS  -> writes 0xDEADBEEF to dmem[0]
+// FAIL  -> writes 0xBAD00000 | test_id to dmem[0], actual to dmem[1], expected to dmem[2]
+//
+// Leaves the foreground cost of one 48-byte line in the DMEM dump:
+//   dmem[4] = cycles with polled output (after the UART FIFO has filled)
+//   dmem[5] = cycles with the ring (bytes sent from the interrupt handler)
+#include <stdint.h>
+#include "../stdio.h"
+#include "../perf_counters.h"
+
+#define RESULT   ((volatile uint32_t *)0x10000000u)
+#define UART     ((volatile uint32_t *)0x00002000u)
+
+#define MIE_MEIE        (1u << 11)
+#define MSTATUS_MIE     (1u << 3)
+#define MCAUSE_MEI      0x8000000Bu
+#define UART_IRQ_BIT    (1u << STDIO_UART_IRQ)
+
+#define LINE    "0123456789abcdef0123456789ABCDEF0123456789abcde\n"
+#define LINE_LEN 48u
+
+static volatile uint32_t n_traps;
+static volatile uint32_t bad_cause;
+
+__attribute__((noreturn)) static void fail(uint16_t code, uint32_t actual, uint32_t expected) {
+    RESULT[1] = actual;
+    RESULT[2] = expected;
+    RESULT[0] = 0xBAD00000u | (uint32_t)code;
+    while (1) {
+    }
+}
+
+__attribute__((interrupt("machine"), aligned(4)))
+static void trap_handler(void) {
+    uint32_t cause = csr_read(mcause);
+    if (cause != MCAUSE_MEI) {
+        bad_cause = cause;
+    }
+    n_traps = n_traps + 1u;
+    stdio_uart_isr();
+}
+
+static uint32_t line_cycles(void) {
+    uint32_t t0 = rdcycle();
+    print(UART, LINE);
+    return rdcycle() - t0;
+}
+
+int main(void) {
+    struct stdio_tx_stats st;
+    uint32_t c;
+
+    // Only line 0 (GPIO) is enabled at reset.
+    c = csr_read(0xF03);
+    if (c != 1u) fail(0x0001, c, 1u);
+
+    csr_write(mtvec, (uint32_t)trap_handler);
+    csr_write(0xF03, 0u);
+    csr_write(mie, MIE_MEIE);
+    csr_write(mstatus, MSTATUS_MIE);
+
+    // Polled: the first line fills the UART FIFO, the second waits for it.
+    line_cycles();
+    RESULT[4] = line_cycles();
+
+    // Nothing enabled: no traps while the polled bytes drain.
+    if (n_traps != 0u) fail(0x0002, n_traps, 0u);
+
+    // Ring, blocking policy: the caller only copies bytes.
+    stdio_init(UART, STDIO_TX_BLOCK);
+    c = line_cycles();
+    RESULT[5] = c;
+    if (c * 8u > RESULT[4]) fail(0x0003, c, RESULT[4] / 8u);
+    if ((csr_read(0xF03) & UART_IRQ_BIT) == 0u) fail(0x0004, csr_read(0xF03), UART_IRQ_BIT);
+
+    stdio_flush();
+    stdio_get_stats(&st);
+    if (st.queued != LINE_LEN) fail(0x0005, st.queued, LINE_LEN);
+    if (st.dropped != 0u) fail(0x0006, st.dropped, 0u);
+    if (st.blocked != 0u) fail(0x0007, st.blocked, 0u);
+    if (n_traps == 0u) fail(0x0008, n_traps, 1u);
+    if (bad_cause != 0u) fail(0x0009, bad_cause, MCAUSE_MEI);
+    // Ring empty: the line is masked again.
+    if ((csr_read(0xF03) & UART_IRQ_BIT) != 0u) fail(0x000A, csr_read(0xF03), 0u);
+
+    // Formats go through the same path.
+    printf_int(UART, "%d %u %x %s%c%%\n", -42, 4000000000u, 0xC0FFEEu, "ok", '!');
+    stdio_flush();
+    stdio_get_stats(&st);
+    c = LINE_LEN + sizeof("-42 4000000000 c0ffee ok!%\n") - 1u;
+    if (st.queued != c) fail(0x000B, st.queued, c);
+
+    // Drop policy with interrupts off: the ring keeps the first STDIO_TX_RING_SIZE bytes.
+    csr_write(mstatus, 0u);
+    stdio_init(UART, STDIO_TX_DROP);
+    for (uint32_t i = 0; i < 6u; i++) {
+        print(UART, LINE);
+    }
+    stdio_get_stats(&st);
+    if (st.queued != STDIO_TX_RING_SIZE) fail(0x000C, st.queued, STDIO_TX_RING_SIZE);
+    if (st.dropped != 6u * LINE_LEN - STDIO_TX_RING_SIZE)
+        fail(0x000D, st.dropped, 6u * LINE_LEN - STDIO_TX_RING_SIZE);
+    if (st.max_used != STDIO_TX_RING_SIZE) fail(0x000E, st.max_used, STDIO_TX_RING_SIZE);
+
+    // Interrupts back on: the handler drains the ring while stdio_flush sleeps.
+    c = n_traps;
+    csr_write(mstatus, MSTATUS_MIE);
+    stdio_flush();
+    if (n_traps == c) fail(0x000F, n_traps, c + 1u);
+    if ((csr_read(0xF03) & UART_IRQ_BIT) != 0u) fail(0x0010, csr_read(0xF03), 0u);
+
+    RESULT[0] = 0xDEADBEEFu;
+    while (1) {
+    }
+}
@@ -0,0 +1,250 @@
+#!/usr/bin/env python3
+"""Benchmark sweep for the programs in sw/bench/ (harness: sw/bench/bench.h).
+
+- Every benchmark is built for each OPT level (-Os, -O2, -O3 by default) and each
+  core configuration into build/bench/<opt>_<m/c/xmem/dual>/<bench>/ (`make image OPT=...`).
+- A configuration is a '+'-separated set of core options, `base` for none:
+  pipe (CPU_PIPELINE), m (CPU_RV32M), c (CPU_RV32C), ei (CPU_EARLY_IRQ), xmem (XMEM),
+  dual (N_HARTS=2: bme280_dual splits its work across the harts, the others run on hart 0).
+  Configurations run one after the other, with the RTL of each compiled once
+  (questasim/bench/<config>/, reused while unchanged); the builds and simulations
+  of one configuration run in parallel.
+- Cycles, instructions retired, CPI, LSU wait and code size come from the results
+  block in the DMEM dump and from the ELF. All rows go to build/bench/results.csv
+  (or --csv); a cycles table with one column per OPT/configuration is printed,
+  each cell also as a ratio to the first column.
+- Questa and Verilator load the image and read the dump directly (+FAST_LOAD
+  +FAST_DUMP, see regress.sim_command), not through the bootloader UART.
+
+    tools/bench.py --sim iss --opt=-Os,-O3 --config base,m,m+c coremark dhrystone
+"""
+
+from __future__ import annotations
+
+import argparse
+import csv
+import os
+import re
+import struct
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from dataclasses import dataclass, fields
+from pathlib import Path
+
+import regress
+from regress import ROOT
+
+BENCH_DIR = ROOT / "sw" / "bench"
+BUILD_ROOT = ROOT / "build" / "bench"
+QUESTA_ROOT = ROOT / "questasim" / "bench"
+
+BENCH_MAGIC = 0x48434E42
+CONFIG_FLAGS = ("pipe", "m", "c", "ei", "xmem", "dual")
+DEFAULT_CONFIGS = "base,m,m+c,pipe,pipe+m+c"
+
+
+@dataclass
+class Row:
+    bench: str
+    opt: str
+    config: str
+    status: str = "ERROR"
+    iterations: int | None = None
+    cycles: int | None = None
+    instret: int | None = None
+    cpi: float | None = None
+    lsu_wait: int | None = None
+    cycles_per_iter: int | None = None
+    text_bytes: int | None = None
+    log: str = ""
+
+
+def parse_config(name: str) -> set[str]:
+    flags = set() if name == "base" else set(name.split("+"))
+    unknown = flags - set(CONFIG_FLAGS)
+    if unknown:
+        raise SystemExit(f"[bench] unknown core option(s) {', '.join(sorted(unknown))} in '{name}' "
+                         f"(known: {', '.join(CONFIG_FLAGS)})")
+    if {"xmem", "dual"} <= flags:
+        raise SystemExit(f"[bench] '{name}': xmem and dual do not combine (hart 1 has no XMEM port)")
+    return flags
+
+
+def opt_dir(opt: str) -> str:
+    return re.sub(r"[^A-Za-z0-9]+", "", opt) or "default"
+
+
+def elf_code_bytes(elf: Path) -> int | None:
+    """Size of the allocated executable sections of a 32-bit little-endian ELF."""
+    try:
+        data = elf.read_bytes()
+    except OSError:
+        return None
+    if data[:4] != b"\x7fELF" or data[4] != 1:
+        return None
+    shoff, = struct.unpack_from("<I", data, 0x20)
+    shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+    total = 0
+    for i in range(shnum):
+        _, sh_type, sh_flags, _, _, sh_size = struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+        if sh_type == 1 and sh_flags & 0x2 and sh_flags & 0x4:    # PROGBITS, ALLOC + EXECINSTR
+            total += sh_size
+    return total
+
+
+def parse_results(text: str, row: Row) -> None:
+    res = regress.Result(row.bench)
+    regress.parse_log(text, res)
+    row.status = res.status
+    words = {int(i): int(v, 16) for i, v in re.findall(r"^dmem\[(\d+)\]=0x([0-9a-fA-F]+)", text, re.M)}
+    if words.get(3) != BENCH_MAGIC:
+        if row.status == "PASS":
+            row.status = "NODUMP"
+        return
+    row.iterations = words[4]
+    row.cycles = words[5]
+    row.instret = words[6]
+    row.cpi = words[7] / 1000.0
+    row.lsu_wait = words[8]
+    row.cycles_per_iter = words[9]
+    if row.status == "FAIL":
+        row.status = "CHECKSUM"
+
+
+def run_bench(src: Path, opt: str, config: str, flags: set[str], sim: str, lib: Path | None,
+              extra: list[str]) -> Row:
+    row = Row(src.stem, opt, config)
+    rv32m, rv32c, xmem = "m" in flags, "c" in flags, "xmem" in flags
+    harts = 2 if "dual" in flags else 1
+    # The program does not depend on pipe/ei: those configurations share a build.
+    sw_cfg = "+".join(f for f in ("m", "c", "xmem", "dual") if f in flags) or "base"
+    out_dir = BUILD_ROOT / f"{opt_dir(opt)}_{sw_cfg}" / src.stem
+
+    ok, _ = regress.build_test(src, out_dir, rv32m, rv32c,
+                               [f"OPT={opt}", f"XMEM={int(xmem)}", f"N_HARTS={harts}"])
+    if not ok:
+        row.status = "BUILD"
+        row.log = str((out_dir / "build.log").relative_to(ROOT))
+        return row
+    row.text_bytes = elf_code_bytes(out_dir / "main.elf")
+
+    work = out_dir / f"sim_{sim}_{config}"
+    work.mkdir(exist_ok=True)
+    plusargs = regress.test_tag(src, "REGRESS_ARGS") + extra
+    if xmem:
+        plusargs.append(f"+XMEM={out_dir / 'xmem.dat'}")
+    cmd = regress.sim_command(sim, lib, out_dir / "imem.dat", plusargs,
+                              "pipe" in flags, rv32m, "ei" in flags, rv32c, xmem, harts=harts)
+    log = work / "sim.log"
+    p = subprocess.run(cmd, cwd=work, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    log.write_text("$ " + " ".join(cmd) + "\n" + p.stdout)
+    row.log = str(log.relative_to(ROOT))
+    parse_results(p.stdout, row)
+    return row
+
+
+def prepare_sim(sim: str, config: str, flags: set[str], force: bool) -> Path | None:
+    pipe, m, ei, c, x = ("pipe" in flags, "m" in flags, "ei" in flags, "c" in flags, "xmem" in flags)
+    harts = 2 if "dual" in flags else 1
+    if sim == "questa":
+        return regress.compile_questa(force, [f"-GCPU_PIPELINE={int(pipe)}", f"-GCPU_RV32M={int(m)}",
+                                              f"-GCPU_EARLY_IRQ={int(ei)}", f"-GCPU_RV32C={int(c)}",
+                                              f"-GXMEM_EN={int(x)}", f"-GN_HARTS={harts}"],
+                                      QUESTA_ROOT / config)
+    target = "iss" if sim == "iss" else "verilator-build"
+    subprocess.run(["make", "-s", "-C", str(ROOT), target, "VL_THREADS=1",
+                    f"CPU_PIPELINE={int(pipe)}", f"CPU_RV32M={int(m)}", f"CPU_EARLY_IRQ={int(ei)}",
+                    f"CPU_RV32C={int(c)}", f"XMEM={int(x)}", f"N_HARTS={harts}"],
+                   check=True)
+    return None
+
+
+def print_table(rows: list[Row], columns: list[tuple[str, str]]) -> None:
+    benches = sorted({r.bench for r in rows})
+    by_key = {(r.bench, r.opt, r.config): r for r in rows}
+    heads = [f"{opt} {config}" for opt, config in columns]
+    width = max([len(b) for b in benches] + [5])
+    cw = max([len(h) for h in heads] + [20])
+    print(f"\ncycles (x: relative to '{heads[0]}'), CPI in brackets")
+    print(f"{'bench':<{width}}  " + "  ".join(f"{h:>{cw}}" for h in heads))
+    for b in benches:
+        base = by_key.get((b, *columns[0]))
+        cells = []
+        for opt, config in columns:
+            r = by_key.get((b, opt, config))
+            if r is None or r.cycles is None or r.status != "PASS":
+                cells.append(f"{r.status if r else '-':>{cw}}")
+                continue
+            cell = f"{r.cycles} [{r.cpi:.2f}]"
+            if base is not None and base.cycles and base.status == "PASS" and r is not base:
+                cell += f" {r.cycles / base.cycles:.2f}x"
+            cells.append(f"{cell:>{cw}}")
+        print(f"{b:<{width}}  " + "  ".join(cells))
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser()
+    ap.add_argument("benches", nargs="*", help="Benchmark names (stem of sw/bench/*.c); default: all")
+    ap.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1, help="Parallel builds/simulations")
+    ap.add_argument("--sim", choices=("questa", "verilator", "iss"), default="questa")
+    ap.add_argument("--opt", default="-Os,-O2,-O3", help="Comma-separated OPT values")
+    ap.add_argument("--config", default=DEFAULT_CONFIGS,
+                    help=f"Comma-separated core configurations, '+'-joined from {', '.join(CONFIG_FLAGS)} "
+                         f"or 'base' (default: {DEFAULT_CONFIGS})")
+    ap.add_argument("--csv", type=Path, default=BUILD_ROOT / "results.csv", help="Output CSV")
+    ap.add_argument("--force-compile", action="store_true", help="Recompile the RTL even if unchanged")
+    ap.add_argument("--plusargs", default="", help="Extra plusargs for every run")
+    ap.add_argument("--list", action="store_true", help="List benchmarks and exit")
+    args = ap.parse_args()
+
+    srcs = sorted(BENCH_DIR.glob("*.c"))
+    if args.benches:
+        wanted = set(args.benches)
+        srcs = [p for p in srcs if p.stem in wanted]
+        missing = wanted - {p.stem for p in srcs}
+        if missing:
+            print(f"[bench] unknown benchmarks: {', '.join(sorted(missing))}", file=sys.stderr)
+            return 2
+    if args.list:
+        for p in srcs:
+            print(p.stem)
+        return 0
+
+    opts = [o for o in args.opt.split(",") if o]
+    configs = [(c, parse_config(c)) for c in args.config.split(",") if c]
+    extra = args.plusargs.split()
+    t_start = time.monotonic()
+
+    rows: list[Row] = []
+    for config, flags in configs:
+        lib = prepare_sim(args.sim, config, flags, args.force_compile)
+        with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+            futs = [pool.submit(run_bench, src, opt, config, flags, args.sim, lib, extra)
+                    for opt in opts for src in srcs]
+            for fut in as_completed(futs):
+                r = fut.result()
+                rows.append(r)
+                print(f"[bench] {r.bench} {r.opt} {r.config}: {r.status}"
+                      + (f" cycles={r.cycles} CPI={r.cpi:.3f}" if r.cycles is not None else ""))
+
+    order = {(o, c): i for i, (o, c) in enumerate((o, c) for c, _ in configs for o in opts)}
+    rows.sort(key=lambda r: (r.bench, order[(r.opt, r.config)]))
+    args.csv.parent.mkdir(parents=True, exist_ok=True)
+    with args.csv.open("w", newline="") as f:
+        w = csv.writer(f)
+        w.writerow([fl.name for fl in fields(Row)])
+        for r in rows:
+            w.writerow(["" if v is None else (f"{v:.3f}" if isinstance(v, float) else v)
+                        for v in (getattr(r, fl.name) for fl in fields(Row))])
+
+    print_table(rows, [(o, c) for c, _ in configs for o in opts])
+    passed = sum(r.status == "PASS" for r in rows)
+    print(f"\n{passed}/{len(rows)} runs passed, sim={args.sim}, wall {time.monotonic() - t_start:.1f}s, "
+          f"results in {args.csv}")
+    return 0 if passed == len(rows) else 1
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
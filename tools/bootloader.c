@@ -1,32 +1,116 @@
+#include <elf.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 
 #define DEFAULT_PORT "/dev/ttyUSB0"
 #define DEFAULT_IMEM "sw/imem.dat"
 #define BAUD_RATE B115200
+#define BAUD_BPS 115200
 #define MAX_WORDS 2048
 #define CHUNK_WORDS 128
+#define DEFAULT_CLK_FREQ 100000000u
+
+// Protocol v2 (see hw/RTL/bootloader/load_store_controller.sv)
+#define V2_OP_WRITE 0u
+#define V2_OP_BAUD 1u
+#define V2_OP_SYNC 2u
+#define V2_OP_HASH 3u
+#define V2_OP_DWRITE 4u
+#define V2_OP_CTRL 5u
+#define V2_ACK 0u
+#define V2_BAD_CRC 1u
+#define V2_BAD_SEQ 2u
+#define V2_BAD_RANGE 3u
+#define V2_MAX_WINDOW 8
+#define V2_MAX_RETRIES 16
+#define V2_RESP_TIMEOUT_MS 200
+#define V2_BAUD_SYNC_MS 40      // must stay below the controller's BAUD_TIMEOUT (100 ms)
+#define V2_HALT_TIMEOUT_MS 1000
+
+// CTRL fields: [9:8] which of reset/halt to update, [1:0] their new values
+#define V2_CTRL_STATUS 0x000u
+#define V2_CTRL_HALT 0x101u
+#define V2_CTRL_RESUME 0x100u
+#define V2_CTRL_RESET 0x303u    // reset, and stay halted after it is released
+#define V2_CTRL_RUN 0x300u
+// Core state in responses
+#define V2_CORE_IN_RESET 0x100u
+#define V2_CORE_HALTED 0x200u
+
+#define MAX_POKES 256
+
+// -watch
+#define WATCH_MAX_RANGES 32
+#define WATCH_MERGE_GAP 1       // words; a read header costs as much as one skipped word
+#define WATCH_LOG_MAGIC 0x48435457u  // "WTCH"
+
+// -drain (sw/sample_ring.h)
+#define RING_MAGIC 0x474E4952u       // "RING"
+#define RING_HDR 4u                  // magic, geometry, seq, reserved
+#define RING_SEQ 2u
+#define DRAIN_LOG_MAGIC 0x474E5244u  // "DRNG"
+
+// -profile (sw/pcprof.h): { seq, mtime, mepc } entries
+#define PROF_RING_SYMBOL "pcprof_ring_mem"
+#define PROF_ENTRY_WORDS 3u
+#define PROF_TOP 20
+#define DMEM_BASE 0x10000000u
 
 static void usage(const char *prog) {
     fprintf(stderr,
             "Usage:\n"
-            "  %s -addr <word> -load [-file <imem.dat>] [-port <dev>]\n"
+            "  %s [-addr <word>] -load [-file <imem.dat|main.bin|main.elf>] [-port <dev>]\n"
+            "     [-v2 [-delta] [-window <n>] [-baud <rate> [-clk-freq <hz>]]]\n"
             "  %s -addr <word> -ndata <n> -read [-port <dev>]\n"
+            "  %s [-halt | -reset] [<load>] [-poke <word>=<value>[/<strb>] ...]\n"
+            "     [-run | -resume] [<read>] [-port <dev>]\n"
+            "  %s -watch <word>[+<n>][,...] [-rate <hz>] [-count <n>] [-log <file.csv|file.bin>]\n"
+            "     [-port <dev>]\n"
+            "  %s -drain <word> [-rate <hz>] [-count <n>] [-log <file.csv|file.bin>]\n"
+            "     [-clk-freq <hz>] [-port <dev>]\n"
+            "  %s -profile <main.elf> [-drain <word>] [-rate <hz>] [-count <n>] [<drain options>]\n"
             "\n"
             "Notes:\n"
-            "  -addr is a word address (0..2047). Baudrate is fixed at 115200.\n",
-            prog, prog);
+            "  -addr is a word address (0..2047). The link starts at 115200 baud.\n"
+            "  An ELF is loaded at its link addresses (PT_LOAD segments in IMEM); -addr\n"
+            "  only applies to .dat and .bin images.\n"
+            "  -v2 sends CRC-checked chunks, up to -window (default 4, max 8) in flight,\n"
+            "  and resends from the first one the board rejects; the loaded range is then\n"
+            "  verified with a CRC read back from IMEM. -delta (implies -v2) first compares\n"
+            "  per-chunk CRCs and only sends the chunks that differ.\n"
+            "  -baud switches both ends to <rate> for the load (implies -v2) and back to\n"
+            "  115200 afterwards; -clk-freq is the board clock (default 100 MHz).\n"
+            "  -watch re-reads the DMEM word ranges at -rate samples/s (default 10) until\n"
+            "  Ctrl-C or -count samples, printing only the words that changed. Adjacent\n"
+            "  ranges are read with one request. -log writes every sample (CSV for a .csv\n"
+            "  name, binary otherwise; see README).\n"
+            "  -drain polls the sample ring (sw/sample_ring.h) at word <word> at -rate\n"
+            "  (default 10/s) and reads the new entries in one burst, until Ctrl-C or\n"
+            "  -count entries. Entries overwritten before they were read count as lost.\n"
+            "  -profile drains the PC sample ring of sw/pcprof.h (found in the ELF unless\n"
+            "  -drain is given) and, on Ctrl-C or -count samples, prints the samples per\n"
+            "  function and per PC, symbolized with the ELF.\n"
+            "  Core control (protocol v2 frames), in this order within one call:\n"
+            "  -halt stops the core before its next instruction, -reset halts it and holds\n"
+            "  it in reset; then the load; then -poke writes DMEM words (strobe mask\n"
+            "  <strb>, default 0xF, for byte writes); then -run releases reset and halt\n"
+            "  (the core restarts at 0 after a reset) or -resume releases the halt; then\n"
+            "  the read.\n",
+            prog, prog, prog, prog, prog, prog);
 }
 
 static int open_serial(const char *port) {
-    int fd = open(port, O_RDWR | O_NOCTTY | O_SYNC);
+    // No O_SYNC: a load is queued as a few large writes and drained once at the end.
+    int fd = open(port, O_RDWR | O_NOCTTY);
     if (fd < 0) {
         perror("open");
         return -1;
@@ -111,12 +195,23 @@ static int read_exact(int fd, uint8_t *buf, size_t len, int timeout_ms) {
     return 0;
 }
 
-static int send_word_le(int fd, uint32_t word) {
-    uint8_t b[4];
+static void put_word_le(uint8_t *b, uint32_t word) {
     b[0] = (uint8_t)(word & 0xFF);
     b[1] = (uint8_t)((word >> 8) & 0xFF);
     b[2] = (uint8_t)((word >> 16) & 0xFF);
     b[3] = (uint8_t)((word >> 24) & 0xFF);
+}
+
+static uint32_t get_word_le(const uint8_t *b) {
+    return (uint32_t)b[0]
+         | ((uint32_t)b[1] << 8)
+         | ((uint32_t)b[2] << 16)
+         | ((uint32_t)b[3] << 24);
+}
+
+static int send_word_le(int fd, uint32_t word) {
+    uint8_t b[4];
+    put_word_le(b, word);
     return write_all(fd, b, sizeof(b));
 }
 
@@ -126,10 +221,137 @@ static int recv_word_le(int fd, uint32_t *out) {
     if (rc != 0) {
         return rc;
     }
-    *out = (uint32_t)b[0]
-         | ((uint32_t)b[1] << 8)
-         | ((uint32_t)b[2] << 16)
-         | ((uint32_t)b[3] << 24);
+    *out = get_word_le(b);
+    return 0;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int read_file(const char *path, uint8_t **out_buf, size_t *out_len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror("fopen");
+        return -1;
+    }
+    size_t cap = 4096;
+    size_t len = 0;
+    uint8_t *buf = (uint8_t *)malloc(cap);
+    if (!buf) {
+        fclose(f);
+        return -1;
+    }
+    for (;;) {
+        if (len == cap) {
+            cap *= 2;
+            uint8_t *tmp = (uint8_t *)realloc(buf, cap);
+            if (!tmp) {
+                free(buf);
+                fclose(f);
+                return -1;
+            }
+            buf = tmp;
+        }
+        size_t n = fread(buf + len, 1, cap - len, f);
+        if (n == 0) {
+            break;
+        }
+        len += n;
+    }
+    fclose(f);
+    *out_buf = buf;
+    *out_len = len;
+    return 0;
+}
+
+// Raw little-endian image (objcopy -O binary), loaded at -addr.
+static int load_bin_file(const uint8_t *raw, size_t len, const char *path,
+                         uint32_t **out_words, size_t *out_count) {
+    size_t count = (len + 3) / 4;
+    if (count == 0) {
+        fprintf(stderr, "bin file is empty: %s\n", path);
+        return -1;
+    }
+    uint32_t *words = (uint32_t *)calloc(count, sizeof(uint32_t));
+    if (!words) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        words[i / 4] |= (uint32_t)raw[i] << (8 * (i % 4));
+    }
+    *out_words = words;
+    *out_count = count;
+    return 0;
+}
+
+// ELF: PT_LOAD segments whose load address falls in IMEM (.text, .rodata and the
+// .data init image), sent as one span from the lowest to the highest loaded word.
+// Segments elsewhere (DMEM .bss, XMEM) are skipped.
+static int load_elf_file(const uint8_t *raw, size_t len, const char *path, uint32_t *out_addr,
+                         uint32_t **out_words, size_t *out_count) {
+    Elf32_Ehdr eh;
+    memcpy(&eh, raw, sizeof(eh));
+    if (eh.e_ident[EI_CLASS] != ELFCLASS32 || eh.e_machine != EM_RISCV) {
+        fprintf(stderr, "%s: not an RV32 ELF\n", path);
+        return -1;
+    }
+
+    const uint32_t imem_bytes = MAX_WORDS * 4u;
+    uint8_t *image = (uint8_t *)calloc(imem_bytes, 1);
+    if (!image) {
+        return -1;
+    }
+    uint32_t lo = imem_bytes;
+    uint32_t hi = 0;
+    for (unsigned i = 0; i < eh.e_phnum; i++) {
+        Elf32_Phdr ph;
+        size_t off = eh.e_phoff + (size_t)i * eh.e_phentsize;
+        if (off + sizeof(ph) > len) {
+            fprintf(stderr, "%s: truncated program header\n", path);
+            free(image);
+            return -1;
+        }
+        memcpy(&ph, raw + off, sizeof(ph));
+        if (ph.p_type != PT_LOAD || ph.p_filesz == 0 || ph.p_paddr >= imem_bytes) {
+            continue;
+        }
+        // p_paddr < imem_bytes here; no sum that a corrupt header could wrap.
+        if (ph.p_filesz > imem_bytes - ph.p_paddr || ph.p_offset > len || ph.p_filesz > len - ph.p_offset) {
+            fprintf(stderr, "%s: segment at 0x%08x does not fit in IMEM\n", path, ph.p_paddr);
+            free(image);
+            return -1;
+        }
+        memcpy(image + ph.p_paddr, raw + ph.p_offset, ph.p_filesz);
+        if (ph.p_paddr < lo) {
+            lo = ph.p_paddr;
+        }
+        if (ph.p_paddr + ph.p_filesz > hi) {
+            hi = ph.p_paddr + ph.p_filesz;
+        }
+    }
+    if (hi == 0) {
+        fprintf(stderr, "%s: no loadable segment in IMEM\n", path);
+        free(image);
+        return -1;
+    }
+
+    lo &= ~3u;
+    size_t count = (hi - lo + 3) / 4;
+    uint32_t *words = (uint32_t *)malloc(count * sizeof(uint32_t));
+    if (!words) {
+        free(image);
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        words[i] = get_word_le(image + lo + 4 * i);
+    }
+    free(image);
+    *out_addr = lo / 4;
+    *out_words = words;
+    *out_count = count;
     return 0;
 }
 
@@ -193,7 +415,33 @@ static int load_imem_file(const char *path, uint32_t **out_words, size_t *out_co
     return 0;
 }
 
+// -file: ELF (by magic), raw .bin (by extension) or $readmemh text (.dat).
+static int load_image(const char *path, uint32_t *addr, uint32_t **out_words, size_t *out_count) {
+    size_t n = strlen(path);
+    if (n >= 4 && strcmp(path + n - 4, ".dat") == 0) {
+        return load_imem_file(path, out_words, out_count);
+    }
+    uint8_t *raw = NULL;
+    size_t len = 0;
+    if (read_file(path, &raw, &len) != 0) {
+        return -1;
+    }
+    int rc;
+    if (len >= sizeof(Elf32_Ehdr) && memcmp(raw, ELFMAG, SELFMAG) == 0) {
+        rc = load_elf_file(raw, len, path, addr, out_words, out_count);
+    } else if (n >= 4 && strcmp(path + n - 4, ".bin") == 0) {
+        rc = load_bin_file(raw, len, path, out_words, out_count);
+    } else {
+        free(raw);
+        return load_imem_file(path, out_words, out_count);
+    }
+    free(raw);
+    return rc;
+}
+
+// Each chunk (header + payload) goes out with a single write().
 static int send_load(int fd, uint32_t addr, const uint32_t *words, size_t count) {
+    uint8_t buf[(1 + CHUNK_WORDS) * 4];
     size_t sent = 0;
     while (sent < count) {
         size_t chunk = count - sent;
@@ -201,13 +449,12 @@ static int send_load(int fd, uint32_t addr, const uint32_t *words, size_t count)
             chunk = CHUNK_WORDS;
         }
         uint32_t header = (1u << 31) | ((addr & 0x7FFFu) << 16) | (uint32_t)chunk;
-        if (send_word_le(fd, header) != 0) {
-            return -1;
-        }
+        put_word_le(buf, header);
         for (size_t i = 0; i < chunk; i++) {
-            if (send_word_le(fd, words[sent + i]) != 0) {
-                return -1;
-            }
+            put_word_le(buf + 4 * (i + 1), words[sent + i]);
+        }
+        if (write_all(fd, buf, 4 * (chunk + 1)) != 0) {
+            return -1;
         }
         addr += (uint32_t)chunk;
         sent += chunk;
@@ -215,18 +462,27 @@ static int send_load(int fd, uint32_t addr, const uint32_t *words, size_t count)
     return 0;
 }
 
-static int send_read(int fd, uint32_t addr, uint32_t ndata) {
+static int read_dmem(int fd, uint32_t addr, uint32_t ndata, uint32_t *out) {
     uint32_t header = (0u << 31) | ((addr & 0x7FFFu) << 16) | (ndata & 0xFFFFu);
     if (send_word_le(fd, header) != 0) {
         return -1;
     }
     for (uint32_t i = 0; i < ndata; i++) {
-        uint32_t word = 0;
-        int rc = recv_word_le(fd, &word);
-        if (rc != 0) {
+        if (recv_word_le(fd, &out[i]) != 0) {
             fprintf(stderr, "timeout reading word %u\n", i);
             return -1;
         }
+    }
+    return 0;
+}
+
+static int send_read(int fd, uint32_t addr, uint32_t ndata) {
+    uint32_t words[MAX_WORDS];
+    if (read_dmem(fd, addr, ndata, words) != 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < ndata; i++) {
+        uint32_t word = words[i];
         printf("dmem[0x%04x]=0x%08x, %c%c%c%c\n", addr + i, word, 
                (char)(word & 0xFF),
                (char)((word >> 8) & 0xFF),
@@ -236,6 +492,1086 @@ static int send_read(int fd, uint32_t addr, uint32_t ndata) {
     return 0;
 }
 
+// ---- Protocol v2 ----
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ ((crc & 1u) ? 0xEDB88320u : 0u);
+        }
+    }
+    return crc;
+}
+
+// Frame = header, payload words, CRC-32 of both; sent with a single write().
+static int v2_send(int fd, uint32_t op, uint32_t seq, uint32_t fields,
+                   const uint32_t *words, size_t count) {
+    uint8_t buf[(2 + CHUNK_WORDS) * 4];
+    uint32_t header = (3u << 30) | ((op & 3u) << 28) | ((seq & 15u) << 24) | (((op >> 2) & 1u) << 23) |
+                      (fields & 0x7FFFFFu);
+    put_word_le(buf, header);
+    for (size_t i = 0; i < count; i++) {
+        put_word_le(buf + 4 * (i + 1), words[i]);
+    }
+    size_t len = 4 * (count + 1);
+    put_word_le(buf + len, ~crc32_update(0xFFFFFFFFu, buf, len));
+    return write_all(fd, buf, len + 4);
+}
+
+// Response {0xAC, 0, halted, in_reset, status, next_seq}; returns 0, -2 on timeout,
+// -1 on error.
+static int v2_recv_word(int fd, int timeout_ms, uint32_t *word) {
+    uint8_t b[4];
+    int rc = read_exact(fd, b, sizeof(b), timeout_ms);
+    if (rc != 0) {
+        return rc;
+    }
+    *word = get_word_le(b);
+    return ((*word >> 24) == 0xACu) ? 0 : -1;
+}
+
+static int v2_recv(int fd, int timeout_ms, uint32_t *status, uint32_t *next_seq) {
+    uint32_t word = 0;
+    int rc = v2_recv_word(fd, timeout_ms, &word);
+    if (rc != 0) {
+        return rc;
+    }
+    *status = (word >> 4) & 15u;
+    *next_seq = word & 15u;
+    return 0;
+}
+
+static int v2_sync(int fd, uint32_t seq, int timeout_ms) {
+    uint32_t status = 0;
+    uint32_t next = 0;
+    if (v2_send(fd, V2_OP_SYNC, seq, 0, NULL, 0) != 0) {
+        return -1;
+    }
+    if (v2_recv(fd, timeout_ms, &status, &next) != 0 || status != V2_ACK || next != (seq & 15u)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int set_host_baud(int fd, speed_t speed) {
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        return -1;
+    }
+    if (cfsetispeed(&tio, speed) != 0 || cfsetospeed(&tio, speed) != 0) {
+        return -1;
+    }
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+static speed_t speed_from_rate(uint32_t rate) {
+    switch (rate) {
+    case 115200: return B115200;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+#ifdef B1000000
+    case 1000000: return B1000000;
+#endif
+#ifdef B1500000
+    case 1500000: return B1500000;
+#endif
+#ifdef B2000000
+    case 2000000: return B2000000;
+#endif
+#ifdef B3000000
+    case 3000000: return B3000000;
+#endif
+#ifdef B4000000
+    case 4000000: return B4000000;
+#endif
+    default: return (speed_t)0;
+    }
+}
+
+// BAUD is acknowledged at the current rate, then both ends switch and a SYNC at the
+// new rate confirms it. Without that SYNC the board falls back by itself, so on
+// failure the host goes back too and checks the link at the old rate.
+static int v2_switch_baud(int fd, uint32_t rate, uint32_t old_rate, uint32_t clk_freq, uint32_t seq) {
+    speed_t speed = speed_from_rate(rate);
+    speed_t old_speed = speed_from_rate(old_rate);
+    uint64_t div = ((uint64_t)clk_freq * 16u + rate / 2) / rate;
+    uint32_t status = 0;
+    uint32_t next = 0;
+    if (speed == (speed_t)0) {
+        fprintf(stderr, "error: %u baud is not supported by the host tty\n", rate);
+        return -1;
+    }
+    if (div < 64 || div > 0xFFFF) {
+        fprintf(stderr, "error: %u baud is out of range for a %u Hz board clock\n", rate, clk_freq);
+        return -1;
+    }
+    double actual = (double)clk_freq * 16.0 / (double)div;
+    if (v2_send(fd, V2_OP_BAUD, seq, (uint32_t)div, NULL, 0) != 0 ||
+        v2_recv(fd, V2_RESP_TIMEOUT_MS, &status, &next) != 0 || status != V2_ACK) {
+        fprintf(stderr, "error: baud switch to %u not acknowledged\n", rate);
+        return -1;
+    }
+    usleep(1000);
+    if (set_host_baud(fd, speed) != 0) {
+        perror("tcsetattr");
+        return -1;
+    }
+    tcflush(fd, TCIFLUSH);
+    if (v2_sync(fd, seq, V2_BAUD_SYNC_MS) == 0) {
+        printf("Switched to %u baud (board divider %.2f clk/bit, %.0f baud, %+.2f%%)\n", rate,
+               (double)div / 16.0, actual, 100.0 * (actual - rate) / rate);
+        return 0;
+    }
+    fprintf(stderr, "warning: no answer at %u baud, falling back to %u\n", rate, old_rate);
+    set_host_baud(fd, old_speed);
+    usleep(200000);
+    tcflush(fd, TCIOFLUSH);
+    if (v2_sync(fd, seq, V2_RESP_TIMEOUT_MS) != 0) {
+        fprintf(stderr, "error: board lost after the baud switch (reset it)\n");
+        return -1;
+    }
+    return 1;
+}
+
+// Go-back-N: up to `window` chunks in flight; every chunk gets one response whose
+// seq is the board's next expected one (cumulative). On a NAK the host stops
+// sending, collects the responses still due, then resends from that seq.
+// `chunks` lists the CHUNK_WORDS-sized chunks of the image to send, in order.
+static int v2_load(int fd, uint32_t addr, const uint32_t *words, size_t count,
+                   const size_t *chunks, size_t nchunks, int window,
+                   size_t *bytes_sent, unsigned *resent) {
+    size_t base = 0;
+    size_t next = 0;
+    size_t sent_max = 0;
+    size_t outstanding = 0;
+    unsigned retries = 0;
+    int rewind = 0;
+    *bytes_sent = 0;
+    *resent = 0;
+
+    while (base < nchunks) {
+        while (!rewind && next < nchunks && next - base < (size_t)window) {
+            size_t off = chunks[next] * CHUNK_WORDS;
+            size_t n = count - off < CHUNK_WORDS ? count - off : CHUNK_WORDS;
+            uint32_t fields = (((addr + (uint32_t)off) & 0x7FFFu) << 8) | (uint32_t)n;
+            if (v2_send(fd, V2_OP_WRITE, (uint32_t)next, fields, words + off, n) != 0) {
+                return -1;
+            }
+            *bytes_sent += 4 * (n + 2);
+            if (next < sent_max) {
+                ++*resent;
+            }
+            next++;
+            if (next > sent_max) {
+                sent_max = next;
+            }
+            outstanding++;
+        }
+
+        uint32_t status = 0;
+        uint32_t seq = 0;
+        int rc = v2_recv(fd, V2_RESP_TIMEOUT_MS, &status, &seq);
+        if (rc != 0) {
+            // Lost framing or response: let the board's idle timeout resync, then resend.
+            if (++retries > V2_MAX_RETRIES) {
+                fprintf(stderr, "error: no response for chunk %zu\n", base);
+                return -1;
+            }
+            usleep(20000);
+            tcflush(fd, TCIFLUSH);
+            next = base;
+            outstanding = 0;
+            rewind = 0;
+            continue;
+        }
+        outstanding--;
+        size_t acked = (seq - (uint32_t)base) & 15u;
+        if (acked <= next - base) {
+            base += acked;
+        }
+        if (status == V2_BAD_RANGE) {
+            fprintf(stderr, "error: chunk %zu rejected (address out of range)\n", base);
+            return -1;
+        }
+        if (status != V2_ACK && !rewind) {
+            if (++retries > V2_MAX_RETRIES) {
+                fprintf(stderr, "error: chunk %zu rejected %u times\n", base, retries);
+                return -1;
+            }
+            rewind = 1;
+        }
+        if (rewind && outstanding == 0) {
+            next = base;
+            rewind = 0;
+        }
+    }
+    return 0;
+}
+
+static uint32_t crc32_words(const uint32_t *words, size_t count) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t b[4];
+        put_word_le(b, words[i]);
+        crc = crc32_update(crc, b, sizeof(b));
+    }
+    return ~crc;
+}
+
+// CRC-32 of `nchunks` IMEM chunks of `len` words starting at `addr`.
+static int v2_hash(int fd, uint32_t addr, uint32_t nchunks, uint32_t len, uint32_t *out) {
+    uint32_t status = V2_BAD_CRC;
+    uint32_t next = 0;
+    uint32_t fields = ((addr & 0x7FFFu) << 8) | (nchunks & 0xFFu);
+    // Resend on a corrupted frame or lost response; anything else is final.
+    for (unsigned tries = 0; status != V2_ACK && status != V2_BAD_RANGE; tries++) {
+        if (tries > V2_MAX_RETRIES || v2_send(fd, V2_OP_HASH, 0, fields, &len, 1) != 0) {
+            return -1;
+        }
+        if (v2_recv(fd, V2_RESP_TIMEOUT_MS, &status, &next) != 0) {
+            usleep(20000);
+            tcflush(fd, TCIFLUSH);
+            status = V2_BAD_CRC;
+        }
+    }
+    if (status != V2_ACK) {
+        fprintf(stderr, "error: HASH of 0x%04x+%u x %u words rejected\n", addr, nchunks, len);
+        return -1;
+    }
+    for (uint32_t i = 0; i < nchunks; i++) {
+        if (recv_word_le(fd, &out[i]) != 0) {
+            fprintf(stderr, "error: timeout reading HASH result %u\n", i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Chunks whose IMEM contents differ from the image (by CRC); returns how many.
+static int v2_delta(int fd, uint32_t addr, const uint32_t *words, size_t count,
+                    size_t *chunks, size_t *nchanged) {
+    uint32_t remote[MAX_WORDS / CHUNK_WORDS + 1];
+    size_t full = count / CHUNK_WORDS;
+    size_t tail = count % CHUNK_WORDS;
+    size_t n = 0;
+    if (full > 0 && v2_hash(fd, addr, (uint32_t)full, CHUNK_WORDS, remote) != 0) {
+        return -1;
+    }
+    if (tail > 0 &&
+        v2_hash(fd, addr + (uint32_t)(full * CHUNK_WORDS), 1, (uint32_t)tail, &remote[full]) != 0) {
+        return -1;
+    }
+    for (size_t c = 0; c < full + (tail > 0); c++) {
+        size_t len = (c < full) ? CHUNK_WORDS : tail;
+        if (crc32_words(words + c * CHUNK_WORDS, len) != remote[c]) {
+            chunks[n++] = c;
+        }
+    }
+    *nchanged = n;
+    return 0;
+}
+
+// ---- DMEM watch ----
+
+struct watch_range {
+    uint32_t addr;
+    uint32_t n;
+};
+
+static volatile sig_atomic_t watch_stop;
+
+static void watch_sigint(int sig) {
+    (void)sig;
+    watch_stop = 1;
+}
+
+static int watch_range_cmp(const void *a, const void *b) {
+    const struct watch_range *x = a;
+    const struct watch_range *y = b;
+    return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+// "2+4,16,32+8" -> ranges; returns the number of ranges or -1.
+static int watch_parse(const char *spec, struct watch_range *r) {
+    int n = 0;
+    const char *p = spec;
+    while (*p) {
+        char *end = NULL;
+        if (n == WATCH_MAX_RANGES) {
+            fprintf(stderr, "error: at most %d -watch ranges\n", WATCH_MAX_RANGES);
+            return -1;
+        }
+        r[n].addr = (uint32_t)strtoul(p, &end, 0);
+        r[n].n = 1;
+        if (end == p) {
+            break;
+        }
+        p = end;
+        if (*p == '+') {
+            r[n].n = (uint32_t)strtoul(p + 1, &end, 0);
+            if (end == p + 1) {
+                break;
+            }
+            p = end;
+        }
+        if (r[n].n == 0 || r[n].addr + r[n].n > MAX_WORDS) {
+            fprintf(stderr, "error: -watch range 0x%x+%u out of range (max %u words)\n",
+                    r[n].addr, r[n].n, MAX_WORDS);
+            return -1;
+        }
+        n++;
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            break;
+        }
+    }
+    if (*p || n == 0) {
+        fprintf(stderr, "error: bad -watch list '%s' (expected <word>[+<n>][,...])\n", spec);
+        return -1;
+    }
+    return n;
+}
+
+// Sort, then merge ranges that overlap or are at most WATCH_MERGE_GAP words apart.
+static int watch_coalesce(struct watch_range *r, int n) {
+    int m = 0;
+    qsort(r, (size_t)n, sizeof(*r), watch_range_cmp);
+    for (int i = 1; i < n; i++) {
+        uint32_t end = r[m].addr + r[m].n;
+        if (r[i].addr <= end + WATCH_MERGE_GAP) {
+            uint32_t new_end = r[i].addr + r[i].n;
+            if (new_end > end) {
+                r[m].n = new_end - r[m].addr;
+            }
+        } else {
+            r[++m] = r[i];
+        }
+    }
+    return m + 1;
+}
+
+static void watch_sleep_until(double t) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)t;
+    ts.tv_nsec = (long)((t - (double)ts.tv_sec) * 1e9);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR && !watch_stop) {
+    }
+}
+
+static int watch_log_header(FILE *log, int csv, const struct watch_range *r, int n) {
+    uint32_t total = 0;
+    for (int i = 0; i < n; i++) {
+        total += r[i].n;
+    }
+    if (csv) {
+        fprintf(log, "t_s");
+        for (int i = 0; i < n; i++) {
+            for (uint32_t j = 0; j < r[i].n; j++) {
+                fprintf(log, ",0x%04x", r[i].addr + j);
+            }
+        }
+        fprintf(log, "\n");
+        return ferror(log) ? -1 : 0;
+    }
+    uint8_t b[4];
+    put_word_le(b, WATCH_LOG_MAGIC);
+    fwrite(b, 1, 4, log);
+    put_word_le(b, total);
+    fwrite(b, 1, 4, log);
+    for (int i = 0; i < n; i++) {
+        for (uint32_t j = 0; j < r[i].n; j++) {
+            put_word_le(b, r[i].addr + j);
+            fwrite(b, 1, 4, log);
+        }
+    }
+    return ferror(log) ? -1 : 0;
+}
+
+static int watch_log_sample(FILE *log, int csv, double t, const uint32_t *words, uint32_t total) {
+    if (csv) {
+        fprintf(log, "%.6f", t);
+        for (uint32_t i = 0; i < total; i++) {
+            fprintf(log, ",0x%08x", words[i]);
+        }
+        fprintf(log, "\n");
+        return ferror(log) ? -1 : 0;
+    }
+    uint64_t us = (uint64_t)(t * 1e6);
+    uint8_t b[8];
+    put_word_le(b, (uint32_t)us);
+    put_word_le(b + 4, (uint32_t)(us >> 32));
+    fwrite(b, 1, 8, log);
+    for (uint32_t i = 0; i < total; i++) {
+        put_word_le(b, words[i]);
+        fwrite(b, 1, 4, log);
+    }
+    return ferror(log) ? -1 : 0;
+}
+
+// Samples the ranges on a fixed schedule; a sample that overruns its slot skips
+// the slots it covered (counted as dropped) instead of bunching up afterwards.
+static int watch_dmem(int fd, struct watch_range *req, int nreq, double rate, unsigned long count,
+                      const char *log_path) {
+    struct watch_range r[WATCH_MAX_RANGES];
+    uint32_t cur[MAX_WORDS];
+    uint32_t prev[MAX_WORDS];
+    uint32_t total = 0;
+    memcpy(r, req, sizeof(*r) * (size_t)nreq);
+    int n = watch_coalesce(r, nreq);
+    for (int i = 0; i < n; i++) {
+        total += r[i].n;
+    }
+
+    FILE *log = NULL;
+    int csv = 0;
+    if (log_path) {
+        size_t len = strlen(log_path);
+        csv = len >= 4 && strcmp(log_path + len - 4, ".csv") == 0;
+        log = fopen(log_path, csv ? "w" : "wb");
+        if (!log) {
+            perror(log_path);
+            return -1;
+        }
+        if (watch_log_header(log, csv, r, n) != 0) {
+            perror(log_path);
+            fclose(log);
+            return -1;
+        }
+    }
+
+    // 8N1 at BAUD_BPS: each request is a header out, then the words back.
+    double sample_s = 10.0 * 4.0 * (n + total) / BAUD_BPS;
+    printf("Watching %u DMEM words in %d read(s) at %.1f Hz (%.1f ms of line time per sample)\n",
+           total, n, rate, 1e3 * sample_s);
+    if (sample_s * rate > 1.0) {
+        printf("warning: the line can sustain about %.1f Hz for these ranges\n", 1.0 / sample_s);
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = watch_sigint;
+    sigaction(SIGINT, &sa, NULL);
+
+    double period = 1.0 / rate;
+    double t0 = now_s();
+    double next = t0;
+    unsigned long samples = 0;
+    unsigned long dropped = 0;
+    double t_last = 0.0;
+    int rc = 0;
+    while (!watch_stop && (count == 0 || samples < count)) {
+        watch_sleep_until(next);
+        if (watch_stop) {
+            break;
+        }
+        double t = now_s() - t0;
+        uint32_t *w = cur;
+        for (int i = 0; i < n && rc == 0; i++) {
+            rc = read_dmem(fd, r[i].addr, r[i].n, w);
+            w += r[i].n;
+        }
+        if (rc != 0) {
+            break;
+        }
+        // Console: everything on the first sample, then only changes.
+        w = cur;
+        for (int i = 0; i < n; i++) {
+            for (uint32_t j = 0; j < r[i].n; j++, w++) {
+                size_t k = (size_t)(w - cur);
+                if (samples == 0) {
+                    printf("[%9.3f] dmem[0x%04x] = 0x%08x\n", t, r[i].addr + j, *w);
+                } else if (*w != prev[k]) {
+                    printf("[%9.3f] dmem[0x%04x] = 0x%08x (was 0x%08x)\n", t, r[i].addr + j, *w,
+                           prev[k]);
+                }
+            }
+        }
+        fflush(stdout);
+        if (log && watch_log_sample(log, csv, t, cur, total) != 0) {
+            perror(log_path);
+            rc = -1;
+            break;
+        }
+        memcpy(prev, cur, sizeof(cur[0]) * total);
+        samples++;
+        t_last = t;
+
+        next += period;
+        double late = now_s() - next;
+        if (late > 0.0) {
+            unsigned long skip = (unsigned long)(late / period) + 1;
+            dropped += skip;
+            next += (double)skip * period;
+        }
+    }
+
+    // Rate over the spans between samples, so a short run is not biased by one slot.
+    double dt = t_last;
+    printf("%lu samples over %.3f s: %.2f Hz achieved (%.2f Hz requested), %lu interval(s) dropped\n",
+           samples, dt, (samples > 1 && dt > 0.0) ? (double)(samples - 1) / dt : 0.0, rate, dropped);
+    if (log && fclose(log) != 0) {
+        perror(log_path);
+        rc = -1;
+    }
+    signal(SIGINT, SIG_DFL);
+    return rc;
+}
+
+// ---- PC sample profile ----
+
+struct prof_sym {
+    uint32_t addr;
+    uint32_t end;               // labels: end of their section (the next symbol comes first)
+    int sized;                  // STT_FUNC
+    const char *name;
+};
+
+struct profile {
+    uint8_t *elf;               // owns the symbol names
+    struct prof_sym *syms;
+    size_t nsyms;
+    uint32_t *pcs;
+    size_t npcs;
+    size_t cap;
+};
+
+static int prof_sym_cmp(const void *a, const void *b) {
+    const struct prof_sym *x = (const struct prof_sym *)a;
+    const struct prof_sym *y = (const struct prof_sym *)b;
+    if (x->addr != y->addr) {
+        return x->addr < y->addr ? -1 : 1;
+    }
+    return y->sized - x->sized;                 // STT_FUNC first
+}
+
+static int u32_cmp(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Code symbols of the ELF (.symtab: functions and asm labels in executable
+// sections, not .L locals) and the DMEM word of the pcprof ring.
+static int prof_load_elf(const char *path, struct profile *p, uint32_t *ring_word) {
+    size_t len = 0;
+    if (read_file(path, &p->elf, &len) != 0) {
+        return -1;
+    }
+    const uint8_t *raw = p->elf;
+    Elf32_Ehdr eh;
+    if (len < sizeof(eh) || memcmp(raw, ELFMAG, SELFMAG) != 0) {
+        fprintf(stderr, "%s: not an ELF file\n", path);
+        return -1;
+    }
+    memcpy(&eh, raw, sizeof(eh));
+    if (eh.e_ident[EI_CLASS] != ELFCLASS32 || eh.e_machine != EM_RISCV ||
+        eh.e_shoff + (size_t)eh.e_shnum * sizeof(Elf32_Shdr) > len) {
+        fprintf(stderr, "%s: not an RV32 ELF\n", path);
+        return -1;
+    }
+    const Elf32_Shdr *sh = (const Elf32_Shdr *)(raw + eh.e_shoff);
+    int have_ring = 0;
+    for (unsigned i = 0; i < eh.e_shnum; i++) {
+        if (sh[i].sh_type != SHT_SYMTAB || sh[i].sh_link >= eh.e_shnum) {
+            continue;
+        }
+        const Elf32_Shdr *str = &sh[sh[i].sh_link];
+        if (sh[i].sh_offset + sh[i].sh_size > len || str->sh_offset + str->sh_size > len) {
+            fprintf(stderr, "%s: truncated symbol table\n", path);
+            return -1;
+        }
+        const size_t n = sh[i].sh_size / sizeof(Elf32_Sym);
+        p->syms = (struct prof_sym *)calloc(n + 1, sizeof(*p->syms));
+        if (!p->syms) {
+            return -1;
+        }
+        for (size_t k = 0; k < n; k++) {
+            Elf32_Sym sym;
+            memcpy(&sym, raw + sh[i].sh_offset + k * sizeof(sym), sizeof(sym));
+            if (sym.st_name >= str->sh_size || sym.st_shndx == SHN_UNDEF || sym.st_shndx >= eh.e_shnum) {
+                continue;
+            }
+            const char *name = (const char *)raw + str->sh_offset + sym.st_name;
+            const unsigned type = ELF32_ST_TYPE(sym.st_info);
+            if (strcmp(name, PROF_RING_SYMBOL) == 0) {
+                if (sym.st_value - DMEM_BASE >= MAX_WORDS * 4u) {
+                    fprintf(stderr, "%s: %s at 0x%08x is not in DMEM\n", path, name, sym.st_value);
+                    return -1;
+                }
+                *ring_word = (sym.st_value - DMEM_BASE) / 4u;
+                have_ring = 1;
+            }
+            if ((type != STT_FUNC && type != STT_NOTYPE) || !(sh[sym.st_shndx].sh_flags & SHF_EXECINSTR) ||
+                name[0] == '\0' || name[0] == '$' || strncmp(name, ".L", 2) == 0) {
+                continue;
+            }
+            const Elf32_Shdr *sec = &sh[sym.st_shndx];
+            p->syms[p->nsyms].addr = sym.st_value;
+            p->syms[p->nsyms].sized = type == STT_FUNC && sym.st_size != 0;
+            p->syms[p->nsyms].end = p->syms[p->nsyms].sized ? sym.st_value + sym.st_size
+                                                            : sec->sh_addr + sec->sh_size;
+            p->syms[p->nsyms].name = name;
+            p->nsyms++;
+        }
+        break;
+    }
+    if (p->nsyms == 0) {
+        fprintf(stderr, "warning: %s has no code symbols, the report shows PCs only\n", path);
+    }
+    qsort(p->syms, p->nsyms, sizeof(*p->syms), prof_sym_cmp);
+    return have_ring ? 1 : 0;
+}
+
+static int prof_add(struct profile *p, uint32_t pc) {
+    if (p->npcs == p->cap) {
+        size_t cap = p->cap ? 2 * p->cap : 4096;
+        uint32_t *tmp = (uint32_t *)realloc(p->pcs, cap * sizeof(uint32_t));
+        if (!tmp) {
+            return -1;
+        }
+        p->pcs = tmp;
+        p->cap = cap;
+    }
+    p->pcs[p->npcs++] = pc;
+    return 0;
+}
+
+// Symbol containing pc, or NULL. At one address the first (sized) entry wins.
+static const struct prof_sym *prof_lookup(const struct profile *p, uint32_t pc) {
+    size_t lo = 0;
+    size_t hi = p->nsyms;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (p->syms[mid].addr <= pc) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return NULL;
+    }
+    size_t i = lo - 1;
+    while (i > 0 && p->syms[i - 1].addr == p->syms[i].addr) {
+        i--;
+    }
+    const struct prof_sym *s = &p->syms[i];
+    if (pc >= s->end) {
+        return NULL;
+    }
+    return s;
+}
+
+struct prof_row {
+    uint32_t key;               // function: symbol index + 1 (0: unknown); PC: the PC
+    size_t count;
+};
+
+static int prof_row_cmp(const void *a, const void *b) {
+    const struct prof_row *x = (const struct prof_row *)a;
+    const struct prof_row *y = (const struct prof_row *)b;
+    if (x->count != y->count) {
+        return x->count > y->count ? -1 : 1;
+    }
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+static void prof_print_where(const struct profile *p, uint32_t pc) {
+    const struct prof_sym *s = prof_lookup(p, pc);
+    if (s) {
+        printf("%s+0x%x", s->name, pc - s->addr);
+    } else {
+        printf("?");
+    }
+}
+
+// Ranked hotspots: samples per function, then per PC.
+static int prof_report(struct profile *p) {
+    if (p->npcs == 0) {
+        printf("no samples\n");
+        return 0;
+    }
+    qsort(p->pcs, p->npcs, sizeof(uint32_t), u32_cmp);
+    struct prof_row *pcs = (struct prof_row *)calloc(p->npcs, sizeof(*pcs));
+    struct prof_row *fns = (struct prof_row *)calloc(p->nsyms + 1, sizeof(*fns));
+    if (!pcs || !fns) {
+        free(pcs);
+        free(fns);
+        return -1;
+    }
+    size_t npc = 0;
+    for (size_t i = 0; i <= p->nsyms; i++) {
+        fns[i].key = (uint32_t)i;
+    }
+    for (size_t i = 0; i < p->npcs; i++) {
+        if (npc == 0 || pcs[npc - 1].key != p->pcs[i]) {
+            pcs[npc].key = p->pcs[i];
+            pcs[npc].count = 0;
+            npc++;
+        }
+        pcs[npc - 1].count++;
+        const struct prof_sym *s = prof_lookup(p, p->pcs[i]);
+        fns[s ? (size_t)(s - p->syms) + 1 : 0].count++;
+    }
+    qsort(pcs, npc, sizeof(*pcs), prof_row_cmp);
+    qsort(fns, p->nsyms + 1, sizeof(*fns), prof_row_cmp);
+
+    const double total = (double)p->npcs;
+    printf("\n---- %zu samples by function ----\n", p->npcs);
+    printf("%10s %7s  %s\n", "samples", "%", "function");
+    for (size_t i = 0; i <= p->nsyms && i < PROF_TOP && fns[i].count > 0; i++) {
+        printf("%10zu %7.2f  %s\n", fns[i].count, 100.0 * (double)fns[i].count / total,
+               fns[i].key ? p->syms[fns[i].key - 1].name : "?");
+    }
+    printf("\n---- by PC ----\n");
+    printf("%10s %7s  %-10s  %s\n", "samples", "%", "pc", "where");
+    for (size_t i = 0; i < npc && i < PROF_TOP; i++) {
+        printf("%10zu %7.2f  0x%08x  ", pcs[i].count, 100.0 * (double)pcs[i].count / total, pcs[i].key);
+        prof_print_where(p, pcs[i].key);
+        printf("\n");
+    }
+    free(pcs);
+    free(fns);
+    return 0;
+}
+
+// ---- Sample ring drain ----
+
+static int drain_log_entry(FILE *log, int csv, const uint32_t *e, uint32_t words) {
+    if (csv) {
+        fprintf(log, "%u,%u", e[0], e[1]);
+        for (uint32_t i = 2; i < words; i++) {
+            fprintf(log, ",0x%08x", e[i]);
+        }
+        fprintf(log, "\n");
+        return ferror(log) ? -1 : 0;
+    }
+    uint8_t b[4];
+    for (uint32_t i = 0; i < words; i++) {
+        put_word_le(b, e[i]);
+        fwrite(b, 1, 4, log);
+    }
+    return ferror(log) ? -1 : 0;
+}
+
+// Each poll reads seq, the slots written since the last poll (two reads when
+// they wrap) and seq again. An entry k is kept if it is still in its slot after
+// the burst: seq - k < entries, and its own sequence word is k.
+static int drain_ring(int fd, uint32_t addr, double rate, unsigned long count, const char *log_path,
+                      uint32_t clk_freq, struct profile *prof) {
+    static uint32_t buf[MAX_WORDS];
+    uint32_t hdr[RING_HDR];
+    if (read_dmem(fd, addr, RING_HDR, hdr) != 0) {
+        return -1;
+    }
+    if (hdr[0] != RING_MAGIC) {
+        fprintf(stderr, "error: no sample ring at word 0x%04x (read 0x%08x)\n", addr, hdr[0]);
+        return -1;
+    }
+    const uint32_t entries = hdr[1] & 0xFFFFu;
+    const uint32_t words = hdr[1] >> 16;
+    if (entries == 0 || (entries & (entries - 1u)) != 0 || words < 2 ||
+        addr + RING_HDR + entries * words > MAX_WORDS) {
+        fprintf(stderr, "error: bad ring geometry 0x%08x at word 0x%04x\n", hdr[1], addr);
+        return -1;
+    }
+    if (prof && words != PROF_ENTRY_WORDS) {
+        fprintf(stderr, "error: the ring at word 0x%04x has %u-word entries, not pcprof samples\n", addr,
+                words);
+        return -1;
+    }
+
+    FILE *log = NULL;
+    int csv = 0;
+    if (log_path) {
+        size_t len = strlen(log_path);
+        csv = len >= 4 && strcmp(log_path + len - 4, ".csv") == 0;
+        log = fopen(log_path, csv ? "w" : "wb");
+        if (!log) {
+            perror(log_path);
+            return -1;
+        }
+        if (csv) {
+            fprintf(log, "seq,time");
+            for (uint32_t i = 2; i < words; i++) {
+                fprintf(log, ",w%u", i - 2);
+            }
+            fprintf(log, "\n");
+        } else {
+            uint8_t b[4];
+            put_word_le(b, DRAIN_LOG_MAGIC);
+            fwrite(b, 1, 4, log);
+            put_word_le(b, words);
+            fwrite(b, 1, 4, log);
+        }
+        if (ferror(log)) {
+            perror(log_path);
+            fclose(log);
+            return -1;
+        }
+    }
+
+    printf("Draining the %u x %u-word ring at word 0x%04x (seq %u) at %.1f polls/s\n", entries,
+           words, addr, hdr[RING_SEQ], rate);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = watch_sigint;
+    sigaction(SIGINT, &sa, NULL);
+
+    // Start with what is still in the ring.
+    uint32_t next = hdr[RING_SEQ] >= entries ? hdr[RING_SEQ] - entries + 1u : 0u;
+    unsigned long got = 0;
+    unsigned long lost = 0;
+    unsigned long bursts = 0;
+    uint32_t prev_k = 0;
+    uint32_t prev_t = 0;
+    int have_prev = 0;
+    uint32_t dt_min = UINT32_MAX;
+    uint32_t dt_max = 0;
+    double dt_sum = 0.0;
+    unsigned long dt_n = 0;
+    double period = 1.0 / rate;
+    double t0 = now_s();
+    double t_next = t0;
+    int rc = 0;
+    while (!watch_stop && (count == 0 || got < count)) {
+        watch_sleep_until(t_next);
+        if (watch_stop) {
+            break;
+        }
+        t_next += period;
+        if (now_s() > t_next) {
+            t_next = now_s();
+        }
+
+        uint32_t seq = 0;
+        uint32_t seq2 = 0;
+        if ((rc = read_dmem(fd, addr + RING_SEQ, 1, &seq)) != 0) {
+            break;
+        }
+        if (seq == next) {
+            continue;
+        }
+        uint32_t first = next;
+        if (seq - first >= entries) {
+            first = seq - entries + 1u;
+        }
+        const uint32_t n = seq - first;
+        const uint32_t s0 = first & (entries - 1u);
+        const uint32_t n0 = (n < entries - s0) ? n : entries - s0;
+        rc = read_dmem(fd, addr + RING_HDR + s0 * words, n0 * words, buf);
+        if (rc == 0 && n > n0) {
+            rc = read_dmem(fd, addr + RING_HDR, (n - n0) * words, buf + n0 * words);
+        }
+        if (rc == 0) {
+            rc = read_dmem(fd, addr + RING_SEQ, 1, &seq2);
+        }
+        if (rc != 0) {
+            break;
+        }
+
+        unsigned long kept = 0;
+        unsigned long dropped = first - next;
+        for (uint32_t i = 0; i < n && (count == 0 || got < count); i++) {
+            const uint32_t k = first + i;
+            const uint32_t *e = buf + i * words;
+            if (seq2 - k >= entries || e[0] != k) {
+                dropped++;
+                continue;
+            }
+            if (have_prev && k == prev_k + 1u) {
+                const uint32_t dt = e[1] - prev_t;
+                dt_min = dt < dt_min ? dt : dt_min;
+                dt_max = dt > dt_max ? dt : dt_max;
+                dt_sum += dt;
+                dt_n++;
+            }
+            have_prev = 1;
+            prev_k = k;
+            prev_t = e[1];
+            if (log && drain_log_entry(log, csv, e, words) != 0) {
+                perror(log_path);
+                rc = -1;
+                break;
+            }
+            if (prof && prof_add(prof, e[2]) != 0) {
+                rc = -1;
+                break;
+            }
+            if (!log && !prof) {
+                printf("seq %u t %u:", e[0], e[1]);
+                for (uint32_t j = 2; j < words; j++) {
+                    printf(" 0x%08x", e[j]);
+                }
+                printf("\n");
+            }
+            kept++;
+            got++;
+        }
+        if (rc != 0) {
+            break;
+        }
+        lost += dropped;
+        bursts++;
+        if (log || prof) {
+            printf("[%9.3f] seq %u..%u: %lu entries, %lu lost\n", now_s() - t0, first, seq - 1u, kept,
+                   dropped);
+        }
+        fflush(stdout);
+        next = seq;
+    }
+
+    printf("%lu entries in %lu bursts, %lu lost\n", got, bursts, lost);
+    if (dt_n > 0) {
+        // Sample intervals from the device timestamps (mtime, one tick per clk).
+        double us = 1e6 / clk_freq;
+        printf("interval min/mean/max %u/%.1f/%u ticks (%.1f/%.1f/%.1f us), jitter %u ticks\n",
+               dt_min, dt_sum / dt_n, dt_max, dt_min * us, dt_sum / dt_n * us, dt_max * us,
+               dt_max - dt_min);
+    }
+    if (lost > 0) {
+        printf("note: entries were overwritten before they were read; raise -rate or the ring size\n");
+    }
+    if (log && fclose(log) != 0) {
+        perror(log_path);
+        rc = -1;
+    }
+    signal(SIGINT, SIG_DFL);
+    return rc;
+}
+
+// ---- Core control and DMEM writes ----
+
+// CTRL is idempotent, so a corrupted frame or lost response is simply resent.
+// *core gets the V2_CORE_* bits from before the request.
+static int v2_ctrl(int fd, uint32_t req, uint32_t *core) {
+    for (unsigned tries = 0; tries <= V2_MAX_RETRIES; tries++) {
+        uint32_t word = 0;
+        if (v2_send(fd, V2_OP_CTRL, 0, req, NULL, 0) != 0) {
+            return -1;
+        }
+        if (v2_recv_word(fd, V2_RESP_TIMEOUT_MS, &word) == 0 && ((word >> 4) & 15u) == V2_ACK) {
+            *core = word & (V2_CORE_HALTED | V2_CORE_IN_RESET);
+            return 0;
+        }
+        usleep(20000);
+        tcflush(fd, TCIFLUSH);
+    }
+    fprintf(stderr, "error: no answer to CTRL 0x%03x\n", req);
+    return -1;
+}
+
+// The halt takes effect once the core reaches its next fetch (after the memory
+// access in flight, if any); poll until the board reports it.
+static int v2_halt(int fd) {
+    uint32_t core = 0;
+    if (v2_ctrl(fd, V2_CTRL_HALT, &core) != 0) {
+        return -1;
+    }
+    double t_end = now_s() + V2_HALT_TIMEOUT_MS / 1000.0;
+    while (!(core & (V2_CORE_HALTED | V2_CORE_IN_RESET))) {
+        if (now_s() > t_end) {
+            fprintf(stderr, "error: core did not halt within %d ms\n", V2_HALT_TIMEOUT_MS);
+            return -1;
+        }
+        usleep(1000);
+        if (v2_ctrl(fd, V2_CTRL_STATUS, &core) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+struct poke {
+    uint32_t addr;
+    uint32_t value;
+    uint32_t strb;
+};
+
+// "<word>=<value>[/<strb>]"
+static int parse_poke(const char *arg, struct poke *p) {
+    char *end = NULL;
+    p->addr = (uint32_t)strtoul(arg, &end, 0);
+    if (end == arg || *end != '=') {
+        return -1;
+    }
+    const char *v = end + 1;
+    p->value = (uint32_t)strtoul(v, &end, 0);
+    if (end == v) {
+        return -1;
+    }
+    p->strb = 0xFu;
+    if (*end == '/') {
+        v = end + 1;
+        p->strb = (uint32_t)strtoul(v, &end, 0);
+        if (end == v || p->strb == 0 || p->strb > 0xFu) {
+            return -1;
+        }
+    }
+    if (*end != '\0' || p->addr >= MAX_WORDS) {
+        return -1;
+    }
+    return 0;
+}
+
+// Consecutive pokes (ascending addresses, same strobes) go out as one DWRITE.
+// Stop-and-wait: a resent frame that already landed comes back as BAD_SEQ with
+// the next seq, which counts as done.
+static int v2_poke(int fd, const struct poke *pokes, size_t npokes) {
+    uint32_t seq = 0;
+    if (v2_sync(fd, seq, V2_RESP_TIMEOUT_MS) != 0) {
+        fprintf(stderr, "error: no v2 response from the board\n");
+        return -1;
+    }
+    size_t i = 0;
+    while (i < npokes) {
+        uint32_t data[CHUNK_WORDS + 1];
+        size_t n = 0;
+        do {
+            data[n] = pokes[i + n].value;
+            n++;
+        } while (i + n < npokes && n < CHUNK_WORDS && pokes[i + n].addr == pokes[i].addr + n &&
+                 pokes[i + n].strb == pokes[i].strb);
+        data[n] = pokes[i].strb;
+        uint32_t fields = ((pokes[i].addr & 0x7FFFu) << 8) | (uint32_t)n;
+        unsigned tries = 0;
+        for (;;) {
+            uint32_t status = 0;
+            uint32_t next = 0;
+            if (tries++ > V2_MAX_RETRIES) {
+                fprintf(stderr, "error: DMEM write at 0x%04x not acknowledged\n", pokes[i].addr);
+                return -1;
+            }
+            if (v2_send(fd, V2_OP_DWRITE, seq, fields, data, n + 1) != 0) {
+                return -1;
+            }
+            if (v2_recv(fd, V2_RESP_TIMEOUT_MS, &status, &next) != 0) {
+                usleep(20000);
+                tcflush(fd, TCIFLUSH);
+                continue;
+            }
+            if (status == V2_BAD_RANGE) {
+                fprintf(stderr, "error: DMEM write at 0x%04x out of range\n", pokes[i].addr);
+                return -1;
+            }
+            if (next == ((seq + 1) & 15u)) {
+                break;
+            }
+        }
+        seq = (seq + 1) & 15u;
+        i += n;
+    }
+    return 0;
+}
+
 int main(int argc, char **argv) {
     const char *port = DEFAULT_PORT;
     const char *imem_path = DEFAULT_IMEM;
@@ -243,7 +1579,27 @@ int main(int argc, char **argv) {
     uint32_t ndata = 0;
     int do_load = 0;
     int do_read = 0;
+    const char *watch_spec = NULL;
+    int have_drain = 0;
+    uint32_t drain_addr = 0;
+    const char *prof_path = NULL;
+    struct profile prof;
+    memset(&prof, 0, sizeof(prof));
+    const char *log_path = NULL;
+    double watch_rate = 10.0;
+    int do_halt = 0;
+    int do_reset = 0;
+    int do_run = 0;
+    int do_resume = 0;
+    struct poke pokes[MAX_POKES];
+    size_t npokes = 0;
+    unsigned long watch_count = 0;
     int have_addr = 0;
+    int v2 = 0;
+    int delta = 0;
+    int window = 4;
+    uint32_t baud = BAUD_BPS;
+    uint32_t clk_freq = DEFAULT_CLK_FREQ;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-port") == 0 && i + 1 < argc) {
@@ -259,6 +1615,49 @@ int main(int argc, char **argv) {
             do_load = 1;
         } else if (strcmp(argv[i], "-read") == 0) {
             do_read = 1;
+        } else if (strcmp(argv[i], "-watch") == 0 && i + 1 < argc) {
+            watch_spec = argv[++i];
+        } else if (strcmp(argv[i], "-drain") == 0 && i + 1 < argc) {
+            drain_addr = (uint32_t)strtoul(argv[++i], NULL, 0);
+            have_drain = 1;
+        } else if (strcmp(argv[i], "-profile") == 0 && i + 1 < argc) {
+            prof_path = argv[++i];
+        } else if (strcmp(argv[i], "-rate") == 0 && i + 1 < argc) {
+            watch_rate = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "-count") == 0 && i + 1 < argc) {
+            watch_count = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-log") == 0 && i + 1 < argc) {
+            log_path = argv[++i];
+        } else if (strcmp(argv[i], "-halt") == 0) {
+            do_halt = 1;
+        } else if (strcmp(argv[i], "-reset") == 0) {
+            do_reset = 1;
+        } else if (strcmp(argv[i], "-run") == 0) {
+            do_run = 1;
+        } else if (strcmp(argv[i], "-resume") == 0) {
+            do_resume = 1;
+        } else if (strcmp(argv[i], "-poke") == 0 && i + 1 < argc) {
+            if (npokes == MAX_POKES) {
+                fprintf(stderr, "error: at most %d -poke\n", MAX_POKES);
+                return 1;
+            }
+            if (parse_poke(argv[++i], &pokes[npokes]) != 0) {
+                fprintf(stderr, "error: bad -poke '%s' (expected <word>=<value>[/<strb>])\n", argv[i]);
+                return 1;
+            }
+            npokes++;
+        } else if (strcmp(argv[i], "-v2") == 0) {
+            v2 = 1;
+        } else if (strcmp(argv[i], "-delta") == 0) {
+            v2 = 1;
+            delta = 1;
+        } else if (strcmp(argv[i], "-window") == 0 && i + 1 < argc) {
+            window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-baud") == 0 && i + 1 < argc) {
+            baud = (uint32_t)strtoul(argv[++i], NULL, 0);
+            v2 = 1;
+        } else if (strcmp(argv[i], "-clk-freq") == 0 && i + 1 < argc) {
+            clk_freq = (uint32_t)strtoul(argv[++i], NULL, 0);
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             usage(argv[0]);
             return 0;
@@ -269,7 +1668,44 @@ int main(int argc, char **argv) {
         }
     }
 
-    if (!have_addr || (do_load == do_read)) {
+    if (prof_path) {
+        uint32_t ring_word = 0;
+        int found = prof_load_elf(prof_path, &prof, &ring_word);
+        if (found < 0) {
+            return 1;
+        }
+        if (!have_drain) {
+            if (!found) {
+                fprintf(stderr, "error: no %s in %s (build with PCPROF=1) and no -drain\n", PROF_RING_SYMBOL,
+                        prof_path);
+                return 1;
+            }
+            drain_addr = ring_word;
+            have_drain = 1;
+        }
+    }
+
+    struct watch_range watch[WATCH_MAX_RANGES];
+    int nwatch = 0;
+    int do_ctrl = do_halt || do_reset || do_run || do_resume || npokes > 0;
+    if (watch_spec || have_drain) {
+        if (do_load || do_read || do_ctrl || (watch_spec && have_drain)) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (watch_spec && (nwatch = watch_parse(watch_spec, watch)) < 0) {
+            return 1;
+        }
+        if (have_drain && drain_addr + RING_HDR > MAX_WORDS) {
+            fprintf(stderr, "error: -drain word out of range (max %u words)\n", MAX_WORDS);
+            return 1;
+        }
+        if (!(watch_rate > 0.0)) {
+            fprintf(stderr, "error: -rate must be > 0\n");
+            return 1;
+        }
+    } else if ((do_load && do_read) || (!do_load && !do_read && !do_ctrl) ||
+               (do_read && !have_addr) || (do_halt && do_reset) || (do_run && do_resume)) {
         usage(argv[0]);
         return 1;
     }
@@ -279,16 +1715,49 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    if (window < 1 || window > V2_MAX_WINDOW) {
+        fprintf(stderr, "error: -window must be 1..%d\n", V2_MAX_WINDOW);
+        return 1;
+    }
+
     int fd = open_serial(port);
     if (fd < 0) {
         return 1;
     }
 
     int rc = 0;
-    if (do_load) {
+    if (do_halt || do_reset) {
+        uint32_t core = 0;
+        rc = v2_sync(fd, 0, V2_RESP_TIMEOUT_MS);
+        if (rc != 0) {
+            fprintf(stderr, "error: no v2 response from the board\n");
+        }
+        if (rc == 0) {
+            rc = v2_halt(fd);
+        }
+        if (rc == 0 && do_reset) {
+            rc = v2_ctrl(fd, V2_CTRL_RESET, &core);
+        }
+        if (rc == 0) {
+            printf("Core %s\n", do_reset ? "held in reset" : "halted");
+        } else {
+            close(fd);
+            return 1;
+        }
+    }
+
+    if (watch_spec) {
+        rc = watch_dmem(fd, watch, nwatch, watch_rate, watch_count, log_path);
+    } else if (have_drain) {
+        rc = drain_ring(fd, drain_addr, watch_rate, watch_count, log_path, clk_freq,
+                        prof_path ? &prof : NULL);
+        if (rc == 0 && prof_path) {
+            rc = prof_report(&prof);
+        }
+    } else if (do_load) {
         uint32_t *words = NULL;
         size_t count = 0;
-        if (load_imem_file(imem_path, &words, &count) != 0) {
+        if (load_image(imem_path, &addr, &words, &count) != 0) {
             close(fd);
             return 1;
         }
@@ -298,10 +1767,92 @@ int main(int argc, char **argv) {
             close(fd);
             return 1;
         }
-        printf("Loading %zu words to IMEM at word address 0x%04x\n", count, addr);
-        rc = send_load(fd, addr, words, count);
+        uint32_t line_baud = BAUD_BPS;
+        if (v2 && baud != BAUD_BPS) {
+            rc = v2_switch_baud(fd, baud, BAUD_BPS, clk_freq, 0);
+            if (rc < 0) {
+                free(words);
+                close(fd);
+                return 1;
+            }
+            line_baud = (rc == 0) ? baud : BAUD_BPS;
+            rc = 0;
+        }
+        printf("Loading %zu words to IMEM at word address 0x%04x%s\n", count, addr,
+               v2 ? " (protocol v2)" : "");
+        size_t bytes = 4 * (count + (count + CHUNK_WORDS - 1) / CHUNK_WORDS);
+        unsigned resent = 0;
+        double t0 = now_s();
+        if (v2) {
+            size_t chunks[MAX_WORDS / CHUNK_WORDS + 1];
+            size_t nchunks = (count + CHUNK_WORDS - 1) / CHUNK_WORDS;
+            for (size_t c = 0; c < nchunks; c++) {
+                chunks[c] = c;
+            }
+            rc = v2_sync(fd, 0, V2_RESP_TIMEOUT_MS);
+            if (rc != 0) {
+                fprintf(stderr, "error: no v2 response from the board (bitstream without protocol v2?)\n");
+            }
+            if (rc == 0 && delta) {
+                size_t total = nchunks;
+                rc = v2_delta(fd, addr, words, count, chunks, &nchunks);
+                if (rc == 0) {
+                    printf("Delta: %zu of %zu chunks changed\n", nchunks, total);
+                }
+            }
+            if (rc == 0) {
+                rc = v2_load(fd, addr, words, count, chunks, nchunks, window, &bytes, &resent);
+            }
+            uint32_t crc = 0;
+            if (rc == 0 && (rc = v2_hash(fd, addr, 1, (uint32_t)count, &crc)) == 0 &&
+                crc != crc32_words(words, count)) {
+                fprintf(stderr, "error: IMEM verify failed (CRC %08x, expected %08x)\n",
+                        crc, crc32_words(words, count));
+                rc = -1;
+            }
+        } else {
+            rc = send_load(fd, addr, words, count);
+            if (rc == 0) {
+                rc = tcdrain(fd);
+            }
+            if (rc != 0) {
+                perror("write");
+            }
+        }
+        double dt = now_s() - t0;
         free(words);
-    } else {
+        if (rc == 0) {
+            // 8N1: 10 bit times per byte on the wire.
+            double rate = dt > 0.0 ? (double)bytes / dt : 0.0;
+            double line = line_baud / 10.0;
+            printf("Sent %zu bytes in %.3f s: %.0f B/s (%.1f%% of the %.0f B/s line rate)",
+                   bytes, dt, rate, 100.0 * rate / line, line);
+            if (v2) {
+                printf(", %u chunks resent", resent);
+            }
+            printf("\n");
+        }
+        if (line_baud != BAUD_BPS && v2_switch_baud(fd, BAUD_BPS, line_baud, clk_freq, 0) < 0) {
+            rc = -1;
+        }
+    }
+
+    if (rc == 0 && npokes > 0) {
+        rc = v2_poke(fd, pokes, npokes);
+        if (rc == 0) {
+            printf("Wrote %zu DMEM word(s)\n", npokes);
+        }
+    }
+
+    if (rc == 0 && (do_run || do_resume)) {
+        uint32_t core = 0;
+        rc = v2_ctrl(fd, do_run ? V2_CTRL_RUN : V2_CTRL_RESUME, &core);
+        if (rc == 0) {
+            printf("Core %s\n", do_run ? "running" : "resumed");
+        }
+    }
+
+    if (rc == 0 && do_read) {
         if (addr + ndata > MAX_WORDS) {
             fprintf(stderr, "error: addr+ndata out of range (max %u words)\n", MAX_WORDS);
             close(fd);
@@ -0,0 +1,181 @@
+// roc_iss: run a ROC_RV32 program image without the RTL.
+//
+// Honors the tb_ROC_RV32_program stop protocol: the run ends on a full-word
+// store of STOP_WDATA (default 0xDEADBEEF) to dmem[STOP_ADDR], fails on a store
+// of 0xBAD0xxxx, and times out after MAX_CYCLES.
+#include "roc_iss.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void usage(const char *prog) {
+    std::fprintf(stderr,
+                 "Usage:\n"
+                 "  %s [-file <imem.dat|main.elf|main.bin>] [+STOP_ADDR=<word>] [+STOP_WDATA=<hex>]\n"
+                 "     [+MAX_CYCLES=<n>] [-clk-freq <hz>] [-mmio-lat <cycles>] [-gpio-irq-period <cycles>]\n"
+                 "     [-spi-miso <byte>] [-rv32m] [-early-irq] [-rv32c] [-pipeline] [-wbuf-depth <n>] [-xmem]\n"
+                 "     [+XMEM=<file>] [-icache-ways <1|2>] [-dcache-ways <1|2>] [-harts <1|2>] [-dump <words>] [+TRACE=<file>]\n"
+                 "\n"
+                 "Notes:\n"
+                 "  Defaults match tb_ROC_RV32_program (50 MHz, 115200 baud, 5000000 cycles).\n"
+                 "  -gpio-irq-period 0 disables the pin_gpio[0] interrupt stimulus.\n"
+                 "  -rv32m decodes MUL/DIV/REM like a core built with CPU_RV32M=1.\n"
+                 "  -early-irq also takes interrupts in FETCH, like a core built with CPU_EARLY_IRQ=1.\n"
+                 "  -rv32c runs compressed instructions, like a core built with CPU_RV32C=1.\n"
+                 "  -pipeline counts cycles as the five-stage core (CPU_PIPELINE=1) does; the default\n"
+                 "  is the multi-cycle FSM. Results are the same, only the timing changes.\n"
+                 "  -wbuf-depth sets the posted MMIO write buffer depth (soc MMIO_WBUF_DEPTH, 0 = off).\n"
+                 "  -xmem maps the cached external memory at 0x80000000 (soc XMEM_EN=1); +XMEM loads it\n"
+                 "  from a $readmemh file, an ELF given with -file fills it from its XMEM segments.\n"
+                 "  -harts 2 adds the second hart (soc N_HARTS=2): same image, own DMEM, MSIP from the\n"
+                 "  mailbox at 0x6000; the run still ends on hart 0's stop store. Not with -xmem.\n"
+                 "  +TRACE writes the retirement trace read by tools/roc_prof, as the testbenches do.\n",
+                 prog);
+}
+
+int main(int argc, char **argv) {
+    roc::SocConfig cfg;
+    roc::StopConfig stop;
+    const char *image = "sw/imem.dat";
+    const char *xmem_image = nullptr;
+    const char *trace_path = nullptr;
+    unsigned dump_words = 10;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (std::strncmp(a, "+STOP_ADDR=", 11) == 0) {
+            stop.stop_addr_word = (uint32_t)std::strtoul(a + 11, nullptr, 10);
+        } else if (std::strncmp(a, "+STOP_WDATA=", 12) == 0) {
+            stop.stop_wdata = (uint32_t)std::strtoul(a + 12, nullptr, 16);
+        } else if (std::strncmp(a, "+MAX_CYCLES=", 12) == 0) {
+            stop.max_cycles = std::strtoull(a + 12, nullptr, 10);
+        } else if (std::strncmp(a, "+XMEM=", 6) == 0) {
+            xmem_image = a + 6;
+        } else if (std::strncmp(a, "+TRACE=", 7) == 0) {
+            trace_path = a + 7;
+        } else if (std::strcmp(a, "-file") == 0 && i + 1 < argc) {
+            image = argv[++i];
+        } else if (std::strcmp(a, "-clk-freq") == 0 && i + 1 < argc) {
+            cfg.clk_freq = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(a, "-mmio-lat") == 0 && i + 1 < argc) {
+            cfg.mmio_latency = (unsigned)std::strtoul(argv[++i], nullptr, 0);
+        } else if (std::strcmp(a, "-gpio-irq-period") == 0 && i + 1 < argc) {
+            cfg.gpio_irq_period = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(a, "-spi-miso") == 0 && i + 1 < argc) {
+            cfg.spi_miso = (uint8_t)std::strtoul(argv[++i], nullptr, 0);
+        } else if (std::strcmp(a, "-rv32m") == 0) {
+            cfg.rv32m = true;
+        } else if (std::strcmp(a, "-early-irq") == 0) {
+            cfg.early_irq = true;
+        } else if (std::strcmp(a, "-rv32c") == 0) {
+            cfg.rv32c = true;
+        } else if (std::strcmp(a, "-pipeline") == 0) {
+            cfg.pipeline = true;
+        } else if (std::strcmp(a, "-wbuf-depth") == 0 && i + 1 < argc) {
+            cfg.wbuf_depth = (unsigned)std::strtoul(argv[++i], nullptr, 0);
+        } else if (std::strcmp(a, "-xmem") == 0) {
+            cfg.xmem = true;
+        } else if (std::strcmp(a, "-icache-ways") == 0 && i + 1 < argc) {
+            cfg.icache_ways = (unsigned)std::strtoul(argv[++i], nullptr, 0);
+        } else if (std::strcmp(a, "-dcache-ways") == 0 && i + 1 < argc) {
+            cfg.dcache_ways = (unsigned)std::strtoul(argv[++i], nullptr, 0);
+        } else if (std::strcmp(a, "-harts") == 0 && i + 1 < argc) {
+            cfg.harts = (unsigned)std::strtoul(argv[++i], nullptr, 0);
+        } else if (std::strcmp(a, "-dump") == 0 && i + 1 < argc) {
+            dump_words = (unsigned)std::strtoul(argv[++i], nullptr, 0);
+        } else if (std::strcmp(a, "-h") == 0 || std::strcmp(a, "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else if (a[0] == '+') {
+            // Unknown plusargs are ignored, as in the simulator.
+        } else {
+            std::fprintf(stderr, "unknown argument: %s\n", a);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (cfg.harts < 1 || cfg.harts > 2 || (cfg.harts > 1 && cfg.xmem)) {
+        std::fprintf(stderr, "error: -harts takes 1 or 2, and hart 1 has no XMEM (no -xmem with -harts 2)\n");
+        return 1;
+    }
+
+    roc::Soc soc(cfg);
+    if (!soc.load_image(image)) {
+        std::fprintf(stderr, "error: %s\n", soc.error().c_str());
+        return 1;
+    }
+    std::printf("[ISS] Loading IMEM from: %s\n", image);
+    if (xmem_image) {
+        if (!soc.load_xmem(xmem_image)) {
+            std::fprintf(stderr, "error: %s\n", soc.error().c_str());
+            return 1;
+        }
+        std::printf("[XMEM] Loading from: %s\n", xmem_image);
+    }
+    if (trace_path) {
+        if (!soc.open_trace(trace_path)) {
+            std::fprintf(stderr, "error: %s\n", soc.error().c_str());
+            return 1;
+        }
+        std::printf("[TRACE] Writing to: %s\n", trace_path);
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const roc::RunResult res = soc.run(stop);
+    const auto t1 = std::chrono::steady_clock::now();
+    std::fflush(stdout);
+
+    int rc = 1;
+    switch (res) {
+    case roc::RunResult::Pass:
+        std::printf("PASS: SUCCESS signature observed at dmem[word %u]: wdata=0x%08x\n",
+                    stop.stop_addr_word, soc.last_stop_wdata());
+        rc = 0;
+        break;
+    case roc::RunResult::Fail:
+        std::printf("FAIL signature observed at dmem[word %u]: wdata=0x%08x (code=0x%04x)\n",
+                    stop.stop_addr_word, soc.last_stop_wdata(), soc.last_stop_wdata() & 0xFFFFu);
+        break;
+    case roc::RunResult::Timeout:
+        std::printf("Timeout: no stop store observed within %llu cycles. Default is store 0x%08x to dmem[word %u].\n",
+                    (unsigned long long)stop.max_cycles, stop.stop_wdata, stop.stop_addr_word);
+        break;
+    case roc::RunResult::BusError:
+        std::printf("Bus error: %s\n", soc.error().c_str());
+        break;
+    }
+
+    const double wall = std::chrono::duration<double>(t1 - t0).count();
+    std::printf("---- FINAL SNAPSHOT ----\n");
+    std::printf("cycles=%llu pc_output=0x%08x ir=0x%08x\n",
+                (unsigned long long)soc.cycles(), soc.pc(), soc.ir());
+    std::printf("instret=%llu CPI=%.3f wall=%.3fs MIPS=%.1f\n",
+                (unsigned long long)soc.instret(),
+                soc.instret() ? (double)soc.cycles() / (double)soc.instret() : 0.0,
+                wall, wall > 0.0 ? (double)soc.instret() / wall / 1e6 : 0.0);
+    if (cfg.harts > 1) {
+        std::printf("hart1: instret=%llu\n", (unsigned long long)soc.hart1_instret());
+    }
+    if (cfg.xmem) {
+        const roc::CacheModel &ic = soc.icache_stats();
+        const roc::CacheModel &dc = soc.dcache_stats();
+        std::printf("icache: hits=%llu misses=%llu  dcache: hits=%llu misses=%llu  (ways %u/%u, %u sets x %u words, xmem lat r%u/w%u)\n",
+                    (unsigned long long)ic.hits, (unsigned long long)ic.misses,
+                    (unsigned long long)dc.hits, (unsigned long long)dc.misses,
+                    cfg.icache_ways, cfg.dcache_ways, cfg.cache_sets, cfg.cache_line_words,
+                    cfg.xmem_read_latency, cfg.xmem_write_latency);
+    }
+    std::printf("------------------------\n");
+
+    if (dump_words) {
+        std::printf("---- DMEM DUMP (word-addressed) ----\n");
+        for (unsigned i = 0; i < dump_words; i++) {
+            std::printf("dmem[%u]=0x%08x\n", i, soc.dmem_word(i));
+        }
+        std::printf("----------------------------------\n");
+    }
+    return rc;
+}
@@ -0,0 +1,364 @@
+// Functional instruction-set simulator for the ROC_RV32 SoC.
+//
+// Models the RV32I+Zicsr subset (plus RV32M and RV32C when enabled, and the AMO*.W the
+// core always decodes) implemented by ROC_RV32.sv / rv32_mtrap_csr.sv and the
+// lsu_interconnect memory map used by soc.sv:
+//   0x0000_0000  MMIO (GPIO, 7-seg, UART, CLINT, SPI, DMA, mailbox) behind the AXI-Lite crossbar
+//   0x1000_0000  DMEM
+//   0x2000_0000  IMEM read-only data window
+//   0x8000_0000  XMEM behind the I/D caches (soc XMEM_EN, -xmem)
+//
+// Cycle counts follow the multi-cycle FSM in control_unit.sv (FETCH/DECODE/EXEC/MEM/WB),
+// so mtime, UART pacing and the TB stop protocol see roughly the same timing as the RTL.
+// With harts = 2 (soc N_HARTS) the second hart runs the same image with its own DMEM,
+// interleaved with hart 0 in short quanta of its own cycle count (see Soc::run).
+#pragma once
+
+#include "../roc_trace.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace roc {
+
+struct SocConfig {
+    unsigned addr_width = 11;            // soc.sv ADDR_WIDTH (words = 2**addr_width)
+    uint32_t dmem_base = 0x10000000u;
+    uint32_t imem_base = 0x20000000u;    // LSU read-only IMEM window
+    uint64_t clk_freq = 50000000u;       // tb_ROC_RV32_program CLK_FREQ
+    uint32_t baud_rate = 115200u;
+    unsigned uart_tx_depth = 16;         // axi_uart TX FIFO depth (status bit 3 = full)
+    unsigned mmio_latency = 8;           // extra cycles per AXI-Lite round trip
+    uint64_t gpio_irq_period = 100000;   // TB stimulus on pin_gpio[0]; 0 disables it
+    unsigned gpio_irq_width = 10;
+    uint8_t spi_miso = 0x00;             // byte returned for every SPI RX slot
+    bool rv32m = false;                  // ROC_RV32 RV32M parameter (soc CPU_RV32M)
+    bool early_irq = false;              // ROC_RV32 EARLY_IRQ (soc CPU_EARLY_IRQ): traps in FETCH too
+    bool rv32c = false;                  // ROC_RV32 RV32C (soc CPU_RV32C): 16-bit instructions
+    bool pipeline = false;               // soc CPU_PIPELINE: rv32_pipeline.sv stage timing
+    unsigned wbuf_depth = 4;             // soc MMIO_WBUF_DEPTH (0: MMIO stores wait for BRESP)
+    unsigned harts = 1;                  // soc N_HARTS (1 or 2)
+    // soc XMEM_EN and the l1_cache / axi4_sram parameters it uses
+    bool xmem = false;
+    uint32_t xmem_base = 0x80000000u;
+    unsigned xmem_addr_width = 16;       // XMEM_ADDR_WIDTH (words = 2**xmem_addr_width)
+    unsigned xmem_read_latency = 8;      // XMEM_READ_LATENCY
+    unsigned xmem_write_latency = 4;     // XMEM_WRITE_LATENCY
+    unsigned icache_ways = 1;            // ICACHE_WAYS (1 or 2)
+    unsigned dcache_ways = 1;            // DCACHE_WAYS (1 or 2)
+    unsigned cache_sets = 64;            // CACHE_SETS
+    unsigned cache_line_words = 8;       // CACHE_LINE_WORDS
+};
+
+// l1_cache.sv tags (no data: XMEM is read directly, write-through keeps it
+// current). Counts lookups the way the RTL stat_hits/stat_misses do.
+class CacheModel {
+public:
+    CacheModel(unsigned ways, unsigned sets, unsigned line_words);
+    // true on a hit; a miss allocates the line (invalid way first, else LRU).
+    // Stores never allocate (write-through, no write-allocate), so they skip the model.
+    bool read(uint32_t addr);
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+private:
+    unsigned ways_;
+    unsigned sets_;
+    unsigned line_shift_;
+    std::vector<uint32_t> tags_;     // [set * ways + way], line address + 1 (0 = invalid)
+    std::vector<uint8_t> lru_;       // way to replace next
+};
+
+// Stop protocol shared with tb_ROC_RV32_program (+STOP_ADDR/+STOP_WDATA/+MAX_CYCLES).
+struct StopConfig {
+    uint32_t stop_addr_word = 0;
+    uint32_t stop_wdata = 0xDEADBEEFu;
+    uint64_t max_cycles = 5000000u;
+};
+
+enum class RunResult { Pass, Fail, Timeout, BusError };
+
+// Predecoded instruction. One entry per IMEM half-word (the instruction starting
+// there), built once at load time (IMEM is read-only from the core, so the cache
+// never goes stale). Without RV32C both halves of a word decode the whole word,
+// as the word-addressed fetch ignores pc[1].
+enum class Op : uint8_t {
+    LUI, AUIPC, JAL, JALR,
+    BEQ, BNE, BLT, BGE, BLTU, BGEU,
+    LB, LH, LW, LBU, LHU,
+    SB, SH, SW, SNONE,
+    ADDI, SLTI, SLTIU, XORI, ORI, ANDI, SLLI, SRLI, SRAI,
+    ADD, SUB, SLL, SLT, SLTU, XOR, SRL, SRA, OR, AND,
+    MUL, MULH, MULHSU, MULHU, DIV, DIVU, REM, REMU,
+    CSRRW, CSRRS, CSRRC, CSRRWI, CSRRSI, CSRRCI,
+    AMO,                                 // imm = funct5
+    MRET, WFI, FENCE, NOP
+};
+
+struct Insn {
+    Op       op;
+    uint8_t  rd;
+    uint8_t  rs1;
+    uint8_t  rs2;
+    int32_t  imm;
+    uint16_t csr;
+    uint8_t  cycles;     // FSM cycles excluding MMIO wait states
+    uint8_t  len;        // 4, or 2 for a compressed instruction
+    uint8_t  deps;       // INSN_RS1 | INSN_RS2 | INSN_SYSTEM (rv32_pipeline.sv hazards)
+};
+
+constexpr uint8_t INSN_RS1 = 1u << 0;     // id_uses_rs1
+constexpr uint8_t INSN_RS2 = 1u << 1;     // id_uses_rs2
+constexpr uint8_t INSN_SYSTEM = 1u << 2;  // waits for an empty pipeline
+
+Insn decode(uint32_t ir, bool rv32m = false);
+// RV32C: the 32-bit instruction a 16-bit one stands for (rv32c_expand.sv), 0 if reserved.
+uint32_t expand_c(uint32_t ic);
+
+class Soc {
+public:
+    explicit Soc(const SocConfig &cfg);
+    ~Soc();
+    Soc(const Soc &) = delete;
+    Soc &operator=(const Soc &) = delete;
+
+    // Program image loaders. The format is picked from the file contents:
+    // ELF (PT_LOAD segments whose LMA falls in IMEM or XMEM), raw .bin, or text imem.dat.
+    bool load_image(const std::string &path);
+    void load_words(const std::vector<uint32_t> &words, uint32_t word_addr = 0);
+    // XMEM contents from a $readmemh-style file (+XMEM=<file>, as axi4_sram).
+    bool load_xmem(const std::string &path);
+
+    // Retirement trace (+TRACE=<file>, tools/roc_trace.h), written by run().
+    bool open_trace(const std::string &path);
+
+    RunResult run(const StopConfig &stop);
+
+    // Hart 0, where run() always returns.
+    uint64_t cycles() const { return cycles_; }
+    uint64_t instret() const { return instret_; }
+    uint64_t hart1_instret() const { return other_.instret; }
+    uint32_t pc() const { return pc_; }
+    uint32_t ir() const { return imem_[(pc_ >> 2) & imem_mask_]; }
+    uint32_t dmem_word(uint32_t idx) const { return dmem_[idx & dmem_mask_]; }
+    uint32_t last_stop_wdata() const { return last_stop_wdata_; }
+    const std::string &error() const { return error_; }
+    const CacheModel &icache_stats() const { return icache_model_; }
+    const CacheModel &dcache_stats() const { return dcache_model_; }
+
+private:
+    // One hart up to cycle `until`; Timeout when it gets there.
+    RunResult run_hart(const StopConfig &stop, uint64_t until);
+    void swap_hart();
+
+    // Core
+    void predecode();
+    Insn decode_half(const std::vector<uint32_t> &mem, size_t h) const;
+    void take_trap(uint32_t mcause, uint32_t next_pc);
+    uint32_t irq_cause(uint32_t pend) const;
+    uint32_t ext_claim() const;
+    uint32_t csr_read(uint16_t addr) const;
+    void csr_write(uint16_t addr, uint32_t value);
+
+    // XMEM: I-cache lookup (refill cycles on a miss) and predecoded instruction
+    const Insn &xmem_fetch(uint32_t pc);
+    void xmem_redecode(uint32_t idx);
+
+    // LSU / memory map
+    bool load(uint32_t addr, uint32_t &data);
+    bool store(uint32_t addr, uint32_t data, uint32_t strb);
+
+    // MMIO slaves
+    uint32_t mmio_read(uint32_t addr);
+    bool mmio_write(uint32_t addr, uint32_t data, uint32_t strb);
+    void wbuf_wait(bool all, uint32_t slave);
+    void update_irq_lines();
+    void dma_advance();
+    void dma_step();
+    void dma_stop(bool err);
+    void wfi_fast_forward(uint64_t limit);
+    uint64_t counter(unsigned idx) const;
+    void hpm_add(unsigned n, uint64_t delta) {
+        if (!(mcountinhibit_ & (1u << n))) hpm_[n - 3] += delta;
+    }
+    // mhpmcounter6 event: cycles an LSU request waits for an AXI slave or XMEM.
+    void lsu_stall(uint64_t n) {
+        lsu_wait_ += n;
+        hpm_add(6, n);
+    }
+    void trace_retire(uint32_t pc, const Insn &d, uint32_t mem_addr, uint32_t mem_data);
+    uint32_t insn_word(uint32_t pc, unsigned len) const;
+    unsigned uart_tx_level() const;
+
+    SocConfig cfg_;
+    uint32_t imem_mask_;
+    uint32_t dmem_mask_;
+    uint32_t mem_bytes_;
+
+    std::vector<uint32_t> imem_;
+    std::vector<uint32_t> dmem_;
+    std::vector<Insn> icache_;          // per half-word
+
+    // XMEM (empty unless cfg.xmem) and its predecoded copy, patched on stores
+    uint32_t xmem_bytes_ = 0;
+    std::vector<uint32_t> xmem_;
+    std::vector<Insn> xdecode_;
+    CacheModel icache_model_;
+    CacheModel dcache_model_;
+    // l1_cache + axi4_sram round trips (see l1_cache.sv): a line refill from the
+    // miss to the retried hit, and a write-through store from request to wr_ready.
+    uint64_t refill_cycles_;
+    uint64_t write_cycles_;
+
+    uint32_t x_[32] = {};
+    uint32_t pc_ = 0;
+    uint64_t cycles_ = 0;
+    uint64_t instret_ = 0;
+    uint32_t hart_id_ = 0;
+    // RV32C: the next instruction is in the word still on imem (no FETCH cycle).
+    bool hold_ = false;
+    // In S_FETCH after WFI with no interrupt line up yet (the quantum ended first).
+    bool asleep_ = false;
+    // cfg.pipeline: the cycle the next instruction is valid in ID, and the last
+    // EX / MEM cycles of the previous one (rv32_pipeline.sv ex_to_mem, mem_done).
+    struct PipeState {
+        uint64_t id = 0;
+        uint64_t ex = 0;
+        uint64_t mem = 0;
+        uint8_t load_rd = 0;     // previous instruction is a load/AMO writing this register
+        bool system = false;     // previous instruction is SYSTEM (sys_hazard)
+    };
+    PipeState pipe_;
+
+    // rv32_mtrap_csr state
+    uint32_t mstatus_ = 0;
+    uint32_t mie_ = 0;
+    uint32_t mtvec_ = 0x00001000u;
+    uint32_t mepc_ = 0;
+    uint32_t mcause_ = 0;
+    uint32_t mip_ = 0;
+    // external_irq (soc N_EXT_IRQ = 8): bit 0 GPIO, bit 1 UART TX room, bit 2 DMA
+    static constexpr uint32_t EXT_INT_MASK = 0xFFu;
+    uint32_t ext_int_ = 0;
+    uint32_t ext_int_en_ = 1u;             // CSR 0xF03, gates ext_int_ into MEIP
+    uint32_t ext_int_prio_ = 0;            // CSR 0xF04, 2 bits per line
+    bool buserr_pend_ = false;
+    uint32_t buserr_addr_ = 0;
+
+    // Counters. mcycle/minstret are kept as offsets from cycles_/instret_
+    // (frozen values while inhibited); mhpmcounter3..8 count
+    // loads, stores, taken branches, LSU stall cycles, WFI cycles, traps.
+    static constexpr unsigned N_HPM = 6;
+    uint32_t mcountinhibit_ = 0;
+    uint64_t mcycle_off_ = 0;
+    uint64_t minstret_off_ = 0;
+    uint64_t hpm_[N_HPM] = {};
+    uint64_t lsu_wait_ = 0;              // mhpmcounter6 events, never inhibited
+
+    // Retirement trace: LSU wait at the previous record, and a trap taken since it
+    FILE *trace_ = nullptr;
+    uint64_t trace_wait_ = 0;
+    bool trace_intr_ = false;
+
+    // lsu_interconnect posted writes: slave (addr >> 12) and the cycle its BRESP
+    // returns. The AXI write channel drains them one at a time, in order.
+    struct PostedWrite {
+        uint32_t slave;
+        uint64_t done;
+    };
+    std::deque<PostedWrite> wbuf_;
+
+    // Next cycle at which an interrupt line may change level.
+    uint64_t next_event_ = 0;
+
+    // The hart not running: the members above that are per hart (registers, pc,
+    // its own cycle count, CSRs, counters, posted writes, DMEM) are swapped with
+    // these by swap_hart(). IMEM and its predecode are shared, as both harts'
+    // IMEMs hold the same image. Hart 1 has no trace, timer or external lines.
+    struct HartContext {
+        uint32_t x[32] = {};
+        uint32_t pc = 0;
+        uint64_t cycles = 0;
+        uint64_t instret = 0;
+        uint32_t hart_id = 1;
+        bool hold = false;
+        bool asleep = false;
+        PipeState pipe;
+        uint32_t mstatus = 0;
+        uint32_t mie = 0;
+        uint32_t mtvec = 0x00001000u;
+        uint32_t mepc = 0;
+        uint32_t mcause = 0;
+        uint32_t mip = 0;
+        uint32_t ext_int_en = 1u;
+        uint32_t ext_int_prio = 0;
+        bool buserr_pend = false;
+        uint32_t buserr_addr = 0;
+        uint32_t mcountinhibit = 0;
+        uint64_t mcycle_off = 0;
+        uint64_t minstret_off = 0;
+        uint64_t hpm[N_HPM] = {};
+        uint64_t lsu_wait = 0;
+        FILE *trace = nullptr;
+        uint64_t trace_wait = 0;
+        bool trace_intr = false;
+        std::deque<PostedWrite> wbuf;
+        uint64_t next_event = 0;
+        std::vector<uint32_t> dmem;
+    };
+    HartContext other_;
+
+    // CLINT
+    uint64_t mtimecmp_ = ~0ull;
+
+    // UART (TX only; bytes go to stdout as the TB print handler does)
+    uint64_t uart_byte_cycles_;
+    uint64_t uart_tx_done_ = 0;
+
+    // SPI
+    uint32_t spi_cfg_ = 0;
+    uint32_t spi_delays_ = 0;
+    uint32_t spi_clk_div_ = 1;
+    uint64_t spi_busy_until_ = 0;
+    unsigned spi_tx_count_ = 0;
+    unsigned spi_rx_count_ = 0;
+
+    // DMA (axi_dma): registers, the descriptor being run and the cycle of the
+    // engine's next step (a descriptor fetch, a status poll or one element).
+    enum class DmaPhase : uint8_t { Fetch, Poll, Elem };
+    bool dma_busy_ = false;
+    bool dma_done_ = false;
+    bool dma_err_ = false;
+    bool dma_irq_en_ = false;
+    bool dma_abort_ = false;
+    DmaPhase dma_phase_ = DmaPhase::Fetch;
+    uint32_t dma_desc_ = 0;
+    uint32_t dma_cur_ = 0;
+    uint32_t dma_count_ = 0;
+    uint32_t dma_periph_ = 0;
+    uint32_t dma_mem_ = 0;
+    uint32_t dma_ctrl_ = 0;
+    uint32_t dma_next_desc_ = 0;
+    uint32_t dma_left_ = 0;
+    uint64_t dma_next_ = 0;
+
+    // Mailbox (axi_mailbox): MSIP bit per hart, shared RAM
+    static constexpr unsigned MBOX_RAM_WORDS = 512;
+    uint32_t mbox_msip_ = 0;
+    std::vector<uint32_t> mbox_ram_;
+
+    // 7-seg / GPIO
+    uint32_t seg7_data_ = 0;
+    uint32_t seg7_dp_ = 0;
+    uint32_t gpio_regs_[16] = {};
+    bool gpio_irq_ = false;
+
+    uint32_t last_stop_wdata_ = 0;
+    std::string error_;
+};
+
+} // namespace roc
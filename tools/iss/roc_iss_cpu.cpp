@@ -0,0 +1,963 @@
+// ROC_RV32 core model: predecode + dispatch loop + machine-mode trap/CSR unit.
+#include "roc_iss.h"
+
+#include <algorithm>
+
+namespace roc {
+
+namespace {
+
+constexpr uint32_t OPC_OP_IMM = 0x13;
+constexpr uint32_t OPC_OP     = 0x33;
+constexpr uint32_t OPC_LOAD   = 0x03;
+constexpr uint32_t OPC_STORE  = 0x23;
+constexpr uint32_t OPC_BRANCH = 0x63;
+constexpr uint32_t OPC_JALR   = 0x67;
+constexpr uint32_t OPC_JAL    = 0x6F;
+constexpr uint32_t OPC_AUIPC  = 0x17;
+constexpr uint32_t OPC_LUI    = 0x37;
+constexpr uint32_t OPC_SYSTEM = 0x73;
+constexpr uint32_t OPC_MISC_MEM = 0x0F;
+constexpr uint32_t OPC_AMO    = 0x2F;
+
+constexpr uint32_t INSN_MRET = 0x30200073u;
+
+constexpr uint16_t CSR_MSTATUS = 0x300;
+constexpr uint16_t CSR_MIE     = 0x304;
+constexpr uint16_t CSR_MTVEC   = 0x305;
+constexpr uint16_t CSR_MEPC    = 0x341;
+constexpr uint16_t CSR_MCAUSE  = 0x342;
+constexpr uint16_t CSR_MIP     = 0x344;
+constexpr uint16_t CSR_EXT_INT = 0xF00;
+constexpr uint16_t CSR_MBUSERR = 0xF01;
+constexpr uint16_t CSR_MBUSERR_ADDR = 0xF02;
+constexpr uint16_t CSR_EXT_INT_EN = 0xF03;
+constexpr uint16_t CSR_EXT_INT_PRIO = 0xF04;
+constexpr uint16_t CSR_EXT_INT_CLAIM = 0xF05;
+constexpr uint16_t CSR_MCOUNTINHIBIT = 0x320;
+constexpr uint16_t CSR_MHARTID = 0xF14;
+
+constexpr uint32_t MCOUNTINHIBIT_CY = 1u << 0;
+constexpr uint32_t MCOUNTINHIBIT_IR = 1u << 2;
+constexpr uint32_t MCOUNTINHIBIT_MASK = 0x1FDu;
+
+constexpr uint32_t MSTATUS_MIE  = 1u << 3;
+constexpr uint32_t MSTATUS_MPIE = 1u << 7;
+constexpr uint32_t MIP_MSIP = 1u << 3;
+constexpr uint32_t MIP_MTIP = 1u << 7;
+constexpr uint32_t MIP_MEIP = 1u << 11;
+constexpr uint32_t MIP_BUSERR = 1u << 16;
+
+constexpr uint32_t MCAUSE_MSI = 0x80000003u;
+constexpr uint32_t MCAUSE_MTI = 0x80000007u;
+constexpr uint32_t MCAUSE_MEI = 0x8000000Bu;
+constexpr uint32_t MCAUSE_BUSERR = 0x80000010u;
+constexpr uint32_t MCAUSE_EXT_BASE = 24;    // vectored mtvec: line n is cause 24 + n
+constexpr uint32_t MTVEC_VECTORED = 1u;
+
+// FSM cycles per instruction class (see control_unit.sv).
+constexpr uint8_t CYC_ALU    = 4;   // FETCH DECODE EXEC WB
+constexpr uint8_t CYC_BRANCH = 3;   // FETCH DECODE EXEC
+constexpr uint8_t CYC_LOAD   = 6;   // FETCH DECODE EXEC MEM MEM WB
+constexpr uint8_t CYC_STORE  = 5;   // FETCH DECODE EXEC MEM MEM
+constexpr uint8_t CYC_WFI    = 3;   // FETCH DECODE EXEC, then sleep in FETCH
+constexpr uint8_t CYC_FENCE  = 5;   // FETCH DECODE EXEC MEM WB, plus the write buffer drain
+constexpr uint8_t CYC_MUL    = 6;   // FETCH DECODE EXEC MULDIV x2 WB (rv32_muldiv.sv)
+constexpr uint8_t CYC_DIV    = 38;  // FETCH DECODE EXEC MULDIV x34 WB
+constexpr uint8_t CYC_DIV0   = 5;   // division by zero: MULDIV x1
+constexpr uint8_t CYC_SPLIT  = 1;   // RV32C: DECODE_HI for a 32-bit instruction across two words
+constexpr uint8_t CYC_AMO    = 9;   // FETCH DECODE EXEC MEM x2 (read) x2 (write) x1 (drain) WB
+
+// Hart interleave: the hart behind runs until it is this many cycles ahead.
+constexpr uint64_t HART_QUANTUM = 64;
+
+inline int32_t sext(uint32_t v, unsigned bits) {
+    const uint32_t m = 1u << (bits - 1);
+    return (int32_t)((v ^ m) - m);
+}
+
+} // namespace
+
+// Decode mirrors control_unit.sv, including its fall-backs: unknown OP/OP-IMM
+// encodings execute as ADD, unknown branch funct3 as BEQ, unknown load width
+// as LW, and anything else retires through WB without a register write.
+// With rv32m, funct7 == 0000001 selects the RV32M operations. AMO*.W decode in
+// every configuration (rv32_opcodes_pkg amo_supported); LR.W/SC.W are no-ops.
+Insn decode(uint32_t ir, bool rv32m) {
+    Insn d{};
+    const uint32_t opcode = ir & 0x7F;
+    const uint32_t funct3 = (ir >> 12) & 0x7;
+    const uint32_t funct7 = ir >> 25;
+    d.rd = (ir >> 7) & 0x1F;
+    d.rs1 = (ir >> 15) & 0x1F;
+    d.rs2 = (ir >> 20) & 0x1F;
+    d.op = Op::NOP;
+    d.cycles = CYC_ALU;
+    d.len = 4;
+
+    const int32_t imm_i = sext(ir >> 20, 12);
+    const int32_t imm_s = sext(((ir >> 25) << 5) | ((ir >> 7) & 0x1F), 12);
+    const int32_t imm_b = sext(((ir >> 31) << 12) | (((ir >> 7) & 1) << 11) |
+                               (((ir >> 25) & 0x3F) << 5) | (((ir >> 8) & 0xF) << 1), 13);
+    const int32_t imm_u = (int32_t)(ir & 0xFFFFF000u);
+    const int32_t imm_j = sext(((ir >> 31) << 20) | (((ir >> 12) & 0xFF) << 12) |
+                               (((ir >> 20) & 1) << 11) | (((ir >> 21) & 0x3FF) << 1), 21);
+
+    switch (opcode) {
+    case OPC_LUI:   d.op = Op::LUI;   d.imm = imm_u; break;
+    case OPC_AUIPC: d.op = Op::AUIPC; d.imm = imm_u; break;
+    case OPC_JAL:   d.op = Op::JAL;   d.imm = imm_j; break;
+    case OPC_JALR:  d.op = Op::JALR;  d.imm = imm_i; break;
+    case OPC_BRANCH: {
+        static const Op ops[8] = {Op::BEQ, Op::BNE, Op::BEQ, Op::BEQ,
+                                  Op::BLT, Op::BGE, Op::BLTU, Op::BGEU};
+        d.op = ops[funct3];
+        d.imm = imm_b;
+        d.cycles = CYC_BRANCH;
+        break;
+    }
+    case OPC_LOAD: {
+        static const Op ops[8] = {Op::LB, Op::LH, Op::LW, Op::LW,
+                                  Op::LBU, Op::LHU, Op::LW, Op::LW};
+        d.op = ops[funct3];
+        d.imm = imm_i;
+        d.cycles = CYC_LOAD;
+        break;
+    }
+    case OPC_STORE: {
+        static const Op ops[8] = {Op::SB, Op::SH, Op::SW, Op::SNONE,
+                                  Op::SNONE, Op::SNONE, Op::SNONE, Op::SNONE};
+        d.op = ops[funct3];
+        d.imm = imm_s;
+        d.cycles = CYC_STORE;
+        break;
+    }
+    case OPC_OP_IMM: {
+        d.imm = imm_i;
+        switch (funct3) {
+        case 0: d.op = Op::ADDI; break;
+        case 1: d.op = Op::SLLI; break;
+        case 2: d.op = Op::SLTI; break;
+        case 3: d.op = Op::SLTIU; break;
+        case 4: d.op = Op::XORI; break;
+        case 5: d.op = (funct7 == 0x20) ? Op::SRAI : Op::SRLI; break;
+        case 6: d.op = Op::ORI; break;
+        default: d.op = Op::ANDI; break;
+        }
+        break;
+    }
+    case OPC_OP: {
+        if (rv32m && funct7 == 0x01) {
+            static const Op ops[8] = {Op::MUL, Op::MULH, Op::MULHSU, Op::MULHU,
+                                      Op::DIV, Op::DIVU, Op::REM, Op::REMU};
+            d.op = ops[funct3];
+            d.cycles = (funct3 & 4) ? CYC_DIV : CYC_MUL;
+            break;
+        }
+        switch ((funct7 << 3) | funct3) {
+        case (0x00 << 3) | 0: d.op = Op::ADD; break;
+        case (0x20 << 3) | 0: d.op = Op::SUB; break;
+        case (0x00 << 3) | 1: d.op = Op::SLL; break;
+        case (0x00 << 3) | 2: d.op = Op::SLT; break;
+        case (0x00 << 3) | 3: d.op = Op::SLTU; break;
+        case (0x00 << 3) | 4: d.op = Op::XOR; break;
+        case (0x00 << 3) | 5: d.op = Op::SRL; break;
+        case (0x20 << 3) | 5: d.op = Op::SRA; break;
+        case (0x00 << 3) | 6: d.op = Op::OR; break;
+        case (0x00 << 3) | 7: d.op = Op::AND; break;
+        default: d.op = Op::ADD; break;
+        }
+        break;
+    }
+    case OPC_AMO: {
+        const uint32_t funct5 = ir >> 27;
+        static const uint32_t supported = (1u << 0x00) | (1u << 0x01) | (1u << 0x04) | (1u << 0x08) |
+                                          (1u << 0x0C) | (1u << 0x10) | (1u << 0x14) | (1u << 0x18) |
+                                          (1u << 0x1C);
+        if (funct3 == 2 && ((supported >> funct5) & 1u)) {
+            d.op = Op::AMO;
+            d.imm = (int32_t)funct5;
+            d.cycles = CYC_AMO;
+        }
+        break;
+    }
+    case OPC_MISC_MEM:
+        d.op = Op::FENCE;
+        d.cycles = CYC_FENCE;
+        break;
+    case OPC_SYSTEM: {
+        d.csr = (uint16_t)(ir >> 20);
+        d.imm = d.rs1; // zimm for CSR*I
+        switch (funct3) {
+        case 0:
+            if (ir == INSN_MRET) {
+                d.op = Op::MRET;
+            } else if ((ir >> 20) == 0x105 && d.rs1 == 0 && d.rd == 0) {
+                d.op = Op::WFI;
+                d.cycles = CYC_WFI;
+            }
+            break;
+        case 1: d.op = Op::CSRRW; break;
+        case 2: d.op = Op::CSRRS; break;
+        case 3: d.op = Op::CSRRC; break;
+        case 5: d.op = Op::CSRRWI; break;
+        case 6: d.op = Op::CSRRSI; break;
+        case 7: d.op = Op::CSRRCI; break;
+        default: d.op = Op::CSRRS; d.rs1 = 0; break; // reads CSR into rd, no write
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    // rv32_pipeline.sv id_uses_rs1 / id_uses_rs2 / id_is_system
+    d.deps = ((opcode == OPC_LUI || opcode == OPC_AUIPC || opcode == OPC_JAL) ? 0 : INSN_RS1) |
+             ((opcode == OPC_OP || opcode == OPC_STORE || opcode == OPC_BRANCH || opcode == OPC_AMO) ? INSN_RS2 : 0) |
+             ((opcode == OPC_SYSTEM) ? INSN_SYSTEM : 0);
+    return d;
+}
+
+// Same cases as rv32c_expand.sv.
+uint32_t expand_c(uint32_t ic) {
+    auto bit = [ic](unsigned b) { return (ic >> b) & 1u; };
+    auto bits = [ic](unsigned hi, unsigned lo) { return (ic >> lo) & ((1u << (hi - lo + 1)) - 1u); };
+    auto i_type = [](uint32_t imm, uint32_t rs1, uint32_t f3, uint32_t rd, uint32_t opc) {
+        return ((imm & 0xFFFu) << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | opc;
+    };
+    auto s_type = [](uint32_t imm, uint32_t rs2, uint32_t rs1, uint32_t f3, uint32_t opc) {
+        return ((imm >> 5) << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | ((imm & 0x1Fu) << 7) | opc;
+    };
+    auto r_type = [](uint32_t f7, uint32_t rs2, uint32_t rs1, uint32_t f3, uint32_t rd) {
+        return (f7 << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | OPC_OP;
+    };
+    auto j_type = [](uint32_t imm, uint32_t rd) {
+        return (((imm >> 20) & 1u) << 31) | (((imm >> 1) & 0x3FFu) << 21) | (((imm >> 11) & 1u) << 20) |
+               (((imm >> 12) & 0xFFu) << 12) | (rd << 7) | OPC_JAL;
+    };
+    auto b_type = [](uint32_t imm, uint32_t rs1, uint32_t f3) {
+        return (((imm >> 12) & 1u) << 31) | (((imm >> 5) & 0x3Fu) << 25) | (rs1 << 15) | (f3 << 12) |
+               (((imm >> 1) & 0xFu) << 8) | (((imm >> 11) & 1u) << 7) | OPC_BRANCH;
+    };
+
+    const uint32_t funct3 = bits(15, 13);
+    const uint32_t rd = bits(11, 7);
+    const uint32_t rs2 = bits(6, 2);
+    const uint32_t rdp = 8 + bits(4, 2);
+    const uint32_t rs1p = 8 + bits(9, 7);
+    const uint32_t imm_ci = (uint32_t)sext((bit(12) << 5) | bits(6, 2), 6);
+    const uint32_t imm_lw = (bit(5) << 6) | (bits(12, 10) << 3) | (bit(6) << 2);
+    const uint32_t imm_j = (uint32_t)sext((bit(12) << 11) | (bit(8) << 10) | (bits(10, 9) << 8) | (bit(6) << 7) |
+                                          (bit(7) << 6) | (bit(2) << 5) | (bit(11) << 4) | (bits(5, 3) << 1), 12);
+    const uint32_t imm_b = (uint32_t)sext((bit(12) << 8) | (bits(6, 5) << 6) | (bit(2) << 5) |
+                                          (bits(11, 10) << 3) | (bits(4, 3) << 1), 9);
+
+    switch (((ic & 3u) << 3) | funct3) {
+    // Quadrant 0
+    case 0: {                                                   // C.ADDI4SPN
+        const uint32_t imm = (bits(10, 7) << 6) | (bits(12, 11) << 4) | (bit(5) << 3) | (bit(6) << 2);
+        return imm ? i_type(imm, 2, 0, rdp, OPC_OP_IMM) : 0;
+    }
+    case 2: return i_type(imm_lw, rs1p, 2, rdp, OPC_LOAD);      // C.LW
+    case 6: return s_type(imm_lw, rdp, rs1p, 2, OPC_STORE);     // C.SW
+    // Quadrant 1
+    case 8:  return i_type(imm_ci, rd, 0, rd, OPC_OP_IMM);      // C.ADDI / C.NOP
+    case 9:  return j_type(imm_j, 1);                           // C.JAL
+    case 10: return i_type(imm_ci, 0, 0, rd, OPC_OP_IMM);       // C.LI
+    case 11:
+        if (rd == 2) {                                          // C.ADDI16SP
+            const uint32_t imm = (uint32_t)sext((bit(12) << 9) | (bits(4, 3) << 7) | (bit(5) << 6) |
+                                                (bit(2) << 5) | (bit(6) << 4), 10);
+            return imm ? i_type(imm, 2, 0, 2, OPC_OP_IMM) : 0;
+        }
+        return imm_ci ? ((imm_ci << 12) | (rd << 7) | OPC_LUI) : 0;   // C.LUI
+    case 12:
+        switch (bits(11, 10)) {
+        case 0: return bit(12) ? 0 : i_type(rs2, rs1p, 5, rs1p, OPC_OP_IMM);            // C.SRLI
+        case 1: return bit(12) ? 0 : i_type(0x400u | rs2, rs1p, 5, rs1p, OPC_OP_IMM);   // C.SRAI
+        case 2: return i_type(imm_ci, rs1p, 7, rs1p, OPC_OP_IMM);                      // C.ANDI
+        default: {
+            if (bit(12)) {
+                return 0;
+            }
+            static const uint32_t f3[4] = {0, 4, 6, 7};                                 // SUB XOR OR AND
+            return r_type(bits(6, 5) == 0 ? 0x20u : 0u, rdp, rs1p, f3[bits(6, 5)], rs1p);
+        }
+        }
+    case 13: return j_type(imm_j, 0);                           // C.J
+    case 14: return b_type(imm_b, rs1p, 0);                     // C.BEQZ
+    case 15: return b_type(imm_b, rs1p, 1);                     // C.BNEZ
+    // Quadrant 2
+    case 16: return bit(12) ? 0 : i_type(rs2, rd, 1, rd, OPC_OP_IMM);                  // C.SLLI
+    case 18: {                                                  // C.LWSP
+        const uint32_t imm = (bits(3, 2) << 6) | (bit(12) << 5) | (bits(6, 4) << 2);
+        return rd ? i_type(imm, 2, 2, rd, OPC_LOAD) : 0;
+    }
+    case 20:
+        if (!bit(12)) {
+            if (rs2 == 0) {
+                return rd ? i_type(0, rd, 0, 0, OPC_JALR) : 0;  // C.JR
+            }
+            return r_type(0, rs2, 0, 0, rd);                    // C.MV
+        }
+        if (rs2 == 0) {
+            return rd ? i_type(0, rd, 0, 1, OPC_JALR) : 0x00100073u;   // C.JALR / C.EBREAK
+        }
+        return r_type(0, rs2, rd, 0, rd);                       // C.ADD
+    case 22: {                                                  // C.SWSP
+        const uint32_t imm = (bits(8, 7) << 6) | (bits(12, 9) << 2);
+        return s_type(imm, rs2, 2, 2, OPC_STORE);
+    }
+    default:
+        return 0;
+    }
+}
+
+// The instruction at half-word h of an IMEM/XMEM image. A 32-bit instruction at
+// pc[1] = 1 takes its high half from the next word (S_DECODE_HI).
+Insn Soc::decode_half(const std::vector<uint32_t> &mem, size_t h) const {
+    const uint32_t w = mem[h >> 1];
+    if (!cfg_.rv32c) {
+        return decode(w, cfg_.rv32m);
+    }
+    const uint32_t lo = (h & 1) ? (w >> 16) : (w & 0xFFFFu);
+    if ((lo & 3u) != 3u) {
+        Insn d = decode(expand_c(lo), cfg_.rv32m);
+        d.len = 2;
+        return d;
+    }
+    if (!(h & 1)) {
+        return decode(w, cfg_.rv32m);
+    }
+    Insn d = decode(lo | (mem[((h >> 1) + 1) & (mem.size() - 1)] << 16), cfg_.rv32m);
+    d.cycles += CYC_SPLIT;
+    return d;
+}
+
+void Soc::predecode() {
+    icache_.resize(2 * imem_.size());
+    for (size_t h = 0; h < icache_.size(); h++) {
+        icache_[h] = decode_half(imem_, h);
+    }
+    xdecode_.resize(2 * xmem_.size());
+    for (size_t h = 0; h < xdecode_.size(); h++) {
+        xdecode_[h] = decode_half(xmem_, h);
+    }
+}
+
+// A store to XMEM word idx changes the instructions that start in it and the
+// one that may straddle into it from the word before.
+void Soc::xmem_redecode(uint32_t idx) {
+    const size_t mask = xdecode_.size() - 1;
+    for (size_t h = 2 * (size_t)idx - 1; h != 2 * (size_t)idx + 2; h++) {
+        xdecode_[h & mask] = decode_half(xmem_, h & mask);
+    }
+}
+
+// Fetch from XMEM: the FSM waits in DECODE while the I-cache refills the line.
+// Unlike the RTL I-cache, the predecoded copy follows stores (no stale lines).
+// A split RV32C instruction looks up the next word as well (S_DECODE_HI).
+const Insn &Soc::xmem_fetch(uint32_t pc) {
+    if (!icache_model_.read(pc)) {
+        cycles_ += refill_cycles_;
+    }
+    const Insn &d = xdecode_[(pc - cfg_.xmem_base) >> 1];
+    if (cfg_.rv32c && d.len == 4 && (pc & 2u) && !icache_model_.read(pc + 2)) {
+        cycles_ += refill_cycles_;
+    }
+    return d;
+}
+
+// Counter index n as in 0xB00 + n: 0 mcycle, 1 time, 2 minstret, 3.. mhpmcounter.
+uint64_t Soc::counter(unsigned idx) const {
+    switch (idx) {
+    case 0: return (mcountinhibit_ & MCOUNTINHIBIT_CY) ? mcycle_off_ : cycles_ - mcycle_off_;
+    case 1: return cycles_;   // CLINT mtime counts clk cycles from reset
+    case 2: return (mcountinhibit_ & MCOUNTINHIBIT_IR) ? minstret_off_ : instret_ - minstret_off_;
+    default: return (idx >= 3 && idx < 3 + N_HPM) ? hpm_[idx - 3] : 0;
+    }
+}
+
+uint32_t Soc::csr_read(uint16_t addr) const {
+    const unsigned hi = addr & 0x80u;
+    const unsigned idx = addr & 0x1Fu;
+    if (((addr >> 8) == 0xB || (addr >> 8) == 0xC) && (addr & 0x60u) == 0) {
+        if ((addr >> 8) == 0xB && idx == 1) return 0;
+        const uint64_t v = counter(idx);
+        return hi ? (uint32_t)(v >> 32) : (uint32_t)v;
+    }
+    switch (addr) {
+    case CSR_MSTATUS: return mstatus_;
+    case CSR_MIE:     return mie_;
+    case CSR_MTVEC:   return mtvec_;
+    case CSR_MEPC:    return mepc_;
+    case CSR_MCAUSE:  return mcause_;
+    case CSR_MIP:     return mip_;
+    case CSR_EXT_INT: return ext_int_;
+    case CSR_EXT_INT_EN: return ext_int_en_;
+    case CSR_EXT_INT_PRIO: return ext_int_prio_;
+    case CSR_EXT_INT_CLAIM: return ext_claim();
+    case CSR_MBUSERR: return buserr_pend_ ? 1u : 0u;
+    case CSR_MBUSERR_ADDR: return buserr_addr_;
+    case CSR_MCOUNTINHIBIT: return mcountinhibit_;
+    case CSR_MHARTID: return hart_id_;
+    default:          return 0;
+    }
+}
+
+void Soc::csr_write(uint16_t addr, uint32_t value) {
+    const unsigned idx = addr & 0x1Fu;
+    if ((addr >> 8) == 0xB && (addr & 0x60u) == 0 && idx != 1 && idx < 3 + N_HPM) {
+        uint64_t v = counter(idx);
+        v = (addr & 0x80u) ? ((v & 0xFFFFFFFFull) | ((uint64_t)value << 32))
+                           : ((v & ~0xFFFFFFFFull) | value);
+        // The RTL suppresses the increment in the writing cycle; the ISS writes
+        // after the instruction's cycles are charged, which is the same thing.
+        if (idx == 0) {
+            mcycle_off_ = (mcountinhibit_ & MCOUNTINHIBIT_CY) ? v : cycles_ - v;
+        } else if (idx == 2) {
+            // This instruction is counted after the write; compensate.
+            minstret_off_ = (mcountinhibit_ & MCOUNTINHIBIT_IR) ? v : instret_ + 1 - v;
+        } else {
+            hpm_[idx - 3] = v;
+        }
+        return;
+    }
+    switch (addr) {
+    case CSR_MSTATUS: mstatus_ = value & (MSTATUS_MIE | MSTATUS_MPIE); break;
+    case CSR_MIE:     mie_ = value & (MIP_MSIP | MIP_MTIP | MIP_MEIP | MIP_BUSERR); break;
+    case CSR_MTVEC:   mtvec_ = value & ~2u; break;
+    case CSR_MEPC:    mepc_ = value & ~1u; break;
+    case CSR_MCAUSE:  mcause_ = value; break;
+    case CSR_EXT_INT_EN:
+        ext_int_en_ = value & EXT_INT_MASK;
+        // MEIP follows at once: a trap at this commit is decided on the new enables.
+        // Hart 1 has no external lines.
+        if (hart_id_ == 0) {
+            mip_ = (mip_ & ~MIP_MEIP) | ((ext_int_ & ext_int_en_) ? MIP_MEIP : 0);
+        }
+        next_event_ = 0;
+        break;
+    case CSR_EXT_INT_PRIO: ext_int_prio_ = value & 0xFFFFu; break;
+    case CSR_MBUSERR:
+        if (!(value & 1u)) {
+            buserr_pend_ = false;
+            mip_ &= ~MIP_BUSERR;
+        }
+        break;
+    case CSR_MCOUNTINHIBIT: {
+        // Switch mcycle/minstret between running (offset) and frozen (value) form.
+        // The writing instruction still counts under the old inhibit bits.
+        const uint64_t cy = counter(0);
+        const uint64_t ir = counter(2) + ((mcountinhibit_ & MCOUNTINHIBIT_IR) ? 0 : 1);
+        mcountinhibit_ = value & MCOUNTINHIBIT_MASK;
+        mcycle_off_ = (mcountinhibit_ & MCOUNTINHIBIT_CY) ? cy : cycles_ - cy;
+        minstret_off_ = (mcountinhibit_ & MCOUNTINHIBIT_IR) ? ir : instret_ + 1 - ir;
+        break;
+    }
+    default: break;
+    }
+}
+
+// Enabled pending line with the highest CSR 0xF04 priority, the lower line on a
+// tie: bit 31 set if there is one, the line in [4:0].
+uint32_t Soc::ext_claim() const {
+    const uint32_t act = ext_int_ & ext_int_en_;
+    uint32_t best = 0, best_prio = 0;
+    for (uint32_t i = 0; i < 8; i++) {
+        const uint32_t p = (ext_int_prio_ >> (2 * i)) & 3u;
+        if ((act >> i) & 1u && (!best || p > best_prio)) {
+            best = 0x80000000u | i;
+            best_prio = p;
+        }
+    }
+    return best;
+}
+
+// Priority: bus error > external > timer > software (rv32_mtrap_csr.sv).
+uint32_t Soc::irq_cause(uint32_t pend) const {
+    if (pend & MIP_BUSERR) return MCAUSE_BUSERR;
+    if (pend & MIP_MEIP) {
+        return (mtvec_ & MTVEC_VECTORED) ? 0x80000000u | (MCAUSE_EXT_BASE + (ext_claim() & 31u))
+                                         : MCAUSE_MEI;
+    }
+    return (pend & MIP_MTIP) ? MCAUSE_MTI : MCAUSE_MSI;
+}
+
+// Vectored: BASE (128-byte aligned) + 4 * cause.
+void Soc::take_trap(uint32_t mcause, uint32_t next_pc) {
+    mepc_ = next_pc & ~1u;
+    mcause_ = mcause;
+    mstatus_ = (mstatus_ & ~(MSTATUS_MIE | MSTATUS_MPIE)) |
+               ((mstatus_ & MSTATUS_MIE) ? MSTATUS_MPIE : 0);
+    pc_ = (mtvec_ & MTVEC_VECTORED) ? (mtvec_ & ~0x7Fu) | ((mcause & 31u) << 2) : mtvec_;
+    hpm_add(8, 1);
+    trace_intr_ = true;
+}
+
+// The instruction at pc as IR holds it (RV32C: expanded).
+uint32_t Soc::insn_word(uint32_t pc, unsigned len) const {
+    const bool in_xmem = pc - cfg_.xmem_base < xmem_bytes_;
+    const std::vector<uint32_t> &mem = in_xmem ? xmem_ : imem_;
+    const size_t mask = mem.size() - 1;
+    const size_t w = ((in_xmem ? pc - cfg_.xmem_base : pc) >> 2) & mask;
+    if (!cfg_.rv32c) {
+        return mem[w];
+    }
+    const uint32_t lo = (pc & 2u) ? mem[w] >> 16 : mem[w] & 0xFFFFu;
+    if (len == 2) {
+        return expand_c(lo);
+    }
+    return (pc & 2u) ? lo | (mem[(w + 1) & mask] << 16) : mem[w];
+}
+
+// One record per retired instruction, called after its cycles are charged and
+// before a trap at its commit is taken (that one marks the next record).
+void Soc::trace_retire(uint32_t pc, const Insn &d, uint32_t mem_addr, uint32_t mem_data) {
+    uint32_t info = 0;
+    switch (d.op) {
+    case Op::BEQ: case Op::BNE: case Op::BLT: case Op::BGE: case Op::BLTU: case Op::BGEU:
+    case Op::MRET: case Op::WFI: case Op::FENCE: case Op::NOP:
+        break;
+    case Op::AMO:
+        info = TRACE_LOAD | d.rd;
+        break;
+    case Op::SB: case Op::SH: case Op::SW: case Op::SNONE:
+        info = TRACE_STORE;
+        break;
+    case Op::LB: case Op::LH: case Op::LW: case Op::LBU: case Op::LHU:
+        info = TRACE_LOAD | d.rd;
+        break;
+    default:
+        info = d.rd;
+        break;
+    }
+    const uint64_t wait = lsu_wait_ - trace_wait_;
+    trace_wait_ = lsu_wait_;
+    info |= (d.len == 2 ? TRACE_C : 0u) | (trace_intr_ ? TRACE_INTR : 0u) |
+            ((uint32_t)std::min<uint64_t>(wait, TRACE_WAIT_MAX) << TRACE_WAIT_SHIFT);
+    trace_intr_ = false;
+
+    TraceRecord r;
+    r.cycle = (uint32_t)cycles_;
+    r.pc = pc;
+    r.insn = insn_word(pc, d.len);
+    r.rd_wdata = (info & TRACE_RD_MASK) ? x_[info & TRACE_RD_MASK] : 0;
+    r.mem_addr = (info & (TRACE_LOAD | TRACE_STORE)) ? mem_addr : 0;
+    r.mem_data = (info & (TRACE_LOAD | TRACE_STORE)) ? mem_data : 0;
+    r.info = info;
+    std::fwrite(&r, sizeof(r), 1, trace_);
+}
+
+// Both harts share the peripherals but keep their own cycle count: the one behind
+// runs until it is HART_QUANTUM cycles ahead of the other, so MMIO and mailbox
+// accesses interleave within that window. Only hart 0 ends the run (its DMEM is
+// the one the stop protocol watches); run() returns with hart 0 swapped in.
+RunResult Soc::run(const StopConfig &stop) {
+    if (cfg_.harts < 2) {
+        return run_hart(stop, stop.max_cycles);
+    }
+    for (;;) {
+        const uint64_t until = std::min(stop.max_cycles, other_.cycles + HART_QUANTUM);
+        const RunResult res = run_hart(stop, until);
+        if (res != RunResult::Timeout || (hart_id_ == 0 && cycles_ >= stop.max_cycles)) {
+            if (hart_id_ != 0) {
+                error_ = "hart 1: " + error_;
+                swap_hart();
+            }
+            return res;
+        }
+        swap_hart();
+    }
+}
+
+void Soc::swap_hart() {
+    HartContext &o = other_;
+    std::swap(x_, o.x);
+    std::swap(pc_, o.pc);
+    std::swap(cycles_, o.cycles);
+    std::swap(instret_, o.instret);
+    std::swap(hart_id_, o.hart_id);
+    std::swap(hold_, o.hold);
+    std::swap(asleep_, o.asleep);
+    std::swap(pipe_, o.pipe);
+    std::swap(mstatus_, o.mstatus);
+    std::swap(mie_, o.mie);
+    std::swap(mtvec_, o.mtvec);
+    std::swap(mepc_, o.mepc);
+    std::swap(mcause_, o.mcause);
+    std::swap(mip_, o.mip);
+    std::swap(ext_int_en_, o.ext_int_en);
+    std::swap(ext_int_prio_, o.ext_int_prio);
+    std::swap(buserr_pend_, o.buserr_pend);
+    std::swap(buserr_addr_, o.buserr_addr);
+    std::swap(mcountinhibit_, o.mcountinhibit);
+    std::swap(mcycle_off_, o.mcycle_off);
+    std::swap(minstret_off_, o.minstret_off);
+    std::swap(hpm_, o.hpm);
+    std::swap(lsu_wait_, o.lsu_wait);
+    std::swap(trace_, o.trace);
+    std::swap(trace_wait_, o.trace_wait);
+    std::swap(trace_intr_, o.trace_intr);
+    std::swap(wbuf_, o.wbuf);
+    std::swap(next_event_, o.next_event);
+    std::swap(dmem_, o.dmem);
+    // The other hart may have rung this one's MSIP.
+    next_event_ = 0;
+}
+
+RunResult Soc::run_hart(const StopConfig &stop, uint64_t until) {
+    const Insn *ic = icache_.data();
+    const uint32_t ic_mask = 2 * imem_mask_ + 1;
+    uint32_t *x = x_;
+    const uint32_t stop_byte = cfg_.dmem_base + (stop.stop_addr_word << 2);
+    const bool stops = hart_id_ == 0;
+    // RV32C: the next instruction is in the word still on imem, S_WB goes straight
+    // to S_DECODE (no FETCH cycle, and no EARLY_IRQ trap point there).
+    bool &hold = hold_;
+
+    while (cycles_ < until) {
+        if (cycles_ >= next_event_) {
+            update_irq_lines();
+        }
+        if (asleep_) {
+            if (!(mip_ & mie_)) {
+                wfi_fast_forward(until);
+                continue;
+            }
+            asleep_ = false;
+            // wfi_sleep clears on the edge after the line is seen.
+            pipe_.id = std::max(pipe_.id, cycles_ + 1);
+        }
+
+        // EARLY_IRQ: S_FETCH is a trap point too (after branches, stores and WFI,
+        // which do not reach S_WB); the FETCH cycle is spent, the vector is fetched next.
+        if (cfg_.early_irq && !cfg_.pipeline && !hold && (mstatus_ & MSTATUS_MIE) && (mip_ & mie_)) {
+            cycles_ += 1;
+            take_trap(irq_cause(mip_ & mie_), pc_);
+            continue;
+        }
+
+        const uint32_t pc = pc_;
+        const uint64_t fetch_start = cycles_;
+        const Insn &d = (pc - cfg_.xmem_base < xmem_bytes_) ? xmem_fetch(pc) : ic[(pc >> 1) & ic_mask];
+        const uint32_t a = x[d.rs1];
+        const uint32_t b = x[d.rs2];
+        uint32_t npc = pc + d.len;
+        bool commit = true;   // reaches S_WB, where traps are taken (also S_FETCH with early_irq)
+        bool mret = false;
+        bool wfi = false;
+        uint32_t mem_addr = 0;    // for the trace
+        uint32_t mem_data = 0;
+        bool csr_wr = false;      // CSR written at this commit
+        uint64_t trap_hpm8 = 0;   // mhpmcounter8 if a trap is taken at this commit
+        uint64_t ex_done = 0;     // pipeline: the cycle it leaves EX
+
+        if (cfg_.pipeline) {
+            // rv32_pipeline.sv: issue once EX is free (SYSTEM: once EX/MEM/WB are
+            // empty, and nothing behind one until it retires), leave EX once MEM is
+            // free, one cycle later for a load result (forwarded from WB only), or
+            // when rv32_muldiv answers. XMEM refills hold the instruction in ID.
+            PipeState &p = pipe_;
+            const uint64_t refill = cycles_ - fetch_start;
+            cycles_ = fetch_start;
+            const bool split = cfg_.rv32c && d.len == 4 && (pc & 2u);
+            uint64_t issue = std::max(p.id + refill + (split ? CYC_SPLIT : 0), p.ex);
+            if ((d.deps & INSN_SYSTEM) || p.system) {
+                issue = std::max(issue, p.mem + 2);
+            }
+            // EARLY_IRQ: taken in ID when nothing older is in flight.
+            if (cfg_.early_irq && issue >= p.mem + 2 && (mstatus_ & MSTATUS_MIE)) {
+                cycles_ = std::max(cycles_, issue);
+                if (cycles_ >= next_event_) {
+                    update_irq_lines();
+                }
+                if (mip_ & mie_) {
+                    take_trap(irq_cause(mip_ & mie_), pc);
+                    p.id = cycles_ + 1;
+                    continue;
+                }
+            }
+            const bool load_use = p.load_rd != 0 &&
+                                  (((d.deps & INSN_RS1) && d.rs1 == p.load_rd) ||
+                                   ((d.deps & INSN_RS2) && d.rs2 == p.load_rd));
+            unsigned md = 0;
+            if (d.op >= Op::MUL && d.op <= Op::MULHU) {
+                md = 2;
+            } else if (d.op >= Op::DIV && d.op <= Op::REMU) {
+                md = b ? 34 : 1;
+            }
+            const uint64_t start = std::max(issue + 1, load_use ? p.mem + 1 : 0);
+            ex_done = std::max(start + md, p.mem);
+            p.id = issue + 1;
+            p.ex = ex_done;
+            // The first MEM cycle for FENCE (lsu_idle), the AXI request of a load,
+            // store or AMO, else WB (CSRs are read and written there).
+            cycles_ = std::max(cycles_, ex_done + (d.op == Op::FENCE ? 1 : 2));
+        } else {
+            cycles_ += d.cycles - (hold ? 1 : 0);
+            hold = false;
+        }
+
+        switch (d.op) {
+        case Op::LUI:   x[d.rd] = (uint32_t)d.imm; break;
+        case Op::AUIPC: x[d.rd] = pc + (uint32_t)d.imm; break;
+        case Op::JAL:   x[d.rd] = pc + d.len; npc = pc + (uint32_t)d.imm; break;
+        case Op::JALR:  x[d.rd] = pc + d.len; npc = (a + (uint32_t)d.imm) & ~1u; break;
+
+        case Op::BEQ:  commit = false; if (a == b) { npc = pc + (uint32_t)d.imm; hpm_add(5, 1); } break;
+        case Op::BNE:  commit = false; if (a != b) { npc = pc + (uint32_t)d.imm; hpm_add(5, 1); } break;
+        case Op::BLT:  commit = false; if ((int32_t)a < (int32_t)b) { npc = pc + (uint32_t)d.imm; hpm_add(5, 1); } break;
+        case Op::BGE:  commit = false; if ((int32_t)a >= (int32_t)b) { npc = pc + (uint32_t)d.imm; hpm_add(5, 1); } break;
+        case Op::BLTU: commit = false; if (a < b) { npc = pc + (uint32_t)d.imm; hpm_add(5, 1); } break;
+        case Op::BGEU: commit = false; if (a >= b) { npc = pc + (uint32_t)d.imm; hpm_add(5, 1); } break;
+
+        case Op::LB: case Op::LH: case Op::LW: case Op::LBU: case Op::LHU: {
+            const uint32_t addr = a + (uint32_t)d.imm;
+            uint32_t w;
+            if (!load(addr, w)) {
+                pc_ = pc;
+                return RunResult::BusError;
+            }
+            // Lane select as in control_unit.sv: the word is fetched at addr[31:2]
+            // and the byte/half is picked from addr[1:0] / addr[1].
+            const unsigned sh8 = (addr & 3u) * 8;
+            const unsigned sh16 = (addr & 2u) * 8;
+            switch (d.op) {
+            case Op::LB:  w = (uint32_t)(int32_t)(int8_t)(w >> sh8); break;
+            case Op::LBU: w = (w >> sh8) & 0xFFu; break;
+            case Op::LH:  w = (uint32_t)(int32_t)(int16_t)(w >> sh16); break;
+            case Op::LHU: w = (w >> sh16) & 0xFFFFu; break;
+            default:      break;
+            }
+            x[d.rd] = w;
+            mem_addr = addr;
+            mem_data = w;
+            hpm_add(3, 1);
+            break;
+        }
+
+        case Op::SB: case Op::SH: case Op::SW: case Op::SNONE: {
+            const uint32_t addr = a + (uint32_t)d.imm;
+            uint32_t data = b;
+            uint32_t strb = 0;
+            commit = false;
+            switch (d.op) {
+            case Op::SB: data = (b & 0xFFu) * 0x01010101u; strb = 1u << (addr & 3u); break;
+            case Op::SH: data = (b & 0xFFFFu) << ((addr & 2u) * 8); strb = (addr & 2u) ? 0xCu : 0x3u; break;
+            case Op::SW: strb = 0xFu; break;
+            default: break;
+            }
+            if (!store(addr, data, strb)) {
+                pc_ = pc;
+                return RunResult::BusError;
+            }
+            hpm_add(4, 1);
+            mem_addr = addr;
+            mem_data = data;
+            if (stops && (addr & ~3u) == stop_byte && strb == 0xFu) {
+                last_stop_wdata_ = data;
+                if (data == stop.stop_wdata) {
+                    if (trace_) trace_retire(pc, d, mem_addr, mem_data);
+                    pc_ = npc;
+                    ++instret_;
+                    return RunResult::Pass;
+                }
+                if ((data & 0xFFFF0000u) == 0xBAD00000u) {
+                    if (trace_) trace_retire(pc, d, mem_addr, mem_data);
+                    pc_ = npc;
+                    ++instret_;
+                    return RunResult::Fail;
+                }
+            }
+            break;
+        }
+
+        case Op::ADDI:  x[d.rd] = a + (uint32_t)d.imm; break;
+        case Op::SLTI:  x[d.rd] = (int32_t)a < d.imm; break;
+        case Op::SLTIU: x[d.rd] = a < (uint32_t)d.imm; break;
+        case Op::XORI:  x[d.rd] = a ^ (uint32_t)d.imm; break;
+        case Op::ORI:   x[d.rd] = a | (uint32_t)d.imm; break;
+        case Op::ANDI:  x[d.rd] = a & (uint32_t)d.imm; break;
+        case Op::SLLI:  x[d.rd] = a << (d.imm & 31); break;
+        case Op::SRLI:  x[d.rd] = a >> (d.imm & 31); break;
+        case Op::SRAI:  x[d.rd] = (uint32_t)((int32_t)a >> (d.imm & 31)); break;
+
+        case Op::ADD:  x[d.rd] = a + b; break;
+        case Op::SUB:  x[d.rd] = a - b; break;
+        case Op::SLL:  x[d.rd] = a << (b & 31); break;
+        case Op::SLT:  x[d.rd] = (int32_t)a < (int32_t)b; break;
+        case Op::SLTU: x[d.rd] = a < b; break;
+        case Op::XOR:  x[d.rd] = a ^ b; break;
+        case Op::SRL:  x[d.rd] = a >> (b & 31); break;
+        case Op::SRA:  x[d.rd] = (uint32_t)((int32_t)a >> (b & 31)); break;
+        case Op::OR:   x[d.rd] = a | b; break;
+        case Op::AND:  x[d.rd] = a & b; break;
+
+        case Op::MUL:    x[d.rd] = a * b; break;
+        case Op::MULH:   x[d.rd] = (uint32_t)(((int64_t)(int32_t)a * (int64_t)(int32_t)b) >> 32); break;
+        case Op::MULHSU: x[d.rd] = (uint32_t)(((int64_t)(int32_t)a * (int64_t)(uint64_t)b) >> 32); break;
+        case Op::MULHU:  x[d.rd] = (uint32_t)(((uint64_t)a * (uint64_t)b) >> 32); break;
+
+        // Division by zero is answered at start (all ones / dividend); the signed
+        // overflow case yields -2^31 / 0 as the spec requires.
+        case Op::DIV: case Op::DIVU: case Op::REM: case Op::REMU: {
+            uint32_t r;
+            if (b == 0) {
+                if (!cfg_.pipeline) {
+                    cycles_ -= CYC_DIV - CYC_DIV0;
+                }
+                r = (d.op == Op::REM || d.op == Op::REMU) ? a : 0xFFFFFFFFu;
+            } else if ((d.op == Op::DIV || d.op == Op::REM) && a == 0x80000000u && b == 0xFFFFFFFFu) {
+                r = (d.op == Op::DIV) ? a : 0;
+            } else {
+                switch (d.op) {
+                case Op::DIV:  r = (uint32_t)((int32_t)a / (int32_t)b); break;
+                case Op::DIVU: r = a / b; break;
+                case Op::REM:  r = (uint32_t)((int32_t)a % (int32_t)b); break;
+                default:       r = a % b; break;
+                }
+            }
+            x[d.rd] = r;
+            break;
+        }
+
+        case Op::CSRRW: case Op::CSRRS: case Op::CSRRC:
+        case Op::CSRRWI: case Op::CSRRSI: case Op::CSRRCI: {
+            const uint32_t old = csr_read(d.csr);
+            const uint32_t src = (d.op >= Op::CSRRWI) ? (uint32_t)d.imm : a;
+            const uint32_t inhibit = mcountinhibit_;
+            switch (d.op) {
+            case Op::CSRRW: case Op::CSRRWI: csr_write(d.csr, src); csr_wr = true; break;
+            case Op::CSRRS: case Op::CSRRSI: if (d.rs1) { csr_write(d.csr, old | src); csr_wr = true; } break;
+            default:                         if (d.rs1) { csr_write(d.csr, old & ~src); csr_wr = true; } break;
+            }
+            // A trap at this commit counts in mhpmcounter8 under the old mcountinhibit,
+            // and not at all if this is a write to mhpmcounter8 (rv32_mtrap_csr.sv).
+            trap_hpm8 = hpm_[8 - 3];
+            if (csr_wr && (d.csr & ~0x80u) != 0xB08u && !(inhibit & (1u << 8))) {
+                trap_hpm8 += 1;
+            }
+            x[d.rd] = old;
+            break;
+        }
+
+        // Read, write back, then S_MEM waits for the write to drain, so the word
+        // is updated before the next instruction (rv32_amo_alu.sv).
+        case Op::AMO: {
+            uint32_t old;
+            if (!load(a, old)) {
+                pc_ = pc;
+                return RunResult::BusError;
+            }
+            uint32_t r = old;
+            switch (d.imm) {
+            case 0x01: r = b; break;
+            case 0x00: r = old + b; break;
+            case 0x04: r = old ^ b; break;
+            case 0x0C: r = old & b; break;
+            case 0x08: r = old | b; break;
+            case 0x10: r = ((int32_t)old < (int32_t)b) ? old : b; break;
+            case 0x14: r = ((int32_t)old < (int32_t)b) ? b : old; break;
+            case 0x18: r = (old < b) ? old : b; break;
+            default:   r = (old < b) ? b : old; break;
+            }
+            if (!store(a, r, 0xFu)) {
+                pc_ = pc;
+                return RunResult::BusError;
+            }
+            wbuf_wait(true, 0);
+            x[d.rd] = old;
+            mem_addr = a;
+            mem_data = old;
+            break;
+        }
+
+        case Op::MRET: mret = true; break;
+
+        // Waits in S_MEM until lsu_interconnect has no posted write left.
+        case Op::FENCE: wbuf_wait(true, 0); break;
+
+        // The pipeline retires WFI through WB (a commit point) and sleeps after it.
+        case Op::WFI:
+            if (cfg_.pipeline) {
+                wfi = true;
+                break;
+            }
+            commit = false;
+            x[0] = 0;
+            pc_ = npc;
+            ++instret_;
+            if (trace_) trace_retire(pc, d, 0, 0);
+            if (!(mip_ & mie_)) {
+                asleep_ = true;
+                wfi_fast_forward(until);
+            }
+            continue;
+
+        case Op::NOP:
+            break;
+        }
+
+        if (cfg_.pipeline) {
+            // mem_done, then WB the cycle after. Every instruction retires through
+            // WB, and a taken branch or JALR redirects from EX (JAL from ID, free).
+            uint64_t mem_done = ex_done + 1;
+            switch (d.op) {
+            case Op::LB: case Op::LH: case Op::LW: case Op::LBU: case Op::LHU:
+            case Op::SB: case Op::SH: case Op::SW: case Op::SNONE: case Op::FENCE:
+                mem_done = cycles_;
+                break;
+            case Op::AMO:
+                mem_done = cycles_ + 3;   // AMO_WRITE x2, AMO_DRAIN
+                break;
+            case Op::JALR:
+                pipe_.id = ex_done + 1;
+                break;
+            default:
+                if (d.op >= Op::BEQ && d.op <= Op::BGEU && npc != pc + d.len) {
+                    pipe_.id = ex_done + 1;
+                }
+                break;
+            }
+            cycles_ = std::max(cycles_, mem_done + 1);
+            pipe_.mem = mem_done;
+            pipe_.load_rd = ((d.op >= Op::LB && d.op <= Op::LHU) || d.op == Op::AMO) ? d.rd : 0;
+            pipe_.system = (d.deps & INSN_SYSTEM) != 0;
+            commit = true;
+            if (cycles_ >= next_event_) {
+                update_irq_lines();
+            }
+        }
+
+        x[0] = 0;
+        pc_ = npc;
+        ++instret_;
+        if (trace_) trace_retire(pc, d, mem_addr, mem_data);
+
+        // The CSR write above has landed: an interrupt at this commit is decided on
+        // the written state, as in rv32_mtrap_csr.sv. It wins over mret, whose target
+        // becomes mepc.
+        if (commit) {
+            const uint32_t pend = (mstatus_ & MSTATUS_MIE) ? (mip_ & mie_) : 0;
+            if (pend) {
+                take_trap(irq_cause(pend), mret ? mepc_ : npc);
+                if (csr_wr) {
+                    hpm_[8 - 3] = trap_hpm8;
+                }
+                pipe_.id = cycles_ + 1;
+            } else if (mret) {
+                pc_ = mepc_;
+                mstatus_ = (mstatus_ & ~MSTATUS_MIE) | MSTATUS_MPIE |
+                           ((mstatus_ & MSTATUS_MPIE) ? MSTATUS_MIE : 0);
+                pipe_.id = cycles_ + 1;
+            } else if (wfi) {
+                asleep_ = !(mip_ & mie_);
+            } else {
+                hold = !cfg_.pipeline && cfg_.rv32c && ((npc ^ pc) & ~3u) == 0;
+            }
+        }
+    }
+    return RunResult::Timeout;
+}
+
+} // namespace roc
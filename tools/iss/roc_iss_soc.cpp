@@ -0,0 +1,742 @@
+// ROC_RV32 SoC model: lsu_interconnect memory map, MMIO slaves and image loaders.
+#include "roc_iss.h"
+
+#include <elf.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace roc {
+
+namespace {
+
+// AXI-Lite crossbar map (soc.sv).
+constexpr uint32_t GPIO_BASE  = 0x0000;
+constexpr uint32_t SEG7_BASE  = 0x1000;
+constexpr uint32_t UART_BASE  = 0x2000;
+constexpr uint32_t CLINT_BASE = 0x3000;
+constexpr uint32_t SPI_BASE   = 0x4000;
+constexpr uint32_t DMA_BASE   = 0x5000;
+constexpr uint32_t MBOX_BASE  = 0x6000;
+constexpr uint32_t SLAVE_MASK = 0x0FFF;
+constexpr unsigned SLAVE_SHIFT = 12;     // lsu_interconnect SLAVE_LSB
+constexpr uint32_t MMIO_LENGTH = 0x10000000u;
+
+// UART register offsets and status bits (sw/stdio.c).
+constexpr uint32_t UART_STATUS = 0x00;
+constexpr uint32_t UART_TX     = 0x04;
+constexpr uint32_t UART_TX_FULL = 1u << 3;
+
+// SPI register offsets and status bits (sw/main.c).
+constexpr uint32_t SPI_STATUS   = 0;
+constexpr uint32_t SPI_WRITE    = 4;
+constexpr uint32_t SPI_READ     = 8;
+constexpr uint32_t SPI_N_BYTE   = 12;
+constexpr uint32_t SPI_DELAYS   = 16;
+constexpr uint32_t SPI_CLK_DIV  = 20;
+constexpr uint32_t SPI_CFG      = 24;
+constexpr uint32_t SPI_BUSY     = 1u << 4;
+
+// DMA register offsets and bits (axi_dma.sv).
+constexpr uint32_t DMA_CTRL   = 0x00;
+constexpr uint32_t DMA_STATUS = 0x04;
+constexpr uint32_t DMA_DESC   = 0x08;
+constexpr uint32_t DMA_CUR    = 0x0C;
+constexpr uint32_t DMA_COUNT  = 0x10;
+constexpr uint32_t DMA_START  = 1u << 0;
+constexpr uint32_t DMA_IRQ_EN = 1u << 1;
+constexpr uint32_t DMA_ABORT  = 1u << 2;
+constexpr uint32_t DMA_BUSY   = 1u << 0;
+constexpr uint32_t DMA_DONE   = 1u << 1;
+constexpr uint32_t DMA_ERR    = 1u << 2;
+// Descriptor CTRL word
+constexpr uint32_t DMA_D_TO_MEM    = 1u << 16;
+constexpr uint32_t DMA_D_WORD      = 1u << 17;
+constexpr uint32_t DMA_D_WAIT_EACH = 1u << 18;
+constexpr uint32_t DMA_D_WAIT_EN   = 1u << 19;
+constexpr uint32_t DMA_D_WAIT_VAL  = 1u << 20;
+// axi_dma FSM cycles besides the AXI round trips: descriptor fetch (4 DMEM reads
+// and S_NEXT) and the per-element states around the peripheral access.
+constexpr uint64_t DMA_FETCH_CYCLES = 9;
+constexpr uint64_t DMA_ELEM_CYCLES  = 4;
+
+// CLINT register offsets.
+constexpr uint32_t CLINT_MTIME_L    = 0x00;
+constexpr uint32_t CLINT_MTIME_H    = 0x04;
+constexpr uint32_t CLINT_MTIMECMP_L = 0x08;
+constexpr uint32_t CLINT_MTIMECMP_H = 0x0C;
+
+// Mailbox offsets (axi_mailbox.sv): MSIP word per hart, then the shared RAM.
+constexpr uint32_t MBOX_RAM = 0x800;
+
+constexpr uint32_t MIP_MSIP = 1u << 3;
+constexpr uint32_t MIP_MTIP = 1u << 7;
+constexpr uint32_t MIP_MEIP = 1u << 11;
+constexpr uint32_t MIP_BUSERR = 1u << 16;
+
+// Crossbar decode: any other address gets DECERR.
+inline bool mmio_decoded(uint32_t addr) {
+    return addr < MMIO_LENGTH && (addr & ~SLAVE_MASK) <= MBOX_BASE;
+}
+
+inline uint32_t merge(uint32_t old, uint32_t data, uint32_t strb) {
+    uint32_t mask = 0;
+    for (unsigned i = 0; i < 4; i++) {
+        if (strb & (1u << i)) {
+            mask |= 0xFFu << (8 * i);
+        }
+    }
+    return (old & ~mask) | (data & mask);
+}
+
+// $readmemh-style text: one hex word per token, '#' and '//' comments.
+bool parse_hex_words(std::vector<uint8_t> raw, std::vector<uint32_t> &words) {
+    raw.push_back('\0');
+    const char *s = (const char *)raw.data();
+    while (*s) {
+        while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n') {
+            s++;
+        }
+        if (*s == '#' || (*s == '/' && s[1] == '/')) {
+            while (*s && *s != '\n') {
+                s++;
+            }
+            continue;
+        }
+        if (!*s) {
+            break;
+        }
+        char *end = nullptr;
+        unsigned long v = std::strtoul(s, &end, 16);
+        if (end == s) {
+            return false;
+        }
+        words.push_back((uint32_t)v);
+        s = end;
+    }
+    return true;
+}
+
+bool read_file(const std::string &path, std::vector<uint8_t> &out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
+} // namespace
+
+CacheModel::CacheModel(unsigned ways, unsigned sets, unsigned line_words)
+    : ways_(ways ? ways : 1), sets_(sets ? sets : 1), line_shift_(2),
+      tags_(ways_ * sets_, 0), lru_(sets_, 0) {
+    while ((1u << line_shift_) < line_words * 4) {
+        line_shift_++;
+    }
+}
+
+bool CacheModel::read(uint32_t addr) {
+    const uint32_t line = addr >> line_shift_;
+    const unsigned set = line % sets_;
+    uint32_t *t = &tags_[set * ways_];
+    for (unsigned w = 0; w < ways_; w++) {
+        if (t[w] == line + 1) {
+            hits++;
+            lru_[set] = (uint8_t)((w + 1) % ways_);
+            return true;
+        }
+    }
+    misses++;
+    unsigned victim = lru_[set];
+    for (unsigned w = 0; w < ways_; w++) {
+        if (t[w] == 0) {
+            victim = w;
+            break;
+        }
+    }
+    t[victim] = line + 1;
+    lru_[set] = (uint8_t)((victim + 1) % ways_);
+    return false;
+}
+
+Soc::Soc(const SocConfig &cfg)
+    : cfg_(cfg),
+      imem_mask_((1u << cfg.addr_width) - 1),
+      dmem_mask_((1u << cfg.addr_width) - 1),
+      mem_bytes_(4u << cfg.addr_width),
+      imem_(1u << cfg.addr_width, 0),
+      dmem_(1u << cfg.addr_width, 0),
+      icache_model_(cfg.icache_ways, cfg.cache_sets, cfg.cache_line_words),
+      dcache_model_(cfg.dcache_ways, cfg.cache_sets, cfg.cache_line_words),
+      mbox_ram_(MBOX_RAM_WORDS, 0) {
+    uart_byte_cycles_ = (cfg_.clk_freq / cfg_.baud_rate) * 10;
+    if (cfg_.harts > 1) {
+        other_.dmem.assign(1u << cfg.addr_width, 0);
+    }
+    if (cfg_.xmem) {
+        xmem_bytes_ = 4u << cfg_.xmem_addr_width;
+        xmem_.assign(1u << cfg_.xmem_addr_width, 0);
+    }
+    // Miss: AR, READ_LATENCY + 1 wait cycles, one cycle per beat, then the cache
+    // returns to idle and looks the address up again (2 cycles).
+    refill_cycles_ = 1 + (cfg_.xmem_read_latency + 1) + cfg_.cache_line_words + 2;
+    // Store: AW, W, WRITE_LATENCY + 1, BVALID, then wr_ready.
+    write_cycles_ = 2 + (cfg_.xmem_write_latency + 1) + 2;
+    predecode();
+}
+
+Soc::~Soc() {
+    if (trace_) {
+        std::fclose(trace_);
+    }
+}
+
+// Records are written in host byte order, little-endian like the TB's %u words.
+bool Soc::open_trace(const std::string &path) {
+    trace_ = std::fopen(path.c_str(), "wb");
+    if (!trace_) {
+        error_ = "failed to open " + path;
+        return false;
+    }
+    const TraceHeader h{TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord) / 4, 0};
+    std::fwrite(&h, sizeof(h), 1, trace_);
+    return true;
+}
+
+bool Soc::load_xmem(const std::string &path) {
+    std::vector<uint8_t> raw;
+    std::vector<uint32_t> words;
+    if (!read_file(path, raw)) {
+        error_ = "failed to open " + path;
+        return false;
+    }
+    if (!parse_hex_words(raw, words)) {
+        error_ = path + ": invalid hex token";
+        return false;
+    }
+    if (words.size() > xmem_.size()) {
+        error_ = path + ": image too large for XMEM" + (cfg_.xmem ? "" : " (enable it with -xmem)");
+        return false;
+    }
+    std::copy(words.begin(), words.end(), xmem_.begin());
+    predecode();
+    return true;
+}
+
+void Soc::load_words(const std::vector<uint32_t> &words, uint32_t word_addr) {
+    for (size_t i = 0; i < words.size(); i++) {
+        imem_[(word_addr + i) & imem_mask_] = words[i];
+    }
+    predecode();
+}
+
+bool Soc::load_image(const std::string &path) {
+    std::vector<uint8_t> raw;
+    if (!read_file(path, raw)) {
+        error_ = "failed to open " + path;
+        return false;
+    }
+
+    // ELF: copy PT_LOAD segments whose load address falls in IMEM (.text, .rodata
+    // and the .data init image); .bss and the DMEM VMAs are set up by crt0.
+    if (raw.size() >= sizeof(Elf32_Ehdr) && std::memcmp(raw.data(), ELFMAG, SELFMAG) == 0) {
+        Elf32_Ehdr eh;
+        std::memcpy(&eh, raw.data(), sizeof(eh));
+        if (eh.e_ident[EI_CLASS] != ELFCLASS32 || eh.e_machine != EM_RISCV) {
+            error_ = path + ": not an RV32 ELF";
+            return false;
+        }
+        std::vector<uint8_t> bytes(mem_bytes_, 0);
+        for (unsigned i = 0; i < eh.e_phnum; i++) {
+            Elf32_Phdr ph;
+            const size_t off = eh.e_phoff + (size_t)i * eh.e_phentsize;
+            if (off + sizeof(ph) > raw.size()) {
+                error_ = path + ": truncated program header";
+                return false;
+            }
+            std::memcpy(&ph, raw.data() + off, sizeof(ph));
+            if (ph.p_type != PT_LOAD || ph.p_filesz == 0) {
+                continue;
+            }
+            if (ph.p_paddr - cfg_.xmem_base < xmem_bytes_) {
+                if (ph.p_paddr - cfg_.xmem_base + ph.p_filesz > xmem_bytes_ ||
+                    ph.p_offset + ph.p_filesz > raw.size()) {
+                    error_ = path + ": segment does not fit in XMEM";
+                    return false;
+                }
+                for (uint32_t b = 0; b < ph.p_filesz; b++) {
+                    const uint32_t a = ph.p_paddr - cfg_.xmem_base + b;
+                    uint32_t &w = xmem_[a >> 2];
+                    w = (w & ~(0xFFu << (8 * (a & 3)))) | ((uint32_t)raw[ph.p_offset + b] << (8 * (a & 3)));
+                }
+                continue;
+            }
+            if (ph.p_paddr >= mem_bytes_) {
+                continue;
+            }
+            if (ph.p_paddr + ph.p_filesz > mem_bytes_ || ph.p_offset + ph.p_filesz > raw.size()) {
+                error_ = path + ": segment does not fit in IMEM";
+                return false;
+            }
+            std::memcpy(bytes.data() + ph.p_paddr, raw.data() + ph.p_offset, ph.p_filesz);
+        }
+        for (uint32_t w = 0; w < imem_.size(); w++) {
+            imem_[w] = (uint32_t)bytes[4 * w] | ((uint32_t)bytes[4 * w + 1] << 8) |
+                       ((uint32_t)bytes[4 * w + 2] << 16) | ((uint32_t)bytes[4 * w + 3] << 24);
+        }
+        predecode();
+        return true;
+    }
+
+    std::vector<uint32_t> words;
+    const bool is_bin = path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+    if (is_bin) {
+        raw.resize((raw.size() + 3) & ~(size_t)3, 0);
+        for (size_t i = 0; i < raw.size(); i += 4) {
+            words.push_back((uint32_t)raw[i] | ((uint32_t)raw[i + 1] << 8) |
+                            ((uint32_t)raw[i + 2] << 16) | ((uint32_t)raw[i + 3] << 24));
+        }
+    } else if (!parse_hex_words(raw, words)) {
+        error_ = path + ": invalid hex token";
+        return false;
+    }
+
+    if (words.empty()) {
+        error_ = "imem file is empty: " + path;
+        return false;
+    }
+    if (words.size() > imem_.size()) {
+        error_ = path + ": image too large for IMEM";
+        return false;
+    }
+    load_words(words);
+    return true;
+}
+
+// lsu_interconnect decode: DMEM, then the IMEM window, then MMIO. Anything else
+// leaves rvalid/wready low and would hang the RTL core in S_MEM.
+bool Soc::load(uint32_t addr, uint32_t &data) {
+    if (addr - cfg_.dmem_base < mem_bytes_) {
+        data = dmem_[(addr - cfg_.dmem_base) >> 2];
+        return true;
+    }
+    if (addr - cfg_.imem_base < mem_bytes_) {
+        data = imem_[(addr - cfg_.imem_base) >> 2];
+        return true;
+    }
+    if (addr - cfg_.xmem_base < xmem_bytes_) {
+        if (!dcache_model_.read(addr)) {
+            cycles_ += refill_cycles_;
+            lsu_stall(refill_cycles_);
+        }
+        data = xmem_[(addr - cfg_.xmem_base) >> 2];
+        return true;
+    }
+    if (addr < MMIO_LENGTH) {
+        // A load waits for posted writes to the same slave, then does its own round trip.
+        wbuf_wait(false, addr >> SLAVE_SHIFT);
+        cycles_ += cfg_.mmio_latency;
+        lsu_stall(cfg_.mmio_latency);
+        data = mmio_read(addr);
+        return true;
+    }
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "load from unmapped address 0x%08x (pc=0x%08x)", addr, pc_);
+    error_ = buf;
+    return false;
+}
+
+bool Soc::store(uint32_t addr, uint32_t data, uint32_t strb) {
+    if (addr - cfg_.dmem_base < mem_bytes_) {
+        uint32_t &w = dmem_[(addr - cfg_.dmem_base) >> 2];
+        w = merge(w, data, strb);
+        return true;
+    }
+    if (addr - cfg_.xmem_base < xmem_bytes_) {
+        // Write-through: every store waits for its BRESP; a cached line is updated
+        // in place and a missing one is not allocated, so the tags do not change.
+        const uint32_t idx = (addr - cfg_.xmem_base) >> 2;
+        cycles_ += write_cycles_;
+        lsu_stall(write_cycles_);
+        xmem_[idx] = merge(xmem_[idx], data, strb);
+        xmem_redecode(idx);
+        return true;
+    }
+    if (addr < MMIO_LENGTH) {
+        if (cfg_.wbuf_depth == 0) {
+            cycles_ += cfg_.mmio_latency;
+            lsu_stall(cfg_.mmio_latency);
+        } else {
+            // Posted: the store retires as soon as there is a free entry. The slave
+            // sees it now (functionally the same), BRESP returns after the queue ahead.
+            wbuf_wait(false, ~0u);
+            if (wbuf_.size() >= cfg_.wbuf_depth) {
+                lsu_stall(wbuf_.front().done - cycles_);
+                cycles_ = wbuf_.front().done;
+                wbuf_.pop_front();
+            }
+            const uint64_t start = wbuf_.empty() ? cycles_ : wbuf_.back().done;
+            wbuf_.push_back({addr >> SLAVE_SHIFT, start + cfg_.mmio_latency});
+        }
+        if (!mmio_write(addr, data, strb) && !buserr_pend_) {
+            // DECERR from the crossbar: reported through mbuserr, not a precise trap.
+            buserr_pend_ = true;
+            buserr_addr_ = addr;
+            mip_ |= MIP_BUSERR;
+        }
+        return true;
+    }
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "store to %s address 0x%08x (pc=0x%08x)",
+                  (addr - cfg_.imem_base < mem_bytes_) ? "read-only IMEM" : "unmapped", addr, pc_);
+    error_ = buf;
+    return false;
+}
+
+unsigned Soc::uart_tx_level() const {
+    if (uart_tx_done_ <= cycles_) {
+        return 0;
+    }
+    return (unsigned)((uart_tx_done_ - cycles_ + uart_byte_cycles_ - 1) / uart_byte_cycles_);
+}
+
+// Drop posted writes whose BRESP is back; then wait for every entry (all) or the
+// ones targeting `slave`. slave = ~0u only retires completed entries.
+void Soc::wbuf_wait(bool all, uint32_t slave) {
+    while (!wbuf_.empty() && wbuf_.front().done <= cycles_) {
+        wbuf_.pop_front();
+    }
+    uint64_t until = cycles_;
+    for (const PostedWrite &w : wbuf_) {
+        if (all || w.slave == slave) {
+            until = w.done;
+        }
+    }
+    if (until > cycles_) {
+        if (!all) {
+            lsu_stall(until - cycles_);
+        }
+        cycles_ = until;
+        while (!wbuf_.empty() && wbuf_.front().done <= cycles_) {
+            wbuf_.pop_front();
+        }
+    }
+}
+
+uint32_t Soc::mmio_read(uint32_t addr) {
+    const uint32_t off = addr & SLAVE_MASK & ~3u;
+    switch (addr & ~SLAVE_MASK) {
+    case GPIO_BASE:
+        return gpio_regs_[(off >> 2) & 15];
+    case SEG7_BASE:
+        return off == 0 ? seg7_data_ : (off == 4 ? seg7_dp_ : 0);
+    case UART_BASE:
+        if (off == UART_STATUS) {
+            return (uart_tx_level() >= cfg_.uart_tx_depth) ? UART_TX_FULL : 0;
+        }
+        return 0;
+    case CLINT_BASE:
+        switch (off) {
+        case CLINT_MTIME_L:    return (uint32_t)cycles_;
+        case CLINT_MTIME_H:    return (uint32_t)(cycles_ >> 32);
+        case CLINT_MTIMECMP_L: return (uint32_t)mtimecmp_;
+        case CLINT_MTIMECMP_H: return (uint32_t)(mtimecmp_ >> 32);
+        default:               return 0;
+        }
+    case SPI_BASE:
+        switch (off) {
+        case SPI_STATUS:  return (cycles_ < spi_busy_until_) ? SPI_BUSY : 0;
+        case SPI_READ:
+            if (spi_rx_count_ > 0) {
+                spi_rx_count_--;
+                return cfg_.spi_miso;
+            }
+            return 0;
+        case SPI_DELAYS:  return spi_delays_;
+        case SPI_CLK_DIV: return spi_clk_div_;
+        case SPI_CFG:     return spi_cfg_;
+        default:          return 0;
+        }
+    case DMA_BASE:
+        switch (off) {
+        case DMA_CTRL:   return dma_irq_en_ ? DMA_IRQ_EN : 0;
+        case DMA_STATUS:
+            return (dma_busy_ ? DMA_BUSY : 0) | (dma_done_ ? DMA_DONE : 0) | (dma_err_ ? DMA_ERR : 0);
+        case DMA_DESC:   return dma_desc_;
+        case DMA_CUR:    return dma_cur_;
+        case DMA_COUNT:  return dma_count_;
+        default:         return 0;
+        }
+    case MBOX_BASE:
+        if (off >= MBOX_RAM) {
+            return mbox_ram_[((off - MBOX_RAM) >> 2) % MBOX_RAM_WORDS];
+        }
+        return (off >> 2) < cfg_.harts ? (mbox_msip_ >> (off >> 2)) & 1u : 0;
+    default:
+        return 0;
+    }
+}
+
+// Returns false for an address no crossbar slave decodes (DECERR).
+bool Soc::mmio_write(uint32_t addr, uint32_t data, uint32_t strb) {
+    const uint32_t off = addr & SLAVE_MASK & ~3u;
+    switch (addr & ~SLAVE_MASK) {
+    case GPIO_BASE: {
+        uint32_t &r = gpio_regs_[(off >> 2) & 15];
+        r = merge(r, data, strb);
+        break;
+    }
+    case SEG7_BASE:
+        if (off == 0) {
+            seg7_data_ = merge(seg7_data_, data, strb);
+        } else if (off == 4) {
+            seg7_dp_ = merge(seg7_dp_, data, strb);
+        }
+        break;
+    case UART_BASE:
+        if (off == UART_TX && uart_tx_level() < cfg_.uart_tx_depth) {
+            const uint64_t start = (uart_tx_done_ > cycles_) ? uart_tx_done_ : cycles_;
+            uart_tx_done_ = start + uart_byte_cycles_;
+            std::putchar((int)(data & 0xFFu));
+            next_event_ = 0;
+        }
+        break;
+    case CLINT_BASE:
+        if (off == CLINT_MTIMECMP_L) {
+            mtimecmp_ = (mtimecmp_ & ~0xFFFFFFFFull) | merge((uint32_t)mtimecmp_, data, strb);
+        } else if (off == CLINT_MTIMECMP_H) {
+            mtimecmp_ = (mtimecmp_ & 0xFFFFFFFFull) |
+                        ((uint64_t)merge((uint32_t)(mtimecmp_ >> 32), data, strb) << 32);
+        }
+        next_event_ = 0;
+        break;
+    case SPI_BASE:
+        switch (off) {
+        case SPI_WRITE:
+            spi_tx_count_++;
+            break;
+        case SPI_N_BYTE: {
+            // One SPI bit every 2*clk_div cycles (clk_div is the half-period count).
+            const uint32_t rx_len = data & 0xFFFFu;
+            const uint32_t tx_len = data >> 16;
+            const uint64_t bit_cycles = 2ull * (spi_clk_div_ ? spi_clk_div_ : 1);
+            spi_busy_until_ = cycles_ + (uint64_t)(tx_len + rx_len) * 8 * bit_cycles;
+            spi_tx_count_ = 0;
+            spi_rx_count_ = rx_len;
+            break;
+        }
+        case SPI_DELAYS:  spi_delays_ = data; break;
+        case SPI_CLK_DIV: spi_clk_div_ = data; break;
+        case SPI_CFG:     spi_cfg_ = data; break;
+        default: break;
+        }
+        break;
+    case DMA_BASE:
+        switch (off) {
+        case DMA_CTRL:
+            dma_irq_en_ = (data & DMA_IRQ_EN) != 0;
+            if ((data & DMA_ABORT) && dma_busy_) {
+                dma_abort_ = true;
+            }
+            if ((data & DMA_START) && !dma_busy_) {
+                dma_done_ = false;
+                dma_err_ = false;
+                dma_abort_ = false;
+                dma_count_ = 0;
+                dma_cur_ = dma_desc_;
+                dma_phase_ = DmaPhase::Fetch;
+                dma_busy_ = true;
+                dma_next_ = cycles_ + 1;
+            }
+            break;
+        case DMA_STATUS:
+            if (data & DMA_DONE) dma_done_ = false;
+            if (data & DMA_ERR)  dma_err_ = false;
+            break;
+        case DMA_DESC:
+            dma_desc_ = data;
+            break;
+        default: break;
+        }
+        next_event_ = 0;
+        break;
+    case MBOX_BASE:
+        if (off >= MBOX_RAM) {
+            uint32_t &w = mbox_ram_[((off - MBOX_RAM) >> 2) % MBOX_RAM_WORDS];
+            w = merge(w, data, strb);
+        } else if ((off >> 2) < cfg_.harts && (strb & 1u)) {
+            const uint32_t bit = 1u << (off >> 2);
+            mbox_msip_ = (data & 1u) ? (mbox_msip_ | bit) : (mbox_msip_ & ~bit);
+            next_event_ = 0;
+        }
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+// The chain ends: DONE (or ERR) and the engine goes idle.
+void Soc::dma_stop(bool err) {
+    dma_busy_ = false;
+    (err ? dma_err_ : dma_done_) = true;
+}
+
+// One step of axi_dma at cycle dma_next_: a descriptor fetch, a status poll or
+// one element. Peripheral side effects (SPI N_BYTE, UART TX) see that cycle.
+// Bus contention with the LSU is not modelled.
+void Soc::dma_step() {
+    const uint64_t now = cycles_;
+    const uint64_t axi = cfg_.mmio_latency;
+    cycles_ = dma_next_;
+
+    switch (dma_phase_) {
+    case DmaPhase::Fetch: {
+        const uint32_t off = dma_cur_ - cfg_.dmem_base;
+        if ((dma_cur_ & 3u) != 0 || off > mem_bytes_ - 16) {
+            dma_stop(true);
+            break;
+        }
+        dma_periph_    = dmem_[(off >> 2) + 0];
+        dma_mem_       = dmem_[(off >> 2) + 1];
+        dma_ctrl_      = dmem_[(off >> 2) + 2];
+        dma_next_desc_ = dmem_[(off >> 2) + 3];
+        dma_left_      = dma_ctrl_ & 0xFFFFu;
+        dma_phase_     = (dma_ctrl_ & DMA_D_WAIT_EN) ? DmaPhase::Poll : DmaPhase::Elem;
+        dma_next_ += DMA_FETCH_CYCLES;
+        break;
+    }
+    case DmaPhase::Poll: {
+        const uint32_t status_addr = dma_periph_ & ~SLAVE_MASK;
+        if (!mmio_decoded(status_addr)) {
+            dma_stop(true);
+            break;
+        }
+        if (dma_abort_) {
+            dma_stop(false);
+            break;
+        }
+        const uint32_t bit = (dma_ctrl_ >> 24) & 31u;
+        const uint32_t val = (dma_ctrl_ & DMA_D_WAIT_VAL) ? 1u : 0u;
+        const uint64_t period = axi + 1;
+        dma_next_ += period;
+        if (((mmio_read(status_addr) >> bit) & 1u) != val) {
+            dma_phase_ = DmaPhase::Elem;
+        } else if (status_addr == SPI_BASE && (1u << bit) == SPI_BUSY && val == 1u &&
+                   spi_busy_until_ > dma_next_) {
+            // SPI busy only changes at spi_busy_until_: skip to the poll that sees it low.
+            dma_next_ += (spi_busy_until_ - dma_next_ + period - 1) / period * period;
+        }
+        break;
+    }
+    case DmaPhase::Elem: {
+        if (dma_left_ == 0) {
+            dma_cur_ = dma_next_desc_;
+            dma_phase_ = DmaPhase::Fetch;
+            dma_next_ += 1;
+            if (dma_next_desc_ == 0 || dma_abort_) {
+                dma_stop(false);
+            }
+            break;
+        }
+        if (dma_abort_) {
+            dma_stop(false);
+            break;
+        }
+        const uint32_t off = dma_mem_ - cfg_.dmem_base;
+        if (off >= mem_bytes_ || !mmio_decoded(dma_periph_)) {
+            dma_stop(true);
+            break;
+        }
+        const bool word = (dma_ctrl_ & DMA_D_WORD) != 0;
+        uint32_t &w = dmem_[off >> 2];
+        if (dma_ctrl_ & DMA_D_TO_MEM) {
+            const uint32_t d = mmio_read(dma_periph_);
+            w = word ? d : merge(w, (d & 0xFFu) * 0x01010101u, 1u << (off & 3u));
+        } else {
+            mmio_write(dma_periph_, word ? w : (w >> (8 * (off & 3u))) & 0xFFu, 0xFu);
+        }
+        dma_count_++;
+        dma_left_--;
+        dma_mem_ += word ? 4 : 1;
+        dma_next_ += axi + DMA_ELEM_CYCLES;
+        if ((dma_ctrl_ & DMA_D_WAIT_EN) && (dma_ctrl_ & DMA_D_WAIT_EACH) && dma_left_ != 0) {
+            dma_phase_ = DmaPhase::Poll;
+        }
+        break;
+    }
+    }
+    cycles_ = now;
+}
+
+// Run the engine up to the current cycle.
+void Soc::dma_advance() {
+    while (dma_busy_ && dma_next_ <= cycles_) {
+        dma_step();
+    }
+}
+
+// Recompute timer_irq / external_irq and the next cycle at which either may change.
+// Hart 1 only has its mailbox MSIP line; the DMA (which reaches hart 0's DMEM) and
+// the other lines advance while hart 0 runs.
+void Soc::update_irq_lines() {
+    const uint32_t msip = ((mbox_msip_ >> hart_id_) & 1u) ? MIP_MSIP : 0;
+    if (hart_id_ != 0) {
+        mip_ = msip | (buserr_pend_ ? MIP_BUSERR : 0);
+        next_event_ = ~0ull;
+        return;
+    }
+    uint64_t next = ~0ull;
+
+    dma_advance();
+    if (dma_busy_) {
+        next = dma_next_;
+    }
+
+    const bool timer = cycles_ >= mtimecmp_;
+    if (!timer && mtimecmp_ < next) {
+        next = mtimecmp_;
+    }
+
+    gpio_irq_ = false;
+    if (cfg_.gpio_irq_period != 0) {
+        const uint64_t span = cfg_.gpio_irq_period + cfg_.gpio_irq_width;
+        const uint64_t phase = cycles_ % span;
+        gpio_irq_ = phase >= cfg_.gpio_irq_period;
+        const uint64_t edge = cycles_ - phase + (gpio_irq_ ? span : cfg_.gpio_irq_period);
+        if (edge < next) {
+            next = edge;
+        }
+    }
+
+    // UART TX room (soc uart_tx_irq): at most half of the TX FIFO still queued.
+    const uint64_t low_water = (uint64_t)(cfg_.uart_tx_depth / 2) * uart_byte_cycles_;
+    const bool uart_irq = uart_tx_level() <= cfg_.uart_tx_depth / 2;
+    if (!uart_irq && uart_tx_done_ - low_water < next) {
+        next = uart_tx_done_ - low_water;
+    }
+
+    const bool dma_irq = dma_irq_en_ && (dma_done_ || dma_err_);
+    ext_int_ = (gpio_irq_ ? 1u : 0u) | (uart_irq ? 2u : 0u) | (dma_irq ? 4u : 0u);
+    mip_ = msip | (timer ? MIP_MTIP : 0) | ((ext_int_ & ext_int_en_) ? MIP_MEIP : 0) |
+           (buserr_pend_ ? MIP_BUSERR : 0);
+    next_event_ = next;
+}
+
+// The FSM idles in S_FETCH after WFI until an interrupt enabled in mie is pending.
+void Soc::wfi_fast_forward(uint64_t limit) {
+    while (!(mip_ & mie_) && cycles_ < limit) {
+        const uint64_t next = (next_event_ < limit) ? next_event_ : limit;
+        if (next > cycles_) {
+            hpm_add(7, next - cycles_);
+            cycles_ = next;
+        }
+        update_irq_lines();
+    }
+}
+
+} // namespace roc
@@ -0,0 +1,324 @@
+#!/usr/bin/env python3
+"""Parallel regression runner for the programs in sw/tests/.
+
+- The RTL in tb_ROC_RV32.flist is compiled once into questasim/regress/ and reused
+  while the file list and every file it names are unchanged (content-hash stamp).
+- Each test is built into build/regress/<test>/ with its own ELF and imem.dat and is
+  simulated in its own work directory, with the image passed as +IMEM=<path>.
+- N tests run in parallel; a pass/fail, cycles and wall-time table is printed at the end.
+
+Per-test plusargs can be given in the test source with a line containing
+`REGRESS_ARGS: +MAX_CYCLES=20000000 ...`. A line `REGRESS_REQUIRES: CPU_RV32M`
+marks a test that only builds/runs with --rv32m (`CPU_RV32C`: with --rv32c, `XMEM`: with --xmem);
+it is reported as SKIP otherwise. `DUAL_HART` tests run on a second, N_HARTS=2 build of
+the simulator when --harts is 1 (SKIP with --xmem, which has no second hart).
+
+Questa and Verilator runs load IMEM and dump DMEM directly (+FAST_LOAD +FAST_DUMP)
+instead of through the bootloader UART; a test with `REGRESS_BOOT: uart` (or every
+test with --uart-boot) goes through the UART. The UART cycles skipped and the
+wall time they would have taken are summed at the end.
+"""
+
+from __future__ import annotations
+
+import argparse
+import hashlib
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from dataclasses import dataclass
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+TESTS_DIR = ROOT / "sw" / "tests"
+FLIST = ROOT / "tb_ROC_RV32.flist"
+QUESTA_DIR = ROOT / "questasim" / "regress"
+BUILD_ROOT = ROOT / "build" / "regress"
+TOP_MODULE = "tb_ROC_RV32_program"
+
+ISS_BIN = ROOT / "tools" / "iss" / "roc_iss"
+VL_BUILD = ROOT / "build"
+
+
+@dataclass
+class Result:
+    name: str
+    status: str = "ERROR"
+    cycles: int | None = None
+    cpi: float | None = None
+    build_s: float = 0.0
+    sim_s: float = 0.0
+    boot: str = "-"
+    skipped_cycles: int = 0
+    sim_cycles: int | None = None
+    log: Path | None = None
+
+    def saved_s(self) -> float:
+        """Wall time the skipped UART cycles would have taken at this run's cycles/s."""
+        if not self.skipped_cycles or not self.sim_cycles:
+            return 0.0
+        return self.sim_s * self.skipped_cycles / self.sim_cycles
+
+
+def flist_sources(flist: Path) -> list[Path]:
+    """Sources named in the file list plus the headers found in its +incdir+ directories."""
+    files = []
+    for line in flist.read_text().splitlines():
+        line = line.strip()
+        if not line or line.startswith("//"):
+            continue
+        if line.startswith("+incdir+"):
+            inc = ROOT / line[len("+incdir+"):]
+            files.extend(sorted(p for p in inc.glob("*") if p.suffix in (".svh", ".vh")))
+        elif not line.startswith("+"):
+            files.append(ROOT / line)
+    return files
+
+
+def rtl_hash(flist: Path, generics: list[str]) -> str:
+    h = hashlib.sha256()
+    h.update(flist.read_bytes())
+    for f in flist_sources(flist):
+        h.update(str(f.relative_to(ROOT)).encode())
+        h.update(f.read_bytes() if f.exists() else b"<missing>")
+    h.update(TOP_MODULE.encode())
+    h.update(" ".join(generics).encode())
+    return h.hexdigest()
+
+
+def compile_questa(force: bool, generics: list[str], qdir: Path = QUESTA_DIR) -> Path:
+    lib = qdir / "work"
+    stamp = qdir / "rtl.sha256"
+    key = rtl_hash(FLIST, generics)
+    if not force and lib.is_dir() and stamp.exists() and stamp.read_text().strip() == key:
+        print(f"[regress] RTL unchanged, reusing {lib.relative_to(ROOT)}")
+        return lib
+
+    print(f"[regress] compiling RTL from {FLIST.name} into {lib.relative_to(ROOT)}")
+    if qdir.exists():
+        shutil.rmtree(qdir)
+    qdir.mkdir(parents=True)
+    log = qdir / "compile.log"
+    with log.open("w") as f:
+        for cmd in (
+            ["vlib", str(lib)],
+            ["vlog", "-sv", "-work", str(lib), "-f", str(FLIST)],
+            ["vopt", "+acc", "-work", str(lib), *generics, TOP_MODULE, "-o", f"{TOP_MODULE}_opt"],
+        ):
+            f.write("$ " + " ".join(cmd) + "\n")
+            f.flush()
+            if subprocess.run(cmd, cwd=ROOT, stdout=f, stderr=subprocess.STDOUT).returncode != 0:
+                raise SystemExit(f"[regress] RTL compile failed, see {log}")
+    stamp.write_text(key + "\n")
+    return lib
+
+
+def test_tag(src: Path, tag: str) -> list[str]:
+    for line in src.read_text(errors="replace").splitlines()[:40]:
+        m = re.search(tag + r":\s*(.*)$", line)
+        if m:
+            return m.group(1).split()
+    return []
+
+
+def build_test(src: Path, out_dir: Path, rv32m: bool, rv32c: bool,
+               make_vars: list[str] | None = None) -> tuple[bool, str]:
+    out_dir.mkdir(parents=True, exist_ok=True)
+    cmd = [
+        "make", "-s", "-C", str(ROOT),
+        f"SW_APP={src.relative_to(ROOT / 'sw')}",
+        f"BUILD_DIR={out_dir.relative_to(ROOT)}",
+        f"IMEM_DAT={(out_dir / 'imem.dat').relative_to(ROOT)}",
+        f"CPU_RV32M={int(rv32m)}",
+        f"CPU_RV32C={int(rv32c)}",
+        *(make_vars or []),
+        "image",
+    ]
+    p = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    (out_dir / "build.log").write_text(p.stdout)
+    return p.returncode == 0, p.stdout
+
+
+def vl_bin(pipeline: bool, rv32m: bool, early_irq: bool, rv32c: bool, xmem: bool, harts: int = 1) -> Path:
+    name = ("verilator_t1" + ("_pipe" if pipeline else "") + ("_m" if rv32m else "")
+            + ("_ei" if early_irq else "") + ("_c" if rv32c else "") + ("_x11" if xmem else "")
+            + (f"_h{harts}" if harts != 1 else ""))
+    return VL_BUILD / name / "Vtb_soc_verilator"
+
+
+def sim_command(sim: str, lib: Path | None, image: Path, extra: list[str],
+                pipeline: bool, rv32m: bool, early_irq: bool, rv32c: bool, xmem: bool,
+                fast_boot: bool = True, harts: int = 1) -> list[str]:
+    boot = ["+FAST_LOAD", "+FAST_DUMP"] if fast_boot else []
+    if sim == "questa":
+        return ["vsim", "-c", "-lib", str(lib), f"{TOP_MODULE}_opt",
+                "-do", "run -all; quit -f", f"+IMEM={image}", *boot, *extra]
+    if sim == "verilator":
+        return [str(vl_bin(pipeline, rv32m, early_irq, rv32c, xmem, harts)), f"+IMEM={image}", *boot, *extra]
+    return [str(ISS_BIN), "-file", str(image), *(["-rv32m"] if rv32m else []),
+            *(["-early-irq"] if early_irq else []), *(["-rv32c"] if rv32c else []),
+            *(["-pipeline"] if pipeline else []), *(["-xmem"] if xmem else []), *(["-harts", str(harts)] if harts != 1 else []), *extra]
+
+
+def parse_log(text: str, res: Result) -> None:
+    if "DMEM dump mismatch" in text:
+        res.status = "FAIL"
+    elif "PASS: SUCCESS signature" in text:
+        res.status = "PASS"
+    elif "FAIL signature" in text:
+        res.status = "FAIL"
+    elif "Timeout" in text:
+        res.status = "TIMEOUT"
+    m = re.search(r"cycles=(\d+)", text)
+    if m:
+        res.cycles = int(m.group(1))
+    m = re.search(r"CPI=([0-9.]+)", text)
+    if m:
+        res.cpi = float(m.group(1))
+    m = re.search(r"\[TB\] boot: load=(\w+) dump=(\w+) uart_cycles=\d+ skipped_cycles=(\d+) sim_cycles=(\d+)", text)
+    if m:
+        res.boot = m.group(1) if m.group(1) == m.group(2) else f"{m.group(1)}/{m.group(2)}"
+        res.skipped_cycles = int(m.group(3))
+        res.sim_cycles = int(m.group(4))
+
+
+def run_test(src: Path, sim: str, lib: Path | None, extra: list[str],
+             pipeline: bool, rv32m: bool, early_irq: bool, rv32c: bool, xmem: bool,
+             uart_boot: bool, harts: int = 1) -> Result:
+    name = src.stem
+    res = Result(name)
+    out_dir = BUILD_ROOT / name
+
+    requires = test_tag(src, "REGRESS_REQUIRES")
+    if (("CPU_RV32M" in requires and not rv32m) or ("CPU_RV32C" in requires and not rv32c)
+            or ("XMEM" in requires and not xmem) or ("DUAL_HART" in requires and harts < 2)):
+        res.status = "SKIP"
+        return res
+
+    t0 = time.monotonic()
+    ok, out = build_test(src, out_dir, rv32m, rv32c, [f"N_HARTS={harts}"])
+    res.build_s = time.monotonic() - t0
+    if not ok:
+        res.status = "BUILD"
+        res.log = out_dir / "build.log"
+        return res
+
+    work = out_dir / f"sim_{sim}"
+    work.mkdir(exist_ok=True)
+    fast_boot = not uart_boot and "uart" not in test_tag(src, "REGRESS_BOOT")
+    cmd = sim_command(sim, lib, out_dir / "imem.dat", test_tag(src, "REGRESS_ARGS") + extra,
+                      pipeline, rv32m, early_irq, rv32c, xmem, fast_boot, harts)
+    res.log = work / "sim.log"
+    t0 = time.monotonic()
+    p = subprocess.run(cmd, cwd=work, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    res.sim_s = time.monotonic() - t0
+    res.log.write_text("$ " + " ".join(cmd) + "\n" + p.stdout)
+    parse_log(p.stdout, res)
+    return res
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser()
+    ap.add_argument("tests", nargs="*", help="Test names (stem of sw/tests/*.c|*.S); default: all")
+    ap.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1, help="Parallel tests")
+    ap.add_argument("--sim", choices=("questa", "verilator", "iss"), default="questa")
+    ap.add_argument("--pipeline", action="store_true", help="Build the RTL with CPU_PIPELINE=1")
+    ap.add_argument("--rv32m", action="store_true",
+                    help="Build the RTL with CPU_RV32M=1 and the tests with -march=rv32imzicsr")
+    ap.add_argument("--early-irq", action="store_true",
+                    help="Build the RTL with CPU_EARLY_IRQ=1 (interrupts between instructions)")
+    ap.add_argument("--rv32c", action="store_true",
+                    help="Build the RTL with CPU_RV32C=1 and the tests with compressed instructions")
+    ap.add_argument("--xmem", action="store_true",
+                    help="Build the RTL with XMEM_EN=1 (I/D caches over the AXI4 memory model)")
+    ap.add_argument("--harts", type=int, choices=(1, 2), default=1,
+                    help="Build the RTL with N_HARTS (2: second hart, AMOs, mailbox) and the tests to match")
+    ap.add_argument("--force-compile", action="store_true", help="Recompile the RTL even if unchanged")
+    ap.add_argument("--plusargs", default="", help="Extra plusargs for every test")
+    ap.add_argument("--uart-boot", action="store_true",
+                    help="Load IMEM and dump DMEM through the bootloader UART in every test")
+    ap.add_argument("--list", action="store_true", help="List tests and exit")
+    args = ap.parse_args()
+
+    srcs = sorted(p for p in TESTS_DIR.iterdir() if p.suffix in (".c", ".S"))
+    if args.tests:
+        wanted = set(args.tests)
+        srcs = [p for p in srcs if p.stem in wanted]
+        missing = wanted - {p.stem for p in srcs}
+        if missing:
+            print(f"[regress] unknown tests: {', '.join(sorted(missing))}", file=sys.stderr)
+            return 2
+    if args.list:
+        for p in srcs:
+            print(p.stem)
+        return 0
+
+    if args.xmem and args.harts > 1:
+        print("[regress] --xmem and --harts 2 do not combine (hart 1 has no XMEM port)", file=sys.stderr)
+        return 2
+
+    # Hart count each test runs with: DUAL_HART tests get their own N_HARTS=2 build.
+    test_harts = {p: 2 if (args.harts == 1 and not args.xmem
+                           and "DUAL_HART" in test_tag(p, "REGRESS_REQUIRES")) else args.harts
+                  for p in srcs}
+
+    t_start = time.monotonic()
+    libs: dict[int, Path | None] = {}
+    for harts in sorted(set(test_harts.values())):
+        if args.sim == "questa":
+            qdir = QUESTA_DIR if harts == args.harts else QUESTA_DIR.with_name(f"regress_h{harts}")
+            libs[harts] = compile_questa(args.force_compile, [f"-GCPU_PIPELINE={int(args.pipeline)}",
+                                                              f"-GCPU_RV32M={int(args.rv32m)}",
+                                                              f"-GCPU_EARLY_IRQ={int(args.early_irq)}",
+                                                              f"-GCPU_RV32C={int(args.rv32c)}",
+                                                              f"-GXMEM_EN={int(args.xmem)}",
+                                                              f"-GN_HARTS={harts}"], qdir)
+        else:
+            # The ISS takes -harts at run time: one build covers both.
+            target = "iss" if args.sim == "iss" else "verilator-build"
+            subprocess.run(["make", "-s", "-C", str(ROOT), target, "VL_THREADS=1",
+                            f"CPU_PIPELINE={int(args.pipeline)}", f"CPU_RV32M={int(args.rv32m)}",
+                            f"CPU_EARLY_IRQ={int(args.early_irq)}", f"CPU_RV32C={int(args.rv32c)}",
+                            f"XMEM={int(args.xmem)}", f"N_HARTS={harts}"],
+                           check=True)
+            libs[harts] = None
+
+    extra = args.plusargs.split()
+    results: list[Result] = []
+    with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        futs = [pool.submit(run_test, p, args.sim, libs[test_harts[p]], extra, args.pipeline, args.rv32m,
+                            args.early_irq, args.rv32c, args.xmem, args.uart_boot, test_harts[p])
+                for p in srcs]
+        for fut in as_completed(futs):
+            r = fut.result()
+            results.append(r)
+            print(f"[regress] {r.name}: {r.status}")
+
+    results.sort(key=lambda r: r.name)
+    width = max([len(r.name) for r in results] + [4])
+    print()
+    print(f"{'test':<{width}}  {'result':<8} {'cycles':>12} {'CPI':>6} {'build_s':>8} {'sim_s':>8} "
+          f"{'boot':>6}  log")
+    for r in results:
+        cycles = str(r.cycles) if r.cycles is not None else "-"
+        cpi = f"{r.cpi:.3f}" if r.cpi is not None else "-"
+        log = str(r.log.relative_to(ROOT)) if r.log else ""
+        print(f"{r.name:<{width}}  {r.status:<8} {cycles:>12} {cpi:>6} {r.build_s:>8.1f} {r.sim_s:>8.1f} "
+              f"{r.boot:>6}  {log}")
+    passed = sum(r.status == "PASS" for r in results)
+    skipped = sum(r.status == "SKIP" for r in results)
+    direct = [r for r in results if r.skipped_cycles]
+    if direct:
+        print(f"\ndirect IMEM load/DMEM dump in {len(direct)} tests: {sum(r.skipped_cycles for r in direct)} "
+              f"UART cycles skipped, ~{sum(r.saved_s() for r in direct):.1f}s of simulation saved")
+    print(f"\n{passed}/{len(results) - skipped} passed ({skipped} skipped), {args.jobs} jobs, "
+          f"sim={args.sim}, wall {time.monotonic() - t_start:.1f}s")
+    return 0 if passed + skipped == len(results) else 1
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,631 @@
+// roc_prof: cycle profile of a retirement trace (+TRACE=<file> from
+// tb_ROC_RV32_program, the Verilator harness or the ISS; see roc_trace.h).
+//
+// Each instruction is charged the cycles since the previous one retired, so
+// stalls, trap entry and WFI sleep land on the instruction that waited. The
+// trace is symbolized against the program's ELF (.symtab) and reported as:
+//  - functions: self and inclusive cycles, instructions, LSU wait cycles,
+//  - basic blocks (split at every jump, branch, trap and jump target seen),
+//  - LSU wait by target (DMEM, each MMIO slave, XMEM) and by instruction,
+//  - collapsed stacks for flamegraph.pl with -folded.
+// Call stacks are rebuilt from JAL/JALR link-register hints, trap entry
+// (TRACE_INTR) and MRET, and register values tracked from rd writebacks.
+#include "roc_trace.h"
+
+#include <elf.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using roc::TraceRecord;
+
+constexpr uint32_t OPC_BRANCH = 0x63;
+constexpr uint32_t OPC_JALR   = 0x67;
+constexpr uint32_t OPC_JAL    = 0x6F;
+constexpr uint32_t INSN_MRET  = 0x30200073u;
+
+constexpr size_t MAX_DEPTH = 256;
+
+// lsu_interconnect / soc map
+constexpr uint32_t MMIO_LENGTH = 0x10000000u;
+constexpr uint32_t DMEM_BASE   = 0x10000000u;
+constexpr uint32_t IMEM_BASE   = 0x20000000u;
+constexpr uint32_t XMEM_BASE   = 0x80000000u;
+constexpr unsigned SLAVE_SHIFT = 12;
+const char *const SLAVE_NAMES[] = {"GPIO", "7SEG", "UART", "CLINT", "SPI", "DMA"};
+
+struct Symbol {
+    uint32_t addr;
+    uint32_t size;          // 0: up to the next symbol
+    std::string name;
+};
+
+struct FuncStats {
+    uint64_t self = 0;
+    uint64_t incl = 0;
+    uint64_t insns = 0;
+    uint64_t wait = 0;
+    uint64_t calls = 0;
+    uint64_t last_incl = ~0ull; // record index of the last inclusive charge (recursion)
+};
+
+struct BlockStats {
+    uint32_t last_pc = 0;
+    uint64_t execs = 0;
+    uint64_t insns = 0;
+    uint64_t cycles = 0;
+    uint64_t wait = 0;
+};
+
+struct SiteStats {
+    uint64_t loads = 0;
+    uint64_t stores = 0;
+    uint64_t wait = 0;
+    uint32_t target = 0;    // last address accessed
+};
+
+// Shadow call stack entry: the function that made the call (or was interrupted)
+// and where it resumes.
+struct Frame {
+    int fn;
+    uint32_t ret;
+    bool trap;
+};
+
+class Symbols {
+public:
+    bool load(const std::string &path, std::string &err);
+
+    // Index into syms_, or -1 outside every symbol.
+    int lookup(uint32_t pc) const {
+        auto it = std::upper_bound(syms_.begin(), syms_.end(), pc,
+                                   [](uint32_t a, const Symbol &s) { return a < s.addr; });
+        if (it == syms_.begin()) {
+            return -1;
+        }
+        --it;
+        const size_t i = (size_t)(it - syms_.begin());
+        if (it->size != 0 && pc - it->addr >= it->size) {
+            return -1;
+        }
+        return (int)i;
+    }
+    const Symbol &at(int i) const { return syms_[(size_t)i]; }
+    size_t size() const { return syms_.size(); }
+
+private:
+    std::vector<Symbol> syms_;
+};
+
+// Functions (STT_FUNC) and code labels (STT_NOTYPE, e.g. asm entry points) in
+// executable sections; .L local labels are skipped. At one address a FUNC wins
+// over a label and a global over a local.
+bool Symbols::load(const std::string &path, std::string &err) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        err = "failed to open " + path;
+        return false;
+    }
+    const std::vector<uint8_t> raw((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    Elf32_Ehdr eh;
+    if (raw.size() < sizeof(eh) || std::memcmp(raw.data(), ELFMAG, SELFMAG) != 0) {
+        err = path + ": not an ELF file";
+        return false;
+    }
+    std::memcpy(&eh, raw.data(), sizeof(eh));
+    if (eh.e_ident[EI_CLASS] != ELFCLASS32 || eh.e_machine != EM_RISCV) {
+        err = path + ": not an RV32 ELF";
+        return false;
+    }
+    if (eh.e_shoff + (size_t)eh.e_shnum * sizeof(Elf32_Shdr) > raw.size()) {
+        err = path + ": truncated section headers";
+        return false;
+    }
+    std::vector<Elf32_Shdr> sh(eh.e_shnum);
+    std::memcpy(sh.data(), raw.data() + eh.e_shoff, sh.size() * sizeof(Elf32_Shdr));
+
+    struct Cand {
+        Symbol s;
+        int rank;
+    };
+    std::vector<Cand> cands;
+    for (const Elf32_Shdr &s : sh) {
+        if (s.sh_type != SHT_SYMTAB || s.sh_link >= sh.size()) {
+            continue;
+        }
+        const Elf32_Shdr &strtab = sh[s.sh_link];
+        if (s.sh_offset + s.sh_size > raw.size() || strtab.sh_offset + strtab.sh_size > raw.size()) {
+            err = path + ": truncated symbol table";
+            return false;
+        }
+        for (size_t off = 0; off + sizeof(Elf32_Sym) <= s.sh_size; off += sizeof(Elf32_Sym)) {
+            Elf32_Sym sym;
+            std::memcpy(&sym, raw.data() + s.sh_offset + off, sizeof(sym));
+            const unsigned type = ELF32_ST_TYPE(sym.st_info);
+            if ((type != STT_FUNC && type != STT_NOTYPE) || sym.st_shndx == SHN_UNDEF ||
+                sym.st_shndx >= sh.size() || !(sh[sym.st_shndx].sh_flags & SHF_EXECINSTR) ||
+                sym.st_name >= strtab.sh_size) {
+                continue;
+            }
+            const char *name = (const char *)raw.data() + strtab.sh_offset + sym.st_name;
+            if (name[0] == '\0' || std::strncmp(name, ".L", 2) == 0 || name[0] == '$') {
+                continue;
+            }
+            const int rank = (type == STT_FUNC ? 2 : 0) + (ELF32_ST_BIND(sym.st_info) != STB_LOCAL ? 1 : 0);
+            cands.push_back({{sym.st_value, type == STT_FUNC ? sym.st_size : 0u, name}, rank});
+        }
+    }
+    std::stable_sort(cands.begin(), cands.end(), [](const Cand &a, const Cand &b) {
+        return a.s.addr != b.s.addr ? a.s.addr < b.s.addr : a.rank > b.rank;
+    });
+    for (const Cand &c : cands) {
+        if (syms_.empty() || syms_.back().addr != c.s.addr) {
+            syms_.push_back(c.s);
+        }
+    }
+    return true;
+}
+
+class TraceReader {
+public:
+    bool open(const char *path, std::string &err) {
+        f_ = std::fopen(path, "rb");
+        if (!f_) {
+            err = std::string("failed to open ") + path;
+            return false;
+        }
+        roc::TraceHeader h;
+        if (std::fread(&h, sizeof(h), 1, f_) != 1 || h.magic != roc::TRACE_MAGIC) {
+            err = std::string(path) + ": not a retirement trace";
+            return false;
+        }
+        if (h.version != roc::TRACE_VERSION || h.record_words != sizeof(TraceRecord) / 4) {
+            err = std::string(path) + ": unsupported trace version";
+            return false;
+        }
+        start_ = std::ftell(f_);
+        return true;
+    }
+    bool next(TraceRecord &r) { return std::fread(&r, sizeof(r), 1, f_) == 1; }
+    void rewind() { std::fseek(f_, start_, SEEK_SET); }
+    ~TraceReader() {
+        if (f_) {
+            std::fclose(f_);
+        }
+    }
+
+private:
+    FILE *f_ = nullptr;
+    long start_ = 0;
+};
+
+inline unsigned insn_len(const TraceRecord &r) { return (r.info & roc::TRACE_C) ? 2u : 4u; }
+inline uint32_t opcode(uint32_t insn) { return insn & 0x7Fu; }
+inline bool is_link(uint32_t reg) { return reg == 1 || reg == 5; }
+
+// The next instruction does not follow in sequence (taken or not).
+inline bool is_control(uint32_t insn) {
+    const uint32_t op = opcode(insn);
+    return op == OPC_BRANCH || op == OPC_JAL || op == OPC_JALR || insn == INSN_MRET;
+}
+
+std::string target_name(uint32_t addr) {
+    char buf[32];
+    if (addr < MMIO_LENGTH) {
+        const uint32_t slave = addr >> SLAVE_SHIFT;
+        if (slave < sizeof(SLAVE_NAMES) / sizeof(SLAVE_NAMES[0])) {
+            return SLAVE_NAMES[slave];
+        }
+        std::snprintf(buf, sizeof(buf), "MMIO 0x%04x", slave << SLAVE_SHIFT);
+        return buf;
+    }
+    if (addr >= XMEM_BASE) return "XMEM";
+    if (addr >= IMEM_BASE) return "IMEM";
+    if (addr >= DMEM_BASE) return "DMEM";
+    std::snprintf(buf, sizeof(buf), "0x%08x", addr);
+    return buf;
+}
+
+class Profiler {
+public:
+    explicit Profiler(const Symbols &syms) : syms_(syms), funcs_(syms.size() + 1) {}
+
+    void find_leaders(TraceReader &tr);
+    void run(TraceReader &tr);
+    void report(size_t top) const;
+    bool write_folded(const char *path) const;
+
+private:
+    // Function index: symbol index, or syms_.size() for "[unknown]".
+    int fn_of(uint32_t pc) const {
+        const int i = syms_.lookup(pc);
+        return i < 0 ? (int)syms_.size() : i;
+    }
+    std::string fn_name(int fn) const { return fn == (int)syms_.size() ? "[unknown]" : syms_.at(fn).name; }
+    std::string where(uint32_t pc) const;
+    void push(const Frame &f);
+    void pop_to_return(uint32_t target);
+    void pop_trap();
+    void charge_stack(int leaf, uint64_t cost, uint64_t idx);
+
+    const Symbols &syms_;
+    std::vector<FuncStats> funcs_;
+    std::unordered_set<uint32_t> leaders_;
+    std::unordered_map<uint32_t, BlockStats> blocks_;
+    std::unordered_map<uint32_t, SiteStats> sites_;
+    std::unordered_map<std::string, SiteStats> targets_;
+    std::unordered_map<std::string, uint64_t> folded_;
+
+    std::vector<Frame> stack_;
+    uint64_t stack_gen_ = 0;            // bumped on every push/pop
+    uint64_t dropped_frames_ = 0;
+
+    uint64_t records_ = 0;
+    uint64_t cycles_ = 0;
+    uint64_t wait_ = 0;
+    uint64_t traps_ = 0;
+};
+
+std::string Profiler::where(uint32_t pc) const {
+    char buf[32];
+    const int i = syms_.lookup(pc);
+    if (i < 0) {
+        std::snprintf(buf, sizeof(buf), "0x%08x", pc);
+        return buf;
+    }
+    std::snprintf(buf, sizeof(buf), "+0x%x", pc - syms_.at(i).addr);
+    return syms_.at(i).name + buf;
+}
+
+void Profiler::push(const Frame &f) {
+    if (stack_.size() == MAX_DEPTH) {
+        stack_.erase(stack_.begin());
+        dropped_frames_++;
+    }
+    stack_.push_back(f);
+    stack_gen_++;
+}
+
+// A return unwinds to the frame it resumes (skipping frames left by tail calls
+// or longjmp), but never past a trap frame. No match: the call was not seen.
+void Profiler::pop_to_return(uint32_t target) {
+    for (size_t i = stack_.size(); i-- > 0;) {
+        if (stack_[i].trap) {
+            return;
+        }
+        if (stack_[i].ret == target) {
+            stack_.resize(i);
+            stack_gen_++;
+            return;
+        }
+    }
+}
+
+void Profiler::pop_trap() {
+    for (size_t i = stack_.size(); i-- > 0;) {
+        if (stack_[i].trap) {
+            stack_.resize(i);
+            stack_gen_++;
+            return;
+        }
+    }
+}
+
+// Inclusive time goes once to each function on the stack, however often it recurses.
+void Profiler::charge_stack(int leaf, uint64_t cost, uint64_t idx) {
+    FuncStats &l = funcs_[(size_t)leaf];
+    l.incl += cost;
+    l.last_incl = idx;
+    for (const Frame &f : stack_) {
+        FuncStats &s = funcs_[(size_t)f.fn];
+        if (s.last_incl != idx) {
+            s.incl += cost;
+            s.last_incl = idx;
+        }
+    }
+}
+
+// Pass 1: block leaders are the targets of every control transfer and trap, and
+// any instruction reached out of sequence.
+void Profiler::find_leaders(TraceReader &tr) {
+    TraceRecord r;
+    bool first = true;
+    uint32_t next_seq = 0;
+    bool prev_control = false;
+    while (tr.next(r)) {
+        if (first || prev_control || r.pc != next_seq || (r.info & roc::TRACE_INTR)) {
+            leaders_.insert(r.pc);
+        }
+        first = false;
+        next_seq = r.pc + insn_len(r);
+        prev_control = is_control(r.insn);
+    }
+}
+
+void Profiler::run(TraceReader &tr) {
+    TraceRecord r;
+    uint32_t x[32] = {};
+    uint32_t prev_cycle = 0;
+    int prev_fn = -1;
+    bool prev_call = false;
+    BlockStats *block = nullptr;
+    uint64_t *folded = nullptr;
+    uint64_t folded_gen = ~0ull;
+    int folded_leaf = -1;
+
+    while (tr.next(r)) {
+        const uint64_t idx = records_++;
+        const uint64_t cost = (uint32_t)(r.cycle - prev_cycle);
+        const uint64_t wait = r.info >> roc::TRACE_WAIT_SHIFT;
+        prev_cycle = r.cycle;
+        cycles_ += cost;
+        wait_ += wait;
+
+        const int fn = fn_of(r.pc);
+        if (r.info & roc::TRACE_INTR) {
+            traps_++;
+            push({prev_fn < 0 ? fn : prev_fn, 0, true});
+        }
+        if (prev_call) {
+            funcs_[(size_t)fn].calls++;
+        }
+
+        FuncStats &fs = funcs_[(size_t)fn];
+        fs.self += cost;
+        fs.insns++;
+        fs.wait += wait;
+        charge_stack(fn, cost, idx);
+
+        if (leaders_.count(r.pc)) {
+            block = &blocks_[r.pc];
+            block->execs++;
+        }
+        if (block) {
+            block->last_pc = std::max(block->last_pc, r.pc);
+            block->insns++;
+            block->cycles += cost;
+            block->wait += wait;
+        }
+
+        if (r.info & (roc::TRACE_LOAD | roc::TRACE_STORE)) {
+            const bool load = r.info & roc::TRACE_LOAD;
+            SiteStats &site = sites_[r.pc];
+            SiteStats &tgt = targets_[target_name(r.mem_addr)];
+            (load ? site.loads : site.stores)++;
+            (load ? tgt.loads : tgt.stores)++;
+            site.wait += wait;
+            tgt.wait += wait;
+            site.target = r.mem_addr;
+        }
+
+        if (folded_gen != stack_gen_ || folded_leaf != fn) {
+            std::string path;
+            for (const Frame &f : stack_) {
+                path += fn_name(f.fn);
+                path += ';';
+            }
+            path += fn_name(fn);
+            folded = &folded_[path];
+            folded_gen = stack_gen_;
+            folded_leaf = fn;
+        }
+        *folded += cost;
+
+        // Calls and returns, with the RISC-V link register hints (x1/x5).
+        const uint32_t rd = (r.insn >> 7) & 31u;
+        const uint32_t rs1 = (r.insn >> 15) & 31u;
+        prev_call = false;
+        if (opcode(r.insn) == OPC_JAL && is_link(rd)) {
+            push({fn, r.pc + insn_len(r), false});
+            prev_call = true;
+        } else if (opcode(r.insn) == OPC_JALR) {
+            const uint32_t target = (x[rs1] + (uint32_t)((int32_t)r.insn >> 20)) & ~1u;
+            if (is_link(rs1) && (!is_link(rd) || rd != rs1)) {
+                pop_to_return(target);
+            }
+            if (is_link(rd)) {
+                push({fn, r.pc + insn_len(r), false});
+                prev_call = true;
+            }
+        } else if (r.insn == INSN_MRET) {
+            pop_trap();
+        }
+
+        const uint32_t wr = r.info & roc::TRACE_RD_MASK;
+        if (wr != 0) {
+            x[wr] = r.rd_wdata;
+        }
+        prev_fn = fn;
+    }
+}
+
+void Profiler::report(size_t top) const {
+    const double total = cycles_ ? (double)cycles_ : 1.0;
+    std::printf("records=%" PRIu64 " cycles=%" PRIu64 " CPI=%.3f lsu_wait=%" PRIu64 " (%.1f%%) traps=%" PRIu64 "\n",
+                records_, cycles_, records_ ? (double)cycles_ / (double)records_ : 0.0,
+                wait_, 100.0 * (double)wait_ / total, traps_);
+    if (dropped_frames_) {
+        std::printf("note: call stack deeper than %zu, %" PRIu64 " outer frames dropped\n",
+                    MAX_DEPTH, dropped_frames_);
+    }
+
+    std::vector<int> order;
+    for (size_t i = 0; i < funcs_.size(); i++) {
+        if (funcs_[i].insns) {
+            order.push_back((int)i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return funcs_[(size_t)a].self > funcs_[(size_t)b].self;
+    });
+    std::printf("\n---- functions (by self cycles) ----\n");
+    std::printf("%12s %6s %12s %6s %10s %6s %8s %10s  %s\n",
+                "self", "%", "incl", "%", "instr", "CPI", "calls", "lsu_wait", "function");
+    for (size_t k = 0; k < order.size() && k < top; k++) {
+        const FuncStats &f = funcs_[(size_t)order[k]];
+        std::printf("%12" PRIu64 " %6.2f %12" PRIu64 " %6.2f %10" PRIu64 " %6.2f %8" PRIu64 " %10" PRIu64 "  %s\n",
+                    f.self, 100.0 * (double)f.self / total, f.incl, 100.0 * (double)f.incl / total,
+                    f.insns, (double)f.self / (double)f.insns, f.calls, f.wait, fn_name(order[k]).c_str());
+    }
+
+    std::vector<std::pair<uint32_t, const BlockStats *>> blocks;
+    for (const auto &b : blocks_) {
+        blocks.push_back({b.first, &b.second});
+    }
+    std::sort(blocks.begin(), blocks.end(), [](const auto &a, const auto &b) {
+        return a.second->cycles != b.second->cycles ? a.second->cycles > b.second->cycles : a.first < b.first;
+    });
+    std::printf("\n---- basic blocks (by cycles) ----\n");
+    std::printf("%12s %6s %10s %10s %8s %10s  %-21s  %s\n",
+                "cycles", "%", "execs", "instr", "cyc/exec", "lsu_wait", "range", "start");
+    for (size_t k = 0; k < blocks.size() && k < top; k++) {
+        const BlockStats &b = *blocks[k].second;
+        char range[32];
+        std::snprintf(range, sizeof(range), "0x%08x-0x%08x", blocks[k].first, b.last_pc);
+        std::printf("%12" PRIu64 " %6.2f %10" PRIu64 " %10" PRIu64 " %8.1f %10" PRIu64 "  %-21s  %s\n",
+                    b.cycles, 100.0 * (double)b.cycles / total, b.execs, b.insns,
+                    b.execs ? (double)b.cycles / (double)b.execs : 0.0, b.wait, range,
+                    where(blocks[k].first).c_str());
+    }
+
+    std::vector<std::pair<std::string, const SiteStats *>> targets;
+    for (const auto &t : targets_) {
+        targets.push_back({t.first, &t.second});
+    }
+    std::sort(targets.begin(), targets.end(), [](const auto &a, const auto &b) {
+        return a.second->wait != b.second->wait ? a.second->wait > b.second->wait : a.first < b.first;
+    });
+    std::printf("\n---- LSU wait by target ----\n");
+    std::printf("%12s %6s %10s %10s %10s  %s\n", "lsu_wait", "%", "loads", "stores", "wait/acc", "target");
+    for (const auto &t : targets) {
+        const SiteStats &s = *t.second;
+        const uint64_t n = s.loads + s.stores;
+        std::printf("%12" PRIu64 " %6.2f %10" PRIu64 " %10" PRIu64 " %10.1f  %s\n",
+                    s.wait, 100.0 * (double)s.wait / total, s.loads, s.stores,
+                    n ? (double)s.wait / (double)n : 0.0, t.first.c_str());
+    }
+
+    std::vector<std::pair<uint32_t, const SiteStats *>> sites;
+    for (const auto &s : sites_) {
+        if (s.second.wait) {
+            sites.push_back({s.first, &s.second});
+        }
+    }
+    std::sort(sites.begin(), sites.end(), [](const auto &a, const auto &b) {
+        return a.second->wait != b.second->wait ? a.second->wait > b.second->wait : a.first < b.first;
+    });
+    std::printf("\n---- LSU wait by instruction ----\n");
+    std::printf("%12s %6s %10s %10s %10s  %-6s %-10s  %s\n",
+                "lsu_wait", "%", "loads", "stores", "wait/acc", "target", "address", "pc");
+    for (size_t k = 0; k < sites.size() && k < top; k++) {
+        const SiteStats &s = *sites[k].second;
+        std::printf("%12" PRIu64 " %6.2f %10" PRIu64 " %10" PRIu64 " %10.1f  %-6s 0x%08x  0x%08x %s\n",
+                    s.wait, 100.0 * (double)s.wait / total, s.loads, s.stores,
+                    (double)s.wait / (double)(s.loads + s.stores), target_name(s.target).c_str(), s.target,
+                    sites[k].first, where(sites[k].first).c_str());
+    }
+}
+
+// One "caller;...;leaf cycles" line per distinct stack (flamegraph.pl input).
+bool Profiler::write_folded(const char *path) const {
+    FILE *f = std::fopen(path, "w");
+    if (!f) {
+        return false;
+    }
+    std::vector<std::pair<std::string, uint64_t>> lines(folded_.begin(), folded_.end());
+    std::sort(lines.begin(), lines.end());
+    for (const auto &l : lines) {
+        if (l.second) {
+            std::fprintf(f, "%s %" PRIu64 "\n", l.first.c_str(), l.second);
+        }
+    }
+    std::fclose(f);
+    return true;
+}
+
+void usage(const char *prog) {
+    std::fprintf(stderr,
+                 "Usage:\n"
+                 "  %s [-elf <main.elf>] [-top <n>] [-folded <out.folded>] <trace.bin>\n"
+                 "\n"
+                 "Notes:\n"
+                 "  The trace comes from +TRACE=<file> (tb_ROC_RV32_program, make sim-verilator, roc_iss).\n"
+                 "  -elf defaults to build/main.elf; without symbols every PC is reported as [unknown].\n"
+                 "  -top limits the function, block and instruction tables (default 25).\n"
+                 "  -folded writes collapsed stacks weighted by cycles for flamegraph.pl.\n",
+                 prog);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *elf = nullptr;
+    const char *trace = nullptr;
+    const char *folded = nullptr;
+    size_t top = 25;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (std::strcmp(a, "-elf") == 0 && i + 1 < argc) {
+            elf = argv[++i];
+        } else if (std::strcmp(a, "-top") == 0 && i + 1 < argc) {
+            top = (size_t)std::strtoul(argv[++i], nullptr, 0);
+        } else if (std::strcmp(a, "-folded") == 0 && i + 1 < argc) {
+            folded = argv[++i];
+        } else if (std::strcmp(a, "-h") == 0 || std::strcmp(a, "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else if (a[0] != '-' && !trace) {
+            trace = a;
+        } else {
+            std::fprintf(stderr, "unknown argument: %s\n", a);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!trace) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::string err;
+    Symbols syms;
+    if (!syms.load(elf ? elf : "build/main.elf", err)) {
+        if (elf) {
+            std::fprintf(stderr, "error: %s\n", err.c_str());
+            return 1;
+        }
+        std::fprintf(stderr, "warning: %s, no symbols\n", err.c_str());
+    }
+
+    TraceReader tr;
+    if (!tr.open(trace, err)) {
+        std::fprintf(stderr, "error: %s\n", err.c_str());
+        return 1;
+    }
+    Profiler prof(syms);
+    prof.find_leaders(tr);
+    tr.rewind();
+    prof.run(tr);
+    prof.report(top);
+
+    if (folded) {
+        if (!prof.write_folded(folded)) {
+            std::fprintf(stderr, "error: failed to write %s\n", folded);
+            return 1;
+        }
+        std::printf("\ncollapsed stacks: %s\n", folded);
+    }
+    return 0;
+}
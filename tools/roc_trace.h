@@ -0,0 +1,45 @@
+// Retirement trace file: written with +TRACE=<file> by tb_ROC_RV32_program,
+// the Verilator harness and the ISS, read by tools/roc_prof.
+//
+// Little-endian 32-bit words: a 4-word header, then one record per retired
+// instruction, in retirement order. The cycle stamp counts from the end of the
+// reset that starts the program, so the cost of an instruction is the stamp
+// difference with the previous record (stalls, trap entry and a sleeping WFI
+// included).
+#pragma once
+
+#include <cstdint>
+
+namespace roc {
+
+constexpr uint32_t TRACE_MAGIC = 0x52545652u;    // "RVTR"
+constexpr uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_words;                       // 7
+    uint32_t reserved;
+};
+
+struct TraceRecord {
+    uint32_t cycle;         // retire cycle, low 32 bits
+    uint32_t pc;
+    uint32_t insn;          // RV32C: the expanded 32-bit instruction
+    uint32_t rd_wdata;
+    uint32_t mem_addr;      // loads and stores, else 0
+    uint32_t mem_data;      // load: value written to rd, store: the word put on the LSU
+    uint32_t info;          // TRACE_* fields
+};
+
+constexpr uint32_t TRACE_RD_MASK = 0x1Fu;        // register written, 0 if none
+constexpr uint32_t TRACE_C       = 1u << 8;      // 16-bit instruction
+constexpr uint32_t TRACE_LOAD    = 1u << 9;
+constexpr uint32_t TRACE_STORE   = 1u << 10;
+constexpr uint32_t TRACE_INTR    = 1u << 11;     // first instruction retired after a trap
+constexpr unsigned TRACE_WAIT_SHIFT = 16;        // LSU wait cycles (mhpmcounter6), saturated
+constexpr uint32_t TRACE_WAIT_MAX = 0xFFFFu;
+
+static_assert(sizeof(TraceRecord) == 7 * 4, "trace record is 7 words");
+
+} // namespace roc
@@ -28,7 +28,12 @@ if {![file exists $flist]} {
 vlog -sv -work work -f $flist
 
 # Carga el testbench o módulo principal en QuestaSim, habilitando el rastreo de aserciones.
-vsim -assertdebug -voptargs=+acc work.$top_simu
+# Argumentos extra de vsim (p.ej. -gCPU_PIPELINE=1) desde la variable de entorno VSIM_ARGS.
+set vsim_args {}
+if {[info exists ::env(VSIM_ARGS)]} {
+    set vsim_args $::env(VSIM_ARGS)
+}
+vsim -assertdebug -voptargs=+acc {*}$vsim_args work.$top_simu
 
 # Ejecuta la simulación hasta que el testbench termine ($finish/$fatal)
 run -all
\ No newline at end of file
@@ -53,6 +53,17 @@ if {[llength $inc_dirs] > 0} {
     set_property include_dirs $inc_dirs [current_fileset]
 }
 set_property top $top_name [current_fileset]
+# Core microarchitecture and memory system (soc CPU_PIPELINE/CPU_RV32M/CPU_EARLY_IRQ/CPU_RV32C/MMIO_WBUF_DEPTH/XMEM_EN/
+# ICACHE_WAYS/DCACHE_WAYS/N_HARTS parameters), e.g. make vivado-syn CPU_PIPELINE=1
+set generics {}
+foreach g {CPU_PIPELINE CPU_RV32M CPU_EARLY_IRQ CPU_RV32C MMIO_WBUF_DEPTH XMEM_EN ICACHE_WAYS DCACHE_WAYS N_HARTS} {
+    if {[info exists ::env($g)] && $::env($g) ne ""} {
+        lappend generics "$g=$::env($g)"
+    }
+}
+if {[llength $generics] > 0} {
+    set_property generic $generics [current_fileset]
+}
 
 # Add constraints (placeholder pins)
 if {![file exists $xdc_file]} {